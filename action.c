@@ -62,6 +62,7 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 #include <strings.h>
 #include <time.h>
@@ -111,6 +112,7 @@ static rsRetVal doSubmitToActionQComplex(action_t *const pAction, wti_t *const p
 static rsRetVal doSubmitToActionQNotAllMark(action_t *const pAction, wti_t *const pWti, smsg_t *);
 static void ATTR_NONNULL() actionSuspend(action_t *const pThis, wti_t *const pWti);
 static void ATTR_NONNULL() actionRetry(action_t *const pThis, wti_t *const pWti);
+static int ATTR_NONNULL() actionBatchGetSize(action_t *const pThis);
 
 /* object static data (once for all instances) */
 DEFobjCurrIf(obj) DEFobjCurrIf(datetime) DEFobjCurrIf(module) DEFobjCurrIf(statsobj) DEFobjCurrIf(ruleset)
@@ -174,7 +176,11 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"action.resumeintervalmax", eCmdHdlrPositiveInt, 0},
     {"action.resumeinterval", eCmdHdlrInt, 0},
     {"action.externalstate.file", eCmdHdlrString, 0},
-    {"action.copymsg", eCmdHdlrBinary, 0}};
+    {"action.copymsg", eCmdHdlrBinary, 0},
+    {"action.maxinflight", eCmdHdlrNonNegInt, 0},
+    {"action.batch.targetlatency", eCmdHdlrNonNegInt, 0},
+    {"action.batch.minsize", eCmdHdlrPositiveInt, 0},
+    {"action.batch.maxsize", eCmdHdlrNonNegInt, 0}};
 static struct cnfparamblk pblk = {CNFPARAMBLK_VERSION, sizeof(cnfparamdescr) / sizeof(struct cnfparamdescr),
                                   cnfparamdescr};
 
@@ -317,6 +323,7 @@ rsRetVal actionDestruct(action_t *const pThis) {
     if (pThis->fdErrFile != -1) close(pThis->fdErrFile);
     pthread_mutex_destroy(&pThis->mutErrFile);
     pthread_mutex_destroy(&pThis->mutAction);
+    pthread_mutex_destroy(&pThis->mutBatchSize);
     pthread_mutex_destroy(&pThis->mutWrkrDataTable);
     free((void *)pThis->pszErrFile);
     free((void *)pThis->pszExternalStateFile);
@@ -379,10 +386,15 @@ rsRetVal actionConstruct(action_t **ppThis) {
     pThis->bReportSuspension = -1; /* indicate "not yet set" */
     pThis->bReportSuspensionCont = -1; /* indicate "not yet set" */
     pThis->bCopyMsg = 0;
+    pThis->iMaxInFlight = 0;
+    pThis->iBatchTargetLatency = 0;
+    pThis->iBatchMinSize = 1;
+    pThis->iBatchMaxSize = 0;
     pThis->tLastOccur = datetime.GetTime(NULL); /* done once per action on startup only */
     pThis->iActionNbr = loadConf->actions.iActionNbr;
     pthread_mutex_init(&pThis->mutErrFile, NULL);
     pthread_mutex_init(&pThis->mutAction, NULL);
+    pthread_mutex_init(&pThis->mutBatchSize, NULL);
     pthread_mutex_init(&pThis->mutWrkrDataTable, NULL);
     INIT_ATOMIC_HELPER_MUT(pThis->mutCAS);
 
@@ -430,6 +442,35 @@ rsRetVal actionConstructFinalize(action_t *__restrict__ const pThis, struct nvls
         }
     }
 
+    if (pThis->iMaxInFlight > 0 && (!pThis->isTransactional || pThis->pMod->mod.om.submitTransaction == NULL)) {
+        LogMsg(0, RS_RET_INVLD_OMOD, LOG_WARNING,
+               "action '%s': module '%s' does not support asynchronous transactions, "
+               "action.maxInFlight=%d is ignored",
+               pThis->pszName, pThis->pMod->pszName, pThis->iMaxInFlight);
+        pThis->iMaxInFlight = 0;
+    }
+
+    if (pThis->iBatchTargetLatency > 0) {
+        if (!pThis->isTransactional) {
+            LogMsg(0, RS_RET_INVLD_OMOD, LOG_WARNING,
+                   "action '%s': module '%s' is not transactional, "
+                   "action.batch.targetLatency is ignored",
+                   pThis->pszName, pThis->pMod->pszName);
+            pThis->iBatchTargetLatency = 0;
+        } else if (pThis->iMaxInFlight > 0) {
+            LogMsg(0, RS_RET_INVALID_VALUE, LOG_WARNING,
+                   "action '%s': action.batch.targetLatency cannot be combined "
+                   "with action.maxInFlight and is ignored",
+                   pThis->pszName);
+            pThis->iBatchTargetLatency = 0;
+        } else if (pThis->iBatchMaxSize > 0 && pThis->iBatchMaxSize < pThis->iBatchMinSize) {
+            LogError(0, RS_RET_INVALID_VALUE,
+                     "action '%s': action.batch.maxSize %d is lower than "
+                     "action.batch.minSize %d - using minSize as maxSize",
+                     pThis->pszName, pThis->iBatchMaxSize, pThis->iBatchMinSize);
+            pThis->iBatchMaxSize = pThis->iBatchMinSize;
+        }
+    }
 
     /* support statistics gathering */
     CHKiRet(statsobj.Construct(&pThis->statsobj));
@@ -455,6 +496,25 @@ rsRetVal actionConstructFinalize(action_t *__restrict__ const pThis, struct nvls
     CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("resumed"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
                                 &pThis->ctrResume));
 
+    if (pThis->iMaxInFlight > 0) {
+        STATSCOUNTER_INIT(pThis->ctrAsyncSubmitted, pThis->mutCtrAsyncSubmitted);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("async.submitted"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrAsyncSubmitted));
+        STATSCOUNTER_INIT(pThis->ctrAsyncRetried, pThis->mutCtrAsyncRetried);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("async.retried"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrAsyncRetried));
+    }
+
+    if (pThis->iBatchTargetLatency > 0) {
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("batch.size"), ctrType_Int, CTR_FLAG_NONE,
+                                    &pThis->iBatchCurSize));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("batch.latency"), ctrType_Int, CTR_FLAG_NONE,
+                                    &pThis->iBatchLatency));
+        STATSCOUNTER_INIT(pThis->ctrBatchCommits, pThis->mutCtrBatchCommits);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("batch.commits"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrBatchCommits));
+    }
+
     CHKiRet(statsobj.ConstructFinalize(pThis->statsobj));
 
     /* create our queue */
@@ -535,7 +595,29 @@ rsRetVal actionConstructFinalize(action_t *__restrict__ const pThis, struct nvls
         qqueueSetDefaultsActionQueue(pThis->pQueue);
         qqueueApplyCnfParam(pThis->pQueue, lst);
     }
+    if (pThis->iBatchTargetLatency > 0) {
+        /* The queue dequeues batches of the adaptive size and waits for them to fill
+         * up (see DequeueConsumableElements()). We start with the size the queue
+         * would use without adaptation. The queue must be able to hold batches up
+         * to maxSize, so its dequeue batch size becomes the upper bound.
+         */
+        pThis->iBatchCurSize = pThis->pQueue->iDeqBatchSize;
+        if (pThis->iBatchMaxSize > pThis->pQueue->iDeqBatchSize) {
+            pThis->pQueue->iDeqBatchSize = pThis->iBatchMaxSize;
+        }
+        pThis->pQueue->pfAdaptiveDeqBatchSize = actionBatchGetSize;
+    }
     qqueueCorrectParams(pThis->pQueue);
+    if (pThis->iBatchTargetLatency > 0) {
+        if (pThis->iBatchCurSize > pThis->pQueue->iDeqBatchSize) pThis->iBatchCurSize = pThis->pQueue->iDeqBatchSize;
+        if (pThis->iBatchMaxSize > 0 && pThis->iBatchCurSize > pThis->iBatchMaxSize) {
+            pThis->iBatchCurSize = pThis->iBatchMaxSize;
+        }
+        if (pThis->iBatchCurSize < pThis->iBatchMinSize) pThis->iBatchCurSize = pThis->iBatchMinSize;
+        if (pThis->iBatchMaxSize == 0 && pThis->pQueue->qType != QUEUETYPE_DIRECT) {
+            pThis->iBatchMaxSize = pThis->pQueue->iDeqBatchSize; /* no larger batch is ever dequeued */
+        }
+    }
 
 #undef setQPROP
 #undef setQPROPstr
@@ -554,6 +636,15 @@ rsRetVal actionConstructFinalize(action_t *__restrict__ const pThis, struct nvls
             (char *)modGetName(pThis->pMod));
     }
 
+    if (pThis->iMaxInFlight > 0 &&
+        (pThis->pQueue->qType == QUEUETYPE_DIRECT || pThis->pQueue->qType == QUEUETYPE_DISK)) {
+        LogMsg(0, RS_RET_INVALID_VALUE, LOG_WARNING,
+               "action '%s': action.maxInFlight requires an in-memory action queue "
+               "(queue.type \"LinkedList\" or \"FixedArray\") and is ignored",
+               pThis->pszName);
+        pThis->iMaxInFlight = 0;
+    }
+
     /* and now reset the queue params (see comment in its function header!) */
     actionResetQueueParams();
 
@@ -793,6 +884,17 @@ static void ATTR_NONNULL() actionSuspend(action_t *const pThis, wti_t *const pWt
 }
 
 
+/* May a retry wait of pThis release the pool thread of worker pWti?
+ * Only a worker of the action's own queue can continue its batch later
+ * (see processBatchMain()); with asynchronous transactions in flight, it
+ * must keep polling them.
+ */
+static int ATTR_NONNULL() actionRetryMayPark(const action_t *const pThis, const wti_t *const pWti) {
+    return pWti->pWtp != NULL && pWti->pWtp->bPooled && pWti->pWtp == pThis->pQueue->pWtpReg &&
+           pWti->nAsyncTxInFlight == 0;
+}
+
+
 /* actually do retry processing. Note that the function receives a timestamp so
  * that we do not need to call the (expensive) time() API.
  * Note that we do the full retry processing here, doing the configured number of
@@ -807,8 +909,12 @@ static void ATTR_NONNULL() actionSuspend(action_t *const pThis, wti_t *const pWt
  * not be the most appropriate, but it should be thought of a "if nothing else helps"
  * kind of facility: in the first place, the module should return a proper indication
  * of its inability to recover. -- rgerhards, 2010-04-26.
+ * If the caller can continue later (pWti->bRetryMayPark), we do not sleep until
+ * the next retry but return RS_RET_RETRY_PARKED, so that the worker releases
+ * its pool thread (see wtiRetryPark()). We are called again when it resumes.
  */
 static rsRetVal ATTR_NONNULL() actionDoRetry(action_t *const pThis, wti_t *const pWti) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
     int iRetries;
     int bTreatOKasSusp;
     time_t ttTemp;
@@ -816,7 +922,11 @@ static rsRetVal ATTR_NONNULL() actionDoRetry(action_t *const pThis, wti_t *const
 
     assert(pThis != NULL);
 
-    iRetries = 0;
+    iRetries = wrkrInfo->iRetriesParked; /* continue the count if we were parked */
+    wrkrInfo->iRetriesParked = 0;
+    if (iRetries > 0 && *pWti->pbShutdownImmediate) {
+        ABORT_FINALIZE(RS_RET_FORCE_TERM);
+    }
     while ((*pWti->pbShutdownImmediate == 0) && getActionState(pWti, pThis) == ACT_STATE_RTRY) {
         if (actionIsDisabled(pThis)) {
             break;
@@ -859,7 +969,12 @@ static rsRetVal ATTR_NONNULL() actionDoRetry(action_t *const pThis, wti_t *const
                     "Will sleep %d seconds. ResumeRtry=%lld (now %lld), iRetries %d\n",
                     pThis->pszName, pThis->iResumeInterval, (long long)pThis->ttResumeRtry, (long long)ttTemp,
                     iRetries);
-                srSleep(pThis->iResumeInterval, 0);
+                if (pWti->bRetryMayPark) {
+                    wrkrInfo->iRetriesParked = iRetries;
+                    pWti->retryParkMs = (long)pThis->iResumeInterval * 1000;
+                    ABORT_FINALIZE(RS_RET_RETRY_PARKED);
+                }
+                wtiSleep(pWti, (long)pThis->iResumeInterval * 1000);
                 if (*pWti->pbShutdownImmediate) {
                     ABORT_FINALIZE(RS_RET_FORCE_TERM);
                 }
@@ -920,7 +1035,7 @@ static rsRetVal ATTR_NONNULL() actionDoRetry_extFile(action_t *const pThis, wti_
                 if (getActionNbrResRtry(pWti, pThis) < 20) incActionNbrResRtry(pWti, pThis);
             } else {
                 ++iRetries;
-                srSleep(pThis->iResumeInterval, 0);
+                wtiSleep(pWti, (long)pThis->iResumeInterval * 1000);
                 if (*pWti->pbShutdownImmediate) {
                     ABORT_FINALIZE(RS_RET_FORCE_TERM);
                 }
@@ -1332,6 +1447,7 @@ static rsRetVal doTransaction(action_t *__restrict__ const pThis,
     actWrkrInfo_t *wrkrInfo;
     int i;
     sbool bSuspended = 0;
+    const sbool bMayPark = pWti->bRetryMayPark;
     DEFiRet;
 
     DBGPRINTF("doTransaction[%s] enter\n", pThis->pszName);
@@ -1341,6 +1457,7 @@ static rsRetVal doTransaction(action_t *__restrict__ const pThis,
         CHKiRet(actionCallCommitTransaction(pThis, pWti, iparams, nparams));
     } else { /* note: this branch is for compatibility with old TX modules */
         DBGPRINTF("doTransaction: action '%s', currIParam %d\n", pThis->pszName, wrkrInfo->p.tx.currIParam);
+        pWti->bRetryMayPark = 0; /* some messages may already be done, so we can not continue later */
         for (i = 0; i < nparams; ++i) {
             /* Note: we provide the message's base iparam - actionProcessMessage()
              * uses this as *base* address.
@@ -1358,7 +1475,7 @@ static rsRetVal doTransaction(action_t *__restrict__ const pThis,
                      * and the rsyslog core’s standard retry logic takes over.
                      */
                     --i; /* reprocess this message on the next loop iteration */
-                    srSleep(1, 0); /* sleep 1 second */
+                    wtiSleep(pWti, 1000); /* sleep 1 second */
                     bSuspended = 1; /* mark that the one local retry has been done */
                     continue;
                 } else {
@@ -1372,6 +1489,7 @@ static rsRetVal doTransaction(action_t *__restrict__ const pThis,
         }
     }
 finalize_it:
+    pWti->bRetryMayPark = bMayPark;
     if (iRet == RS_RET_DEFER_COMMIT || iRet == RS_RET_PREVIOUS_COMMITTED)
         iRet = RS_RET_OK; /* this is expected for transactional action! */
     RETiRet;
@@ -1530,12 +1648,35 @@ done:
 }
 
 
+/* swap the parameters of messages i and j. We swap rather than copy, as
+ * each entry owns its string buffers.
+ */
+static void ATTR_NONNULL() actionSwapIParams(const action_t *__restrict__ const pThis,
+                                             actWrkrIParams_t *const iparams,
+                                             const unsigned i,
+                                             const unsigned j) {
+    actWrkrIParams_t tmp[CONF_OMOD_NUMSTRINGS_MAXSIZE];
+    const size_t len = sizeof(actWrkrIParams_t) * pThis->iNumTpls;
+
+    if (i == j) {
+        return;
+    }
+    memcpy(tmp, &actParam(iparams, pThis->iNumTpls, i, 0), len);
+    memcpy(&actParam(iparams, pThis->iNumTpls, i, 0), &actParam(iparams, pThis->iNumTpls, j, 0), len);
+    memcpy(&actParam(iparams, pThis->iNumTpls, j, 0), tmp, len);
+}
+
+
+/* commit the messages of a failed batch one by one. Those with a temporary
+ * error are moved, in order, to the start of batchParams; *new_nMsgs is
+ * their number. If the worker parks (RS_RET_RETRY_PARKED), the current and
+ * all following messages are kept as well, as they were not yet tried.
+ */
 static rsRetVal actionTryRemoveHardErrorsFromBatch(action_t *__restrict__ const pThis,
                                                    wti_t *__restrict__ const pWti,
-                                                   actWrkrIParams_t *const new_iparams,
+                                                   actWrkrIParams_t *const batchParams,
+                                                   const unsigned nMsgs,
                                                    unsigned *new_nMsgs) {
-    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
-    const unsigned nMsgs = wrkrInfo->p.tx.currIParam;
     actWrkrIParams_t oneParamSet[CONF_OMOD_NUMSTRINGS_MAXSIZE];
     rsRetVal ret;
     DEFiRet;
@@ -1543,57 +1684,59 @@ static rsRetVal actionTryRemoveHardErrorsFromBatch(action_t *__restrict__ const
     *new_nMsgs = 0;
     for (unsigned i = 0; i < nMsgs; ++i) {
         setActionResumeInRow(pWti, pThis, 0);  // make sure we do not trigger OK-as-SUSPEND handling
-        memcpy(&oneParamSet, &actParam(wrkrInfo->p.tx.iparams, pThis->iNumTpls, i, 0),
-               sizeof(actWrkrIParams_t) * pThis->iNumTpls);
+        memcpy(&oneParamSet, &actParam(batchParams, pThis->iNumTpls, i, 0), sizeof(actWrkrIParams_t) * pThis->iNumTpls);
         ret = actionTryCommit(pThis, pWti, oneParamSet, 1);
-        if (ret == RS_RET_SUSPENDED) {
-            memcpy(new_iparams + (*new_nMsgs * pThis->iNumTpls), &oneParamSet,
-                   sizeof(actWrkrIParams_t) * pThis->iNumTpls);
-            ++(*new_nMsgs);
+        if (ret == RS_RET_RETRY_PARKED) {
+            for (; i < nMsgs; ++i) {
+                actionSwapIParams(pThis, batchParams, (*new_nMsgs)++, i);
+            }
+            ABORT_FINALIZE(RS_RET_RETRY_PARKED);
+        } else if (ret == RS_RET_SUSPENDED) {
+            actionSwapIParams(pThis, batchParams, (*new_nMsgs)++, i);
         } else if (ret != RS_RET_OK) {
             actionWriteErrorFile(pThis, ret, oneParamSet, 1);
         }
     }
+
+finalize_it:
     RETiRet;
 }
 
 /**
- * Commit all messages currently buffered for an action.
+ * Synchronously commit a batch of messages.
  *
  * The function first tries to commit the whole batch. On failure each
  * message is retried individually so that permanent errors can be
  * written to the action's error file while temporary errors trigger the
- * usual retry handling.
+ * usual retry handling. The messages still to be retried are moved to the
+ * start of @a batchParams.
  *
- * @param[in] pThis action being committed
- * @param[in] pWti  worker thread instance
+ * If the worker parks while waiting for a retry (RS_RET_RETRY_PARKED), the
+ * messages not yet committed are left at the start of the worker's
+ * parameter buffer, and its currIParam is set to their number. So the
+ * commit continues when the batch is processed again. Only the caller
+ * that commits that very buffer may permit this (see actionCommit()).
  *
- * The return value is propagated via qqueueAdd() when the action queue
- * operates in direct mode so that callers can react immediately.
-
+ * @param[in] pThis       action being committed
+ * @param[in] pWti        worker thread instance
+ * @param[in] batchParams parameter array of the batch
+ * @param[in] nBatch      number of messages in @a batchParams
  * @return Status code from the final commit attempt.
- * The result is propagated back through direct-mode queues so
- * higher levels can act on suspend or failure states.
  */
-static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti) {
-    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
-    /* Variables that permit us to override the batch of messages */
-    unsigned nMsgs = 0;
-    actWrkrIParams_t *iparams = NULL;
-    int needfree_iparams = 0;  // work-around for clang static analyzer false positive
+static rsRetVal ATTR_NONNULL() actionCommitBatch(action_t *__restrict__ const pThis,
+                                                 wti_t *__restrict__ const pWti,
+                                                 actWrkrIParams_t *const batchParams,
+                                                 const unsigned nBatch) {
+    /* the messages still to commit, at the start of batchParams */
+    unsigned nMsgs = nBatch;
+    actWrkrIParams_t *const iparams = batchParams;
     DEFiRet;
 
-    DBGPRINTF("actionCommit[%s]: enter, %d msgs\n", pThis->pszName, wrkrInfo->p.tx.currIParam);
-    if (actionIsDisabled(pThis)) {
-        actionDisableForWorker(pThis, pWti);
-        ABORT_FINALIZE(RS_RET_DISABLE_ACTION);
-    } else if (!pThis->isTransactional || pWti->actWrkrInfo[pThis->iActionNbr].p.tx.currIParam == 0) {
-        FINALIZE;
-    } else if (getActionState(pWti, pThis) == ACT_STATE_SUSP) {
+    if (getActionState(pWti, pThis) == ACT_STATE_SUSP) {
         /* if we are suspended, we already tried everything to recover the
          * action - and failed. So all we can do here is write the error file.
          */
-        actionWriteErrorFile(pThis, iRet, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+        actionWriteErrorFile(pThis, iRet, batchParams, nBatch);
         FINALIZE;
     }
     DBGPRINTF("actionCommit[%s]: processing...\n", pThis->pszName);
@@ -1605,9 +1748,9 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
      * than configured (if temporary failure), but this unavoidable and should
      * do no real harm. - rgerhards, 2017-10-06
      */
-    iRet = actionTryCommit(pThis, pWti, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+    iRet = actionTryCommit(pThis, pWti, batchParams, nBatch);
     DBGPRINTF("actionCommit[%s]: return actionTryCommit %d\n", pThis->pszName, iRet);
-    if (iRet == RS_RET_OK) {
+    if (iRet == RS_RET_OK || iRet == RS_RET_RETRY_PARKED) {
         FINALIZE;
     }
 
@@ -1615,21 +1758,16 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
      * are done. If it is a multi-message batch, we need to sort out the individual
      * message states.
      */
-    if (wrkrInfo->p.tx.currIParam == 1) {
-        needfree_iparams = 0;
-        iparams = wrkrInfo->p.tx.iparams;
-        nMsgs = wrkrInfo->p.tx.currIParam;
+    if (nBatch == 1) {
         if (iRet == RS_RET_DATAFAIL) {
             FINALIZE;
         }
     } else {
         DBGPRINTF(
-            "actionCommit[%s]: somewhat unhappy, full batch of %d msgs returned "
+            "actionCommit[%s]: somewhat unhappy, full batch of %u msgs returned "
             "status %d. Trying messages as individual actions.\n",
-            pThis->pszName, wrkrInfo->p.tx.currIParam, iRet);
-        CHKmalloc(iparams = malloc(sizeof(actWrkrIParams_t) * pThis->iNumTpls * wrkrInfo->p.tx.currIParam));
-        needfree_iparams = 1;
-        actionTryRemoveHardErrorsFromBatch(pThis, pWti, iparams, &nMsgs);
+            pThis->pszName, nBatch, iRet);
+        CHKiRet(actionTryRemoveHardErrorsFromBatch(pThis, pWti, batchParams, nBatch, &nMsgs));
     }
 
     if (nMsgs == 0) {
@@ -1644,13 +1782,13 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
     do {
         iRet = actionTryCommit(pThis, pWti, iparams, nMsgs);
         DBGPRINTF("actionCommit[%s]: in retry loop, iRet %d\n", pThis->pszName, iRet);
-        if (iRet == RS_RET_FORCE_TERM) {
-            ABORT_FINALIZE(RS_RET_FORCE_TERM);
+        if (iRet == RS_RET_FORCE_TERM || iRet == RS_RET_RETRY_PARKED) {
+            FINALIZE;
         } else if (iRet == RS_RET_SUSPENDED) {
             iRet = actionDoRetry(pThis, pWti);
             DBGPRINTF("actionCommit[%s]: actionDoRetry returned %d\n", pThis->pszName, iRet);
-            if (iRet == RS_RET_FORCE_TERM) {
-                ABORT_FINALIZE(RS_RET_FORCE_TERM);
+            if (iRet == RS_RET_FORCE_TERM || iRet == RS_RET_RETRY_PARKED) {
+                FINALIZE;
             } else if (iRet != RS_RET_OK) {
                 actionWriteErrorFile(pThis, iRet, iparams, nMsgs);
                 bDone = 1;
@@ -1666,11 +1804,447 @@ static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis,
         }
     } while (!bDone);
 finalize_it:
-    DBGPRINTF("actionCommit[%s]: done, iRet %d\n", pThis->pszName, iRet);
-    if (needfree_iparams) {
-        free(iparams);
+    if (iRet == RS_RET_RETRY_PARKED) {
+        pWti->actWrkrInfo[pThis->iActionNbr].p.tx.currIParam = nMsgs;
+    }
+    RETiRet;
+}
+
+
+/* Asynchronous transactions (action.maxInFlight > 0)
+ *
+ * Each worker keeps up to iMaxInFlight submitted batches per action. A
+ * slot owns the parameter array of its batch until the module reported
+ * completion; on submit, the worker's current array is swapped with the
+ * (idle) array of the slot, so that string buffers keep being reused.
+ * A batch counts as committed only once the module reported its success.
+ * Batches which did not complete successfully are re-processed via the
+ * synchronous path, which does the regular retry, suspend and error file
+ * handling.
+ *
+ * Asynchronous commit is only done for batches of the action's own
+ * in-memory queue: in direct mode, the caller acts on the commit result,
+ * and a disk queue (including the disk part of a disk-assisted queue)
+ * must keep messages until they are delivered.
+ */
+#define ASYNCTX_POLL_TIMEOUT_MS 1000
+
+typedef struct actAsyncTxSlot_s {
+    actWrkrIParams_t *iparams;
+    int maxIParams;
+    unsigned nMsgs;
+    sbool bInFlight;
+    wti_t *pWti; /* worker owning this slot, for completion notification */
+} actAsyncTxSlot_t;
+
+struct actAsyncTx_s {
+    int nSlots;
+    int nInFlight;
+    actAsyncTxSlot_t *slots;
+    omTxCompletion_t *compl;
+};
+
+static int ATTR_NONNULL() actionAsyncTxPermitted(const action_t *const pThis, const wti_t *const pWti) {
+    return pThis->iMaxInFlight > 0 && pThis->pQueue->qType != QUEUETYPE_DIRECT &&
+           pThis->pQueue->qType != QUEUETYPE_DISK && pWti->pWtp == pThis->pQueue->pWtpReg;
+}
+
+static rsRetVal actionAsyncTxConstruct(action_t *const pThis, wti_t *const pWti, actAsyncTx_t **const ppAsyncTx) {
+    actAsyncTx_t *pAsyncTx = NULL;
+    DEFiRet;
+
+    CHKmalloc(pAsyncTx = calloc(1, sizeof(actAsyncTx_t)));
+    pAsyncTx->nSlots = pThis->iMaxInFlight;
+    CHKmalloc(pAsyncTx->slots = calloc(pAsyncTx->nSlots, sizeof(actAsyncTxSlot_t)));
+    CHKmalloc(pAsyncTx->compl = calloc(pAsyncTx->nSlots, sizeof(omTxCompletion_t)));
+    for (int i = 0; i < pAsyncTx->nSlots; ++i) {
+        pAsyncTx->slots[i].pWti = pWti;
+    }
+    *ppAsyncTx = pAsyncTx;
+    pAsyncTx = NULL;
+
+finalize_it:
+    if (pAsyncTx != NULL) {
+        free(pAsyncTx->slots);
+        free(pAsyncTx);
+    }
+    RETiRet;
+}
+
+static void actionAsyncTxReleaseSlot(wti_t *const pWti, actAsyncTx_t *const pAsyncTx, actAsyncTxSlot_t *const slot) {
+    slot->bInFlight = 0;
+    slot->nMsgs = 0;
+    --pAsyncTx->nInFlight;
+    --pWti->nAsyncTxInFlight;
+}
+
+/* process the outcome of one asynchronous transaction */
+static void ATTR_NONNULL() actionAsyncTxCompleted(action_t *const pThis,
+                                                  wti_t *const pWti,
+                                                  actAsyncTxSlot_t *const slot,
+                                                  const rsRetVal result) {
+    actAsyncTx_t *const pAsyncTx = pWti->actWrkrInfo[pThis->iActionNbr].asyncTx;
+
+    DBGPRINTF("action[%s]: async transaction of %u msgs completed, result %d\n", pThis->pszName, slot->nMsgs,
+              result);
+    switch (result) {
+        case RS_RET_OK:
+        case RS_RET_DEFER_COMMIT:
+        case RS_RET_PREVIOUS_COMMITTED:
+            /* Completions are reaped while the worker's next transaction may already
+             * be open (ITX, see actionCommitAsync()), so we must not touch that state;
+             * a suspended action stays so until its regular resume. Only a pending
+             * retry is resolved, as the module evidently works again.
+             */
+            if (getActionState(pWti, pThis) == ACT_STATE_RTRY) {
+                actionCommitted(pThis, pWti);
+            }
+            actionSetActionWorked(pThis, pWti);
+            break;
+        case RS_RET_DISABLE_ACTION:
+            actionDisableForWorker(pThis, pWti);
+            actionWriteErrorFile(pThis, result, slot->iparams, slot->nMsgs);
+            break;
+        case RS_RET_SUSPENDED:
+            actionRetry(pThis, pWti);
+            /* fallthrough */
+        default:
+            STATSCOUNTER_INC(pThis->ctrAsyncRetried, pThis->mutCtrAsyncRetried);
+            actionCommitBatch(pThis, pWti, slot->iparams, slot->nMsgs);
+            break;
+    }
+    actionAsyncTxReleaseSlot(pWti, pAsyncTx, slot);
+}
+
+/* wait up to timeoutMs for completions and process them */
+static void ATTR_NONNULL() actionAsyncTxPoll(action_t *const pThis, wti_t *const pWti, const int timeoutMs) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+    actAsyncTx_t *const pAsyncTx = wrkrInfo->asyncTx;
+    actAsyncTxSlot_t *slot;
+    unsigned nCompl = 0;
+    rsRetVal localRet;
+
+    localRet = pThis->pMod->mod.om.pollTransactions(wrkrInfo->actWrkrData, timeoutMs, pAsyncTx->compl,
+                                                     pAsyncTx->nSlots, &nCompl);
+    if (localRet != RS_RET_OK) {
+        /* outcome unknown: the module has forgotten all outstanding
+         * transactions, so we re-process them synchronously.
+         */
+        LogMsg(0, localRet, LOG_WARNING,
+               "action '%s': polling asynchronous transactions failed, "
+               "re-processing %d outstanding batches synchronously",
+               pThis->pszName, pAsyncTx->nInFlight);
+        for (int i = 0; i < pAsyncTx->nSlots; ++i) {
+            if (pAsyncTx->slots[i].bInFlight) {
+                actionAsyncTxCompleted(pThis, pWti, &pAsyncTx->slots[i], localRet);
+            }
+        }
+        return;
+    }
+
+    for (unsigned i = 0; i < nCompl && i < (unsigned)pAsyncTx->nSlots; ++i) {
+        slot = pAsyncTx->compl[i].txCookie;
+        if (slot < pAsyncTx->slots || slot >= pAsyncTx->slots + pAsyncTx->nSlots || !slot->bInFlight) {
+            LogError(0, RS_RET_INTERNAL_ERROR,
+                     "action '%s': module '%s' reported completion of "
+                     "unknown transaction - ignored; this is a module bug",
+                     pThis->pszName, pThis->pMod->pszName);
+            continue;
+        }
+        actionAsyncTxCompleted(pThis, pWti, slot, pAsyncTx->compl[i].result);
+    }
+}
+
+/* commit current batch by submitting it asynchronously, if possible */
+static rsRetVal ATTR_NONNULL() actionCommitAsync(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+    actAsyncTx_t *pAsyncTx;
+    actAsyncTxSlot_t *slot = NULL;
+    actWrkrIParams_t *iparamsSwap;
+    int maxSwap;
+    rsRetVal localRet;
+    DEFiRet;
+
+    if (wrkrInfo->asyncTx == NULL) {
+        CHKiRet(actionAsyncTxConstruct(pThis, pWti, &wrkrInfo->asyncTx));
+    }
+    pAsyncTx = wrkrInfo->asyncTx;
+
+    /* reap what is already done, then wait for a free slot */
+    if (pAsyncTx->nInFlight > 0) {
+        actionAsyncTxPoll(pThis, pWti, 0);
+    }
+    while (pAsyncTx->nInFlight == pAsyncTx->nSlots && !*pWti->pbShutdownImmediate) {
+        actionAsyncTxPoll(pThis, pWti, ASYNCTX_POLL_TIMEOUT_MS);
     }
-    wrkrInfo->p.tx.currIParam = 0; /* reset to beginning */
+
+    iRet = actionPrepare(pThis, pWti);
+    if (iRet != RS_RET_OK || getActionState(pWti, pThis) != ACT_STATE_ITX ||
+        pAsyncTx->nInFlight == pAsyncTx->nSlots) {
+        /* not ready (or shutting down): regular processing does all the retry handling */
+        iRet = actionCommitBatch(pThis, pWti, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+        FINALIZE;
+    }
+
+    for (int i = 0; i < pAsyncTx->nSlots; ++i) {
+        if (!pAsyncTx->slots[i].bInFlight) {
+            slot = &pAsyncTx->slots[i];
+            break;
+        }
+    }
+    assert(slot != NULL);
+
+    localRet = pThis->pMod->mod.om.submitTransaction(wrkrInfo->actWrkrData, wrkrInfo->p.tx.iparams,
+                                                      wrkrInfo->p.tx.currIParam, slot);
+    DBGPRINTF("actionCommit[%s]: submitTransaction of %d msgs returned %d\n", pThis->pszName,
+              wrkrInfo->p.tx.currIParam, localRet);
+    switch (localRet) {
+        case RS_RET_OK:
+            iparamsSwap = slot->iparams;
+            maxSwap = slot->maxIParams;
+            slot->iparams = wrkrInfo->p.tx.iparams;
+            slot->maxIParams = wrkrInfo->p.tx.maxIParams;
+            slot->nMsgs = wrkrInfo->p.tx.currIParam;
+            slot->bInFlight = 1;
+            wrkrInfo->p.tx.iparams = iparamsSwap;
+            wrkrInfo->p.tx.maxIParams = maxSwap;
+            ++pAsyncTx->nInFlight;
+            ++pWti->nAsyncTxInFlight;
+            STATSCOUNTER_INC(pThis->ctrAsyncSubmitted, pThis->mutCtrAsyncSubmitted);
+            /* the module took over the transaction, so the next batch may
+             * begin a new one. This is no commit: the batch is only committed
+             * when actionAsyncTxCompleted() receives its successful outcome.
+             */
+            actionSetState(pThis, pWti, ACT_STATE_RDY);
+            break;
+        case RS_RET_DISABLE_ACTION:
+            actionDisableForWorker(pThis, pWti);
+            iRet = RS_RET_DISABLE_ACTION;
+            break;
+        case RS_RET_SUSPENDED:
+            actionRetry(pThis, pWti);
+            /* fallthrough */
+        default:
+            iRet = actionCommitBatch(pThis, pWti, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+            break;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+void ATTR_NONNULL() actionAsyncTxPollAll(wti_t *const pWti, const int timeoutMs) {
+    actWrkrInfo_t *wrkrInfo;
+
+    for (int i = 0; i < runConf->actions.iActionNbr; ++i) {
+        wrkrInfo = &(pWti->actWrkrInfo[i]);
+        if (wrkrInfo->asyncTx != NULL && wrkrInfo->asyncTx->nInFlight > 0) {
+            actionAsyncTxPoll(wrkrInfo->pAction, pWti, timeoutMs);
+        }
+    }
+}
+
+rsRetVal actionAsyncTxNotify(void *const txCookie) {
+    DEFiRet;
+
+    if (txCookie == NULL) {
+        ABORT_FINALIZE(RS_RET_PARAM_ERROR);
+    }
+    wtiAsyncTxNotify(((actAsyncTxSlot_t *)txCookie)->pWti);
+
+finalize_it:
+    RETiRet;
+}
+
+void ATTR_NONNULL() actionAsyncTxDrain(action_t *const pThis, wti_t *const pWti) {
+    actAsyncTx_t *const pAsyncTx = pWti->actWrkrInfo[pThis->iActionNbr].asyncTx;
+    actAsyncTxSlot_t *slot;
+    rsRetVal localRet;
+
+    if (pAsyncTx == NULL) {
+        return;
+    }
+    while (pAsyncTx->nInFlight > 0 && !*pWti->pbShutdownImmediate) {
+        actionAsyncTxPoll(pThis, pWti, ASYNCTX_POLL_TIMEOUT_MS);
+    }
+    if (pAsyncTx->nInFlight == 0) {
+        return;
+    }
+
+    /* We must not wait any longer, but the outcome of these batches is
+     * unknown. So we commit them once more synchronously, which may
+     * duplicate messages but does not lose them. What cannot be committed
+     * before we are terminated goes to the error file (if configured).
+     */
+    LogMsg(0, RS_RET_FORCE_TERM, LOG_WARNING,
+           "action '%s': shutdown with %d asynchronous transactions outstanding, "
+           "committing them synchronously",
+           pThis->pszName, pAsyncTx->nInFlight);
+    for (int i = 0; i < pAsyncTx->nSlots; ++i) {
+        slot = &pAsyncTx->slots[i];
+        if (slot->bInFlight) {
+            localRet = actionCommitBatch(pThis, pWti, slot->iparams, slot->nMsgs);
+            if (localRet == RS_RET_FORCE_TERM) {
+                actionWriteErrorFile(pThis, localRet, slot->iparams, slot->nMsgs);
+            }
+            actionAsyncTxReleaseSlot(pWti, pAsyncTx, slot);
+        }
+    }
+}
+
+void ATTR_NONNULL() actionAsyncTxFree(action_t *const pThis, wti_t *const pWti) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+    actAsyncTx_t *const pAsyncTx = wrkrInfo->asyncTx;
+
+    if (pAsyncTx == NULL) {
+        return;
+    }
+    for (int i = 0; i < pAsyncTx->nSlots; ++i) {
+        actAsyncTxSlot_t *const slot = &pAsyncTx->slots[i];
+        for (int j = 0; j < slot->maxIParams; ++j) {
+            for (int k = 0; k < pThis->iNumTpls; ++k) {
+                free(actParam(slot->iparams, pThis->iNumTpls, j, k).param);
+            }
+        }
+        free(slot->iparams);
+    }
+    free(pAsyncTx->compl);
+    free(pAsyncTx->slots);
+    free(pAsyncTx);
+    wrkrInfo->asyncTx = NULL;
+}
+
+
+/* Adaptive commit size (action.batch.targetLatency > 0)
+ *
+ * The action queue dequeues batches of the action's current commit size,
+ * waiting up to queue.minDequeueBatchSize.timeout for them to fill. A batch
+ * that is nevertheless larger (direct queue, or the size shrank meanwhile)
+ * is committed in chunks of that size. After each chunk, the size is
+ * adjusted from the observed latency:
+ * it doubles while commits take less than half the target, grows by 1/8
+ * while below 90% of the target and shrinks proportionally if the target
+ * is exceeded. A failed commit halves it. Growth is only considered for
+ * full-sized chunks, as small batches under light load tell nothing about
+ * the destination's capacity. The size is shared by all workers of the
+ * action.
+ */
+static int ATTR_NONNULL() actionBatchGetSize(action_t *const pThis) {
+    int size;
+    pthread_mutex_lock(&pThis->mutBatchSize);
+    size = pThis->iBatchCurSize;
+    pthread_mutex_unlock(&pThis->mutBatchSize);
+    return size;
+}
+
+static void ATTR_NONNULL() actionBatchAdapt(action_t *const pThis,
+                                            const unsigned nMsgs,
+                                            const long long latencyUs,
+                                            const rsRetVal commitRet) {
+    const long long targetUs = (long long)pThis->iBatchTargetLatency * 1000;
+    long long size;
+
+    pthread_mutex_lock(&pThis->mutBatchSize);
+    size = pThis->iBatchCurSize;
+    if (commitRet != RS_RET_OK) {
+        size /= 2;
+    } else if (latencyUs > targetUs) {
+        size = size * targetUs / latencyUs;
+    } else if (nMsgs >= (unsigned)size) {
+        if (latencyUs < targetUs / 2) {
+            size *= 2;
+        } else if (latencyUs < targetUs * 9 / 10) {
+            size += (size / 8 > 0) ? size / 8 : 1;
+        }
+    }
+    if (size < pThis->iBatchMinSize) size = pThis->iBatchMinSize;
+    if (pThis->iBatchMaxSize > 0 && size > pThis->iBatchMaxSize) size = pThis->iBatchMaxSize;
+    if (size > INT_MAX / 2) size = INT_MAX / 2;
+    pThis->iBatchCurSize = (int)size;
+    pThis->iBatchLatency = (int)((7 * (long long)pThis->iBatchLatency + latencyUs / 1000) / 8);
+    pthread_mutex_unlock(&pThis->mutBatchSize);
+    DBGPRINTF("action[%s]: commit of %u msgs took %lld us, iRet %d - commit size now %d\n", pThis->pszName, nMsgs,
+              latencyUs, commitRet, (int)size);
+}
+
+/* commit the current batch in chunks of the adaptive commit size */
+static rsRetVal ATTR_NONNULL() actionCommitAdaptive(action_t *__restrict__ const pThis,
+                                                    wti_t *__restrict__ const pWti) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+    const unsigned nTotal = wrkrInfo->p.tx.currIParam;
+    unsigned nDone = 0;
+    unsigned nChunk;
+    struct timespec tStart, tEnd;
+    long long latencyUs;
+    DEFiRet;
+
+    while (nDone < nTotal) {
+        nChunk = (unsigned)actionBatchGetSize(pThis);
+        if (nChunk > nTotal - nDone) nChunk = nTotal - nDone;
+        clock_gettime(CLOCK_MONOTONIC, &tStart);
+        iRet = actionCommitBatch(pThis, pWti, &actParam(wrkrInfo->p.tx.iparams, pThis->iNumTpls, nDone, 0), nChunk);
+        clock_gettime(CLOCK_MONOTONIC, &tEnd);
+        latencyUs = (long long)(tEnd.tv_sec - tStart.tv_sec) * 1000000 + (tEnd.tv_nsec - tStart.tv_nsec) / 1000;
+        STATSCOUNTER_INC(pThis->ctrBatchCommits, pThis->mutCtrBatchCommits);
+        actionBatchAdapt(pThis, nChunk, latencyUs, iRet);
+        nDone += nChunk;
+        if (iRet == RS_RET_FORCE_TERM || iRet == RS_RET_DISABLE_ACTION) {
+            break; /* same as for a single commit: the rest of the batch is not processed */
+        }
+    }
+
+    RETiRet;
+}
+
+
+/**
+ * Commit all messages currently buffered for an action.
+ *
+ * If the action uses asynchronous transactions, the batch is submitted
+ * to the output module and its outcome is processed later. With an
+ * adaptive commit size, it is committed in chunks of that size. Otherwise
+ * the batch is committed synchronously via actionCommitBatch().
+ *
+ * @param[in] pThis action being committed
+ * @param[in] pWti  worker thread instance
+ *
+ * The return value is propagated via qqueueAdd() when the action queue
+ * operates in direct mode so that callers can react immediately.
+
+ * @return Status code from the final commit attempt.
+ * The result is propagated back through direct-mode queues so
+ * higher levels can act on suspend or failure states.
+ */
+static rsRetVal ATTR_NONNULL() actionCommit(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti) {
+    actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+    const sbool bMayPark = pWti->bRetryMayPark;
+    DEFiRet;
+
+    DBGPRINTF("actionCommit[%s]: enter, %d msgs\n", pThis->pszName, wrkrInfo->p.tx.currIParam);
+    if (actionIsDisabled(pThis)) {
+        actionDisableForWorker(pThis, pWti);
+        ABORT_FINALIZE(RS_RET_DISABLE_ACTION);
+    } else if (!pThis->isTransactional || pWti->actWrkrInfo[pThis->iActionNbr].p.tx.currIParam == 0) {
+        FINALIZE;
+    }
+
+    /* a parked worker can only continue a commit of its whole parameter buffer */
+    if (actionAsyncTxPermitted(pThis, pWti) && getActionState(pWti, pThis) != ACT_STATE_SUSP) {
+        pWti->bRetryMayPark = 0;
+        iRet = actionCommitAsync(pThis, pWti);
+    } else if (pThis->iBatchTargetLatency > 0) {
+        pWti->bRetryMayPark = 0;
+        iRet = actionCommitAdaptive(pThis, pWti);
+    } else {
+        iRet = actionCommitBatch(pThis, pWti, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+    }
+    pWti->bRetryMayPark = bMayPark;
+
+finalize_it:
+    DBGPRINTF("actionCommit[%s]: done, iRet %d\n", pThis->pszName, iRet);
+    if (iRet != RS_RET_RETRY_PARKED) {
+        wrkrInfo->p.tx.currIParam = 0; /* reset to beginning */
+    } /* else the messages not yet committed are kept for the parked worker */
     RETiRet;
 }
 
@@ -1710,7 +2284,12 @@ static rsRetVal processMsgMain(action_t *__restrict__ const pAction,
     if (pAction->isTransactional) {
         pWti->actWrkrInfo[pAction->iActionNbr].pAction = pAction;
         DBGPRINTF("action '%s': is transactional - executing in commit phase\n", pAction->pszName);
-        CHKiRet(actionPrepare(pAction, pWti));
+        iRet = actionPrepare(pAction, pWti);
+        if (iRet == RS_RET_RETRY_PARKED) {
+            /* not accepted, the message is processed again when the worker resumes */
+            --pWti->actWrkrInfo[pAction->iActionNbr].p.tx.currIParam;
+        }
+        CHKiRet(iRet);
         iRet = getReturnCode(pAction, pWti);
         FINALIZE;
     }
@@ -1731,6 +2310,13 @@ finalize_it:
  * message is executed via processMsgMain() so that transactional
  * actions collect parameters before a final call to actionCommit().
  *
+ * A pooled worker of the action's own queue does not sleep while the
+ * action waits for a retry. We then return RS_RET_RETRY_PARKED, the
+ * worker releases its pool thread and keeps the batch. When the retry is
+ * due, we are called with the same batch and continue at the message
+ * recorded in pWti->iRetryElem, with the messages accepted so far still
+ * waiting for their commit.
+ *
  * @param[in] pVoid   pointer to the action instance
  * @param[in] pBatch  batch of messages from the queue
  * @param[in] pWti    worker thread state
@@ -1739,10 +2325,13 @@ static rsRetVal ATTR_NONNULL() processBatchMain(void *__restrict__ const pVoid,
                                                 batch_t *__restrict__ const pBatch,
                                                 wti_t *__restrict__ const pWti) {
     action_t *__restrict__ const pAction = (action_t *__restrict__ const)pVoid;
+    const int iFirst = pWti->iRetryElem; /* where to continue a parked batch, else 0 */
     int i;
     struct syslogTime ttNow;
     DEFiRet;
 
+    pWti->iRetryElem = 0;
+    pWti->bRetryMayPark = actionRetryMayPark(pAction, pWti);
     wtiResetExecState(pWti, pBatch);
     /* indicate we have not yet read the date */
     ttNow.year = 0;
@@ -1752,15 +2341,24 @@ static rsRetVal ATTR_NONNULL() processBatchMain(void *__restrict__ const pVoid,
         ABORT_FINALIZE(RS_RET_DISABLE_ACTION);
     }
 
-    for (i = 0; i < batchNumMsgs(pBatch) && !*pWti->pbShutdownImmediate; ++i) {
+    for (i = iFirst; i < batchNumMsgs(pBatch) && !*pWti->pbShutdownImmediate; ++i) {
         if (batchIsValidElem(pBatch, i)) {
+            const int nParams = pAction->isTransactional ? pWti->actWrkrInfo[pAction->iActionNbr].p.tx.currIParam : 0;
             /* we do not check error state below, because aborting would be
              * more harmful than continuing.
              */
             rsRetVal localRet = processMsgMain(pAction, pWti, pBatch->pElem[i].pMsg, &ttNow);
             DBGPRINTF("processBatchMain: i %d, processMsgMain iRet %d\n", i, localRet);
-            if (localRet == RS_RET_OK || localRet == RS_RET_DEFER_COMMIT || localRet == RS_RET_ACTION_FAILED ||
-                localRet == RS_RET_PREVIOUS_COMMITTED) {
+            if (localRet == RS_RET_RETRY_PARKED) {
+                if (pAction->isTransactional && pWti->actWrkrInfo[pAction->iActionNbr].p.tx.currIParam > nParams) {
+                    /* parked in an auto-commit: the message waits for the commit */
+                    batchSetElemState(pBatch, i, BATCH_STATE_COMM);
+                    ++i;
+                }
+                pWti->iRetryElem = i;
+                ABORT_FINALIZE(RS_RET_RETRY_PARKED);
+            } else if (localRet == RS_RET_OK || localRet == RS_RET_DEFER_COMMIT || localRet == RS_RET_ACTION_FAILED ||
+                       localRet == RS_RET_PREVIOUS_COMMITTED) {
                 batchSetElemState(pBatch, i, BATCH_STATE_COMM);
                 DBGPRINTF("processBatchMain: i %d, COMM state set\n", i);
             } else if (localRet == RS_RET_DISABLE_ACTION) {
@@ -1771,8 +2369,12 @@ static rsRetVal ATTR_NONNULL() processBatchMain(void *__restrict__ const pVoid,
     }
 
     iRet = actionCommit(pAction, pWti);
+    if (iRet == RS_RET_RETRY_PARKED) {
+        pWti->iRetryElem = batchNumMsgs(pBatch); /* only the commit is left */
+    }
 
 finalize_it:
+    pWti->bRetryMayPark = 0;
     RETiRet;
 }
 
@@ -2144,6 +2746,14 @@ static rsRetVal actionApplyCnfParam(action_t *const pAction, struct cnfparamvals
             pAction->iResumeInterval = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "action.resumeintervalmax")) {
             pAction->iResumeIntervalMax = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.maxinflight")) {
+            pAction->iMaxInFlight = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.batch.targetlatency")) {
+            pAction->iBatchTargetLatency = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.batch.minsize")) {
+            pAction->iBatchMinSize = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "action.batch.maxsize")) {
+            pAction->iBatchMaxSize = pvals[i].val.d.n;
         } else {
             dbgprintf(
                 "action: program error, non-handled "
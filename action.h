@@ -71,6 +71,14 @@ struct action_s {
     int bDisabled; /* disable flag; accessed atomically via mutCAS helper */
     sbool isTransactional;
     sbool bCopyMsg;
+    int iMaxInFlight; /* max async transactions in flight per worker, 0 = synchronous commit */
+    /* adaptive commit size (action.batch.*), used only if iBatchTargetLatency > 0 */
+    int iBatchTargetLatency; /* target commit latency in ms */
+    int iBatchMinSize;
+    int iBatchMaxSize; /* 0 = bounded by dequeue batch size only */
+    int iBatchCurSize; /* current commit size, protected by mutBatchSize */
+    int iBatchLatency; /* smoothed observed commit latency in ms, for stats */
+    pthread_mutex_t mutBatchSize;
     int iSecsExecOnceInterval; /* if non-zero, minimum seconds to wait until action is executed again */
     time_t ttResumeRtry; /* when is it time to retry the resume? */
     int iResumeInterval; /* resume interval for this action */
@@ -115,6 +123,11 @@ struct action_s {
     STATSCOUNTER_DEF(ctrSuspend, mutCtrSuspend)
     STATSCOUNTER_DEF(ctrSuspendDuration, mutCtrSuspendDuration)
     STATSCOUNTER_DEF(ctrResume, mutCtrResume)
+    /* only registered if asynchronous commit is enabled (action.maxInFlight) */
+    STATSCOUNTER_DEF(ctrAsyncSubmitted, mutCtrAsyncSubmitted)
+    STATSCOUNTER_DEF(ctrAsyncRetried, mutCtrAsyncRetried)
+    /* only registered if adaptive commit size is enabled */
+    STATSCOUNTER_DEF(ctrBatchCommits, mutCtrBatchCommits)
 };
 
 static inline int actionLoadDisabled(action_t *const pAction) {
@@ -187,6 +200,29 @@ void actionCommitAllDirect(wti_t *pWti);
 /** Remove a worker instance from the action's bookkeeping. */
 void actionRemoveWorker(action_t *const pAction, void *const actWrkrData);
 
+/**
+ * Wait up to @p timeoutMs for asynchronous transactions of all actions of
+ * worker @p pWti and process their completions.
+ */
+void actionAsyncTxPollAll(wti_t *pWti, int timeoutMs);
+
+/**
+ * Output module callback (host entry point "actionAsyncTxNotify"): tell the
+ * worker owning @p txCookie that the transaction completed, so that it calls
+ * pollTransactions(). May be called from any thread.
+ */
+rsRetVal actionAsyncTxNotify(void *const txCookie);
+
+/**
+ * Wait for all asynchronous transactions of this worker to complete. Called
+ * before the worker instance is freed. If shutdown does not permit waiting,
+ * outstanding batches are committed synchronously.
+ */
+void actionAsyncTxDrain(action_t *const pAction, wti_t *const pWti);
+
+/** Free asynchronous transaction state after the worker instance was freed. */
+void actionAsyncTxFree(action_t *const pAction, wti_t *const pWti);
+
 /** Release parameter memory allocated by prepareDoActionParams(). */
 void releaseDoActionParams(action_t *const pAction, wti_t *const pWti, int action_destruct);
 
@@ -85,10 +85,10 @@ extern int yyerror(const char*);
 %token <s> BSD_TAG_SELECTOR
 %token <s> BSD_HOST_SELECTOR
 %token <s> RELOAD_LOOKUP_TABLE_PROCEDURE
-%token IF
+%token <n> IF
 %token THEN
 %token ELSE
-%token FOREACH
+%token <n> FOREACH
 %token ITERATOR_ASSIGNMENT
 %token DO
 %token OR
@@ -168,14 +168,17 @@ script:	  stmt				{ $$ = $1; }
 	| script stmt			{ $$ = scriptAddStmt($1, $2); }
 stmt:	  actlst			{ $$ = $1; }
 	| IF expr THEN block 		{ $$ = cnfstmtNew(S_IF);
+					  $$->lineno = $1;
 					  $$->d.s_if.expr = $2;
 					  $$->d.s_if.t_then = $4;
 					  $$->d.s_if.t_else = NULL; }
 	| IF expr THEN block ELSE block	{ $$ = cnfstmtNew(S_IF);
+					  $$->lineno = $1;
 					  $$->d.s_if.expr = $2;
 					  $$->d.s_if.t_then = $4;
 					  $$->d.s_if.t_else = $6; }
 	| FOREACH iterator_decl DO block { $$ = cnfstmtNew(S_FOREACH);
+					  $$->lineno = $1;
 					  $$->d.s_foreach.iter = $2;
 					  $$->d.s_foreach.body = $4;}
 	| RESET VAR '=' expr ';'	{ $$ = cnfstmtNewSet($2, $4, 1); }
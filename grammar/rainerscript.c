@@ -55,6 +55,8 @@
 #include "wti.h"
 #include "unicode-helper.h"
 #include "errmsg.h"
+#include "scriptprof.h"
+#include "jsonlazy.h"
 
 PRAGMA_IGNORE_Wswitch_enum
 
@@ -1795,6 +1797,15 @@ static es_str_t *doFuncReplace(struct svar *__restrict__ const operandVal,
 }
 
 
+/* the worker's tokener for parse_json(), created on first use and kept
+ * for the lifetime of the worker. NULL if out of memory.
+ */
+static struct json_tokener *getParseJsonTokener(wti_t *const pWti) {
+    if (pWti->jsonTokener == NULL) pWti->jsonTokener = json_tokener_new();
+    return pWti->jsonTokener;
+}
+
+
 static void ATTR_NONNULL() doFunc_parse_json(struct cnffunc *__restrict__ const func,
                                              struct svar *__restrict__ const ret,
                                              void *const usrptr,
@@ -1808,17 +1819,31 @@ static void ATTR_NONNULL() doFunc_parse_json(struct cnffunc *__restrict__ const
     char *jsontext = (char *)var2CString(&srcVal[0], &bMustFree);
     char *container = (char *)var2CString(&srcVal[1], &bMustFree2);
     struct json_object *json;
+    struct json_tokener *const tokener = getParseJsonTokener(pWti);
 
     int retVal;
     assert(jsontext != NULL);
     assert(container != NULL);
     assert(pMsg != NULL);
 
-    struct json_tokener *const tokener = json_tokener_new();
     if (tokener == NULL) {
         retVal = 1;
         goto finalize_it;
     }
+
+    if (func->funcdata != NULL) { /* lazy mode */
+        if (jsonlazyParse(func->funcdata, tokener, jsontext, strlen(jsontext), &json) == RS_RET_OK) {
+            size_t off = (*container == '$') ? 1 : 0;
+            msgAddJSON(pMsg, (uchar *)container + off, json, 0, 0);
+            retVal = RS_SCRIPT_EOK;
+        } else {
+            retVal = RS_SCRIPT_EINVAL;
+        }
+        wtiSetScriptErrno(pWti, retVal);
+        goto finalize_it;
+    }
+
+    json_tokener_reset(tokener);
     json = json_tokener_parse_ex(tokener, jsontext, strlen(jsontext));
     if (json == NULL) {
         retVal = RS_SCRIPT_EINVAL;
@@ -1839,7 +1864,6 @@ static void ATTR_NONNULL() doFunc_parse_json(struct cnffunc *__restrict__ const
         }
     }
     wtiSetScriptErrno(pWti, retVal);
-    json_tokener_free(tokener);
 
 
 finalize_it:
@@ -2875,6 +2899,10 @@ static void ATTR_NONNULL() doFuncCall(struct cnffunc *__restrict__ const func,
     if (func->fPtr == NULL) {
         ret->datatype = 'N';
         ret->d.n = 0;
+    } else if (func->prof != NULL) {
+        const uint64_t start = scriptprofGetTicks();
+        func->fPtr(func, ret, usrptr, pWti);
+        scriptprofRecord(func->prof, start, 1);
     } else {
         func->fPtr(func, ret, usrptr, pWti);
     }
@@ -3781,6 +3809,46 @@ finalize_it:
     RETiRet;
 }
 
+/* parse_json() with the optional third parameter "lazy" only materializes
+ * top-level members that the config references (see jsonlazy.h). This
+ * requires the container to be a constant, as it must be known when the
+ * references are resolved.
+ */
+static rsRetVal initFunc_parse_json(struct cnffunc *func) {
+    char *mode = NULL;
+    char *container = NULL;
+    DEFiRet;
+
+    func->funcdata = NULL;
+    if (func->nParams != 3) FINALIZE;
+
+    if (func->expr[2]->nodetype != 'S') {
+        parser_errmsg("parse_json(): param 3 must be a constant string");
+        ABORT_FINALIZE(RS_RET_CONFIG_ERROR);
+    }
+    CHKmalloc(mode = es_str2cstr(((struct cnfstringval *)func->expr[2])->estr, NULL));
+    if (!strcmp(mode, "full")) FINALIZE;
+    if (strcmp(mode, "lazy")) {
+        parser_errmsg("parse_json(): invalid mode '%s', must be \"lazy\" or \"full\"", mode);
+        ABORT_FINALIZE(RS_RET_CONFIG_ERROR);
+    }
+    if (func->expr[1]->nodetype != 'S') {
+        parser_warnmsg("parse_json(): lazy mode requires a constant container name - doing full parse");
+        FINALIZE;
+    }
+    CHKmalloc(container = es_str2cstr(((struct cnfstringval *)func->expr[1])->estr, NULL));
+    CHKiRet(jsonlazyRegister((uchar *)container, (jsonlazy_keys_t **)&func->funcdata));
+
+finalize_it:
+    free(mode);
+    free(container);
+    RETiRet;
+}
+
+static void parse_json_destruct(struct cnffunc *func) {
+    jsonlazyKeysDestruct((jsonlazy_keys_t **)&func->funcdata);
+}
+
 static rsRetVal initFunc_prifilt(struct cnffunc *func) {
     struct funcData_prifilt *pData;
     uchar *cstr;
@@ -3877,7 +3945,7 @@ static struct scriptFunct functions[] = {
     {"format_time", 2, 2, doFunct_FormatTime, NULL, NULL},
     {"parse_time", 1, 1, doFunct_ParseTime, NULL, NULL},
     {"is_time", 1, 2, doFunct_IsTime, NULL, NULL},
-    {"parse_json", 2, 2, doFunc_parse_json, NULL, NULL},
+    {"parse_json", 2, 3, doFunc_parse_json, initFunc_parse_json, parse_json_destruct},
     {"get_property", 2, 2, doFunc_get_property, NULL, NULL},
     {"script_error", 0, 0, doFunct_ScriptError, NULL, NULL},
     {"previous_action_suspended", 0, 0, doFunct_PreviousActionSuspended, NULL, NULL},
@@ -3957,6 +4025,7 @@ static void cnffuncDestruct(struct cnffunc *func) {
     if (func->destructable_funcdata) {
         free(func->funcdata);
     }
+    free(func->srcfile);
     free(func->fname);
 }
 
@@ -4419,12 +4488,23 @@ struct cnfvar *cnfvarNew(char *name) {
     return var;
 }
 
+/* the config file name is only needed to label script profiler counters,
+ * so we do not keep a copy per statement if profiling is off.
+ */
+static char *cnfSrcfileDup(void) {
+    if (cnfcurrfn == NULL || !loadConf->globals.bScriptProfiling) return NULL;
+    return strdup(cnfcurrfn);
+}
+
 struct cnfstmt *cnfstmtNew(unsigned s_type) {
     struct cnfstmt *cnfstmt;
     if ((cnfstmt = malloc(sizeof(struct cnfstmt))) != NULL) {
         cnfstmt->nodetype = s_type;
         cnfstmt->printable = NULL;
         cnfstmt->next = NULL;
+        cnfstmt->srcfile = cnfSrcfileDup();
+        cnfstmt->lineno = yylineno;
+        cnfstmt->prof = NULL;
     }
     return cnfstmt;
 }
@@ -4502,6 +4582,7 @@ static void cnfstmtDestruct(struct cnfstmt *stmt) {
             break;
     }
     free(stmt->printable);
+    free(stmt->srcfile);
     free(stmt);
 }
 
@@ -5183,6 +5264,7 @@ static void cnfstmtOptimizePRIFilt(struct cnfstmt *stmt) {
     for (last = subroot; last->next != NULL; last = last->next) /* find last node in subtree */
         ;
     last->next = stmt->next;
+    free(stmt->srcfile);
     memcpy(stmt, subroot, sizeof(struct cnfstmt));
     free(subroot);
 
@@ -5283,6 +5365,250 @@ done:
 }
 
 
+static const char *cnfstmtKindName(const unsigned nodetype) {
+    switch (nodetype) {
+        case S_IF:
+            return "if";
+        case S_FOREACH:
+            return "foreach";
+        case S_SET:
+            return "set";
+        case S_UNSET:
+            return "unset";
+        case S_CALL:
+            return "call";
+        case S_CALL_INDIRECT:
+            return "call_indirect";
+        case S_PRIFILT:
+            return "prifilt";
+        case S_PROPFILT:
+            return "propfilt";
+        case S_RELOAD_LOOKUP_TABLE:
+            return "reload_lookup_table";
+        default:
+            return "unknown";
+    }
+}
+
+/* register profiling counters for all function calls inside an expression */
+static rsRetVal cnfexprProfileRegister(struct cnfexpr *const expr) {
+    DEFiRet;
+
+    if (expr == NULL) FINALIZE;
+    switch (expr->nodetype) {
+        case CMP_NE:
+        case CMP_EQ:
+        case CMP_LE:
+        case CMP_GE:
+        case CMP_LT:
+        case CMP_GT:
+        case CMP_STARTSWITH:
+        case CMP_ENDSWITH:
+        case CMP_STARTSWITHI:
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+        case OR:
+        case AND:
+        case '&':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            CHKiRet(cnfexprProfileRegister(expr->l));
+            CHKiRet(cnfexprProfileRegister(expr->r));
+            break;
+        case NOT:
+        case 'M':
+            CHKiRet(cnfexprProfileRegister(expr->r));
+            break;
+        case 'F': {
+            struct cnffunc *const func = (struct cnffunc *)expr;
+            char kind[256];
+            char *const fname = es_str2cstr(func->fname, NULL);
+            snprintf(kind, sizeof(kind), "%s()", (fname == NULL) ? "?" : fname);
+            free(fname);
+            CHKiRet(scriptprofRegister(kind, func->srcfile, func->lineno, &func->prof));
+            for (unsigned short i = 0; i < func->nParams; ++i) {
+                CHKiRet(cnfexprProfileRegister(func->expr[i]));
+            }
+            break;
+        }
+        default: /* constants, variables, exists(): nothing to profile */
+            break;
+    }
+finalize_it:
+    RETiRet;
+}
+
+
+/* Register profiling counters for a statement list, its sub-statements and
+ * all function calls contained in it. Must be called after the optimizer
+ * run, as the optimizer may change statement types and replace expressions.
+ * Called rulesets are registered on their own, so we do not follow calls.
+ */
+rsRetVal cnfstmtProfileRegister(struct cnfstmt *const root) {
+    char kind[256];
+    DEFiRet;
+
+    for (struct cnfstmt *stmt = root; stmt != NULL; stmt = stmt->next) {
+        if (stmt->nodetype == S_NOP || stmt->nodetype == S_STOP) continue;
+        if (stmt->nodetype == S_ACT) {
+            snprintf(kind, sizeof(kind), "action(%s)",
+                     (stmt->d.act->pszName == NULL) ? "-" : (char *)stmt->d.act->pszName);
+        } else {
+            snprintf(kind, sizeof(kind), "%s", cnfstmtKindName(stmt->nodetype));
+        }
+        CHKiRet(scriptprofRegister(kind, stmt->srcfile, stmt->lineno, &stmt->prof));
+
+        switch (stmt->nodetype) {
+            case S_IF:
+                CHKiRet(cnfexprProfileRegister(stmt->d.s_if.expr));
+                CHKiRet(cnfstmtProfileRegister(stmt->d.s_if.t_then));
+                CHKiRet(cnfstmtProfileRegister(stmt->d.s_if.t_else));
+                break;
+            case S_FOREACH:
+                CHKiRet(cnfexprProfileRegister(stmt->d.s_foreach.iter->collection));
+                CHKiRet(cnfstmtProfileRegister(stmt->d.s_foreach.body));
+                break;
+            case S_PRIFILT:
+                CHKiRet(cnfstmtProfileRegister(stmt->d.s_prifilt.t_then));
+                CHKiRet(cnfstmtProfileRegister(stmt->d.s_prifilt.t_else));
+                break;
+            case S_PROPFILT:
+                CHKiRet(cnfstmtProfileRegister(stmt->d.s_propfilt.t_then));
+                break;
+            case S_SET:
+                CHKiRet(cnfexprProfileRegister(stmt->d.s_set.expr));
+                break;
+            case S_CALL_INDIRECT:
+                CHKiRet(cnfexprProfileRegister(stmt->d.s_call_ind.expr));
+                break;
+            default:
+                break;
+        }
+    }
+finalize_it:
+    RETiRet;
+}
+
+
+/* account a variable name as used by set/unset/foreach, e.g. "!a!b" */
+static void cnfvarnameCollectJSONRefs(const char *const name, jsonlazy_keys_t *const pKeys) {
+    propid_t id;
+
+    if (name == NULL) return;
+    switch (name[0]) {
+        case '!':
+            id = PROP_CEE;
+            break;
+        case '.':
+            id = PROP_LOCAL_VAR;
+            break;
+        case '/':
+            id = PROP_GLOBAL_VAR;
+            break;
+        default:
+            return;
+    }
+    jsonlazyAddRef(pKeys, id, (const uchar *)name);
+}
+
+/* collect all variable references inside an expression for lazy JSON parsing */
+static void cnfexprCollectJSONRefs(struct cnfexpr *const expr, jsonlazy_keys_t *const pKeys) {
+    if (expr == NULL) return;
+    switch (expr->nodetype) {
+        case 'V': {
+            struct cnfvar *const var = (struct cnfvar *)expr;
+            jsonlazyAddRef(pKeys, var->prop.id, var->prop.name);
+            break;
+        }
+        case 'E': {
+            struct cnffuncexists *const ex = (struct cnffuncexists *)expr;
+            jsonlazyAddRef(pKeys, ex->prop.id, ex->prop.name);
+            break;
+        }
+        case 'F': {
+            struct cnffunc *const func = (struct cnffunc *)expr;
+            for (unsigned short i = 0; i < func->nParams; ++i) {
+                cnfexprCollectJSONRefs(func->expr[i], pKeys);
+            }
+            break;
+        }
+        case CMP_NE:
+        case CMP_EQ:
+        case CMP_LE:
+        case CMP_GE:
+        case CMP_LT:
+        case CMP_GT:
+        case CMP_STARTSWITH:
+        case CMP_ENDSWITH:
+        case CMP_STARTSWITHI:
+        case CMP_CONTAINS:
+        case CMP_CONTAINSI:
+        case OR:
+        case AND:
+        case '&':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            cnfexprCollectJSONRefs(expr->l, pKeys);
+            cnfexprCollectJSONRefs(expr->r, pKeys);
+            break;
+        case NOT:
+        case 'M':
+            cnfexprCollectJSONRefs(expr->r, pKeys);
+            break;
+        default: /* constants */
+            break;
+    }
+}
+
+
+/* Collect all message variable references of a statement list for lazy
+ * JSON parsing (see jsonlazy.h). Like the profiler, this must run after
+ * the optimizer. Called rulesets are walked on their own.
+ */
+void cnfstmtCollectJSONRefs(struct cnfstmt *const root, jsonlazy_keys_t *const pKeys) {
+    for (struct cnfstmt *stmt = root; stmt != NULL; stmt = stmt->next) {
+        switch (stmt->nodetype) {
+            case S_IF:
+                cnfexprCollectJSONRefs(stmt->d.s_if.expr, pKeys);
+                cnfstmtCollectJSONRefs(stmt->d.s_if.t_then, pKeys);
+                cnfstmtCollectJSONRefs(stmt->d.s_if.t_else, pKeys);
+                break;
+            case S_FOREACH:
+                cnfvarnameCollectJSONRefs(stmt->d.s_foreach.iter->var, pKeys);
+                cnfexprCollectJSONRefs(stmt->d.s_foreach.iter->collection, pKeys);
+                cnfstmtCollectJSONRefs(stmt->d.s_foreach.body, pKeys);
+                break;
+            case S_PRIFILT:
+                cnfstmtCollectJSONRefs(stmt->d.s_prifilt.t_then, pKeys);
+                cnfstmtCollectJSONRefs(stmt->d.s_prifilt.t_else, pKeys);
+                break;
+            case S_PROPFILT:
+                jsonlazyAddRef(pKeys, stmt->d.s_propfilt.prop.id, stmt->d.s_propfilt.prop.name);
+                cnfstmtCollectJSONRefs(stmt->d.s_propfilt.t_then, pKeys);
+                break;
+            case S_SET:
+                cnfvarnameCollectJSONRefs((char *)stmt->d.s_set.varname, pKeys);
+                cnfexprCollectJSONRefs(stmt->d.s_set.expr, pKeys);
+                break;
+            case S_UNSET:
+                cnfvarnameCollectJSONRefs((char *)stmt->d.s_unset.varname, pKeys);
+                break;
+            case S_CALL_INDIRECT:
+                cnfexprCollectJSONRefs(stmt->d.s_call_ind.expr, pKeys);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+
 struct cnffparamlst *cnffparamlstNew(struct cnfexpr *expr, struct cnffparamlst *next) {
     struct cnffparamlst *lst;
     if ((lst = malloc(sizeof(struct cnffparamlst))) != NULL) {
@@ -5348,6 +5674,9 @@ struct cnffunc *cnffuncNew(es_str_t *fname, struct cnffparamlst *paramlst) {
         func->nParams = nParams;
         func->funcdata = NULL;
         func->destructable_funcdata = 1;
+        func->srcfile = cnfSrcfileDup();
+        func->lineno = yylineno;
+        func->prof = NULL;
         cstr = es_str2cstr(fname, NULL);
         func->fPtr = funcName2Ptr(cstr, nParams);
 
@@ -5394,6 +5723,9 @@ struct cnffunc *cnffuncNew_prifilt(int fac) {
         func->nParams = 0;
         func->fPtr = doFunct_Prifilt;
         func->destructable_funcdata = 1;
+        func->srcfile = NULL;
+        func->lineno = 0;
+        func->prof = NULL;
         ((struct funcData_prifilt *)func->funcdata)->pmask[fac] = TABLE_ALLPRI;
     }
     return func;
@@ -130,6 +130,9 @@ struct cnfstmt {
     unsigned nodetype;
     struct cnfstmt *next;
     uchar *printable; /* printable text for debugging */
+    char *srcfile; /* config file this statement was defined in (NULL if unknown) */
+    int lineno; /* line inside srcfile */
+    scriptprof_ctr_t *prof; /* profiling counters, NULL if profiling is disabled */
     union {
         struct {
             struct cnfexpr *expr;
@@ -263,6 +266,9 @@ struct cnffunc {
     rscriptFuncPtr fPtr;
     void *funcdata; /* global data for function-specific use (e.g. compiled regex) */
     uint8_t destructable_funcdata;
+    char *srcfile; /* config file of the call site (NULL if unknown) */
+    int lineno; /* line of the call site inside srcfile */
+    scriptprof_ctr_t *prof; /* profiling counters, NULL if profiling is disabled */
     struct cnfexpr *expr[];
 } __attribute__((aligned(8)));
 
@@ -426,6 +432,8 @@ struct cnfstmt *cnfstmtNewContinue(void);
 struct cnfstmt *cnfstmtNewReloadLookupTable(struct cnffparamlst *fparams);
 void cnfstmtDestructLst(struct cnfstmt *root);
 struct cnfstmt *cnfstmtOptimize(struct cnfstmt *root);
+rsRetVal cnfstmtProfileRegister(struct cnfstmt *root);
+void cnfstmtCollectJSONRefs(struct cnfstmt *root, jsonlazy_keys_t *pKeys);
 struct cnfarray *cnfarrayNew(es_str_t *val);
 struct cnfarray *cnfarrayDup(struct cnfarray *old);
 struct cnfarray *cnfarrayAdd(struct cnfarray *ar, es_str_t *val);
@@ -38,6 +38,10 @@
 #include <poll.h>
 #include <json.h>
 #include <fnmatch.h>
+#include <stdint.h>
+#ifdef HAVE_SYS_PRCTL_H
+    #include <sys/prctl.h>
+#endif
 #ifdef HAVE_SYS_INOTIFY_H
     #include <sys/inotify.h>
     #include <linux/types.h>
@@ -66,6 +70,8 @@
 #include "srUtils.h"
 #include "parserif.h"
 #include "datetime.h"
+#include "hashtable.h"
+#include "statestore.h"
 
 #include <regex.h>
 
@@ -100,7 +106,10 @@ static int bLegacyCnfModGlobalsPermitted; /* are legacy module-global config par
 
 #define NUM_MULTISUB 1024 /* default max number of submits */
 #define DFLT_PollInterval 10
-#define INIT_WDMAP_TAB_SIZE 1 /* default wdMap table size - is extended as needed, use 2^x value */
+#define INIT_WDMAP_TAB_SIZE 64 /* initial wdMap table size - is extended as needed */
+#define INIT_ACTIDX_TAB_SIZE 16 /* initial size of an edge's active object index */
+#define INOTIFY_BUF_SIZE 8192 /* size of buffer for reading inotify events */
+#define DFLT_READER_MAX_LINES 1024 /* lines read from a file per turn of a reader thread, if not configured */
 #define ADD_METADATA_UNSPECIFIED -1
 
 /* If set to 1, fileTableDisplay will be compiled and used for debugging */
@@ -119,6 +128,7 @@ struct per_minute_rate_limit_s {
     uint64_t bytesThisMinute; /* bytes sent so far this minute */
     uint32_t linesThisMinute; /* lines sent to far this minute */
     time_t rateLimitingMinute; /* minute we are currently rate limiting for */
+    pthread_mutex_t mut; /* files of an instance may be read by different reader threads */
 };
 
 static struct configSettings_s {
@@ -166,6 +176,7 @@ struct instanceConf_s {
     sbool msgDiscardingError;
     sbool escapeLF;
     sbool reopenOnTruncate;
+    sbool bMmap; /* read the file through mmap() */
     sbool addCeeTag;
     sbool addMetadata;
     sbool freshStartTail;
@@ -191,6 +202,7 @@ struct act_obj_s {
     char *name; /* full path name of active object */
     char *basename; /* only basename */  // TODO: remove when refactoring rename support
     char *source_name; /* if this object is target of a symlink, source_name is its name (else NULL) */
+    act_obj_t *nextSameName; /* next object with the same name in the edge's index (symlink targets) */
     int wd;
 #if defined(OS_SOLARIS) && defined(HAVE_PORT_SOURCE_FILE)
     struct fileinfo *pfinf;
@@ -210,6 +222,10 @@ struct act_obj_s {
     multi_submit_t multiSub;
     int is_symlink;
     time_t time_to_delete; /* Helper variable to DELAY the actual file delete in act_obj_unlink */
+    /* reader thread scheduling, protected by readerPool.mut */
+    act_obj_t *readPrev; /* reader queue linkage */
+    act_obj_t *readNext;
+    uint8_t readState; /* ACT_READ_* */
 };
 struct fs_edge_s {
     fs_node_t *parent; /* node pointing to this edge */
@@ -218,6 +234,7 @@ struct fs_edge_s {
     uchar *name;
     uchar *path;
     act_obj_t *active;
+    struct hashtable *actIdx; /* name -> active object, created on first use */
     int is_file;
     int ninst; /* nbr of instances in instarr */
     instanceConf_t **instarr;
@@ -228,15 +245,30 @@ struct fs_node_s {
 };
 
 
+/* read state of an active object, see scheduleRead() */
+#define ACT_READ_IDLE 0 /* not in reader queue, no reader thread working on it */
+#define ACT_READ_QUEUED 1 /* waiting in reader queue */
+#define ACT_READ_ACTIVE 2 /* a reader thread is reading it */
+#define ACT_READ_AGAIN 3 /* as ACT_READ_ACTIVE, but new data arrived meanwhile */
+
+
 /* forward definitions */
 static rsRetVal persistStrmState(act_obj_t *);
 static rsRetVal resetConfigVariables(uchar __attribute__((unused)) * pp, void __attribute__((unused)) * pVal);
 static rsRetVal ATTR_NONNULL(1) pollFile(act_obj_t *act);
+static rsRetVal ATTR_NONNULL(1) pollFileLimited(act_obj_t *act, int maxLines);
+static rsRetVal ATTR_NONNULL(1) openFile(act_obj_t *act);
+static void ATTR_NONNULL() scheduleRead(act_obj_t *act);
+static void ATTR_NONNULL() unscheduleRead(act_obj_t *act);
+#ifdef HAVE_INOTIFY_INIT
+static void ATTR_NONNULL() scheduleReadIfTimedOut(act_obj_t *act);
+#endif
 static int ATTR_NONNULL() getBasename(uchar *const __restrict__ basen, uchar *const __restrict__ path);
 static void ATTR_NONNULL() act_obj_unlink(act_obj_t *act);
 static uchar *ATTR_NONNULL(1, 2) getStateFileName(const act_obj_t *, uchar *, const size_t);
 static int ATTR_NONNULL()
     getFullStateFileName(const uchar *const, const char *const, uchar *const pszout, const size_t ilenout);
+static void ATTR_NONNULL() removeStoredState(const uchar *const statefn, const char *const file_id);
 
 
 #define OPMODE_POLLING 0
@@ -258,6 +290,10 @@ struct modConfData_s {
     sbool sortFiles;
     sbool normalizePath; /* normalize file system pathes (all start with root dir) */
     sbool haveReadTimeouts; /* use special processing if read timeouts exist */
+    int nReaderThreads; /* nbr of threads reading files, 0: read on input thread (inotify mode only) */
+    uchar *pszStateStore; /* state store file, NULL: one state file per monitored file */
+    int iStateStoreCommitInterval; /* ms */
+    statestore_t *pStateStore; /* open state store, if configured */
     sbool bHadFileData; /* actually a global variable:
                    1 - last call to pollFile() had data
                    0 - last call to pollFile() had NO data
@@ -272,23 +308,39 @@ static modConfData_t *currModConf = NULL; /* modConf ptr to CURRENT mod conf (ru
 
 #ifdef HAVE_INOTIFY_INIT
 /* We need to map watch descriptors to our actual objects. Unfortunately, the
- * inotify API does not provide us with any cookie, so a simple O(1) algorithm
- * cannot be done (what a shame...). We assume that maintaining the array is much
- * less often done than looking it up, so we keep the array sorted by watch descriptor
- * and do a binary search on the wd we get back. This is at least O(log n), which
- * is not too bad for the anticipated use case.
+ * inotify API does not provide us with any cookie, so we keep a hash table
+ * wd -> active object. Watches come and go with the monitored files, so with
+ * many files (e.g. container logs) adding and removing must be cheap as well
+ * as looking up; a hash table is O(1) for all of them.
  */
-struct wd_map_s {
-    int wd; /* ascending sort key */
-    act_obj_t *act; /* point to related active object */
-};
-typedef struct wd_map_s wd_map_t;
-static wd_map_t *wdmap = NULL;
-static int nWdmap;
-static int allocMaxWdmap;
+static struct hashtable *wdmap = NULL;
 static int ino_fd; /* fd for inotify calls */
 #endif /* #if HAVE_INOTIFY_INIT -------------------------------------------------- */
 
+/* reader threads, see scheduleRead() */
+static struct {
+    pthread_mutex_t mut;
+    pthread_cond_t wakeup; /* signaled when a file is queued or the pool shall stop */
+    pthread_cond_t readDone; /* signaled when a reader thread finished a turn */
+    act_obj_t *head; /* reader queue */
+    act_obj_t *tail;
+    int nThreads; /* 0 if the pool is not running */
+    pthread_t *tids;
+    sbool bStop;
+} readerPool;
+
+/* state files whose state has been moved into the state store. They are
+ * removed once a commit made their states durable, so that migrating many
+ * files costs a single commit. Files may be opened by reader threads, so the
+ * list is protected by a mutex.
+ */
+static struct {
+    pthread_mutex_t mut;
+    char **names;
+    int nNames;
+    int maxNames;
+} migratedStateFiles = {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0};
+
 #if defined(OS_SOLARIS) && defined(HAVE_PORT_SOURCE_FILE)
 struct fileinfo {
     struct file_obj fobj;
@@ -312,6 +364,9 @@ static struct cnfparamdescr modpdescr[] = {
     {"normalizepath", eCmdHdlrBinary, 0},
     {"mode", eCmdHdlrGetWord, 0},
     {"deletestateonfilemove", eCmdHdlrBinary, 0},
+    {"readerthreads", eCmdHdlrNonNegInt, 0},
+    {"statestore", eCmdHdlrString, 0},
+    {"statestore.commitinterval", eCmdHdlrPositiveInt, 0},
 };
 static struct cnfparamblk modpblk = {CNFPARAMBLK_VERSION, sizeof(modpdescr) / sizeof(struct cnfparamdescr), modpdescr};
 
@@ -330,6 +385,7 @@ static struct cnfparamdescr inppdescr[] = {
     {"escapelf", eCmdHdlrBinary, 0},
     {"escapelf.replacement", eCmdHdlrString, 0},
     {"reopenontruncate", eCmdHdlrBinary, 0},
+    {"mmap", eCmdHdlrBinary, 0},
     {"maxlinesatonce", eCmdHdlrInt, 0},
     {"trimlineoverbytes", eCmdHdlrInt, 0},
     {"maxsubmitatonce", eCmdHdlrInt, 0},
@@ -451,57 +507,44 @@ finalize_it:
 
 
 #ifdef HAVE_INOTIFY_INIT
-    #if ULTRA_DEBUG == 1
-static void dbg_wdmapPrint(const char *msg) {
-    int i;
-    DBGPRINTF("%s\n", msg);
-    for (i = 0; i < nWdmap; ++i)
-        DBGPRINTF("wdmap[%d]: wd: %d, act %p, name: %s\n", i, wdmap[i].wd, wdmap[i].act, wdmap[i].act->name);
+static unsigned int wdmap_hash(void *k) {
+    return (unsigned int)*((int *)k);
+}
+
+static int wdmap_equals(void *key1, void *key2) {
+    return *((int *)key1) == *((int *)key2);
 }
-    #endif
 
 static rsRetVal wdmapInit(void) {
     DEFiRet;
-    free(wdmap);
-    CHKmalloc(wdmap = malloc(sizeof(wd_map_t) * INIT_WDMAP_TAB_SIZE));
-    allocMaxWdmap = INIT_WDMAP_TAB_SIZE;
-    nWdmap = 0;
+    if (wdmap != NULL) {
+        hashtable_destroy(wdmap, 0);
+    }
+    CHKmalloc(wdmap = create_hashtable(INIT_WDMAP_TAB_SIZE, wdmap_hash, wdmap_equals, NULL));
 finalize_it:
     RETiRet;
 }
 
 
-/* note: we search backwards, as inotify tends to return increasing wd's */
 static rsRetVal wdmapAdd(int wd, act_obj_t *const act) {
-    wd_map_t *newmap;
-    int newmapsize;
-    int i;
+    int *pKey = NULL;
     DEFiRet;
 
-    for (i = nWdmap - 1; i >= 0 && wdmap[i].wd > wd; --i); /* just scan */
-    if (i >= 0 && wdmap[i].wd == wd) {
+    if (hashtable_search(wdmap, &wd) != NULL) {
         LogError(0, RS_RET_INTERNAL_ERROR, "imfile: wd %d already in wdmap!", wd);
         ABORT_FINALIZE(RS_RET_FILE_ALREADY_IN_TABLE);
     }
-    ++i;
-    /* i now points to the entry that is to be moved upwards (or end of map) */
-    if (nWdmap == allocMaxWdmap) {
-        newmapsize = 2 * allocMaxWdmap;
-        CHKmalloc(newmap = realloc(wdmap, sizeof(wd_map_t) * newmapsize));
-        // TODO: handle the error more intelligently? At all possible? -- 2013-10-15
-        wdmap = newmap;
-        allocMaxWdmap = newmapsize;
+    CHKmalloc(pKey = malloc(sizeof(int)));
+    *pKey = wd;
+    if (!hashtable_insert(wdmap, pKey, act)) {
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
     }
-    if (i < nWdmap) {
-        /* we need to shift to make room for new entry */
-        memmove(wdmap + i + 1, wdmap + i, sizeof(wd_map_t) * (nWdmap - i));
-    }
-    wdmap[i].wd = wd;
-    wdmap[i].act = act;
-    ++nWdmap;
-    DBGPRINTF("add wdmap[%d]: wd %d, act obj %p, path %s\n", i, wd, act, act->name);
+    DBGPRINTF("add wdmap: wd %d, act obj %p, path %s\n", wd, act, act->name);
 
 finalize_it:
+    if (iRet != RS_RET_OK) {
+        free(pKey);
+    }
     RETiRet;
 }
 
@@ -527,44 +570,18 @@ done:
     return wd;
 }
 
-/* compare function for bsearch() */
-static int wdmap_cmp(const void *k, const void *a) {
-    int key = *((int *)k);
-    wd_map_t *etry = (wd_map_t *)a;
-    if (key < etry->wd)
-        return -1;
-    else if (key > etry->wd)
-        return 1;
-    else
-        return 0;
-}
-/* looks up a wdmap entry and returns it's index if found
- * or -1 if not found.
- */
-static wd_map_t *wdmapLookup(int wd) {
-    return bsearch(&wd, wdmap, nWdmap, sizeof(wd_map_t), wdmap_cmp);
+/* looks up the active object for a wd, NULL if not found */
+static act_obj_t *wdmapLookup(int wd) {
+    return hashtable_search(wdmap, &wd);
 }
 
 
-static rsRetVal wdmapDel(const int wd) {
-    int i;
-    DEFiRet;
-
-    for (i = 0; i < nWdmap && wdmap[i].wd < wd; ++i); /* just scan */
-    if (i == nWdmap || wdmap[i].wd != wd) {
+static void wdmapDel(int wd) {
+    if (hashtable_remove(wdmap, &wd) == NULL) {
         DBGPRINTF("wd %d shall be deleted but not in wdmap!\n", wd);
-        FINALIZE;
-    }
-
-    if (i < nWdmap - 1) {
-        /* we need to shift to delete it (see comment at wdmap definition) */
-        memmove(wdmap + i, wdmap + i + 1, sizeof(wd_map_t) * (nWdmap - i - 1));
+    } else {
+        DBGPRINTF("wd %d deleted\n", wd);
     }
-    --nWdmap;
-    DBGPRINTF("wd %d deleted, was idx %d\n", wd, i);
-
-finalize_it:
-    RETiRet;
 }
 
 #endif  // #ifdef HAVE_INOTIFY_INIT
@@ -669,6 +686,75 @@ static sbool isIgnoreOlderFile(const instanceConf_t *const inst, const char *con
     return 0;
 }
 
+/* The active objects of an edge are indexed by name, as an edge of a
+ * wildcard may match a very large number of files and each poll run needs to
+ * check every file found for whether it is already active. Names are unique
+ * except for symlink targets: these are kept once per symlink pointing to
+ * them (source_name), chained via nextSameName behind the indexed object.
+ */
+static act_obj_t *act_obj_find(const fs_edge_t *const edge, const char *const name, const char *const source) {
+    act_obj_t *act;
+
+    if (edge->actIdx == NULL) return NULL;
+    for (act = hashtable_search(edge->actIdx, (void *)name); act != NULL; act = act->nextSameName) {
+        if (!source || !act->source_name || !strcmp(act->source_name, source)) {
+            break;
+        }
+    }
+    return act;
+}
+
+static rsRetVal ATTR_NONNULL() act_obj_index(fs_edge_t *const edge, act_obj_t *const act) {
+    act_obj_t *first;
+    char *key = NULL;
+    DEFiRet;
+
+    if (edge->actIdx == NULL) {
+        CHKmalloc(edge->actIdx = create_hashtable(INIT_ACTIDX_TAB_SIZE, hash_from_string, key_equals_string, NULL));
+    }
+    first = hashtable_search(edge->actIdx, act->name);
+    if (first != NULL) {
+        act->nextSameName = first->nextSameName;
+        first->nextSameName = act;
+        FINALIZE;
+    }
+    CHKmalloc(key = strdup(act->name));
+    if (!hashtable_insert(edge->actIdx, key, act)) {
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    }
+    key = NULL;
+
+finalize_it:
+    free(key);
+    RETiRet;
+}
+
+static void ATTR_NONNULL() act_obj_unindex(fs_edge_t *const edge, act_obj_t *const act) {
+    act_obj_t *first;
+    act_obj_t *prev;
+    char *key;
+
+    if (edge->actIdx == NULL) return;
+    first = hashtable_search(edge->actIdx, act->name);
+    if (first == act) {
+        hashtable_remove(edge->actIdx, act->name);
+        if (act->nextSameName != NULL) {
+            /* promote the next object of that name; on failure it simply
+             * is no longer found and will be added again by a later poll.
+             */
+            if ((key = strdup(act->name)) == NULL || !hashtable_insert(edge->actIdx, key, act->nextSameName)) {
+                free(key);
+            }
+        }
+    } else {
+        for (prev = first; prev != NULL && prev->nextSameName != act; prev = prev->nextSameName); /* just scan */
+        if (prev != NULL) {
+            prev->nextSameName = act->nextSameName;
+        }
+    }
+    act->nextSameName = NULL;
+}
+
 /* add a new file system object if it not yet exists, ignore call
  * if it already does.
  */
@@ -689,13 +775,9 @@ static rsRetVal ATTR_NONNULL(1, 2) act_obj_add(fs_edge_t *const edge,
         ABORT_FINALIZE(RS_RET_ERR);
     }
 
-    for (act = edge->active; act != NULL; act = act->next) {
-        if (!strcmp(act->name, name)) {
-            if (!source || !act->source_name || !strcmp(act->source_name, source)) {
-                DBGPRINTF("active object '%s' already exists in '%s' - no need to add\n", name, edge->path);
-                FINALIZE;
-            }
-        }
+    if (act_obj_find(edge, name, source) != NULL) {
+        DBGPRINTF("active object '%s' already exists in '%s' - no need to add\n", name, edge->path);
+        FINALIZE;
     }
     DBGPRINTF("need to add new active object '%s' in '%s' - checking if accessible\n", name, edge->path);
     fd = open(name, O_RDONLY | O_CLOEXEC);
@@ -728,6 +810,7 @@ static rsRetVal ATTR_NONNULL(1, 2) act_obj_add(fs_edge_t *const edge,
     } else {
         act->source_name = NULL;
     }
+    CHKiRet(act_obj_index(edge, act));
 #ifdef HAVE_INOTIFY_INIT
     act->wd = in_setupWatch(act, is_file);
 #endif
@@ -738,7 +821,13 @@ static rsRetVal ATTR_NONNULL(1, 2) act_obj_add(fs_edge_t *const edge,
         CHKmalloc(act->multiSub.ppMsgs = malloc(inst->nMultiSub * sizeof(smsg_t *)));
         act->multiSub.maxElem = inst->nMultiSub;
         act->multiSub.nElem = 0;
-        pollFile(act);
+        if (readerPool.nThreads > 0) {
+            /* open it now, so that freshStartTail and the state file are
+             * applied while the initial poll run is in progress.
+             */
+            openFile(act);
+        }
+        scheduleRead(act);
     }
 
     /* all well, add to active list */
@@ -750,6 +839,7 @@ static rsRetVal ATTR_NONNULL(1, 2) act_obj_add(fs_edge_t *const edge,
 finalize_it:
     if (iRet != RS_RET_OK) {
         if (act != NULL) {
+            if (act->name != NULL) act_obj_unindex(edge, act);
             if (act->ratelimiter != NULL) ratelimitDestruct(act->ratelimiter);
             free(act->name);
             free(act);
@@ -768,10 +858,11 @@ finalize_it:
  */
 static void detect_updates(fs_edge_t *const edge) {
     act_obj_t *act;
+    act_obj_t *next;
     struct stat fileInfo;
-    int restart = 0;
 
-    for (act = edge->active; act != NULL; act = act->next) {
+    for (act = edge->active; act != NULL; act = next) {
+        next = act->next; /* act may be unlinked below */
         DBGPRINTF("detect_updates checking active obj '%s'\n", act->name);
         // lstat() has the disadvantage, that we get "deleted" when the name has changed
         // but inode is still the same (like with logrotate)
@@ -804,30 +895,22 @@ static void detect_updates(fs_edge_t *const edge) {
                         "'%s', ttDelete: %" PRId64 "s, ttNow:%" PRId64 " isFile: %d\n",
                         act->name, (int64_t)ttNow - (act->time_to_delete + FILE_DELETE_DELAY), (int64_t)ttNow, is_file);
                     act_obj_unlink(act);
-                    restart = 1;
                 } else {
                     DBGPRINTF(
                         "detect_updates obj gone away, keep '%s' "
                         "open: %" PRId64 "/%" PRId64 "/%" PRId64 "s!\n",
                         act->name, (int64_t)act->time_to_delete, (int64_t)ttNow, (int64_t)ttNow - act->time_to_delete);
-                    pollFile(act);
+                    scheduleRead(act);
                 }
             }
-            break;
         } else if (fileInfo.st_ino != act->ino) {
             DBGPRINTF(
                 "file '%s' inode changed from %llu to %llu, unlinking from "
                 "internal lists\n",
                 act->name, (long long unsigned)act->ino, (long long unsigned)fileInfo.st_ino);
             act_obj_unlink(act);
-            restart = 1;
-            break;
         }
     }
-
-    if (restart) {
-        detect_updates(edge);
-    }
 }
 
 
@@ -947,10 +1030,7 @@ static void ATTR_NONNULL() poll_timeouts(fs_edge_t *const edge) {
     if (edge->is_file) {
         act_obj_t *act;
         for (act = edge->active; act != NULL; act = act->next) {
-            if (act->pStrm && strmReadMultiLine_isTimedOut(act->pStrm)) {
-                DBGPRINTF("timeout occurred on %s\n", act->name);
-                pollFile(act);
-            }
+            scheduleReadIfTimedOut(act);
         }
     }
 }
@@ -978,9 +1058,10 @@ static void act_obj_destroy(act_obj_t *const act, const int is_deleted) {
             }
         }
     }
+    unscheduleRead(act);
     if (act->pStrm != NULL) {
         const instanceConf_t *const inst = act->edge->instarr[0];  // TODO: same file, multiple instances?
-        pollFile(act); /* get any left-over data */
+        pollFileLimited(act, 0); /* get any left-over data */
         if (inst->bRMStateOnDel) {
             statefn = getStateFileName(act, statefile, sizeof(statefile));
             getFullStateFileName(statefn, act->file_id, toDel, sizeof(toDel));  // TODO: check!
@@ -999,8 +1080,12 @@ static void act_obj_destroy(act_obj_t *const act, const int is_deleted) {
          *     has been renamed. This prevents orphaned state files.
          */
         if (is_deleted && ((!act->in_move && inst->bRMStateOnDel) || inst->bRMStateOnMove)) {
-            DBGPRINTF("act_obj_destroy: deleting state file %s\n", statefn);
-            unlink((char *)statefn);
+            if (runModConf->pStateStore != NULL) {
+                removeStoredState(getStateFileName(act, statefile, sizeof(statefile)), act->file_id);
+            } else {
+                DBGPRINTF("act_obj_destroy: deleting state file %s\n", statefn);
+                unlink((char *)statefn);
+            }
         }
     }
     if (act->ratelimiter != NULL) {
@@ -1075,6 +1160,7 @@ static void ATTR_NONNULL() act_obj_unlink(act_obj_t *act) {
     if (act->next != NULL) {
         act->next->prev = act->prev;
     }
+    act_obj_unindex(act->edge, act);
     act_obj_destroy(act, 1);
     act = NULL;
 }
@@ -1089,6 +1175,9 @@ static void fs_node_destroy(fs_node_t *const node) {
         fs_edge_t *const toDel = edge;
         edge = edge->next;
         act_obj_destroy_all(toDel->active);
+        if (toDel->actIdx != NULL) {
+            hashtable_destroy(toDel->actIdx, 0);
+        }
         free(toDel->name);
         free(toDel->path);
         free(toDel->instarr);
@@ -1217,6 +1306,28 @@ static int ATTR_NONNULL() getFullStateFileName(const uchar *const pszstatefile,
 }
 
 
+/* Helper function to build the key of a state in the state store. It is
+ * the name the state file would have, so keys do not clash with those of
+ * other modules sharing the store.
+ */
+static void ATTR_NONNULL() getStateStoreKey(const uchar *const pszstatefile,
+                                            const char *const file_id,
+                                            char *const pszout,
+                                            const size_t ilenout) {
+    snprintf(pszout, ilenout, "%s%s%s", (const char *)pszstatefile, (*file_id == '\0') ? "" : ":", file_id);
+}
+
+
+/* remove a state from the state store */
+static void ATTR_NONNULL() removeStoredState(const uchar *const statefn, const char *const file_id) {
+    char key[MAXFNAME];
+
+    getStateStoreKey(statefn, file_id, key, sizeof(key));
+    DBGPRINTF("removing state '%s' from state store\n", key);
+    statestoreDelete(runModConf->pStateStore, key);
+}
+
+
 /* hash function for file-id
  * Takes a block of data and returns a string with the hash value.
  *
@@ -1286,6 +1397,7 @@ static uchar *ATTR_NONNULL(1, 2)
 static rsRetVal checkPerMinuteRateLimits(per_minute_rate_limit_t *per_minute_rate_limits, const size_t msgLen) {
     DEFiRet;
     time_t current_minute = time(NULL) / 60;
+    pthread_mutex_lock(&per_minute_rate_limits->mut);
     if (per_minute_rate_limits->maxBytesPerMinute) {
         if (per_minute_rate_limits->rateLimitingMinute == current_minute) {
             per_minute_rate_limits->bytesThisMinute += msgLen;
@@ -1311,6 +1423,7 @@ static rsRetVal checkPerMinuteRateLimits(per_minute_rate_limit_t *per_minute_rat
         }
     }
 finalize_it:
+    pthread_mutex_unlock(&per_minute_rate_limits->mut);
     RETiRet;
 }
 
@@ -1378,59 +1491,165 @@ static rsRetVal ATTR_NONNULL(1, 2)
 finalize_it:
     RETiRet;
 }
+/* read the state of a file from the state store. Like for state files, the
+ * state for the current file id is preferred over an inode-only one. If
+ * there is no (valid) state, *pjson is NULL.
+ */
+static rsRetVal ATTR_NONNULL()
+    readStoredState(const act_obj_t *const act, const uchar *const statefn, struct json_object **const pjson) {
+    char key[MAXFNAME];
+    char *pszState = NULL;
+    DEFiRet;
+
+    *pjson = NULL;
+    getStateStoreKey(statefn, act->file_id, key, sizeof(key));
+    iRet = statestoreGet(runModConf->pStateStore, key, &pszState);
+    if (iRet == RS_RET_NOT_FOUND && act->file_id[0] != '\0') {
+        DBGPRINTF("no state '%s' for %s in state store - trying inode-only state\n", key, act->name);
+        getStateStoreKey(statefn, "", key, sizeof(key));
+        iRet = statestoreGet(runModConf->pStateStore, key, &pszState);
+    }
+    if (iRet == RS_RET_NOT_FOUND) {
+        DBGPRINTF("no state for %s in state store\n", act->name);
+        ABORT_FINALIZE(RS_RET_OK);
+    }
+    CHKiRet(iRet);
+
+    DBGPRINTF("found state '%s' for %s in state store\n", key, act->name);
+    *pjson = fjson_tokener_parse(pszState);
+    if (*pjson == NULL) {
+        LogError(0, RS_RET_ERR, "imfile: invalid state '%s' for '%s' in state store - ignored", key, act->name);
+    }
+
+finalize_it:
+    free(pszState);
+    RETiRet;
+}
+
+
+/* remember a state file whose state was moved into the store. If we run out
+ * of memory, the file is kept; it is then migrated again on next startup.
+ */
+static void addMigratedStateFile(const char *const pszSFNam) {
+    char **newNames;
+    char *name;
+    int newMax;
+
+    if ((name = strdup(pszSFNam)) == NULL) return;
+    pthread_mutex_lock(&migratedStateFiles.mut);
+    if (migratedStateFiles.nNames == migratedStateFiles.maxNames) {
+        newMax = (migratedStateFiles.maxNames == 0) ? 16 : 2 * migratedStateFiles.maxNames;
+        newNames = realloc(migratedStateFiles.names, newMax * sizeof(char *));
+        if (newNames == NULL) {
+            pthread_mutex_unlock(&migratedStateFiles.mut);
+            free(name);
+            return;
+        }
+        migratedStateFiles.names = newNames;
+        migratedStateFiles.maxNames = newMax;
+    }
+    migratedStateFiles.names[migratedStateFiles.nNames++] = name;
+    pthread_mutex_unlock(&migratedStateFiles.mut);
+}
+
+
+/* commit the states moved into the store since the last call, and remove
+ * their state files. Called by the input thread after each walk, so a bulk
+ * migration at startup costs one commit instead of one per file.
+ */
+static void commitMigratedStateFiles(void) {
+    char **names;
+    int nNames;
+    int i;
+
+    pthread_mutex_lock(&migratedStateFiles.mut);
+    names = migratedStateFiles.names;
+    nNames = migratedStateFiles.nNames;
+    migratedStateFiles.names = NULL;
+    migratedStateFiles.nNames = 0;
+    migratedStateFiles.maxNames = 0;
+    pthread_mutex_unlock(&migratedStateFiles.mut);
+
+    if (nNames == 0) goto done;
+    DBGPRINTF("committing %d state files moved into state store\n", nNames);
+    if (statestoreCommit(runModConf->pStateStore) == RS_RET_OK) {
+        for (i = 0; i < nNames; ++i) {
+            unlink(names[i]);
+        }
+    }
+    for (i = 0; i < nNames; ++i) {
+        free(names[i]);
+    }
+done:
+    free(names);
+}
+
+
 /* try to open a file which has a state file. If the state file does not
- * exist or cannot be read, an error is returned.
+ * exist or cannot be read, an error is returned. If a state store is used,
+ * the state is taken from it. A state file is then only read if the store
+ * does not know the file yet, and its state is moved into the store.
  */
 static rsRetVal ATTR_NONNULL(1) openFileWithStateFile(act_obj_t *const act) {
     DEFiRet;
     uchar pszSFNam[MAXFNAME];
     uchar statefile[MAXFNAME];
     int fd = -1;
+    struct json_object *json = NULL;
+    sbool bMoveToStore = 0;
     const instanceConf_t *const inst = act->edge->instarr[0];  // TODO: same file, multiple instances?
 
     uchar *const statefn = getStateFileName(act, statefile, sizeof(statefile));
     getFileID(act);
 
-    getFullStateFileName(statefn, act->file_id, pszSFNam, sizeof(pszSFNam));
-    DBGPRINTF("trying to open state for '%s', state file '%s'\n", act->name, pszSFNam);
+    if (runModConf->pStateStore != NULL) {
+        CHKiRet(readStoredState(act, statefn, &json));
+    }
 
-    /* check if the file exists */
-    fd = open((char *)pszSFNam, O_CLOEXEC | O_NOCTTY | O_RDONLY, 0600);
-    if (fd < 0) {
-        if (errno == ENOENT) {
-            if (act->file_id[0] != '\0') {
-                DBGPRINTF(
-                    "state file %s for %s does not exist - trying to see if "
-                    "inode-only file exists\n",
-                    pszSFNam, act->name);
-                getFullStateFileName(statefn, "", pszSFNam, sizeof(pszSFNam));
-                fd = open((char *)pszSFNam, O_CLOEXEC | O_NOCTTY | O_RDONLY, 0600);
-                if (fd >= 0) {
-                    dbgprintf("found inode-only state file, will be renamed at next persist\n");
+    if (json == NULL) {
+        getFullStateFileName(statefn, act->file_id, pszSFNam, sizeof(pszSFNam));
+        DBGPRINTF("trying to open state for '%s', state file '%s'\n", act->name, pszSFNam);
+
+        /* check if the file exists */
+        fd = open((char *)pszSFNam, O_CLOEXEC | O_NOCTTY | O_RDONLY, 0600);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                if (act->file_id[0] != '\0') {
+                    DBGPRINTF(
+                        "state file %s for %s does not exist - trying to see if "
+                        "inode-only file exists\n",
+                        pszSFNam, act->name);
+                    getFullStateFileName(statefn, "", pszSFNam, sizeof(pszSFNam));
+                    fd = open((char *)pszSFNam, O_CLOEXEC | O_NOCTTY | O_RDONLY, 0600);
+                    if (fd >= 0) {
+                        dbgprintf("found inode-only state file, will be renamed at next persist\n");
+                    }
                 }
+                if (fd < 0) {
+                    DBGPRINTF(
+                        "state file %s for %s does not exist - trying to see if "
+                        "old-style file exists\n",
+                        pszSFNam, act->name);
+                    CHKiRet(OLD_openFileWithStateFile(act));
+                    FINALIZE;
+                }
+            } else {
+                LogError(errno, RS_RET_IO_ERROR, "imfile error trying to access state file for '%s'", act->name);
+                ABORT_FINALIZE(RS_RET_IO_ERROR);
             }
-            if (fd < 0) {
-                DBGPRINTF(
-                    "state file %s for %s does not exist - trying to see if "
-                    "old-style file exists\n",
-                    pszSFNam, act->name);
-                CHKiRet(OLD_openFileWithStateFile(act));
-                FINALIZE;
-            }
-        } else {
-            LogError(errno, RS_RET_IO_ERROR, "imfile error trying to access state file for '%s'", act->name);
-            ABORT_FINALIZE(RS_RET_IO_ERROR);
         }
+
+        DBGPRINTF("opened state file %s for %s\n", pszSFNam, act->name);
+        json = fjson_object_from_fd(fd);
+        if (json == NULL) {
+            LogError(0, RS_RET_ERR, "imfile: error reading state file for '%s'", act->name);
+        }
+        bMoveToStore = (runModConf->pStateStore != NULL);
     }
 
-    DBGPRINTF("opened state file %s for %s\n", pszSFNam, act->name);
     CHKiRet(strm.Construct(&act->pStrm));
 
     struct json_object *jval;
-    struct json_object *json = fjson_object_from_fd(fd);
-    if (json == NULL) {
-        LogError(0, RS_RET_ERR, "imfile: error reading state file for '%s'", act->name);
-    }
 
     /* we access some data items a bit dirty, as we need to refactor the whole
      * thing in any case - TODO
@@ -1464,17 +1683,28 @@ static rsRetVal ATTR_NONNULL(1) openFileWithStateFile(act_obj_t *const act) {
         uchar *ret = rsCStrGetSzStrNoNULL(act->pStrm->prevMsgSegment);
         DBGPRINTF("prev_msg_segment present in state file 2, is: %s\n", ret);
     }
-    fjson_object_put(json);
 
     CHKiRet(strm.SetFName(act->pStrm, (uchar *)act->name, strlen(act->name)));
     CHKiRet(strm.SettOperationsMode(act->pStrm, STREAMMODE_READ));
     CHKiRet(strm.SetsType(act->pStrm, STREAMTYPE_FILE_MONITOR));
     CHKiRet(strm.SetFileNotFoundError(act->pStrm, inst->fileNotFoundError));
+    CHKiRet(strm.SetbMmap(act->pStrm, inst->bMmap));
     CHKiRet(strm.ConstructFinalize(act->pStrm));
 
     CHKiRet(strm.SeekCurrOffs(act->pStrm));
 
+    if (bMoveToStore) {
+        /* the state file is only removed once its state is safe in the store */
+        DBGPRINTF("moving state file %s into state store\n", pszSFNam);
+        if (persistStrmState(act) == RS_RET_OK) {
+            addMigratedStateFile((const char *)pszSFNam);
+        }
+    }
+
 finalize_it:
+    if (json != NULL) {
+        fjson_object_put(json);
+    }
     if (fd >= 0) {
         close(fd);
     }
@@ -1496,6 +1726,7 @@ static rsRetVal openFileWithoutStateFile(act_obj_t *const act) {
     CHKiRet(strm.SetsType(act->pStrm, STREAMTYPE_FILE_MONITOR));
     CHKiRet(strm.SetFName(act->pStrm, (uchar *)act->name, strlen(act->name)));
     CHKiRet(strm.SetFileNotFoundError(act->pStrm, inst->fileNotFoundError));
+    CHKiRet(strm.SetbMmap(act->pStrm, inst->bMmap));
     CHKiRet(strm.ConstructFinalize(act->pStrm));
 
     /* As a state file not exist, this is a fresh start. seek to file end
@@ -1552,7 +1783,7 @@ static void pollFileCancelCleanup(void *pArg) {
 
 
 /* pollFile needs to be split due to the unfortunate pthread_cancel_push() macros. */
-static rsRetVal ATTR_NONNULL() pollFileReal(act_obj_t *act, cstr_t **pCStr) {
+static rsRetVal ATTR_NONNULL() pollFileReal(act_obj_t *act, cstr_t **pCStr, const int maxLines) {
     int64 strtOffs;
     DEFiRet;
     int64_t startOffs = 0;
@@ -1575,7 +1806,7 @@ static rsRetVal ATTR_NONNULL() pollFileReal(act_obj_t *act, cstr_t **pCStr) {
     startOffs = act->pStrm->iCurrOffs;
     /* loop below will be exited when strmReadLine() returns EOF */
     while (glbl.GetGlobalInputTermState() == 0) {
-        if (inst->maxLinesAtOnce != 0 && nProcessed >= inst->maxLinesAtOnce) break;
+        if (maxLines != 0 && nProcessed >= maxLines) break;
         if ((start_preg == NULL) && (end_preg == NULL)) {
             CHKiRet(strm.ReadLine(act->pStrm, pCStr, inst->readMode, inst->escapeLF, inst->escapeLFString,
                                   inst->trimLineOverBytes, &strtOffs));
@@ -1589,7 +1820,9 @@ static rsRetVal ATTR_NONNULL() pollFileReal(act_obj_t *act, cstr_t **pCStr) {
             persistStrmState(act);
             startOffs = act->pStrm->iCurrOffs; /* disable check */
         }
-        runModConf->bHadFileData = 1; /* this is just a flag, so set it and forget it */
+        if (runModConf->opMode == OPMODE_POLLING) {
+            runModConf->bHadFileData = 1; /* this is just a flag, so set it and forget it */
+        }
         CHKiRet(enqLine(act, *pCStr, strtOffs)); /* process line */
         rsCStrDestruct(pCStr); /* discard string (must be done by us!) */
         if (inst->iPersistStateInterval > 0 && ++act->nRecords >= inst->iPersistStateInterval) {
@@ -1611,8 +1844,11 @@ finalize_it:
     RETiRet;
 }
 
-/* poll a file, need to check file rollover etc. open file if not open */
-static rsRetVal ATTR_NONNULL(1) pollFile(act_obj_t *const act) {
+/* poll a file, need to check file rollover etc. open file if not open.
+ * At most maxLines lines are read (0: no limit). Returns RS_RET_OK if reading
+ * stopped before EOF was reached.
+ */
+static rsRetVal ATTR_NONNULL(1) pollFileLimited(act_obj_t *const act, const int maxLines) {
     cstr_t *pCStr = NULL;
     DEFiRet;
     if (act->is_symlink) {
@@ -1622,12 +1858,215 @@ static rsRetVal ATTR_NONNULL(1) pollFile(act_obj_t *const act) {
      * otherwise do not work if I include the _cleanup_pop() inside an if... -- rgerhards, 2008-08-14
      */
     pthread_cleanup_push(pollFileCancelCleanup, &pCStr);
-    iRet = pollFileReal(act, &pCStr);
+    iRet = pollFileReal(act, &pCStr, maxLines);
     pthread_cleanup_pop(0);
 finalize_it:
     RETiRet;
 }
 
+static rsRetVal ATTR_NONNULL(1) pollFile(act_obj_t *const act) {
+    return pollFileLimited(act, act->edge->instarr[0]->maxLinesAtOnce);
+}
+
+
+/* Reader threads. In inotify mode, files can be read by a pool of threads
+ * instead of the input thread, so that the input thread only handles events
+ * and a single busy file does not delay all others. Files with new data are
+ * put on a FIFO queue. A reader thread reads at most maxLinesAtOnce lines of
+ * a file and then puts it to the end of the queue if there is more data. A
+ * file is read by at most one thread at a time, which keeps its messages in
+ * order and its state file consistent. All other processing, including the
+ * destruction of active objects, stays on the input thread.
+ */
+
+/* append to reader queue, caller must hold readerPool.mut */
+static void ATTR_NONNULL() readerQueueAppend(act_obj_t *const act) {
+    act->readNext = NULL;
+    act->readPrev = readerPool.tail;
+    if (readerPool.tail == NULL) {
+        readerPool.head = act;
+    } else {
+        readerPool.tail->readNext = act;
+    }
+    readerPool.tail = act;
+    act->readState = ACT_READ_QUEUED;
+    pthread_cond_signal(&readerPool.wakeup);
+}
+
+/* remove from reader queue, caller must hold readerPool.mut */
+static void ATTR_NONNULL() readerQueueRemove(act_obj_t *const act) {
+    if (act->readPrev == NULL) {
+        readerPool.head = act->readNext;
+    } else {
+        act->readPrev->readNext = act->readNext;
+    }
+    if (act->readNext == NULL) {
+        readerPool.tail = act->readPrev;
+    } else {
+        act->readNext->readPrev = act->readPrev;
+    }
+    act->readPrev = act->readNext = NULL;
+    act->readState = ACT_READ_IDLE;
+}
+
+
+/* read new data of a file. Without reader threads, this is done right away,
+ * otherwise the file is scheduled for a reader thread.
+ */
+static void ATTR_NONNULL() scheduleRead(act_obj_t *const act) {
+    if (readerPool.nThreads == 0) {
+        pollFile(act);
+        return;
+    }
+    if (act->is_symlink) return; /* nothing to read */
+
+    pthread_mutex_lock(&readerPool.mut);
+    if (act->readState == ACT_READ_IDLE) {
+        readerQueueAppend(act);
+    } else if (act->readState == ACT_READ_ACTIVE) {
+        act->readState = ACT_READ_AGAIN;
+    }
+    pthread_mutex_unlock(&readerPool.mut);
+}
+
+
+#ifdef HAVE_INOTIFY_INIT
+/* read a file if its read timeout expired */
+static void ATTR_NONNULL() scheduleReadIfTimedOut(act_obj_t *const act) {
+    if (readerPool.nThreads == 0) {
+        if (act->pStrm && strmReadMultiLine_isTimedOut(act->pStrm)) {
+            DBGPRINTF("timeout occurred on %s\n", act->name);
+            pollFile(act);
+        }
+        return;
+    }
+
+    /* the stream must not be accessed while a reader thread works on it */
+    pthread_mutex_lock(&readerPool.mut);
+    if (act->readState == ACT_READ_IDLE && act->pStrm && strmReadMultiLine_isTimedOut(act->pStrm)) {
+        DBGPRINTF("timeout occurred on %s\n", act->name);
+        readerQueueAppend(act);
+    }
+    pthread_mutex_unlock(&readerPool.mut);
+}
+#endif
+
+
+/* make sure no reader thread works on act, now or later. Must be called
+ * before an active object is destructed.
+ */
+static void ATTR_NONNULL() unscheduleRead(act_obj_t *const act) {
+    if (readerPool.nThreads == 0) return;
+
+    pthread_mutex_lock(&readerPool.mut);
+    while (act->readState == ACT_READ_ACTIVE || act->readState == ACT_READ_AGAIN) {
+        pthread_cond_wait(&readerPool.readDone, &readerPool.mut);
+    }
+    if (act->readState == ACT_READ_QUEUED) {
+        readerQueueRemove(act);
+    }
+    pthread_mutex_unlock(&readerPool.mut);
+}
+
+
+static void *readerThread(void *arg) {
+    const int idx = (int)(intptr_t)arg;
+    act_obj_t *act;
+    rsRetVal localRet;
+
+#if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    char thrdName[16];
+    snprintf(thrdName, sizeof(thrdName), "imfile/r%d", idx);
+    /* set thread name - we ignore if the call fails, has no harsh consequences... */
+    if (prctl(PR_SET_NAME, thrdName, 0, 0, 0) != 0) {
+        DBGPRINTF("prctl failed, not setting thread name for '%s'\n", thrdName);
+    }
+#endif
+    DBGPRINTF("imfile: reader thread %d started\n", idx);
+
+    pthread_mutex_lock(&readerPool.mut);
+    while (!readerPool.bStop) {
+        if ((act = readerPool.head) == NULL) {
+            pthread_cond_wait(&readerPool.wakeup, &readerPool.mut);
+            continue;
+        }
+        readerQueueRemove(act);
+        act->readState = ACT_READ_ACTIVE;
+        pthread_mutex_unlock(&readerPool.mut);
+
+        const instanceConf_t *const inst = act->edge->instarr[0];
+        localRet = pollFileLimited(act, (inst->maxLinesAtOnce == 0) ? DFLT_READER_MAX_LINES : inst->maxLinesAtOnce);
+
+        pthread_mutex_lock(&readerPool.mut);
+        /* RS_RET_OK means the read budget was used up before EOF */
+        if ((localRet == RS_RET_OK || act->readState == ACT_READ_AGAIN) && !readerPool.bStop &&
+            glbl.GetGlobalInputTermState() == 0) {
+            readerQueueAppend(act);
+        } else {
+            act->readState = ACT_READ_IDLE;
+        }
+        pthread_cond_broadcast(&readerPool.readDone);
+    }
+    pthread_mutex_unlock(&readerPool.mut);
+
+    DBGPRINTF("imfile: reader thread %d terminated\n", idx);
+    return NULL;
+}
+
+
+static void readerPoolStart(void) {
+    int i;
+
+    if (runModConf->nReaderThreads == 0) return;
+    pthread_mutex_init(&readerPool.mut, NULL);
+    pthread_cond_init(&readerPool.wakeup, NULL);
+    pthread_cond_init(&readerPool.readDone, NULL);
+    readerPool.head = readerPool.tail = NULL;
+    readerPool.bStop = 0;
+    if ((readerPool.tids = calloc(runModConf->nReaderThreads, sizeof(pthread_t))) == NULL) {
+        LogError(errno, RS_RET_OUT_OF_MEMORY, "imfile: cannot start reader threads, reading on input thread");
+        return;
+    }
+    for (i = 0; i < runModConf->nReaderThreads; ++i) {
+        if (pthread_create(&readerPool.tids[i], &default_thread_attr, readerThread, (void *)(intptr_t)i) != 0) {
+            LogError(errno, RS_RET_SYS_ERR, "imfile: cannot create reader thread %d", i);
+            break;
+        }
+    }
+    readerPool.nThreads = i;
+    if (i == 0) {
+        free(readerPool.tids);
+        readerPool.tids = NULL;
+    }
+    DBGPRINTF("imfile: %d reader threads started\n", readerPool.nThreads);
+}
+
+
+/* stop reader threads. Files still queued are read by whoever processes them
+ * next without reader threads (usually act_obj_destroy()).
+ */
+static void readerPoolStop(void) {
+    if (readerPool.tids == NULL) return;
+
+    pthread_mutex_lock(&readerPool.mut);
+    readerPool.bStop = 1;
+    pthread_cond_broadcast(&readerPool.wakeup);
+    pthread_mutex_unlock(&readerPool.mut);
+    for (int i = 0; i < readerPool.nThreads; ++i) {
+        pthread_join(readerPool.tids[i], NULL);
+    }
+    while (readerPool.head != NULL) {
+        readerQueueRemove(readerPool.head);
+    }
+    free(readerPool.tids);
+    readerPool.tids = NULL;
+    readerPool.nThreads = 0;
+    pthread_cond_destroy(&readerPool.readDone);
+    pthread_cond_destroy(&readerPool.wakeup);
+    pthread_mutex_destroy(&readerPool.mut);
+    DBGPRINTF("imfile: reader threads stopped\n");
+}
+
 
 /* create input instance, set default parameters, and
  * add it to the list of instances.
@@ -1636,6 +2075,7 @@ static rsRetVal ATTR_NONNULL(1) createInstance(instanceConf_t **const pinst) {
     instanceConf_t *inst;
     DEFiRet;
     CHKmalloc(inst = malloc(sizeof(instanceConf_t)));
+    pthread_mutex_init(&inst->perMinuteRateLimits.mut, NULL);
     inst->next = NULL;
     inst->pBindRuleset = NULL;
 
@@ -1665,6 +2105,7 @@ static rsRetVal ATTR_NONNULL(1) createInstance(instanceConf_t **const pinst) {
     inst->escapeLF = 1;
     inst->escapeLFString = NULL;
     inst->reopenOnTruncate = 0;
+    inst->bMmap = 0;
     inst->addMetadata = ADD_METADATA_UNSPECIFIED;
     inst->addCeeTag = 0;
     inst->freshStartTail = 0;
@@ -1816,6 +2257,7 @@ static rsRetVal addInstance(void __attribute__((unused)) * pVal, uchar *pNewVal)
     inst->escapeLF = 0;
     inst->escapeLFString = NULL;
     inst->reopenOnTruncate = 0;
+    inst->bMmap = 0;
     inst->addMetadata = 0;
     inst->addCeeTag = 0;
     inst->bRMStateOnDel = 0;
@@ -1899,8 +2341,10 @@ BEGINnewInpInst
             inst->escapeLFString = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
         } else if (!strcmp(inppblk.descr[i].name, "reopenontruncate")) {
             inst->reopenOnTruncate = (sbool)pvals[i].val.d.n;
+        } else if (!strcmp(inppblk.descr[i].name, "mmap")) {
+            inst->bMmap = (sbool)pvals[i].val.d.n;
         } else if (!strcmp(inppblk.descr[i].name, "maxlinesatonce")) {
-            if (loadModConf->opMode == OPMODE_INOTIFY && pvals[i].val.d.n > 0) {
+            if (loadModConf->opMode == OPMODE_INOTIFY && loadModConf->nReaderThreads == 0 && pvals[i].val.d.n > 0) {
                 LogError(0, RS_RET_PARAM_NOT_PERMITTED,
                          "parameter \"maxLinesAtOnce\" not "
                          "permited in inotify mode - ignored");
@@ -1984,6 +2428,10 @@ BEGINbeginCnfLoad
     loadModConf->normalizePath = 1;
     loadModConf->sortFiles = GLOB_NOSORT;
     loadModConf->stateFileDirectory = NULL;
+    loadModConf->nReaderThreads = 0;
+    loadModConf->pszStateStore = NULL;
+    loadModConf->iStateStoreCommitInterval = STATESTORE_DFLT_COMMIT_INTERVAL;
+    loadModConf->pStateStore = NULL;
     loadModConf->conf_tree = calloc(1, sizeof(fs_node_t));
     loadModConf->conf_tree->edges = NULL;
     bLegacyCnfModGlobalsPermitted = 1;
@@ -2043,6 +2491,12 @@ BEGINsetModCnf
             loadModConf->stateFileDirectory = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
         } else if (!strcmp(modpblk.descr[i].name, "normalizepath")) {
             loadModConf->normalizePath = (sbool)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "readerthreads")) {
+            loadModConf->nReaderThreads = (int)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "statestore")) {
+            loadModConf->pszStateStore = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(modpblk.descr[i].name, "statestore.commitinterval")) {
+            loadModConf->iStateStoreCommitInterval = (int)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "mode")) {
             if (!es_strconstcmp(pvals[i].val.d.estr, "polling"))
                 loadModConf->opMode = OPMODE_POLLING;
@@ -2119,6 +2573,12 @@ BEGINcheckCnf
     for (inst = pModConf->root; inst != NULL; inst = inst->next) {
         std_checkRuleset(pModConf, inst);
     }
+    if (pModConf->nReaderThreads > 0 && pModConf->opMode != OPMODE_INOTIFY) {
+        LogMsg(0, RS_RET_PARAM_NOT_PERMITTED, LOG_WARNING,
+               "imfile: parameter \"readerThreads\" is only supported in "
+               "inotify mode - ignored");
+        pModConf->nReaderThreads = 0;
+    }
     if (pModConf->root == NULL) {
         LogError(0, RS_RET_NO_LISTNERS,
                  "imfile: no files configured to be monitored - "
@@ -2128,6 +2588,26 @@ BEGINcheckCnf
 ENDcheckCnf
 
 
+/* open the state store. A relative name is relative to the work directory.
+ * If it cannot be opened, we do not run at all: reading without the saved
+ * states would duplicate or skip data.
+ */
+static rsRetVal openStateStore(void) {
+    DEFiRet;
+
+    iRet = statestoreOpen(&runModConf->pStateStore, runModConf->pConf, (const char *)runModConf->pszStateStore,
+                          runModConf->iStateStoreCommitInterval);
+    if (iRet != RS_RET_OK) {
+        LogError(0, iRet, "imfile: cannot open state store '%s' - input not activated",
+                 (const char *)runModConf->pszStateStore);
+        ABORT_FINALIZE(RS_RET_NO_RUN);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
 /* note: we do access files AFTER we have dropped privileges. This is
  * intentional, user must make sure the files have the right permissions.
  */
@@ -2159,6 +2639,10 @@ BEGINactivateCnf
         fs_node_add(runModConf->conf_tree, NULL, inst->pszFileName, 0, inst);
     }
 
+    if (runModConf->pszStateStore != NULL) {
+        CHKiRet(openStateStore());
+    }
+
     if (Debug) {
         fs_node_print(runModConf->conf_tree, 0);
     }
@@ -2171,6 +2655,9 @@ BEGINfreeCnf
     instanceConf_t *inst, *del;
     CODESTARTfreeCnf;
     fs_node_destroy(pModConf->conf_tree);
+    /* after the tree, as destroying it persists the final file states */
+    statestoreClose(&pModConf->pStateStore);
+    free(pModConf->pszStateStore);
     for (inst = pModConf->root; inst != NULL;) {
         free(inst->pszBindRuleset);
         free(inst->pszFileName);
@@ -2185,6 +2672,7 @@ BEGINfreeCnf
             regfree(&inst->end_preg);
             free(inst->endRegex);
         }
+        pthread_mutex_destroy(&inst->perMinuteRateLimits.mut);
         del = inst;
         inst = inst->next;
         free(del);
@@ -2205,6 +2693,7 @@ ENDfreeCnf
  */
 static void do_initial_poll_run(void) {
     fs_node_walk(runModConf->conf_tree, poll_tree);
+    commitMigratedStateFiles();
 
     /* fresh start done, so disable freshStartTail for files that now will be created */
     for (instanceConf_t *inst = runModConf->root; inst != NULL; inst = inst->next) {
@@ -2224,6 +2713,7 @@ static rsRetVal doPolling(void) {
             fs_node_walk(runModConf->conf_tree, poll_tree);
             DBGPRINTF("doPolling: end poll walk, hadData %d\n", runModConf->bHadFileData);
         } while (runModConf->bHadFileData); /* warning: do...while()! */
+        commitMigratedStateFiles();
 
         /* Note: the additional 10ns wait is vitally important. It guards rsyslog
          * against totally hogging the CPU if the users selects a polling interval
@@ -2286,10 +2776,29 @@ static void ATTR_NONNULL(1) in_dbg_showEv(const struct inotify_event *ev) {
 }
 
 
-static void ATTR_NONNULL(1, 2) in_handleFileEvent(struct inotify_event *ev, const wd_map_t *const etry) {
+/* Events on directories (and moves) require a rescan of the affected part of
+ * the config tree. If many files are created at once, e.g. while a lot of
+ * containers start, a single read from the inotify fd returns a burst of such
+ * events for the same directories. They are collected here, so that each node
+ * is rescanned only once after all events of the read have been processed.
+ */
+typedef struct in_rescan_s {
+    int nNodes;
+    fs_node_t *nodes[INOTIFY_BUF_SIZE / sizeof(struct inotify_event)]; /* max nbr of events per read */
+} in_rescan_t;
+
+static void ATTR_NONNULL() in_scheduleRescan(in_rescan_t *const rescan, fs_node_t *const node) {
+    for (int i = 0; i < rescan->nNodes; ++i) {
+        if (rescan->nodes[i] == node) return;
+    }
+    rescan->nodes[rescan->nNodes++] = node;
+}
+
+
+static void ATTR_NONNULL(1, 2) in_handleFileEvent(struct inotify_event *ev, act_obj_t *const act) {
     if (ev->mask & IN_MODIFY) {
-        DBGPRINTF("fs_node_notify_file_update: act->name '%s'\n", etry->act->name);
-        pollFile(etry->act);
+        DBGPRINTF("fs_node_notify_file_update: act->name '%s'\n", act->name);
+        scheduleRead(act);
     } else {
         DBGPRINTF("got non-expected inotify event:\n");
         in_dbg_showEv(ev);
@@ -2319,15 +2828,15 @@ static void flag_in_move(fs_edge_t *const edge, const char *name_moved) {
     }
 }
 
-static void ATTR_NONNULL(1) in_processEvent(struct inotify_event *ev) {
+static void ATTR_NONNULL(1, 2) in_processEvent(struct inotify_event *ev, in_rescan_t *const rescan) {
     if (ev->mask & IN_IGNORED) {
         DBGPRINTF("imfile: got IN_IGNORED event\n");
         goto done;
     }
 
     DBGPRINTF("in_processEvent process Event %x for %s\n", ev->mask, ev->name);
-    const wd_map_t *const etry = wdmapLookup(ev->wd);
-    if (etry == NULL) {
+    act_obj_t *const act = wdmapLookup(ev->wd);
+    if (act == NULL) {
         LogMsg(0, RS_RET_INTERNAL_ERROR, LOG_WARNING,
                "imfile: internal error? "
                "inotify provided watch descriptor %d which we could not find "
@@ -2335,18 +2844,18 @@ static void ATTR_NONNULL(1) in_processEvent(struct inotify_event *ev) {
                ev->wd);
         goto done;
     }
-    DBGPRINTF("in_processEvent process Event %x is_file %d, act->name '%s'\n", ev->mask, etry->act->edge->is_file,
-              etry->act->name);
+    DBGPRINTF("in_processEvent process Event %x is_file %d, act->name '%s'\n", ev->mask, act->edge->is_file,
+              act->name);
 
     if ((ev->mask & IN_MOVED_FROM)) {
-        flag_in_move(etry->act->edge->node->edges, ev->name);
+        flag_in_move(act->edge->node->edges, ev->name);
     }
     if (ev->mask & (IN_MOVED_FROM | IN_MOVED_TO)) {
-        fs_node_walk(etry->act->edge->node, poll_tree);
-    } else if (etry->act->edge->is_file && !(etry->act->is_symlink)) {
-        in_handleFileEvent(ev, etry);  // esentially poll_file()!
+        in_scheduleRescan(rescan, act->edge->node);
+    } else if (act->edge->is_file && !(act->is_symlink)) {
+        in_handleFileEvent(ev, act);  // esentially poll_file()!
     } else {
-        fs_node_walk(etry->act->edge->node, poll_tree);
+        in_scheduleRescan(rescan, act->edge->node);
     }
 done:
     return;
@@ -2355,7 +2864,8 @@ done:
 
 /* Monitor files in inotify mode */
 static rsRetVal do_inotify(void) {
-    char iobuf[8192];
+    char iobuf[INOTIFY_BUF_SIZE];
+    in_rescan_t rescan;
     int rd;
     int currev;
     static int last_timeout = 0;
@@ -2429,6 +2939,7 @@ static rsRetVal do_inotify(void) {
                 continue;
             }
             currev = 0;
+            rescan.nNodes = 0;
             while (currev < rd) {
                 union {
                     char *buf;
@@ -2436,9 +2947,13 @@ static rsRetVal do_inotify(void) {
                 } savecast;
                 savecast.buf = iobuf + currev;
                 in_dbg_showEv(savecast.ev);
-                in_processEvent(savecast.ev);
+                in_processEvent(savecast.ev, &rescan);
                 currev += sizeof(struct inotify_event) + savecast.ev->len;
             }
+            for (int i = 0; i < rescan.nNodes; ++i) {
+                fs_node_walk(rescan.nodes[i], poll_tree);
+            }
+            commitMigratedStateFiles();
         }
     }
 
@@ -2540,6 +3055,7 @@ static rsRetVal do_fen(void) {
             } else {
                 fs_node_walk(act->edge->node, poll_tree);
             }
+            commitMigratedStateFiles();
         }
     }
 
@@ -2575,13 +3091,15 @@ BEGINrunInput
     DBGPRINTF("working in %s mode\n", (runModConf->opMode == OPMODE_POLLING)
                                           ? "polling"
                                           : ((runModConf->opMode == OPMODE_INOTIFY) ? "inotify" : "fen"));
-    if (runModConf->opMode == OPMODE_POLLING)
+    if (runModConf->opMode == OPMODE_POLLING) {
         iRet = doPolling();
-    else if (runModConf->opMode == OPMODE_INOTIFY)
+    } else if (runModConf->opMode == OPMODE_INOTIFY) {
+        /* the pool is stopped in afterRun, in case we get cancelled */
+        readerPoolStart();
         iRet = do_inotify();
-    else if (runModConf->opMode == OPMODE_FEN)
+    } else if (runModConf->opMode == OPMODE_FEN) {
         iRet = do_fen();
-    else {
+    } else {
         LogError(0, RS_RET_NOT_IMPLEMENTED, "imfile: unknown mode %d set", runModConf->opMode);
         return RS_RET_NOT_IMPLEMENTED;
     }
@@ -2649,6 +3167,10 @@ static void removeOldStatefile(const uchar *statefn, const char *hashToDelete) {
     int ret;
     uchar statefname[MAXFNAME];
 
+    if (runModConf->pStateStore != NULL) {
+        removeStoredState(statefn, hashToDelete);
+        return;
+    }
     getFullStateFileName(statefn, hashToDelete, statefname, sizeof(statefname));
     DBGPRINTF("removing old state file: '%s'\n", statefname);
     ret = unlink((const char *)statefname);
@@ -2714,8 +3236,13 @@ static rsRetVal ATTR_NONNULL() persistStrmState(act_obj_t *const act) {
 
     const char *jstr = json_object_to_json_string_ext(json, JSON_C_TO_STRING_SPACED);
 
-    CHKiRet(atomicWriteStateFile((const char *)statefname, jstr));
-    json_object_put(json);
+    if (runModConf->pStateStore != NULL) {
+        char key[MAXFNAME];
+        getStateStoreKey(statefn, act->file_id, key, sizeof(key));
+        CHKiRet(statestoreSet(runModConf->pStateStore, key, jstr));
+    } else {
+        CHKiRet(atomicWriteStateFile((const char *)statefname, jstr));
+    }
 
     /* file-id changed remove the old statefile */
     if (strncmp((const char *)act->file_id_prev, (const char *)act->file_id, FILE_ID_HASH_SIZE)) {
@@ -2723,6 +3250,9 @@ static rsRetVal ATTR_NONNULL() persistStrmState(act_obj_t *const act) {
     }
 
 finalize_it:
+    if (json != NULL) {
+        json_object_put(json);
+    }
     if (iRet != RS_RET_OK) {
         LogError(0, iRet,
                  "imfile: could not persist state "
@@ -2739,6 +3269,8 @@ finalize_it:
  */
 BEGINafterRun
     CODESTARTafterRun;
+    readerPoolStop();
+    commitMigratedStateFiles();
     if (pInputName != NULL) prop.Destruct(&pInputName);
 ENDafterRun
 
@@ -2763,7 +3295,10 @@ BEGINmodExit
     objRelease(datetime, CORE_COMPONENT);
 
 #ifdef HAVE_INOTIFY_INIT
-    free(wdmap);
+    if (wdmap != NULL) {
+        hashtable_destroy(wdmap, 0);
+        wdmap = NULL;
+    }
 #endif
 ENDmodExit
 
@@ -56,6 +56,7 @@
 #include "srUtils.h"
 #include "unicode-helper.h"
 #include "ratelimit.h"
+#include "statestore.h"
 
 
 MODULE_TYPE_INPUT;
@@ -99,6 +100,8 @@ static struct configSettings_s {
     int bFsync;
     int bRemote;
     char *dfltTag;
+    char *stateStore; /* state store file, NULL: use state files */
+    int iStateStoreCommitInterval; /* ms */
 } cs;
 
 static rsRetVal facilityHdlr(uchar **pp, void *pVal);
@@ -118,7 +121,9 @@ static struct cnfparamdescr modpdescr[] = {{"statefile", eCmdHdlrGetWord, 0},
                                            {"workaroundjournalbug", eCmdHdlrBinary, 0},
                                            {"fsync", eCmdHdlrBinary, 0},
                                            {"remote", eCmdHdlrBinary, 0},
-                                           {"defaulttag", eCmdHdlrGetWord, 0}};
+                                           {"defaulttag", eCmdHdlrGetWord, 0},
+                                           {"statestore", eCmdHdlrGetWord, 0},
+                                           {"statestore.commitinterval", eCmdHdlrPositiveInt, 0}};
 static struct cnfparamblk modpblk = {CNFPARAMBLK_VERSION, sizeof(modpdescr) / sizeof(struct cnfparamdescr), modpdescr};
 
 /* input instance parameters */
@@ -151,6 +156,7 @@ static prop_t *pLocalHostIP = NULL; /* a pseudo-constant propterty for 127.0.0.1
 static const char *pidFieldName; /* read-only after startup */
 static int bPidFallBack;
 static ratelimit_t *ratelimiter = NULL;
+static statestore_t *pStateStore = NULL; /* keeps the cursors if configured, instead of state files */
 static struct {
     statsobj_t *stats;
     STATSCOUNTER_DEF(ctrSubmitted, mutCtrSubmitted)
@@ -564,7 +570,16 @@ finalize_it:
 }
 
 
-/* This function saves journal cursor into state file.
+/* Builds the key of a journal's state in the state store. The state file
+ * name is still configured by "statefile", it just names the state then.
+ */
+static void getStateStoreKey(const char *const stateFile, char *const pszKey, const size_t lenKey) {
+    snprintf(pszKey, lenKey, "imjournal:%s", stateFile);
+}
+
+
+/* This function saves journal cursor into state file (or the state store,
+ * if one is configured).
  * It must be checked that stateFile is configured prior to calling this.
  */
 static rsRetVal persistJournalState(struct journalContext_s *journalContext, char *stateFile) {
@@ -582,6 +597,17 @@ static rsRetVal persistJournalState(struct journalContext_s *journalContext, cha
         ABORT_FINALIZE(RS_RET_OK);
     }
 
+    if (pStateStore != NULL) {
+        char key[MAXFNAME];
+        getStateStoreKey(stateFile, key, sizeof(key));
+        CHKiRet(statestoreSet(pStateStore, key, journalContext->cursor));
+        if (cs.bFsync) {
+            CHKiRet(statestoreCommit(pStateStore));
+        }
+        DBGPRINTF("Persisted journal to state store as '%s'\n", key);
+        FINALIZE;
+    }
+
     /* we create a temporary name by adding a ".tmp"
      * suffix to the end of our state file's name
      *
@@ -728,95 +754,117 @@ finalize_it:
     RETiRet;
 }
 
-/* This function loads a journal cursor from the state file.
+/* Seek the journal to a cursor loaded from the state file or store.
  */
-static rsRetVal loadJournalState(struct journalContext_s *journalContext, char *stateFile) {
+static rsRetVal seekToCursor(struct journalContext_s *journalContext, const char *const readCursor) {
     DEFiRet;
     int r;
+
+    if (sd_journal_seek_cursor(journalContext->j, readCursor) != 0) {
+        LogError(0, RS_RET_ERR,
+                 "imjournal: "
+                 "couldn't seek to cursor `%s'\n",
+                 readCursor);
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    journalContext->atHead = 0;
+    char *tmp_cursor = NULL;
+    sd_journal_next(journalContext->j);
+    /*
+    * This is resolving the situation when system is after reboot and boot_id
+    * doesn't match so cursor pointing into "future".
+    * Usually sd_journal_next jump to head of journal due to journal aproximation,
+    * but when system time goes backwards and cursor is still
+      invalid, rsyslog stops logging.
+    * We use sd_journal_get_cursor to validate our cursor.
+    * When cursor is invalid we are trying to jump to the head of journal
+    * This problem with time should not affect persistent journal,
+    * but if cursor has been intentionally compromised it could stop logging even
+    * with persistent journal.
+    * */
+    if ((r = sd_journal_get_cursor(journalContext->j, &tmp_cursor)) < 0) {
+        LogError(-r, RS_RET_IO_ERROR,
+                 "imjournal: "
+                 "loaded invalid cursor, seeking to the head of journal\n");
+        if ((r = sd_journal_seek_head(journalContext->j)) < 0) {
+            LogError(-r, RS_RET_ERR,
+                     "imjournal: "
+                     "sd_journal_seek_head() failed, when cursor is invalid\n");
+            iRet = RS_RET_ERR;
+        }
+        journalContext->atHead = 1;
+    }
+    free(tmp_cursor);
+
+finalize_it:
+    RETiRet;
+}
+
+/* This function loads a journal cursor from the state file. If a state
+ * store is used, the cursor is taken from it. The state file is then only
+ * read if the store does not know the journal yet, and its cursor is moved
+ * into the store.
+ */
+static rsRetVal loadJournalState(struct journalContext_s *journalContext, char *stateFile) {
+    DEFiRet;
     FILE *r_sf;
+    char readCursor[128 + 1];
+    char key[MAXFNAME];
+    char *pszCursor = NULL;
 
     DBGPRINTF("Loading journal position, at head? %d, reloaded? %d\n", journalContext->atHead,
               journalContext->reloaded);
 
-    /* if state file not exists (on very first run), skip */
-    if (access(stateFile, F_OK | R_OK) == -1 && errno == ENOENT) {
-        if (cs.bIgnorePrevious) {
-            /* Seek to the very end of the journal and ignore all older messages. */
-            skipOldMessages(journalContext);
+    getStateStoreKey(stateFile, key, sizeof(key));
+    if (pStateStore != NULL && statestoreGet(pStateStore, key, &pszCursor) == RS_RET_OK) {
+        DBGPRINTF("Loaded journal position from state store, key '%s'\n", key);
+        iRet = seekToCursor(journalContext, pszCursor);
+    } else {
+        /* if state file not exists (on very first run), skip */
+        if (access(stateFile, F_OK | R_OK) == -1 && errno == ENOENT) {
+            if (cs.bIgnorePrevious) {
+                /* Seek to the very end of the journal and ignore all older messages. */
+                skipOldMessages(journalContext);
+            }
+            LogMsg(errno, RS_RET_FILE_NOT_FOUND, LOG_NOTICE,
+                   "imjournal: No statefile exists, "
+                   "%s will be created (ignore if this is first run)",
+                   stateFile);
+            FINALIZE;
         }
-        LogMsg(errno, RS_RET_FILE_NOT_FOUND, LOG_NOTICE,
-               "imjournal: No statefile exists, "
-               "%s will be created (ignore if this is first run)",
-               stateFile);
-        FINALIZE;
-    }
 
-    if ((r_sf = fopen(stateFile, "rb")) != NULL) {
-        char readCursor[128 + 1];
-        if (fscanf(r_sf, "%128s\n", readCursor) != EOF) {
-            if (sd_journal_seek_cursor(journalContext->j, readCursor) != 0) {
-                LogError(0, RS_RET_ERR,
-                         "imjournal: "
-                         "couldn't seek to cursor `%s'\n",
-                         readCursor);
-                iRet = RS_RET_ERR;
+        if ((r_sf = fopen(stateFile, "rb")) != NULL) {
+            if (fscanf(r_sf, "%128s\n", readCursor) != EOF) {
+                iRet = seekToCursor(journalContext, readCursor);
             } else {
-                journalContext->atHead = 0;
-                char *tmp_cursor = NULL;
-                sd_journal_next(journalContext->j);
-                /*
-                * This is resolving the situation when system is after reboot and boot_id
-                * doesn't match so cursor pointing into "future".
-                * Usually sd_journal_next jump to head of journal due to journal aproximation,
-                * but when system time goes backwards and cursor is still
-                  invalid, rsyslog stops logging.
-                * We use sd_journal_get_cursor to validate our cursor.
-                * When cursor is invalid we are trying to jump to the head of journal
-                * This problem with time should not affect persistent journal,
-                * but if cursor has been intentionally compromised it could stop logging even
-                * with persistent journal.
-                * */
-                if ((r = sd_journal_get_cursor(journalContext->j, &tmp_cursor)) < 0) {
-                    LogError(-r, RS_RET_IO_ERROR,
-                             "imjournal: "
-                             "loaded invalid cursor, seeking to the head of journal\n");
-                    if ((r = sd_journal_seek_head(journalContext->j)) < 0) {
-                        LogError(-r, RS_RET_ERR,
-                                 "imjournal: "
-                                 "sd_journal_seek_head() failed, when cursor is invalid\n");
-                        iRet = RS_RET_ERR;
-                    }
-                    journalContext->atHead = 1;
-                }
-                free(tmp_cursor);
+                LogError(0, RS_RET_IO_ERROR,
+                         "imjournal: "
+                         "fscanf on state file `%s' failed\n",
+                         stateFile);
+                iRet = RS_RET_IO_ERROR;
             }
-        } else {
-            LogError(0, RS_RET_IO_ERROR,
-                     "imjournal: "
-                     "fscanf on state file `%s' failed\n",
-                     stateFile);
-            iRet = RS_RET_IO_ERROR;
-        }
-
-        fclose(r_sf);
 
-        if (iRet != RS_RET_OK && cs.bIgnoreNonValidStatefile) {
-            /* ignore state file errors */
-            iRet = RS_RET_OK;
-            LogError(0, NO_ERRCODE, "imjournal: ignoring invalid state file %s", stateFile);
+            fclose(r_sf);
+        } else {
+            LogError(0, RS_RET_FOPEN_FAILURE, "imjournal: open on state file `%s' failed\n", stateFile);
             if (cs.bIgnorePrevious) {
+                /* Seek to the very end of the journal and ignore all older messages. */
                 skipOldMessages(journalContext);
             }
         }
-    } else {
-        LogError(0, RS_RET_FOPEN_FAILURE, "imjournal: open on state file `%s' failed\n", stateFile);
+    }
+
+    if (iRet != RS_RET_OK && cs.bIgnoreNonValidStatefile) {
+        /* ignore state file errors */
+        iRet = RS_RET_OK;
+        LogError(0, NO_ERRCODE, "imjournal: ignoring invalid state file %s", stateFile);
         if (cs.bIgnorePrevious) {
-            /* Seek to the very end of the journal and ignore all older messages. */
             skipOldMessages(journalContext);
         }
     }
 
 finalize_it:
+    free(pszCursor);
     RETiRet;
 }
 
@@ -855,6 +903,43 @@ finalize_it:
 }
 
 
+/* Move the cursors of existing state files into the state store. All of
+ * them go into the store with a single commit, and the state files are only
+ * removed once that commit succeeded. Otherwise they are used again on the
+ * next start. A state file that cannot be read is left to loadJournalState(),
+ * which reports it; the cursors are validated when they are loaded.
+ */
+static void migrateStateFiles(void) {
+    char *migrated[MAX_JOURNAL];
+    int nMigrated = 0;
+    char key[MAXFNAME];
+    char readCursor[128 + 1];
+    char *pszCursor;
+    FILE *r_sf;
+
+    for (journal_etry_t *etry = journal_root; etry != NULL && nMigrated < MAX_JOURNAL; etry = etry->next) {
+        char *const stateFile = (etry->stateFile != NULL) ? etry->stateFile : cs.stateFile;
+        if (stateFile == NULL) continue;
+        getStateStoreKey(stateFile, key, sizeof(key));
+        if (statestoreGet(pStateStore, key, &pszCursor) == RS_RET_OK) {
+            free(pszCursor);
+            continue;
+        }
+        if ((r_sf = fopen(stateFile, "rb")) == NULL) continue;
+        if (fscanf(r_sf, "%128s\n", readCursor) == 1 && statestoreSet(pStateStore, key, readCursor) == RS_RET_OK) {
+            migrated[nMigrated++] = stateFile;
+        }
+        fclose(r_sf);
+    }
+    if (nMigrated > 0 && statestoreCommit(pStateStore) == RS_RET_OK) {
+        for (int i = 0; i < nMigrated; ++i) {
+            DBGPRINTF("moved state file %s into state store\n", migrated[i]);
+            unlink(migrated[i]);
+        }
+    }
+}
+
+
 static rsRetVal doRun(journal_etry_t const *etry) {
     DEFiRet;
     uint64_t count = 0;
@@ -1023,6 +1108,10 @@ BEGINrunInput
         LogError(0, RS_RET_DEPRECATED, "\"usepidfromsystem\" is deprecated, use \"usepid\" instead");
     }
 
+    if (pStateStore != NULL) {
+        migrateStateFiles();
+    }
+
     journal_etry_t *etry = journal_root->next;
     while (etry != NULL) {
         startSrvWrkr(etry);
@@ -1061,6 +1150,8 @@ BEGINbeginCnfLoad
     cs.bFsync = 0;
     cs.bRemote = 0;
     cs.dfltTag = NULL;
+    cs.stateStore = NULL;
+    cs.iStateStoreCommitInterval = STATESTORE_DFLT_COMMIT_INTERVAL;
 ENDbeginCnfLoad
 
 
@@ -1086,6 +1177,11 @@ BEGINcheckCnf
     for (inst = pModConf->root; inst != NULL; inst = inst->next) {
         std_checkRuleset(pModConf, inst);
     }
+    if (cs.stateStore != NULL && cs.stateFile == NULL) {
+        LogMsg(0, RS_RET_PARAM_ERROR, LOG_WARNING,
+               "imjournal: parameter \"stateStore\" is set, but \"stateFile\" is not - "
+               "the journal position is not persisted");
+    }
 ENDcheckCnf
 
 
@@ -1125,6 +1221,14 @@ BEGINactivateCnf
     CHKiRet(statsobj.ConstructFinalize(statsCounter.stats));
     /* end stats counter */
 
+    if (cs.stateStore != NULL && cs.stateFile != NULL) {
+        iRet = statestoreOpen(&pStateStore, runModConf->pConf, cs.stateStore, cs.iStateStoreCommitInterval);
+        if (iRet != RS_RET_OK) {
+            LogError(0, iRet, "imjournal: cannot open state store '%s' - input not activated", cs.stateStore);
+            ABORT_FINALIZE(RS_RET_NO_RUN);
+        }
+    }
+
     for (inst = runModConf->root; inst != NULL; inst = inst->next) {
         if (cs.stateFile) {
             char *new_stateFile;
@@ -1200,6 +1304,9 @@ BEGINfreeCnf
         inst = inst->next;
         free(del);
     }
+    /* the final cursors were persisted in afterRun */
+    statestoreClose(&pStateStore);
+    free(cs.stateStore);
     free(cs.stateFile);
     free(cs.usePid);
     free(cs.dfltTag);
@@ -1316,6 +1423,10 @@ BEGINsetModCnf
             cs.bRemote = (int)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "defaulttag")) {
             cs.dfltTag = (char *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(modpblk.descr[i].name, "statestore")) {
+            cs.stateStore = (char *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(modpblk.descr[i].name, "statestore.commitinterval")) {
+            cs.iStateStoreCommitInterval = (int)pvals[i].val.d.n;
         } else {
             dbgprintf(
                 "imjournal: program error, non-handled "
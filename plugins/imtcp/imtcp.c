@@ -125,6 +125,7 @@ struct instanceConf_s {
     int iTCPSessMax;
     int iTCPLstnMax;
     unsigned numWrkr;
+    sbool bWrkrReusePort; /* each worker has its own epoll set and SO_REUSEPORT listener */
     tcpLstnParams_t *cnf_params; /**< listener config parameters */
     uchar *pszBindRuleset; /* name of ruleset to bind to */
     ruleset_t *pBindRuleset; /* ruleset to bind listener to (use system default if unspecified) */
@@ -171,6 +172,7 @@ struct modConfData_s {
     int iTCPSessMax; /* max number of sessions */
     int iTCPLstnMax; /* max number of sessions */
     unsigned numWrkr;
+    sbool bWrkrReusePort;
     int iStrmDrvrMode; /* mode for stream driver, driver-dependent (0 mostly means plain tcp) */
     int iStrmDrvrExtendedCertCheck; /* verify also purpose OID in certificate extended field */
     int iStrmDrvrSANPreference; /* ignore CN when any SAN set */
@@ -218,6 +220,7 @@ static struct cnfparamdescr modpdescr[] = {{"flowcontrol", eCmdHdlrBinary, 0},
                                            {"maxlistners", eCmdHdlrPositiveInt, 0},
                                            {"maxlisteners", eCmdHdlrPositiveInt, 0},
                                            {"workerthreads", eCmdHdlrPositiveInt, 0},
+                                           {"workerthreads.reuseport", eCmdHdlrBinary, 0},
                                            {"starvationprotection.maxreads", eCmdHdlrNonNegInt, 0},
                                            {"streamdriver.mode", eCmdHdlrNonNegInt, 0},
                                            {"streamdriver.authmode", eCmdHdlrString, 0},
@@ -245,6 +248,7 @@ static struct cnfparamdescr inppdescr[] = {{"port", eCmdHdlrString, CNFPARAM_REQ
                                            {"maxsessions", eCmdHdlrPositiveInt, 0},
                                            {"maxlisteners", eCmdHdlrPositiveInt, 0},
                                            {"workerthreads", eCmdHdlrPositiveInt, 0},
+                                           {"workerthreads.reuseport", eCmdHdlrBinary, 0},
                                            {"flowcontrol", eCmdHdlrBinary, 0},
                                            {"disablelfdelimiter", eCmdHdlrBinary, 0},
                                            {"discardtruncatedmsg", eCmdHdlrBinary, 0},
@@ -395,6 +399,7 @@ static rsRetVal createInstance(instanceConf_t **pinst) {
     inst->iTCPLstnMax = loadModConf->iTCPLstnMax;
     inst->iTCPSessMax = loadModConf->iTCPSessMax;
     inst->numWrkr = loadModConf->numWrkr;
+    inst->bWrkrReusePort = loadModConf->bWrkrReusePort;
     inst->starvationMaxReads = loadModConf->starvationMaxReads;
 
     inst->cnf_params->pszLstnPortFileName = NULL;
@@ -465,6 +470,7 @@ static rsRetVal addInstance(void __attribute__((unused)) * pVal, uchar *pNewVal)
     inst->iTCPLstnMax = cs.iTCPLstnMax;
     inst->iTCPSessMax = cs.iTCPSessMax;
     inst->numWrkr = DEFAULT_NUMWRKR;
+    inst->bWrkrReusePort = 0;
     inst->starvationMaxReads = DEFAULT_STARVATIONMAXREADS;
     inst->iStrmDrvrMode = cs.iStrmDrvrMode;
 
@@ -490,6 +496,7 @@ static rsRetVal addListner(modConfData_t *modConf, instanceConf_t *inst) {
     CHKiRet(tcpsrv.SetCBOnErrClose(pOurTcpsrv, onErrClose));
     /* params */
     CHKiRet(tcpsrv.SetNumWrkr(pOurTcpsrv, inst->numWrkr));
+    CHKiRet(tcpsrv.SetWrkrReusePort(pOurTcpsrv, inst->bWrkrReusePort));
     CHKiRet(tcpsrv.SetStarvationMaxReads(pOurTcpsrv, inst->starvationMaxReads));
     CHKiRet(tcpsrv.SetKeepAlive(pOurTcpsrv, inst->bKeepAlive));
     CHKiRet(tcpsrv.SetKeepAliveIntvl(pOurTcpsrv, inst->iKeepAliveIntvl));
@@ -682,6 +689,8 @@ BEGINnewInpInst
             inst->iTCPLstnMax = (int)pvals[i].val.d.n;
         } else if (!strcmp(inppblk.descr[i].name, "workerthreads")) {
             inst->numWrkr = (int)pvals[i].val.d.n;
+        } else if (!strcmp(inppblk.descr[i].name, "workerthreads.reuseport")) {
+            inst->bWrkrReusePort = (sbool)pvals[i].val.d.n;
         } else if (!strcmp(inppblk.descr[i].name, "supportoctetcountedframing")) {
             inst->cnf_params->bSuppOctetFram = (int)pvals[i].val.d.n;
         } else if (!strcmp(inppblk.descr[i].name, "keepalive")) {
@@ -722,6 +731,7 @@ BEGINbeginCnfLoad
     loadModConf->iTCPSessMax = 200;
     loadModConf->iTCPLstnMax = 20;
     loadModConf->numWrkr = DEFAULT_NUMWRKR;
+    loadModConf->bWrkrReusePort = 0;
     loadModConf->starvationMaxReads = DEFAULT_STARVATIONMAXREADS;
     loadModConf->bSuppOctetFram = 1;
     loadModConf->iStrmDrvrMode = 0;
@@ -810,6 +820,8 @@ BEGINsetModCnf
             loadModConf->iTCPLstnMax = (int)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "workerthreads")) {
             loadModConf->numWrkr = (int)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "workerthreads.reuseport")) {
+            loadModConf->bWrkrReusePort = (sbool)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "keepalive")) {
             loadModConf->bKeepAlive = (int)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "keepalive.probes")) {
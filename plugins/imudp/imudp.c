@@ -32,6 +32,7 @@
 #include <unistd.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <netinet/udp.h>
 #include <pthread.h>
 #include <signal.h>
 #include <poll.h>
@@ -44,6 +45,9 @@
 #ifdef HAVE_SYS_PRCTL_H
     #include <sys/prctl.h>
 #endif
+#ifdef HAVE_LINUX_FILTER_H
+    #include <linux/filter.h>
+#endif
 #include "rsyslog.h"
 #include "dirty.h"
 #include "net.h"
@@ -60,6 +64,7 @@
 #include "statsobj.h"
 #include "ratelimit.h"
 #include "unicode-helper.h"
+#include "cpuaffinity.h"
 
 MODULE_TYPE_INPUT;
 MODULE_TYPE_NOKEEP;
@@ -77,22 +82,35 @@ DEFobjCurrIf(glbl) DEFobjCurrIf(net) DEFobjCurrIf(datetime) DEFobjCurrIf(prop) D
         static struct lstn_s {
     struct lstn_s *next;
     int sock; /* socket */
+    int *shardSocks; /* with reusePort: the socket of each worker (shardSocks[0] is sock), else NULL */
     ruleset_t *pRuleset; /* bound ruleset */
     prop_t *pInputName;
     statsobj_t *stats; /* listener stats */
     ratelimit_t *ratelimiter;
     uchar *dfltTZ;
+    sbool bGRO; /* UDP_GRO is enabled on the socket(s) */
     STATSCOUNTER_DEF(ctrSubmit, mutCtrSubmit)
     STATSCOUNTER_DEF(ctrDisallowed, mutCtrDisallowed)
+    STATSCOUNTER_DEF(ctrGROBufs, mutCtrGROBufs)
+    STATSCOUNTER_DEF(ctrGROSegs, mutCtrGROSegs)
 } *lcnfRoot = NULL, *lcnfLast = NULL;
 
 
 static int bLegacyCnfModGlobalsPermitted; /* are legacy module-global config parameters permitted? */
 static int bDoACLCheck; /* are ACL checks neeed? Cached once immediately before listener startup */
 static int iMaxLine; /* maximum UDP message size supported */
+static int iRcvLen; /* size of a receive buffer, at least iMaxLine (larger with GRO) */
 #define BATCH_SIZE_DFLT 32 /* do not overdo, has heavy toll on memory, especially with large msgs */
 #define TIME_REQUERY_DFLT 2
 #define SCHED_PRIO_UNSET -12345678 /* a value that indicates that the scheduling priority has not been set */
+/* how the kernel distributes datagrams across the sockets of a listener with reusePort */
+#define STEERING_HASH 0 /* by flow hash (kernel default) */
+#define STEERING_CPU 1 /* by the CPU that received the datagram */
+#if defined(HAVE_RECVMMSG) && defined(UDP_GRO)
+    #define USE_UDP_GRO 1
+#endif
+#define GRO_BUF_LEN 65535 /* a coalesced GRO buffer can hold up to a maximum size IP packet */
+#define GRO_CTL_LEN CMSG_SPACE(sizeof(int)) /* control buffer for the GRO segment size */
 /* config vars for legacy config system */
 static struct configSettings_s {
     uchar *pszBindAddr; /* IP to bind socket to */
@@ -127,6 +145,7 @@ struct instanceConf_s {
  */
 static struct wrkrInfo_s {
     pthread_t tid; /* the worker's thread ID */
+    sbool bRunning; /* tid is valid, the thread must be joined */
     int id;
     thrdInfo_t *pThrd;
     statsobj_t *stats; /* worker thread stats */
@@ -138,6 +157,7 @@ static struct wrkrInfo_s {
     struct sockaddr_storage *frominet;
     struct mmsghdr *recvmsg_mmh;
     struct iovec *recvmsg_iov;
+    uchar *recvmsg_ctl; /* with GRO: control buffer for each batch element, else NULL */
 #endif
 } wrkrInfo[MAX_WRKR_THREADS];
 
@@ -147,9 +167,15 @@ struct modConfData_s {
     uchar *pszSchedPolicy; /* scheduling policy string */
     int iSchedPolicy; /* scheduling policy as SCHED_xxx */
     int iSchedPrio; /* scheduling priority */
+    uchar *pszCpuset; /* CPUs to run the workers on, NULL if not set */
+    int iNumaNode; /* NUMA node to run the workers on, CPUAFFINITY_NO_NODE if not set */
+    cpuaffinity_t *pAffinity; /* placement built from the above, NULL if none */
     int iTimeRequery; /* how often is time to be queried inside tight recv loop? 0=always */
     int batchSize; /* max nbr of input batch --> also recvmmsg() max count */
     int8_t wrkrMax; /* max nbr of worker threads */
+    sbool bReusePort; /* one SO_REUSEPORT socket per worker and listener */
+    int iSteering; /* STEERING_xxx, only with bReusePort */
+    sbool bGRO; /* receive with UDP_GRO */
     sbool configSetViaV2Method;
     sbool bPreserveCase; /* preserves the case of fromhost; "off" by default */
 };
@@ -159,10 +185,15 @@ static modConfData_t *runModConf = NULL; /* modConf ptr to use for the current l
 /* module-global parameters */
 static struct cnfparamdescr modpdescr[] = {{"schedulingpolicy", eCmdHdlrGetWord, 0},
                                            {"schedulingpriority", eCmdHdlrInt, 0},
+                                           {"cpuset", eCmdHdlrString, 0},
+                                           {"numanode", eCmdHdlrNonNegInt, 0},
                                            {"batchsize", eCmdHdlrInt, 0},
                                            {"threads", eCmdHdlrPositiveInt, 0},
                                            {"timerequery", eCmdHdlrInt, 0},
-                                           {"preservecase", eCmdHdlrBinary, 0}};
+                                           {"preservecase", eCmdHdlrBinary, 0},
+                                           {"reuseport", eCmdHdlrBinary, 0},
+                                           {"reuseport.steering", eCmdHdlrGetWord, 0},
+                                           {"gro", eCmdHdlrBinary, 0}};
 static struct cnfparamblk modpblk = {CNFPARAMBLK_VERSION, sizeof(modpdescr) / sizeof(struct cnfparamdescr), modpdescr};
 
 /* input instance parameters */
@@ -252,15 +283,111 @@ finalize_it:
 }
 
 
+/* Make the kernel pass each datagram for the SO_REUSEPORT group of sock to
+ * the socket with the index of the CPU that received it (modulo the group
+ * size). As the sockets were bound in worker order, a datagram is then
+ * processed by the same worker for each CPU, which keeps the data in that
+ * CPU's caches if the NIC queues are spread over the CPUs (RSS/RPS).
+ * The (classic) BPF program is attached to the group as a whole.
+ */
+static void attachCpuSteering(const int sock, const int nShards, const uchar *const port) {
+#if defined(HAVE_LINUX_FILTER_H) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU}, /* A = receiving CPU */
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)nShards}, /* A %= nShards */
+        {BPF_RET | BPF_A, 0, 0, 0} /* deliver to socket A */
+    };
+    struct sock_fprog prog;
+
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+    if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+        LogError(errno, RS_RET_ERR,
+                 "imudp: cannot attach CPU steering program for port %s - "
+                 "datagrams are distributed by flow hash",
+                 port);
+    }
+#else
+    (void)sock;
+    (void)nShards;
+    LogError(0, RS_RET_NOT_IMPLEMENTED,
+             "imudp: reusePort.steering=\"cpu\" is not supported on this platform, "
+             "datagrams for port %s are distributed by flow hash",
+             port);
+#endif
+}
+
+
+/* Permit the kernel to coalesce datagrams of the same flow into one receive
+ * buffer (UDP GRO). Returns 1 if that worked, 0 otherwise.
+ */
+static int enableGRO(const int sock, const uchar *const port) {
+#ifdef USE_UDP_GRO
+    const int one = 1;
+
+    if (setsockopt(sock, SOL_UDP, UDP_GRO, &one, sizeof(one)) == 0) return 1;
+    LogError(errno, RS_RET_ERR, "imudp: cannot enable GRO for port %s, receiving without it", port);
+#else
+    (void)sock;
+    (void)port;
+#endif
+    return 0;
+}
+
+
+/* Obtain the port sock is bound to, as a string. Returns 0 on success. */
+static int getBoundPort(const int sock, uchar *const pszBuf, const size_t lenBuf) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+
+    if (getsockname(sock, (struct sockaddr *)&addr, &len) < 0) {
+        LogError(errno, RS_RET_IO_ERROR, "imudp: could not obtain dynamic listen port");
+        return -1;
+    }
+    snprintf((char *)pszBuf, lenBuf, "%u",
+             ntohs((addr.ss_family == AF_INET6) ? ((struct sockaddr_in6 *)&addr)->sin6_port
+                                                : ((struct sockaddr_in *)&addr)->sin_port));
+    return 0;
+}
+
+
+/* The sockets were created for a SO_REUSEPORT group that did not come about.
+ * Take them out of it, so that no other socket can join the address and
+ * receive a share of its datagrams.
+ */
+static void clearReusePort(const int *const socks) {
+#if defined(SO_REUSEPORT)
+    const int off = 0;
+
+    for (int i = 1; i <= socks[0]; ++i) {
+        if (setsockopt(socks[i], SOL_SOCKET, SO_REUSEPORT, &off, sizeof(off)) < 0) {
+            LogError(errno, RS_RET_ERR, "imudp: cannot clear SO_REUSEPORT on socket %d", socks[i]);
+        }
+    }
+#else
+    (void)socks;
+#endif
+}
+
+
 /* This function is called when a new listener shall be added. It takes
  * the instance config description, tries to bind the socket and, if that
  * succeeds, adds it to the list of existing listen sockets.
+ * With reusePort, each worker gets its own socket for each listener (socket
+ * i of a listener belongs to worker i). They are all bound to the same
+ * address via SO_REUSEPORT and the kernel distributes the datagrams across
+ * them, so the workers do not contend for a single socket.
  */
 static rsRetVal addListner(instanceConf_t *inst) {
     DEFiRet;
     uchar *bindAddr;
     int *newSocks;
+    int *shardSocks[MAX_WRKR_THREADS]; /* newSocks of each worker, [0] is newSocks itself */
+    int nShards;
+    sbool bShardsWanted;
+    uchar portBuf[8];
     int iSrc;
+    int i;
     struct lstn_s *newlcnfinfo;
     uchar *bindName;
     uchar *port;
@@ -281,7 +408,49 @@ static rsRetVal addListner(instanceConf_t *inst) {
 
     DBGPRINTF("Trying to open syslog UDP ports at %s:%s.\n", bindName, inst->pszBindPort);
 
-    newSocks = net.create_udp_socket(bindAddr, port, 1, inst->rcvbuf, 0, inst->ipfreebind, inst->pszBindDevice);
+    bShardsWanted = runModConf->bReusePort && runModConf->wrkrMax > 1;
+    nShards = bShardsWanted ? runModConf->wrkrMax : 1;
+    newSocks = net.create_udp_socket(bindAddr, port, 1, inst->rcvbuf, 0, inst->ipfreebind, inst->pszBindDevice,
+                                     nShards > 1);
+    shardSocks[0] = newSocks;
+    if (newSocks != NULL && nShards > 1 && !strcmp((char *)port, "0")) {
+        /* each socket would get a port of its own; the sockets of the other
+         * workers must join the group of the first one. That port may not be
+         * free for other addresses, so this only works with a single one.
+         */
+        if (newSocks[0] == 1 && getBoundPort(newSocks[1], portBuf, sizeof(portBuf)) == 0) {
+            port = portBuf;
+        } else {
+            LogError(0, RS_RET_ERR,
+                     "imudp: a dynamic port for bind-address %s needs a single address "
+                     "for a socket per worker, workers share one socket instead",
+                     bindName);
+            nShards = 1;
+        }
+    }
+    for (i = 1; newSocks != NULL && i < nShards; ++i) {
+        shardSocks[i] = net.create_udp_socket(bindAddr, port, 1, inst->rcvbuf, 0, inst->ipfreebind,
+                                              inst->pszBindDevice, 1);
+        if (shardSocks[i] == NULL || shardSocks[i][0] != newSocks[0]) {
+            LogError(0, RS_RET_ERR,
+                     "imudp: could not create a socket per worker for port %s "
+                     "bind-address %s, workers share one socket instead",
+                     port, bindName);
+            for (; i > 0; --i) {
+                if (shardSocks[i] != NULL) {
+                    for (iSrc = 1; iSrc <= shardSocks[i][0]; ++iSrc) {
+                        close(shardSocks[i][iSrc]);
+                    }
+                    free(shardSocks[i]);
+                }
+            }
+            nShards = 1;
+            break;
+        }
+    }
+    if (newSocks != NULL && bShardsWanted && nShards == 1) {
+        clearReusePort(newSocks);
+    }
     if (newSocks != NULL) {
         /* we now need to add the new sockets to the existing set */
         /* ready to copy */
@@ -292,6 +461,21 @@ static rsRetVal addListner(instanceConf_t *inst) {
             CHKmalloc(newlcnfinfo = (struct lstn_s *)calloc(1, sizeof(struct lstn_s)));
             newlcnfinfo->next = NULL;
             newlcnfinfo->sock = newSocks[iSrc];
+            if (nShards > 1) {
+                CHKmalloc(newlcnfinfo->shardSocks = malloc(nShards * sizeof(int)));
+                for (i = 0; i < nShards; ++i) {
+                    newlcnfinfo->shardSocks[i] = shardSocks[i][iSrc];
+                }
+                if (runModConf->iSteering == STEERING_CPU) {
+                    attachCpuSteering(newlcnfinfo->sock, nShards, port);
+                }
+            }
+            if (runModConf->bGRO) {
+                newlcnfinfo->bGRO = enableGRO(newlcnfinfo->sock, port);
+                for (i = 1; newlcnfinfo->bGRO && i < nShards; ++i) {
+                    newlcnfinfo->bGRO = enableGRO(newlcnfinfo->shardSocks[i], port);
+                }
+            }
             newlcnfinfo->pRuleset = inst->pBindRuleset;
             newlcnfinfo->dfltTZ = inst->dfltTZ;
             newlcnfinfo->ratelimiter = NULL;
@@ -336,6 +520,15 @@ static rsRetVal addListner(instanceConf_t *inst) {
             STATSCOUNTER_INIT(newlcnfinfo->ctrDisallowed, newlcnfinfo->mutCtrDisallowed);
             CHKiRet(statsobj.AddCounter(newlcnfinfo->stats, UCHAR_CONSTANT("disallowed"), ctrType_IntCtr,
                                         CTR_FLAG_RESETTABLE, &(newlcnfinfo->ctrDisallowed)));
+            if (newlcnfinfo->bGRO) {
+                /* gro.segments / gro.buffers is the average number of datagrams per receive */
+                STATSCOUNTER_INIT(newlcnfinfo->ctrGROBufs, newlcnfinfo->mutCtrGROBufs);
+                CHKiRet(statsobj.AddCounter(newlcnfinfo->stats, UCHAR_CONSTANT("gro.buffers"), ctrType_IntCtr,
+                                            CTR_FLAG_RESETTABLE, &(newlcnfinfo->ctrGROBufs)));
+                STATSCOUNTER_INIT(newlcnfinfo->ctrGROSegs, newlcnfinfo->mutCtrGROSegs);
+                CHKiRet(statsobj.AddCounter(newlcnfinfo->stats, UCHAR_CONSTANT("gro.segments"), ctrType_IntCtr,
+                                            CTR_FLAG_RESETTABLE, &(newlcnfinfo->ctrGROSegs)));
+            }
             CHKiRet(statsobj.ConstructFinalize(newlcnfinfo->stats));
             /* link to list. Order must be preserved to take care for
              * conflicting matches.
@@ -361,15 +554,21 @@ finalize_it:
             if (newlcnfinfo->ratelimiter != NULL) ratelimitDestruct(newlcnfinfo->ratelimiter);
             if (newlcnfinfo->pInputName != NULL) prop.Destruct(&newlcnfinfo->pInputName);
             if (newlcnfinfo->stats != NULL) statsobj.Destruct(&newlcnfinfo->stats);
+            free(newlcnfinfo->shardSocks);
             free(newlcnfinfo);
         }
         /* close the rest of the open sockets as there's
            nowhere to put them */
         for (; iSrc <= newSocks[0]; iSrc++) {
-            close(newSocks[iSrc]);
+            for (i = 0; i < nShards; ++i) {
+                close(shardSocks[i][iSrc]);
+            }
         }
     }
 
+    for (i = 1; i < nShards; ++i) {
+        free(shardSocks[i]);
+    }
     free(newSocks);
     RETiRet;
 }
@@ -383,6 +582,12 @@ static inline void std_checkRuleset_genErrMsg(__attribute__((unused)) modConfDat
 }
 
 
+/* the socket a worker receives on for a listener */
+static inline int lstnSock(const struct lstn_s *const lstn, const struct wrkrInfo_s *const pWrkr) {
+    return (lstn->shardSocks == NULL) ? lstn->sock : lstn->shardSocks[pWrkr->id];
+}
+
+
 /* This function processes received data. It provides unified handling
  * in cases where recvmmsg() is available and not.
  */
@@ -461,6 +666,49 @@ finalize_it:
 }
 
 
+#ifdef USE_UDP_GRO
+/* Process a buffer received with UDP_GRO. The kernel may have coalesced
+ * several datagrams of one sender into it. All of them have the segment
+ * size passed in the control message, except for the last one, which may
+ * be shorter. Each datagram is processed as if received by itself.
+ * Returns the number of datagrams in the buffer.
+ */
+static int processGROBuf(struct lstn_s *lstn,
+                         struct mmsghdr *mmh,
+                         struct sockaddr_storage *frominetPrev,
+                         int *pbIsPermitted,
+                         struct syslogTime *stTime,
+                         time_t ttGenTime,
+                         struct sockaddr_storage *frominet,
+                         multi_submit_t *multiSub) {
+    uchar *const buf = mmh->msg_hdr.msg_iov->iov_base;
+    const int lenBuf = mmh->msg_len;
+    struct cmsghdr *cmsg;
+    int lenSeg = 0;
+    int lenDgram;
+    int offs = 0;
+    int nSegs = 0;
+
+    for (cmsg = CMSG_FIRSTHDR(&mmh->msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&mmh->msg_hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+            memcpy(&lenSeg, CMSG_DATA(cmsg), sizeof(lenSeg));
+        }
+    }
+    if (lenSeg <= 0 || lenSeg > lenBuf) lenSeg = lenBuf; /* not coalesced */
+
+    do {
+        lenDgram = (lenBuf - offs < lenSeg) ? lenBuf - offs : lenSeg;
+        /* truncate like the kernel does without GRO */
+        processPacket(lstn, frominetPrev, pbIsPermitted, buf + offs, (lenDgram > iMaxLine) ? iMaxLine : lenDgram,
+                      stTime, ttGenTime, frominet, mmh->msg_hdr.msg_namelen, multiSub);
+        offs += lenDgram;
+        ++nSegs;
+    } while (offs < lenBuf);
+    return nSegs;
+}
+#endif /* #ifdef USE_UDP_GRO */
+
+
 /* The following "two" functions are helpers to runInput. Actually, it is
  * just one function. Depending on whether or not we have recvmmsg(),
  * an appropriate version is compiled (as such we need to maintain both!).
@@ -479,6 +727,7 @@ static rsRetVal processSocket(struct wrkrInfo_s *pWrkr,
     char errStr[1024];
     smsg_t *pMsgs[CONF_NUM_MULTISUB];
     multi_submit_t multiSub;
+    const int sock = lstnSock(lstn, pWrkr);
     int nelem;
     int i;
 
@@ -491,20 +740,24 @@ static rsRetVal processSocket(struct wrkrInfo_s *pWrkr,
         memset(pWrkr->recvmsg_iov, 0, runModConf->batchSize * sizeof(struct iovec));
         memset(pWrkr->recvmsg_mmh, 0, runModConf->batchSize * sizeof(struct mmsghdr));
         for (i = 0; i < runModConf->batchSize; ++i) {
-            pWrkr->recvmsg_iov[i].iov_base = pWrkr->pRcvBuf + (i * (iMaxLine + 1));
-            pWrkr->recvmsg_iov[i].iov_len = iMaxLine;
+            pWrkr->recvmsg_iov[i].iov_base = pWrkr->pRcvBuf + (i * (iRcvLen + 1));
+            pWrkr->recvmsg_iov[i].iov_len = iRcvLen;
             pWrkr->recvmsg_mmh[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
             pWrkr->recvmsg_mmh[i].msg_hdr.msg_name = &(pWrkr->frominet[i]);
             pWrkr->recvmsg_mmh[i].msg_hdr.msg_iov = &(pWrkr->recvmsg_iov[i]);
             pWrkr->recvmsg_mmh[i].msg_hdr.msg_iovlen = 1;
+            if (pWrkr->recvmsg_ctl != NULL) {
+                pWrkr->recvmsg_mmh[i].msg_hdr.msg_control = pWrkr->recvmsg_ctl + (i * GRO_CTL_LEN);
+                pWrkr->recvmsg_mmh[i].msg_hdr.msg_controllen = GRO_CTL_LEN;
+            }
         }
-        nelem = recvmmsg(lstn->sock, pWrkr->recvmsg_mmh, runModConf->batchSize, 0, NULL);
+        nelem = recvmmsg(sock, pWrkr->recvmsg_mmh, runModConf->batchSize, 0, NULL);
         STATSCOUNTER_INC(pWrkr->ctrCall_recvmmsg, pWrkr->mutCtrCall_recvmmsg);
         DBGPRINTF("imudp: recvmmsg returned %d (errno %d)\n", nelem, errno);
         if (nelem < 0 && errno == ENOSYS) {
             /* be careful: some versions of valgrind do not support recvmmsg()! */
             DBGPRINTF("imudp: error ENOSYS on call to recvmmsg() - fall back to recvmsg\n");
-            nelem = recvmsg(lstn->sock, &(pWrkr->recvmsg_mmh[0].msg_hdr), 0);
+            nelem = recvmsg(sock, &(pWrkr->recvmsg_mmh[0].msg_hdr), 0);
             STATSCOUNTER_INC(pWrkr->ctrCall_recvmsg, pWrkr->mutCtrCall_recvmsg);
             if (nelem >= 0) {
                 pWrkr->recvmsg_mmh[0].msg_len = nelem;
@@ -525,6 +778,21 @@ static rsRetVal processSocket(struct wrkrInfo_s *pWrkr,
             datetime.getCurrTime(&stTime, &ttGenTime, TIME_IN_LOCALTIME);
         }
 
+#ifdef USE_UDP_GRO
+        if (pWrkr->recvmsg_ctl != NULL) {
+            int nSegs = 0;
+            for (i = 0; i < nelem; ++i) {
+                nSegs += processGROBuf(lstn, &(pWrkr->recvmsg_mmh[i]), frominetPrev, pbIsPermitted, &stTime,
+                                       ttGenTime, &(pWrkr->frominet[i]), &multiSub);
+            }
+            pWrkr->ctrMsgsRcvd += nSegs;
+            if (lstn->bGRO) {
+                STATSCOUNTER_ADD(lstn->ctrGROBufs, lstn->mutCtrGROBufs, nelem);
+                STATSCOUNTER_ADD(lstn->ctrGROSegs, lstn->mutCtrGROSegs, nSegs);
+            }
+            continue;
+        }
+#endif
         pWrkr->ctrMsgsRcvd += nelem;
         for (i = 0; i < nelem; ++i) {
             processPacket(lstn, frominetPrev, pbIsPermitted, pWrkr->recvmsg_mmh[i].msg_hdr.msg_iov->iov_base,
@@ -566,6 +834,7 @@ static rsRetVal processSocket(struct wrkrInfo_s *pWrkr,
     char errStr[1024];
     struct msghdr mh;
     struct iovec iov[1];
+    const int sock = lstnSock(lstn, pWrkr);
     DEFiRet;
 
     multiSub.ppMsgs = pMsgs;
@@ -582,7 +851,7 @@ static rsRetVal processSocket(struct wrkrInfo_s *pWrkr,
         mh.msg_namelen = sizeof(struct sockaddr_storage);
         mh.msg_iov = iov;
         mh.msg_iovlen = 1;
-        lenRcvBuf = recvmsg(lstn->sock, &mh, 0);
+        lenRcvBuf = recvmsg(sock, &mh, 0);
         STATSCOUNTER_INC(pWrkr->ctrCall_recvmsg, pWrkr->mutCtrCall_recvmsg);
         if (lenRcvBuf < 0) {
             if (errno != EINTR && errno != EAGAIN) {
@@ -778,9 +1047,9 @@ static rsRetVal rcvMainLoop(struct wrkrInfo_s *const __restrict__ pWrkr) {
         if (lstn->sock != -1) {
             udpEPollEvt[i].events = EPOLLIN | EPOLLET;
             udpEPollEvt[i].data.ptr = lstn;
-            if (epoll_ctl(efd, EPOLL_CTL_ADD, lstn->sock, &(udpEPollEvt[i])) < 0) {
+            if (epoll_ctl(efd, EPOLL_CTL_ADD, lstnSock(lstn, pWrkr), &(udpEPollEvt[i])) < 0) {
                 rs_strerror_r(errno, errStr, sizeof(errStr));
-                LogError(errno, NO_ERRCODE, "epoll_ctrl failed on fd %d with %s\n", lstn->sock, errStr);
+                LogError(errno, NO_ERRCODE, "epoll_ctrl failed on fd %d with %s\n", lstnSock(lstn, pWrkr), errStr);
             }
         }
         i++;
@@ -836,7 +1105,7 @@ static rsRetVal ATTR_NONNULL() rcvMainLoop(struct wrkrInfo_s *const __restrict__
     for (lstn = lcnfRoot; lstn != NULL; lstn = lstn->next) {
         assert(i < nfd);
         if (lstn->sock != -1) {
-            pollfds[i].fd = lstn->sock;
+            pollfds[i].fd = lstnSock(lstn, pWrkr);
             pollfds[i].events = POLLIN;
             ++i;
         }
@@ -1003,7 +1272,13 @@ BEGINbeginCnfLoad
     loadModConf->iTimeRequery = TIME_REQUERY_DFLT;
     loadModConf->iSchedPrio = SCHED_PRIO_UNSET;
     loadModConf->pszSchedPolicy = NULL;
+    loadModConf->pszCpuset = NULL;
+    loadModConf->iNumaNode = CPUAFFINITY_NO_NODE;
+    loadModConf->pAffinity = NULL;
     loadModConf->bPreserveCase = 0; /* off */
+    loadModConf->bReusePort = 0;
+    loadModConf->bGRO = 0;
+    loadModConf->iSteering = STEERING_HASH;
     bLegacyCnfModGlobalsPermitted = 1;
     /* init legacy config vars */
     cs.pszBindRuleset = NULL;
@@ -1043,6 +1318,10 @@ BEGINsetModCnf
             loadModConf->iSchedPrio = (int)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "schedulingpolicy")) {
             loadModConf->pszSchedPolicy = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(modpblk.descr[i].name, "cpuset")) {
+            loadModConf->pszCpuset = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(modpblk.descr[i].name, "numanode")) {
+            loadModConf->iNumaNode = (int)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "threads")) {
             wrkrMax = (int)pvals[i].val.d.n;
             if (wrkrMax > MAX_WRKR_THREADS) {
@@ -1056,6 +1335,23 @@ BEGINsetModCnf
             }
         } else if (!strcmp(modpblk.descr[i].name, "preservecase")) {
             loadModConf->bPreserveCase = (int)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "gro")) {
+            loadModConf->bGRO = (sbool)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "reuseport")) {
+            loadModConf->bReusePort = (sbool)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "reuseport.steering")) {
+            char *const steering = es_str2cstr(pvals[i].val.d.estr, NULL);
+            if (!strcasecmp(steering, "hash")) {
+                loadModConf->iSteering = STEERING_HASH;
+            } else if (!strcasecmp(steering, "cpu")) {
+                loadModConf->iSteering = STEERING_CPU;
+            } else {
+                LogError(0, RS_RET_PARAM_ERROR,
+                         "imudp: invalid reusePort.steering '%s', "
+                         "must be \"hash\" or \"cpu\" - using \"hash\"",
+                         steering);
+            }
+            free(steering);
         } else {
             dbgprintf(
                 "imudp: program error, non-handled "
@@ -1099,6 +1395,24 @@ BEGINcheckCnf
     instanceConf_t *inst;
     CODESTARTcheckCnf;
     checkSchedParam(pModConf); /* this can not cause fatal errors */
+    if (pModConf->pszCpuset != NULL || pModConf->iNumaNode != CPUAFFINITY_NO_NODE) {
+        /* not fatal either: on error, the workers just run unpinned */
+        cpuaffinityConstruct(&pModConf->pAffinity, (char *)pModConf->pszCpuset, pModConf->iNumaNode, "imudp");
+    }
+    if (pModConf->bReusePort && pModConf->wrkrMax < 2) {
+        LogMsg(0, RS_RET_OK_WARN, LOG_WARNING,
+               "imudp: reusePort has no effect with a single worker thread, "
+               "see the \"threads\" parameter");
+    }
+    if (!pModConf->bReusePort && pModConf->iSteering != STEERING_HASH) {
+        LogMsg(0, RS_RET_OK_WARN, LOG_WARNING, "imudp: reusePort.steering is ignored as reusePort is off");
+    }
+#ifndef USE_UDP_GRO
+    if (pModConf->bGRO) {
+        LogError(0, RS_RET_NOT_IMPLEMENTED, "imudp: gro is not supported on this platform, receiving without it");
+        pModConf->bGRO = 0;
+    }
+#endif
     for (inst = pModConf->root; inst != NULL; inst = inst->next) {
         std_checkRuleset(pModConf, inst);
     }
@@ -1136,7 +1450,8 @@ BEGINactivateCnf
     CODESTARTactivateCnf;
     /* caching various settings */
     iMaxLine = glbl.GetMaxLine(runConf);
-    lenRcvBuf = iMaxLine + 1;
+    iRcvLen = (runModConf->bGRO && iMaxLine < GRO_BUF_LEN) ? GRO_BUF_LEN : iMaxLine;
+    lenRcvBuf = iRcvLen + 1;
 #ifdef HAVE_RECVMMSG
     lenRcvBuf *= runModConf->batchSize;
 #endif
@@ -1146,6 +1461,11 @@ BEGINactivateCnf
         CHKmalloc(wrkrInfo[i].recvmsg_iov = malloc(runModConf->batchSize * sizeof(struct iovec)));
         CHKmalloc(wrkrInfo[i].recvmsg_mmh = malloc(runModConf->batchSize * sizeof(struct mmsghdr)));
         CHKmalloc(wrkrInfo[i].frominet = malloc(runModConf->batchSize * sizeof(struct sockaddr_storage)));
+        if (runModConf->bGRO) {
+            CHKmalloc(wrkrInfo[i].recvmsg_ctl = malloc(runModConf->batchSize * GRO_CTL_LEN));
+        } else {
+            wrkrInfo[i].recvmsg_ctl = NULL;
+        }
 #endif
         CHKmalloc(wrkrInfo[i].pRcvBuf = malloc(lenRcvBuf));
         wrkrInfo[i].id = i;
@@ -1168,6 +1488,8 @@ BEGINfreeCnf
         inst = inst->next;
         free(del);
     }
+    free(pModConf->pszCpuset);
+    cpuaffinityDestruct(&pModConf->pAffinity);
 ENDfreeCnf
 
 
@@ -1193,6 +1515,10 @@ static void *wrkr(void *myself) {
      * privileges within the same instance.
      */
     setSchedParams(runModConf);
+    /* with a NUMA node, messages constructed by this thread are allocated on it */
+    if (runModConf->pAffinity != NULL) {
+        cpuaffinityApply(runModConf->pAffinity);
+    }
 
     /* support statistics gathering */
     statsobj.Construct(&(pWrkr->stats));
@@ -1215,6 +1541,18 @@ static void *wrkr(void *myself) {
     return NULL;
 }
 
+/* A worker could not be started. Its own sockets would keep receiving their
+ * share of the datagrams without anyone reading them, so they are closed and
+ * the kernel distributes the datagrams across the remaining ones.
+ */
+static void closeWrkrSocks(const int id) {
+    for (struct lstn_s *lstn = lcnfRoot; lstn != NULL; lstn = lstn->next) {
+        if (lstn->shardSocks == NULL) continue;
+        close(lstn->shardSocks[id]);
+        lstn->shardSocks[id] = -1;
+    }
+}
+
 /* This function is called to gather input.
  * In essence, it just starts the pool of workers. To save resources,
  * we run one of the workers on our own thread -- otherwise that thread would
@@ -1222,13 +1560,19 @@ static void *wrkr(void *myself) {
  */
 BEGINrunInput
     int i;
+    int r;
     pthread_attr_t wrkrThrdAttr;
     CODESTARTrunInput;
     pthread_attr_init(&wrkrThrdAttr);
     pthread_attr_setstacksize(&wrkrThrdAttr, 4096 * 1024);
     for (i = 0; i < runModConf->wrkrMax - 1; ++i) {
         wrkrInfo[i].pThrd = pThrd;
-        pthread_create(&wrkrInfo[i].tid, &wrkrThrdAttr, wrkr, &(wrkrInfo[i]));
+        r = pthread_create(&wrkrInfo[i].tid, &wrkrThrdAttr, wrkr, &(wrkrInfo[i]));
+        wrkrInfo[i].bRunning = (r == 0);
+        if (r != 0) {
+            LogError(r, RS_RET_ERR, "imudp: cannot start worker %d", i);
+            closeWrkrSocks(i);
+        }
     }
     pthread_attr_destroy(&wrkrThrdAttr);
 
@@ -1237,10 +1581,11 @@ BEGINrunInput
     wrkr(&wrkrInfo[i]);
 
     for (i = 0; i < runModConf->wrkrMax - 1; ++i) {
-        pthread_kill(wrkrInfo[i].tid, SIGTTIN);
+        if (wrkrInfo[i].bRunning) pthread_kill(wrkrInfo[i].tid, SIGTTIN);
     }
     for (i = 0; i < runModConf->wrkrMax - 1; ++i) {
-        pthread_join(wrkrInfo[i].tid, NULL);
+        if (wrkrInfo[i].bRunning) pthread_join(wrkrInfo[i].tid, NULL);
+        wrkrInfo[i].bRunning = 0;
     }
 ENDrunInput
 
@@ -1262,7 +1607,15 @@ BEGINafterRun
     for (lstn = lcnfRoot; lstn != NULL;) {
         statsobj.Destruct(&(lstn->stats));
         ratelimitDestruct(lstn->ratelimiter);
-        close(lstn->sock);
+        if (lstn->shardSocks == NULL) {
+            close(lstn->sock);
+        } else {
+            /* shardSocks[0] is sock */
+            for (i = 0; i < runModConf->wrkrMax; ++i) {
+                if (lstn->shardSocks[i] != -1) close(lstn->shardSocks[i]);
+            }
+            free(lstn->shardSocks);
+        }
         prop.Destruct(&lstn->pInputName);
         lstnDel = lstn;
         lstn = lstn->next;
@@ -1273,6 +1626,7 @@ BEGINafterRun
 #ifdef HAVE_RECVMMSG
         free(wrkrInfo[i].recvmsg_iov);
         free(wrkrInfo[i].recvmsg_mmh);
+        free(wrkrInfo[i].recvmsg_ctl);
         free(wrkrInfo[i].frominet);
 #endif
         free(wrkrInfo[i].pRcvBuf);
@@ -45,6 +45,7 @@
 #include "cfsysline.h"
 #include "dirty.h"
 #include "statsobj.h"
+#include "jsonlazy.h"
 
 MODULE_TYPE_OUTPUT;
 MODULE_TYPE_NOKEEP;
@@ -73,6 +74,8 @@ typedef struct _instanceData {
     parse_mode_t mode; /**< parsing mode: cookie or find-json */
     int max_scan_bytes; /**< max bytes to scan in find-json mode */
     sbool allow_trailing; /**< allow trailing data after JSON in find-json mode */
+    sbool bLazy; /**< cookie mode: only materialize referenced members */
+    jsonlazy_keys_t *lazyKeys; /**< referenced members, set if bLazy */
     /* TODO: add start_regex support in future enhancement */
 } instanceData;
 
@@ -101,7 +104,8 @@ static modConfData_t *runModConf = NULL; /* modConf ptr to use for the current e
 /* action (instance) parameters */
 static struct cnfparamdescr actpdescr[] = {
     {"cookie", eCmdHdlrString, 0}, {"container", eCmdHdlrString, 0},           {"userawmsg", eCmdHdlrBinary, 0},
-    {"mode", eCmdHdlrString, 0},   {"max_scan_bytes", eCmdHdlrPositiveInt, 0}, {"allow_trailing", eCmdHdlrBinary, 0}};
+    {"mode", eCmdHdlrString, 0},   {"max_scan_bytes", eCmdHdlrPositiveInt, 0}, {"allow_trailing", eCmdHdlrBinary, 0},
+    {"lazy", eCmdHdlrBinary, 0}};
 static struct cnfparamblk actpblk = {CNFPARAMBLK_VERSION, sizeof(actpdescr) / sizeof(struct cnfparamdescr), actpdescr};
 
 
@@ -183,6 +187,7 @@ BEGINfreeInstance
     CODESTARTfreeInstance;
     free(pData->cookie);
     free(pData->container);
+    jsonlazyKeysDestruct(&pData->lazyKeys);
 ENDfreeInstance
 
 BEGINfreeWrkrInstance
@@ -315,6 +320,18 @@ static rsRetVal processJSONBuffer(wrkrInstanceData_t *pWrkrData, smsg_t *pMsg, c
 
     assert(pWrkrData->tokener != NULL);
     DBGPRINTF("mmjsonparse: toParse: '%s'\n", buf);
+    if (pWrkrData->pData->lazyKeys != NULL) {
+        if (jsonlazyParse(pWrkrData->pData->lazyKeys, pWrkrData->tokener, buf, lenBuf, &json) != RS_RET_OK) {
+            DBGPRINTF("mmjsonparse: Error parsing JSON '%s'\n", buf);
+            ABORT_FINALIZE(RS_RET_NO_CEE_MSG);
+        }
+        if (!json_object_is_type(json, json_type_object)) {
+            json_object_put(json);
+            ABORT_FINALIZE(RS_RET_NO_CEE_MSG);
+        }
+        msgAddJSON(pMsg, pWrkrData->pData->container, json, 0, 0);
+        FINALIZE;
+    }
     json_tokener_reset(pWrkrData->tokener);
 
     json = json_tokener_parse_ex(pWrkrData->tokener, buf, lenBuf);
@@ -514,6 +531,8 @@ BEGINnewActInst
             }
         } else if (!strcmp(actpblk.descr[i].name, "allow_trailing")) {
             pData->allow_trailing = (int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "lazy")) {
+            pData->bLazy = (int)pvals[i].val.d.n;
         } else {
             dbgprintf("mmjsonparse: program error, non-handled param '%s'\n", actpblk.descr[i].name);
         }
@@ -521,6 +540,14 @@ BEGINnewActInst
 
     if (pData->container == NULL) CHKmalloc(pData->container = (uchar *)strdup("!"));
     pData->lenCookie = strlen(pData->cookie);
+    if (pData->bLazy) {
+        if (pData->mode == PARSE_MODE_COOKIE) {
+            CHKiRet(jsonlazyRegister(pData->container, &pData->lazyKeys));
+        } else {
+            LogMsg(0, RS_RET_CONF_PARAM_INVLD, LOG_WARNING,
+                   "mmjsonparse: lazy parsing is only supported in cookie mode, ignored");
+        }
+    }
     CODE_STD_FINALIZERnewActInst;
     cnfparamvalsDestruct(pvals, &actpblk);
 ENDnewActInst
@@ -77,6 +77,7 @@
 #include "statsobj.h"
 #include "unicode-helper.h"
 #include "datetime.h"
+#include "dyncache.h"
 
 MODULE_TYPE_OUTPUT;
 MODULE_TYPE_NOKEEP;
@@ -94,6 +95,7 @@ STATSCOUNTER_DEF(ctrKafkaFail, mutCtrKafkaFail);
 STATSCOUNTER_DEF(ctrCacheMiss, mutCtrCacheMiss);
 STATSCOUNTER_DEF(ctrCacheEvict, mutCtrCacheEvict);
 STATSCOUNTER_DEF(ctrCacheSkip, mutCtrCacheSkip);
+STATSCOUNTER_DEF(ctrCacheHit, mutCtrCacheHit);
 STATSCOUNTER_DEF(ctrKafkaAck, mutCtrKafkaAck);
 STATSCOUNTER_DEF(ctrKafkaMsgTooLarge, mutCtrKafkaMsgTooLarge);
 STATSCOUNTER_DEF(ctrKafkaUnknownTopic, mutCtrKafkaUnknownTopic);
@@ -185,23 +187,6 @@ struct kafka_params {
 #define RESUBMIT 1
 #define NO_RESUBMIT 0
 
-#ifdef HAVE_ATOMIC_BUILTINS64
-static uint64 clockTopicAccess = 0;
-#else
-static unsigned clockTopicAccess = 0;
-#endif
-/* and the "tick" function */
-#ifndef HAVE_ATOMIC_BUILTINS
-static pthread_mutex_t mutClock;
-#endif
-static uint64 getClockTopicAccess(void) {
-#ifdef HAVE_ATOMIC_BUILTINS64
-    return ATOMIC_INC_AND_FETCH_uint64(&clockTopicAccess, &mutClock);
-#else
-    return ATOMIC_INC_AND_FETCH_unsigned(&clockTopicAccess, &mutClock);
-#endif
-}
-
 /* Needed for Kafka timestamp librdkafka > 0.9.4 */
 #define KAFKA_TimeStamp "\"%timestamp:::date-unixtimestamp%\""
 
@@ -215,9 +200,8 @@ static uint64 int_latency_avg_usec;
 
 /* dynamic topic cache */
 struct s_dynaTopicCacheEntry {
-    uchar *pName;
+    dyncache_entry_t cacheEntry; /* name and LRU linkage, must be first */
     rd_kafka_topic_t *pTopic;
-    uint64 clkTickAccessed;
     pthread_rwlock_t lock;
 };
 typedef struct s_dynaTopicCacheEntry dynaTopicCacheEntry;
@@ -235,11 +219,10 @@ typedef struct _instanceData {
     uchar *topic;
     sbool dynaKey;
     sbool dynaTopic;
-    dynaTopicCacheEntry **dynCache;
+    dyncache_t *dynCache;
     pthread_mutex_t mutDynCache;
     rd_kafka_topic_t *pTopic;
-    int iCurrElt;
-    int iCurrCacheSize;
+    dynaTopicCacheEntry *pCurrElt;
     int bReportErrs;
     int iDynaTopicCacheSize;
     uchar *tplName; /* assigned output template */
@@ -406,46 +389,34 @@ static void closeTopic(instanceData *__restrict__ const pData) {
  * i will only put the bare descriptions in this one. 2015-01-09 - Tait Clarridge
  */
 
-/* delete a cache entry from the dynamic topic cache */
+/* destructor for entries dropped from the dynamic topic cache */
 /* must be called with lock(mutDynCache) */
-static rsRetVal dynaTopicDelCacheEntry(instanceData *__restrict__ const pData, const int iEntry, const int bFreeEntry) {
-    dynaTopicCacheEntry **pCache = pData->dynCache;
-    DEFiRet;
-    assert(pCache != NULL);
-
-    if (pCache[iEntry] == NULL) FINALIZE;
-    pthread_rwlock_wrlock(&pCache[iEntry]->lock);
+static void dynaTopicDestructCacheEntry(dyncache_entry_t *const pCacheEntry, void *const pUsr) {
+    instanceData *const pData = (instanceData *)pUsr;
+    dynaTopicCacheEntry *const pEntry = (dynaTopicCacheEntry *)pCacheEntry;
 
-    DBGPRINTF("Removing entry %d for topic '%s' from dynaCache.\n", iEntry,
-              pCache[iEntry]->pName == NULL ? UCHAR_CONSTANT("[OPEN FAILED]") : pCache[iEntry]->pName);
-
-    if (pCache[iEntry]->pName != NULL) {
-        free(pCache[iEntry]->pName);
-        pCache[iEntry]->pName = NULL;
+    /* wait until no message is produced to this topic any longer */
+    pthread_rwlock_wrlock(&pEntry->lock);
+    DBGPRINTF("Removing entry for topic '%s' from dynaCache.\n", pCacheEntry->pName);
+    if (pEntry == pData->pCurrElt) {
+        pData->pCurrElt = NULL;
     }
+    free_topic(&pEntry->pTopic);
+    pthread_rwlock_unlock(&pEntry->lock);
 
-    pthread_rwlock_unlock(&pCache[iEntry]->lock);
-
-    if (bFreeEntry) {
-        pthread_rwlock_destroy(&pCache[iEntry]->lock);
-        free(pCache[iEntry]);
-        pCache[iEntry] = NULL;
-    }
-
-finalize_it:
-    RETiRet;
+    pthread_rwlock_destroy(&pEntry->lock);
+    free(pEntry);
 }
 
 /* clear the entire dynamic topic cache */
 static void dynaTopicFreeCacheEntries(instanceData *__restrict__ const pData) {
-    register int i;
     assert(pData != NULL);
 
     pthread_mutex_lock(&pData->mutDynCache);
-    for (i = 0; i < pData->iCurrCacheSize; ++i) {
-        dynaTopicDelCacheEntry(pData, i, 1);
+    if (pData->dynCache != NULL) {
+        dyncacheClear(pData->dynCache);
     }
-    pData->iCurrElt = -1; /* invalidate current element */
+    pData->pCurrElt = NULL; /* invalidate current element */
     pthread_mutex_unlock(&pData->mutDynCache);
 }
 
@@ -519,79 +490,36 @@ static rsRetVal ATTR_NONNULL() prepareDynTopic(instanceData *__restrict__ const
                                                const uchar *__restrict__ const newTopicName,
                                                rd_kafka_topic_t **topic,
                                                pthread_rwlock_t **lock) {
-    uint64 ctOldest;
-    int iOldest;
-    int i;
-    int iFirstFree;
     rsRetVal localRet;
-    dynaTopicCacheEntry **pCache;
     dynaTopicCacheEntry *entry = NULL;
     rd_kafka_topic_t *tmpTopic = NULL;
     DEFiRet;
     assert(pData != NULL);
     assert(newTopicName != NULL);
 
-    pCache = pData->dynCache;
-    /* first check, if we still have the current topic */
-    if ((pData->iCurrElt != -1) && !ustrcmp(newTopicName, pCache[pData->iCurrElt]->pName)) {
+    /* first check, if we still have the current topic. It is always the
+     * most recently used cache entry, so there is no LRU state to update.
+     */
+    if (pData->pCurrElt != NULL && !ustrcmp(newTopicName, pData->pCurrElt->cacheEntry.pName)) {
         /* great, we are all set */
-        pCache[pData->iCurrElt]->clkTickAccessed = getClockTopicAccess();
-        entry = pCache[pData->iCurrElt];
+        entry = pData->pCurrElt;
         STATSCOUNTER_INC(ctrCacheSkip, mutCtrCacheSkip);
         FINALIZE;
     }
 
-    /* ok, no luck. Now let's search the table if we find a matching spot.
-     * While doing so, we also prepare for creation of a new one.
-     */
-    pData->iCurrElt = -1;
-    iFirstFree = -1;
-    iOldest = 0;
-    ctOldest = getClockTopicAccess();
-    for (i = 0; i < pData->iCurrCacheSize; ++i) {
-        if (pCache[i] == NULL || pCache[i]->pName == NULL) {
-            if (iFirstFree == -1) iFirstFree = i;
-        } else { /*got an element, let's see if it matches */
-            if (!ustrcmp(newTopicName, pCache[i]->pName)) {
-                /* we found our element! */
-                entry = pCache[i];
-                pData->iCurrElt = i;
-                /* update "timestamp" for LRU */
-                pCache[i]->clkTickAccessed = getClockTopicAccess();
-                FINALIZE;
-            }
-            /* did not find it - so lets keep track of the counters for LRU */
-            if (pCache[i]->clkTickAccessed < ctOldest) {
-                ctOldest = pCache[i]->clkTickAccessed;
-                iOldest = i;
-            }
-        }
+    /* ok, no luck. Now let's check if the topic is already cached. */
+    pData->pCurrElt = NULL;
+    entry = (dynaTopicCacheEntry *)dyncacheFind(pData->dynCache, newTopicName);
+    if (entry != NULL) {
+        /* we found our element! */
+        STATSCOUNTER_INC(ctrCacheHit, mutCtrCacheHit);
+        pData->pCurrElt = entry;
+        FINALIZE;
     }
     STATSCOUNTER_INC(ctrCacheMiss, mutCtrCacheMiss);
 
-    /* invalidate iCurrElt as we may error-exit out of this function when the currrent
-     * iCurrElt has been freed or otherwise become unusable. This is a precaution, and
-     * performance-wise it may be better to do that in each of the exits. However, that
-     * is error-prone, so I prefer to do it here. -- rgerhards, 2010-03-02
-     */
-    pData->iCurrElt = -1;
-
-    if (iFirstFree == -1 && (pData->iCurrCacheSize < pData->iDynaTopicCacheSize)) {
-        /* there is space left, so set it to that index */
-        iFirstFree = pData->iCurrCacheSize++;
-    }
-
-    if (iFirstFree == -1) {
-        dynaTopicDelCacheEntry(pData, iOldest, 0);
+    if (dyncacheEvict(pData->dynCache)) {
         STATSCOUNTER_INC(ctrCacheEvict, mutCtrCacheEvict);
-        iFirstFree = iOldest; /* this one *is* now free ;) */
-    } else {
-        pCache[iFirstFree] = NULL;
-    }
-    /* we need to allocate memory for the cache structure */
-    if (pCache[iFirstFree] == NULL) {
-        CHKmalloc(pCache[iFirstFree] = (dynaTopicCacheEntry *)calloc(1, sizeof(dynaTopicCacheEntry)));
-        CHKiRet(pthread_rwlock_init(&pCache[iFirstFree]->lock, NULL));
     }
 
     /* Ok, we finally can open the topic */
@@ -605,15 +533,25 @@ static rsRetVal ATTR_NONNULL() prepareDynTopic(instanceData *__restrict__ const
         ABORT_FINALIZE(localRet);
     }
 
-    if ((pCache[iFirstFree]->pName = ustrdup(newTopicName)) == NULL) {
+    if ((entry = (dynaTopicCacheEntry *)calloc(1, sizeof(dynaTopicCacheEntry))) == NULL) {
         free_topic(&tmpTopic);
         ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
     }
-    pCache[iFirstFree]->pTopic = tmpTopic;
-    pCache[iFirstFree]->clkTickAccessed = getClockTopicAccess();
-    entry = pCache[iFirstFree];
-    pData->iCurrElt = iFirstFree;
-    DBGPRINTF("Added new entry %d for topic cache, topic '%s'.\n", iFirstFree, newTopicName);
+    if (pthread_rwlock_init(&entry->lock, NULL) != 0) {
+        free(entry);
+        free_topic(&tmpTopic);
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    entry->pTopic = tmpTopic;
+    localRet = dyncacheInsert(pData->dynCache, &entry->cacheEntry, newTopicName);
+    if (localRet != RS_RET_OK) {
+        pthread_rwlock_destroy(&entry->lock);
+        free(entry);
+        free_topic(&tmpTopic);
+        ABORT_FINALIZE(localRet);
+    }
+    pData->pCurrElt = entry;
+    DBGPRINTF("Added new entry for topic cache, topic '%s'.\n", newTopicName);
 
 finalize_it:
     if (iRet == RS_RET_OK) {
@@ -1747,9 +1685,8 @@ BEGINfreeInstance
     /* Closing Kafka first! */
     pthread_rwlock_wrlock(&pData->rkLock);
     closeKafka(pData);
-    if (pData->dynaTopic && pData->dynCache != NULL) {
-        free(pData->dynCache);
-        pData->dynCache = NULL;
+    if (pData->dynaTopic) {
+        dyncacheDestruct(&pData->dynCache);
     }
     /* Persist failed messages */
     if (pData->bResubmitOnFailure && pData->bKeepFailedMessages && pData->failedMsgFile != NULL) {
@@ -2126,9 +2063,8 @@ BEGINnewActInst
 
     if (pData->dynaTopic) {
         CHKiRet(OMSRsetEntry(*ppOMSR, pData->dynaKey ? 3 : 2, ustrdup(pData->topic), OMSR_NO_RQD_TPL_OPTS));
-        CHKmalloc(pData->dynCache =
-                      (dynaTopicCacheEntry **)calloc(pData->iDynaTopicCacheSize, sizeof(dynaTopicCacheEntry *)));
-        pData->iCurrElt = -1;
+        CHKiRet(dyncacheConstruct(&pData->dynCache, pData->iDynaTopicCacheSize, dynaTopicDestructCacheEntry, pData));
+        pData->pCurrElt = NULL;
     }
 
     pthread_mutex_lock(&closeTimeoutMut);
@@ -2169,7 +2105,6 @@ BEGINmodExit
     CODESTARTmodExit;
     statsobj.Destruct(&kafkaStats);
     CHKiRet(objRelease(statsobj, CORE_COMPONENT));
-    DESTROY_ATOMIC_HELPER_MUT(mutClock);
 
     pthread_mutex_lock(&closeTimeoutMut);
     int timeout = closeTimeout;
@@ -2204,7 +2139,6 @@ BEGINmodInit()
     CHKiRet(objUse(strm, CORE_COMPONENT));
     CHKiRet(objUse(statsobj, CORE_COMPONENT));
 
-    INIT_ATOMIC_HELPER_MUT(mutClock);
 
     DBGPRINTF("omkafka %s using librdkafka version %s, 0x%x\n", VERSION, rd_kafka_version_str(), rd_kafka_version());
     CHKiRet(statsobj.Construct(&kafkaStats));
@@ -2221,6 +2155,9 @@ BEGINmodInit()
     STATSCOUNTER_INIT(ctrCacheSkip, mutCtrCacheSkip);
     CHKiRet(statsobj.AddCounter(kafkaStats, (uchar *)"topicdynacache.skipped", ctrType_IntCtr, CTR_FLAG_RESETTABLE,
                                 &ctrCacheSkip));
+    STATSCOUNTER_INIT(ctrCacheHit, mutCtrCacheHit);
+    CHKiRet(statsobj.AddCounter(kafkaStats, (uchar *)"topicdynacache.hits", ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &ctrCacheHit));
     STATSCOUNTER_INIT(ctrCacheMiss, mutCtrCacheMiss);
     CHKiRet(statsobj.AddCounter(kafkaStats, (uchar *)"topicdynacache.miss", ctrType_IntCtr, CTR_FLAG_RESETTABLE,
                                 &ctrCacheMiss));
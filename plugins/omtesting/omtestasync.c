@@ -0,0 +1,415 @@
+/* omtestasync.c
+ *
+ * This module is a testing aid for the asynchronous transaction interface
+ * (submitTransaction()/pollTransactions(), see module-template.h). It is
+ * not meant to be used in production.
+ *
+ * Submitted batches are handed to a completion thread per worker instance,
+ * which writes them to a file after a short delay and then reports their
+ * outcome. Every "failEvery"th batch is not written, but reported as
+ * suspended or failed instead, so that the core's retry processing can be
+ * tested. Batches the core commits synchronously are always written.
+ *
+ * action(type="omtestasync" file="..." [failEvery="n"] [failWith="suspend|error"]
+ *        [delay="ms"] [template="..."])
+ *
+ * Copyright 2026 Adiscon GmbH.
+ *
+ * This file is part of rsyslog.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include "rsyslog.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include "conf.h"
+#include "syslogd-types.h"
+#include "srUtils.h"
+#include "template.h"
+#include "module-template.h"
+#include "errmsg.h"
+
+MODULE_TYPE_OUTPUT;
+MODULE_TYPE_NOKEEP;
+MODULE_CNFNAME("omtestasync")
+
+/* internal structures
+ */
+DEF_OMOD_STATIC_DATA;
+
+/* core callback to report completions, see actionAsyncTxNotify() */
+static rsRetVal (*pNotify)(void *txCookie) = NULL;
+
+typedef struct _instanceData {
+    uchar *file;
+    uchar *tplName;
+    int failEvery; /* 0: never fail */
+    rsRetVal failWith;
+    int delay; /* milliseconds before a batch completes */
+    int nBatches; /* number of batches processed so far, for failEvery */
+    pthread_mutex_t mut; /* guards nBatches and file writes */
+} instanceData;
+
+typedef struct asyncBatch_s {
+    actWrkrIParams_t *pParams;
+    unsigned nParams;
+    void *txCookie;
+    rsRetVal result;
+    struct asyncBatch_s *next;
+} asyncBatch_t;
+
+typedef struct wrkrInstanceData {
+    instanceData *pData;
+    pthread_t tid;
+    sbool bThrdStarted;
+    sbool bStop;
+    pthread_mutex_t mut;
+    pthread_cond_t condSubmitted;
+    pthread_cond_t condCompleted;
+    asyncBatch_t *submitted; /* FIFO, processed by completion thread */
+    asyncBatch_t *submittedTail;
+    asyncBatch_t *completed; /* reported by pollTransactions() */
+} wrkrInstanceData_t;
+
+static struct cnfparamdescr actpdescr[] = {{"file", eCmdHdlrString, CNFPARAM_REQUIRED},
+                                           {"failevery", eCmdHdlrNonNegInt, 0},
+                                           {"failwith", eCmdHdlrGetWord, 0},
+                                           {"delay", eCmdHdlrNonNegInt, 0},
+                                           {"template", eCmdHdlrGetWord, 0}};
+static struct cnfparamblk actpblk = {CNFPARAMBLK_VERSION, sizeof(actpdescr) / sizeof(struct cnfparamdescr), actpdescr};
+
+struct modConfData_s {
+    rsconf_t *pConf; /* our overall config object */
+};
+
+static modConfData_t *loadModConf = NULL; /* modConf ptr to use for the current load process */
+static modConfData_t *runModConf = NULL; /* modConf ptr to use for the current exec process */
+
+
+/* append a batch to the output file */
+static rsRetVal writeBatch(instanceData *const pData, actWrkrIParams_t *const pParams, const unsigned nParams) {
+    FILE *fp;
+    DEFiRet;
+
+    pthread_mutex_lock(&pData->mut);
+    if ((fp = fopen((char *)pData->file, "a")) == NULL) {
+        LogError(errno, RS_RET_FILE_OPEN_ERROR, "omtestasync: cannot open '%s'", pData->file);
+        ABORT_FINALIZE(RS_RET_SUSPENDED);
+    }
+    for (unsigned i = 0; i < nParams; ++i) {
+        fputs((char *)actParam(pParams, 1, i, 0).param, fp);
+    }
+    fclose(fp);
+
+finalize_it:
+    pthread_mutex_unlock(&pData->mut);
+    RETiRet;
+}
+
+
+/* decide the outcome of a submitted batch and deliver it, if it succeeds */
+static rsRetVal completeBatch(instanceData *const pData, asyncBatch_t *const pBatch) {
+    int bFail;
+
+    pthread_mutex_lock(&pData->mut);
+    ++pData->nBatches;
+    bFail = pData->failEvery > 0 && pData->nBatches % pData->failEvery == 0;
+    pthread_mutex_unlock(&pData->mut);
+    if (bFail) {
+        DBGPRINTF("omtestasync: batch of %u msgs completes with %d\n", pBatch->nParams, pData->failWith);
+        return pData->failWith;
+    }
+    return writeBatch(pData, pBatch->pParams, pBatch->nParams);
+}
+
+
+/* completion thread of a worker instance */
+static void *completer(void *arg) {
+    wrkrInstanceData_t *const pWrkrData = (wrkrInstanceData_t *)arg;
+    asyncBatch_t *pBatch;
+
+    pthread_mutex_lock(&pWrkrData->mut);
+    while (1) {
+        while (pWrkrData->submitted == NULL && !pWrkrData->bStop) {
+            pthread_cond_wait(&pWrkrData->condSubmitted, &pWrkrData->mut);
+        }
+        if (pWrkrData->submitted == NULL) {
+            break; /* stop requested and nothing left */
+        }
+        pBatch = pWrkrData->submitted;
+        pWrkrData->submitted = pBatch->next;
+        if (pWrkrData->submitted == NULL) {
+            pWrkrData->submittedTail = NULL;
+        }
+        pthread_mutex_unlock(&pWrkrData->mut);
+
+        srSleep(pWrkrData->pData->delay / 1000, (pWrkrData->pData->delay % 1000) * 1000);
+        pBatch->result = completeBatch(pWrkrData->pData, pBatch);
+
+        pthread_mutex_lock(&pWrkrData->mut);
+        pBatch->next = pWrkrData->completed;
+        pWrkrData->completed = pBatch;
+        pthread_cond_signal(&pWrkrData->condCompleted);
+        pthread_mutex_unlock(&pWrkrData->mut);
+        pNotify(pBatch->txCookie);
+        pthread_mutex_lock(&pWrkrData->mut);
+    }
+    pthread_mutex_unlock(&pWrkrData->mut);
+    return NULL;
+}
+
+
+static void freeBatchList(asyncBatch_t *pBatch) {
+    asyncBatch_t *pDel;
+
+    while (pBatch != NULL) {
+        pDel = pBatch;
+        pBatch = pBatch->next;
+        free(pDel);
+    }
+}
+
+
+BEGINinitConfVars
+    CODESTARTinitConfVars;
+ENDinitConfVars
+
+BEGINcreateInstance
+    CODESTARTcreateInstance;
+    pData->failWith = RS_RET_SUSPENDED;
+    pData->delay = 10;
+    pthread_mutex_init(&pData->mut, NULL);
+ENDcreateInstance
+
+
+BEGINcreateWrkrInstance
+    int r;
+    CODESTARTcreateWrkrInstance;
+    pthread_mutex_init(&pWrkrData->mut, NULL);
+    pthread_cond_init(&pWrkrData->condSubmitted, NULL);
+    pthread_cond_init(&pWrkrData->condCompleted, NULL);
+    if ((r = pthread_create(&pWrkrData->tid, NULL, completer, pWrkrData)) != 0) {
+        LogError(r, RS_RET_SYS_ERR, "omtestasync: cannot start completion thread");
+        ABORT_FINALIZE(RS_RET_SYS_ERR);
+    }
+    pWrkrData->bThrdStarted = 1;
+finalize_it:
+ENDcreateWrkrInstance
+
+
+BEGINbeginCnfLoad
+    CODESTARTbeginCnfLoad;
+    loadModConf = pModConf;
+    pModConf->pConf = pConf;
+ENDbeginCnfLoad
+
+
+BEGINendCnfLoad
+    CODESTARTendCnfLoad;
+    loadModConf = NULL; /* done loading */
+ENDendCnfLoad
+
+BEGINcheckCnf
+    CODESTARTcheckCnf;
+ENDcheckCnf
+
+BEGINactivateCnf
+    CODESTARTactivateCnf;
+    runModConf = pModConf;
+ENDactivateCnf
+
+BEGINfreeCnf
+    CODESTARTfreeCnf;
+ENDfreeCnf
+
+
+BEGINisCompatibleWithFeature
+    CODESTARTisCompatibleWithFeature;
+ENDisCompatibleWithFeature
+
+
+BEGINfreeInstance
+    CODESTARTfreeInstance;
+    free(pData->file);
+    free(pData->tplName);
+    pthread_mutex_destroy(&pData->mut);
+ENDfreeInstance
+
+
+BEGINfreeWrkrInstance
+    CODESTARTfreeWrkrInstance;
+    if (pWrkrData->bThrdStarted) {
+        pthread_mutex_lock(&pWrkrData->mut);
+        pWrkrData->bStop = 1;
+        pthread_cond_signal(&pWrkrData->condSubmitted);
+        pthread_mutex_unlock(&pWrkrData->mut);
+        pthread_join(pWrkrData->tid, NULL);
+    }
+    freeBatchList(pWrkrData->submitted);
+    freeBatchList(pWrkrData->completed);
+    pthread_cond_destroy(&pWrkrData->condCompleted);
+    pthread_cond_destroy(&pWrkrData->condSubmitted);
+    pthread_mutex_destroy(&pWrkrData->mut);
+ENDfreeWrkrInstance
+
+
+BEGINdbgPrintInstInfo
+    CODESTARTdbgPrintInstInfo;
+    dbgprintf("omtestasync\n");
+    dbgprintf("\tfile='%s'\n", pData->file);
+    dbgprintf("\tfailEvery=%d, failWith=%d, delay=%d\n", pData->failEvery, pData->failWith, pData->delay);
+ENDdbgPrintInstInfo
+
+
+BEGINtryResume
+    CODESTARTtryResume;
+ENDtryResume
+
+BEGINbeginTransaction
+    CODESTARTbeginTransaction;
+ENDbeginTransaction
+
+BEGINcommitTransaction
+    CODESTARTcommitTransaction;
+    iRet = writeBatch(pWrkrData->pData, pParams, nParams);
+ENDcommitTransaction
+
+
+BEGINsubmitTransaction
+    asyncBatch_t *pBatch;
+    CODESTARTsubmitTransaction;
+    CHKmalloc(pBatch = calloc(1, sizeof(asyncBatch_t)));
+    pBatch->pParams = pParams;
+    pBatch->nParams = nParams;
+    pBatch->txCookie = txCookie;
+    pthread_mutex_lock(&pWrkrData->mut);
+    if (pWrkrData->submittedTail == NULL) {
+        pWrkrData->submitted = pBatch;
+    } else {
+        pWrkrData->submittedTail->next = pBatch;
+    }
+    pWrkrData->submittedTail = pBatch;
+    pthread_cond_signal(&pWrkrData->condSubmitted);
+    pthread_mutex_unlock(&pWrkrData->mut);
+finalize_it:
+ENDsubmitTransaction
+
+
+BEGINpollTransactions
+    asyncBatch_t *pBatch;
+    struct timespec t;
+    CODESTARTpollTransactions;
+    pthread_mutex_lock(&pWrkrData->mut);
+    if (pWrkrData->completed == NULL && timeoutMs > 0) {
+        timeoutComp(&t, timeoutMs);
+        while (pWrkrData->completed == NULL) {
+            if (pthread_cond_timedwait(&pWrkrData->condCompleted, &pWrkrData->mut, &t) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+    while (pWrkrData->completed != NULL && *pnCompl < maxCompl) {
+        pBatch = pWrkrData->completed;
+        pWrkrData->completed = pBatch->next;
+        pCompl[*pnCompl].txCookie = pBatch->txCookie;
+        pCompl[*pnCompl].result = pBatch->result;
+        ++(*pnCompl);
+        free(pBatch);
+    }
+    pthread_mutex_unlock(&pWrkrData->mut);
+ENDpollTransactions
+
+
+BEGINnewActInst
+    struct cnfparamvals *pvals;
+    int i;
+    char *cstr;
+    CODESTARTnewActInst;
+    DBGPRINTF("newActInst (omtestasync)\n");
+
+    if ((pvals = nvlstGetParams(lst, &actpblk, NULL)) == NULL) {
+        ABORT_FINALIZE(RS_RET_MISSING_CNFPARAMS);
+    }
+
+    CHKiRet(createInstance(&pData));
+
+    for (i = 0; i < actpblk.nParams; ++i) {
+        if (!pvals[i].bUsed) {
+            continue;
+        } else if (!strcmp(actpblk.descr[i].name, "file")) {
+            pData->file = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(actpblk.descr[i].name, "failevery")) {
+            pData->failEvery = (int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "failwith")) {
+            cstr = es_str2cstr(pvals[i].val.d.estr, NULL);
+            if (!strcmp(cstr, "suspend")) {
+                pData->failWith = RS_RET_SUSPENDED;
+            } else if (!strcmp(cstr, "error")) {
+                pData->failWith = RS_RET_ERR;
+            } else {
+                LogError(0, RS_RET_INVALID_PARAMS, "omtestasync: failWith must be \"suspend\" or \"error\"");
+                free(cstr);
+                ABORT_FINALIZE(RS_RET_INVALID_PARAMS);
+            }
+            free(cstr);
+        } else if (!strcmp(actpblk.descr[i].name, "delay")) {
+            pData->delay = (int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "template")) {
+            pData->tplName = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else {
+            DBGPRINTF("omtestasync: program error, non-handled param '%s'\n", actpblk.descr[i].name);
+        }
+    }
+
+    CODE_STD_STRING_REQUESTnewActInst(1);
+    CHKiRet(OMSRsetEntry(*ppOMSR, 0,
+                         (uchar *)strdup((pData->tplName == NULL) ? "RSYSLOG_FileFormat" : (char *)pData->tplName),
+                         OMSR_NO_RQD_TPL_OPTS));
+    CODE_STD_FINALIZERnewActInst;
+    cnfparamvalsDestruct(pvals, &actpblk);
+ENDnewActInst
+
+
+NO_LEGACY_CONF_parseSelectorAct
+
+
+BEGINmodExit
+    CODESTARTmodExit;
+ENDmodExit
+
+
+BEGINqueryEtryPt
+    CODESTARTqueryEtryPt;
+    CODEqueryEtryPt_STD_OMODTX_QUERIES;
+    CODEqueryEtryPt_STD_OMOD8_QUERIES;
+    CODEqueryEtryPt_STD_CONF2_CNFNAME_QUERIES;
+    CODEqueryEtryPt_STD_CONF2_QUERIES;
+    CODEqueryEtryPt_STD_CONF2_OMOD_QUERIES;
+    CODEqueryEtryPt_ASYNCTX_OMOD_QUERIES;
+ENDqueryEtryPt
+
+
+BEGINmodInit()
+    CODESTARTmodInit;
+    INITLegCnfVars;
+    *ipIFVersProvided = CURR_MOD_IF_VERSION; /* we only support the current interface specification */
+    CODEmodInit_QueryRegCFSLineHdlr CHKiRet(pHostQueryEtryPt((uchar *)"actionAsyncTxNotify", &pNotify));
+ENDmodInit
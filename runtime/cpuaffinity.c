@@ -0,0 +1,247 @@
+/* cpuaffinity.c - CPU and NUMA placement of rsyslog threads
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    #include <sched.h>
+#endif
+#if defined(HAVE_LINUX_MEMPOLICY_H) && defined(HAVE_SYSCALL)
+    #include <unistd.h>
+    #include <sys/syscall.h>
+    #include <linux/mempolicy.h>
+    #if defined(SYS_set_mempolicy)
+        #define USE_MEMPOLICY 1
+    #endif
+#endif
+
+#include "rsyslog.h"
+#include "errmsg.h"
+#include "debug.h"
+#include "atomic.h"
+#include "cpuaffinity.h"
+
+/* highest NUMA node we support, sized for the memory policy node mask */
+#define MAX_NUMA_NODE 1023
+
+struct cpuaffinity_s {
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    cpu_set_t cpus;
+#endif
+    int numaNode;
+    char *owner; /* for error messages */
+    int bApplyErrReported; /* apply failures are logged once, then only debug-printed */
+    DEF_ATOMIC_HELPER_MUT(mutApplyErrReported);
+};
+
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+/* parse a Linux style CPU list ("0-3,8,10-11") into pSet. Returns
+ * RS_RET_CONF_PARAM_INVLD on syntax errors or CPUs out of range.
+ */
+static rsRetVal parseCpuList(const char *list, cpu_set_t *const pSet) {
+    const char *p = list;
+    char *end;
+    long lo, hi;
+    DEFiRet;
+
+    CPU_ZERO(pSet);
+    while (1) {
+        while (isspace((unsigned char)*p)) ++p;
+        if (*p == '\0') break;
+        if (!isdigit((unsigned char)*p)) ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        lo = hi = strtol(p, &end, 10);
+        p = end;
+        if (*p == '-') {
+            ++p;
+            if (!isdigit((unsigned char)*p)) ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+            hi = strtol(p, &end, 10);
+            p = end;
+        }
+        if (lo > hi || hi >= CPU_SETSIZE) ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        for (long cpu = lo; cpu <= hi; ++cpu) {
+            CPU_SET((int)cpu, pSet);
+        }
+        while (isspace((unsigned char)*p)) ++p;
+        if (*p == ',') {
+            ++p;
+        } else if (*p != '\0') {
+            ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        }
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* obtain the CPUs of a NUMA node from sysfs */
+static rsRetVal getNodeCpus(const int node, cpu_set_t *const pSet) {
+    char path[128];
+    char buf[4096];
+    FILE *fp = NULL;
+    DEFiRet;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    if ((fp = fopen(path, "r")) == NULL) {
+        ABORT_FINALIZE(RS_RET_FILE_NOT_FOUND);
+    }
+    if (fgets(buf, sizeof(buf), fp) == NULL) {
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    CHKiRet(parseCpuList(buf, pSet));
+
+finalize_it:
+    if (fp != NULL) fclose(fp);
+    RETiRet;
+}
+#endif /* #ifdef HAVE_PTHREAD_SETAFFINITY_NP */
+
+
+rsRetVal cpuaffinityConstruct(cpuaffinity_t **const ppThis,
+                              const char *const cpuset,
+                              const int numaNode,
+                              const char *const owner) {
+    cpuaffinity_t *pThis = NULL;
+    DEFiRet;
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    cpu_set_t nodeCpus;
+
+    CHKmalloc(pThis = calloc(1, sizeof(cpuaffinity_t)));
+    INIT_ATOMIC_HELPER_MUT(pThis->mutApplyErrReported);
+    CHKmalloc(pThis->owner = strdup(owner));
+    pThis->numaNode = numaNode;
+
+    if (cpuset != NULL) {
+        if (parseCpuList(cpuset, &pThis->cpus) != RS_RET_OK || CPU_COUNT(&pThis->cpus) == 0) {
+            LogError(0, RS_RET_CONF_PARAM_INVLD, "%s: invalid cpuset '%s', expected a list like '0-3,8'", owner,
+                     cpuset);
+            ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        }
+    }
+
+    if (numaNode != CPUAFFINITY_NO_NODE) {
+        if (numaNode < 0 || numaNode > MAX_NUMA_NODE) {
+            LogError(0, RS_RET_CONF_PARAM_INVLD, "%s: numaNode %d out of range (0 - %d)", owner, numaNode,
+                     MAX_NUMA_NODE);
+            ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        }
+        if ((iRet = getNodeCpus(numaNode, &nodeCpus)) != RS_RET_OK) {
+            LogError(errno, iRet, "%s: cannot obtain CPUs of NUMA node %d", owner, numaNode);
+            ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        }
+        if (cpuset == NULL) {
+            pThis->cpus = nodeCpus;
+        } else {
+            CPU_AND(&pThis->cpus, &pThis->cpus, &nodeCpus);
+            if (CPU_COUNT(&pThis->cpus) == 0) {
+                LogError(0, RS_RET_CONF_PARAM_INVLD, "%s: cpuset '%s' contains no CPU of NUMA node %d", owner, cpuset,
+                         numaNode);
+                ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+            }
+        }
+    }
+#else
+    (void)cpuset;
+    (void)numaNode;
+    LogError(0, RS_RET_NOT_IMPLEMENTED, "%s: cpuset/numaNode are not supported on this platform - ignored", owner);
+    ABORT_FINALIZE(RS_RET_NOT_IMPLEMENTED);
+#endif
+
+    *ppThis = pThis;
+
+finalize_it:
+    if (iRet != RS_RET_OK) {
+        cpuaffinityDestruct(&pThis);
+    }
+    RETiRet;
+}
+
+
+/* every worker of a queue applies the same placement, so a failure would be
+ * reported on each worker start. Only the first one is logged.
+ */
+static int applyErrFirst(cpuaffinity_t *const pThis) {
+    return ATOMIC_CAS(&pThis->bApplyErrReported, 0, 1, &pThis->mutApplyErrReported);
+}
+
+
+rsRetVal cpuaffinityApply(cpuaffinity_t *const pThis) {
+    DEFiRet;
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    const int err = pthread_setaffinity_np(pthread_self(), sizeof(pThis->cpus), &pThis->cpus);
+    if (err != 0) {
+        if (applyErrFirst(pThis)) {
+            LogError(err, RS_RET_ERR, "%s: cannot set CPU affinity - running unpinned", pThis->owner);
+        } else {
+            DBGPRINTF("%s: cannot set CPU affinity, error %d - running unpinned\n", pThis->owner, err);
+        }
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    DBGPRINTF("%s: thread pinned to %d CPU(s)\n", pThis->owner, CPU_COUNT(&pThis->cpus));
+#endif
+
+#ifdef USE_MEMPOLICY
+    if (pThis->numaNode != CPUAFFINITY_NO_NODE) {
+        unsigned long nodemask[(MAX_NUMA_NODE + 1) / (8 * sizeof(unsigned long))];
+        memset(nodemask, 0, sizeof(nodemask));
+        nodemask[pThis->numaNode / (8 * sizeof(unsigned long))] |= 1UL
+                                                                   << (pThis->numaNode % (8 * sizeof(unsigned long)));
+        /* the kernel expects one more than the number of bits in the mask */
+        if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodemask, sizeof(nodemask) * 8 + 1) != 0) {
+            const int errSave = errno;
+            if (applyErrFirst(pThis)) {
+                LogError(errSave, RS_RET_ERR, "%s: cannot set memory policy for NUMA node %d", pThis->owner,
+                         pThis->numaNode);
+            } else {
+                DBGPRINTF("%s: cannot set memory policy for NUMA node %d, errno %d\n", pThis->owner,
+                          pThis->numaNode, errSave);
+            }
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+    }
+#endif
+
+finalize_it:
+    RETiRet;
+}
+
+
+int cpuaffinityGetNumaNode(const cpuaffinity_t *const pThis) {
+    return pThis->numaNode;
+}
+
+
+void cpuaffinityDestruct(cpuaffinity_t **const ppThis) {
+    cpuaffinity_t *const pThis = *ppThis;
+
+    if (pThis == NULL) return;
+    DESTROY_ATOMIC_HELPER_MUT(pThis->mutApplyErrReported);
+    free(pThis->owner);
+    free(pThis);
+    *ppThis = NULL;
+}
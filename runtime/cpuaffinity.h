@@ -0,0 +1,60 @@
+/* cpuaffinity.h - CPU and NUMA placement of rsyslog threads
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file cpuaffinity.h
+ * @brief Pin threads to a set of CPUs and prefer memory of a NUMA node.
+ *
+ * A placement is built from the "cpuset" (a list like "0-3,8") and/or
+ * "numaNode" config parameters of a queue or input. If a NUMA node is
+ * given, its CPUs are read from sysfs; together with a cpuset, the
+ * intersection is used. The thread that applies the placement also gets
+ * a preferred-node memory policy, so that everything it allocates and
+ * touches first (batch arrays, messages) is placed on that node.
+ *
+ * Placement is only available on platforms with pthread_setaffinity_np();
+ * elsewhere configuring it is an error.
+ */
+#ifndef INCLUDED_CPUAFFINITY_H
+#define INCLUDED_CPUAFFINITY_H
+
+/** No NUMA node configured. */
+#define CPUAFFINITY_NO_NODE -1
+
+/**
+ * Build a placement. @p cpuset may be NULL and @p numaNode may be
+ * CPUAFFINITY_NO_NODE, but not both. @p owner names the config object in
+ * error messages.
+ */
+rsRetVal cpuaffinityConstruct(cpuaffinity_t **ppThis, const char *cpuset, int numaNode, const char *owner);
+
+/**
+ * Apply the placement to the calling thread. Failures do not stop the
+ * thread from running unpinned. Only the first failure of a placement is
+ * logged, later ones go to the debug log.
+ */
+rsRetVal cpuaffinityApply(cpuaffinity_t *pThis);
+
+/** Configured NUMA node or CPUAFFINITY_NO_NODE. */
+int cpuaffinityGetNumaNode(const cpuaffinity_t *pThis);
+
+void cpuaffinityDestruct(cpuaffinity_t **ppThis);
+
+#endif /* #ifndef INCLUDED_CPUAFFINITY_H */
@@ -0,0 +1,156 @@
+/* dyncache.c - name-indexed LRU cache for dynamic output targets
+ *
+ * See dyncache.h for the concept.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "rsyslog.h"
+#include "unicode-helper.h"
+#include "hashtable.h"
+#include "dyncache.h"
+
+
+static void dyncacheUnlink(dyncache_t *const pThis, dyncache_entry_t *const pEntry) {
+    if (pEntry->pPrev == NULL) {
+        pThis->pHead = pEntry->pNext;
+    } else {
+        pEntry->pPrev->pNext = pEntry->pNext;
+    }
+    if (pEntry->pNext == NULL) {
+        pThis->pTail = pEntry->pPrev;
+    } else {
+        pEntry->pNext->pPrev = pEntry->pPrev;
+    }
+    pEntry->pPrev = pEntry->pNext = NULL;
+}
+
+
+static void dyncacheLinkHead(dyncache_t *const pThis, dyncache_entry_t *const pEntry) {
+    pEntry->pPrev = NULL;
+    pEntry->pNext = pThis->pHead;
+    if (pThis->pHead == NULL) {
+        pThis->pTail = pEntry;
+    } else {
+        pThis->pHead->pPrev = pEntry;
+    }
+    pThis->pHead = pEntry;
+}
+
+
+rsRetVal dyncacheConstruct(dyncache_t **const ppThis,
+                           const int maxEntries,
+                           void (*pDestruct)(dyncache_entry_t *pEntry, void *pUsr),
+                           void *const pUsr) {
+    dyncache_t *pThis = NULL;
+    DEFiRet;
+
+    CHKmalloc(pThis = calloc(1, sizeof(dyncache_t)));
+    CHKmalloc(pThis->ht = create_hashtable(maxEntries, hash_from_string, key_equals_string, NULL));
+    pThis->maxEntries = maxEntries;
+    pThis->pDestruct = pDestruct;
+    pThis->pUsr = pUsr;
+    *ppThis = pThis;
+
+finalize_it:
+    if (iRet != RS_RET_OK) {
+        free(pThis);
+    }
+    RETiRet;
+}
+
+
+void dyncacheRemove(dyncache_t *const pThis, dyncache_entry_t *const pEntry) {
+    uchar *const pName = pEntry->pName;
+
+    dyncacheUnlink(pThis, pEntry);
+    --pThis->nEntries;
+    pThis->pDestruct(pEntry, pThis->pUsr);
+    /* the hash table owns the key and frees it here. It does not access
+     * the (already destructed) value.
+     */
+    hashtable_remove(pThis->ht, pName);
+}
+
+
+void dyncacheClear(dyncache_t *const pThis) {
+    while (pThis->pHead != NULL) {
+        dyncacheRemove(pThis, pThis->pHead);
+    }
+}
+
+
+void dyncacheDestruct(dyncache_t **const ppThis) {
+    dyncache_t *const pThis = *ppThis;
+
+    if (pThis == NULL) return;
+    dyncacheClear(pThis);
+    hashtable_destroy(pThis->ht, 0);
+    free(pThis);
+    *ppThis = NULL;
+}
+
+
+dyncache_entry_t *dyncacheFind(dyncache_t *const pThis, const uchar *const pName) {
+    dyncache_entry_t *const pEntry = hashtable_search(pThis->ht, (void *)pName);
+
+    if (pEntry != NULL && pEntry != pThis->pHead) {
+        dyncacheUnlink(pThis, pEntry);
+        dyncacheLinkHead(pThis, pEntry);
+    }
+    return pEntry;
+}
+
+
+int dyncacheEvict(dyncache_t *const pThis) {
+    dyncache_entry_t *pEntry;
+
+    if (pThis->nEntries < pThis->maxEntries) return 0;
+    for (pEntry = pThis->pTail; pEntry != NULL && pEntry->nRefs > 0; pEntry = pEntry->pPrev) {
+        /* in use, try the next more recently used one */
+    }
+    if (pEntry == NULL) return 0;
+    DBGPRINTF("dyncache: evicting '%s'\n", pEntry->pName);
+    dyncacheRemove(pThis, pEntry);
+    return 1;
+}
+
+
+rsRetVal dyncacheInsert(dyncache_t *const pThis, dyncache_entry_t *const pEntry, const uchar *const pName) {
+    uchar *pKey = NULL;
+    DEFiRet;
+
+    dyncacheEvict(pThis);
+    CHKmalloc(pKey = ustrdup(pName));
+    if (!hashtable_insert(pThis->ht, pKey, pEntry)) {
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    }
+    pEntry->pName = pKey;
+    dyncacheLinkHead(pThis, pEntry);
+    ++pThis->nEntries;
+
+finalize_it:
+    if (iRet != RS_RET_OK) {
+        free(pKey);
+    }
+    RETiRet;
+}
@@ -0,0 +1,105 @@
+/* dyncache.h - name-indexed LRU cache for dynamic output targets
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file dyncache.h
+ * @brief Bounded LRU cache of objects that are looked up by name.
+ *
+ * Output modules with dynamic targets (omfile dynafiles, omkafka dynamic
+ * topics) keep the most recently used targets open. This cache finds an
+ * entry via a hash table instead of scanning all entries, and keeps the
+ * entries on a doubly-linked list in the order of their last use, so the
+ * least recently used one is found without a scan as well.
+ *
+ * The list is intrusive: a user embeds dyncache_entry_t as the first
+ * member of its own entry structure. Entries are allocated by the user and
+ * handed to the cache, which calls the destructor given at construction
+ * once it drops an entry.
+ *
+ * Users that work with an entry outside of their cache lock can hold a
+ * reference to it (nRefs). Referenced entries are never evicted. If all
+ * entries are referenced, an insert makes the cache grow beyond
+ * maxEntries until references are dropped again.
+ *
+ * The cache does not lock. Callers must serialize access to it.
+ */
+#ifndef INCLUDED_DYNCACHE_H
+#define INCLUDED_DYNCACHE_H
+
+typedef struct dyncache_entry_s dyncache_entry_t;
+typedef struct dyncache_s dyncache_t;
+
+/** Cache linkage of an entry. Must be the first member of the user's entry. */
+struct dyncache_entry_s {
+    uchar *pName; /**< key, owned by the cache */
+    dyncache_entry_t *pPrev; /**< next more recently used entry, NULL for the head */
+    dyncache_entry_t *pNext; /**< next less recently used entry, NULL for the tail */
+    int nRefs; /**< references held by the user, maintained by the user */
+};
+
+struct dyncache_s {
+    struct hashtable *ht; /**< name -> entry */
+    dyncache_entry_t *pHead; /**< most recently used entry */
+    dyncache_entry_t *pTail; /**< least recently used entry */
+    int nEntries;
+    int maxEntries;
+    void (*pDestruct)(dyncache_entry_t *pEntry, void *pUsr); /**< frees an entry dropped by the cache */
+    void *pUsr; /**< passed to pDestruct */
+};
+
+/**
+ * Construct a cache for up to @p maxEntries entries. @p pDestruct is called
+ * for every entry the cache drops; pEntry->pName is still valid then, but
+ * freed by the cache afterwards.
+ */
+rsRetVal dyncacheConstruct(dyncache_t **ppThis,
+                           int maxEntries,
+                           void (*pDestruct)(dyncache_entry_t *pEntry, void *pUsr),
+                           void *pUsr);
+
+/** Drop all entries and free the cache. */
+void dyncacheDestruct(dyncache_t **ppThis);
+
+/** Find the entry for @p pName and mark it as most recently used. NULL if not cached. */
+dyncache_entry_t *dyncacheFind(dyncache_t *pThis, const uchar *pName);
+
+/**
+ * If the cache is full, drop the least recently used unreferenced entry.
+ * Callers that open a resource for a new entry do this first, so that no
+ * more than maxEntries resources are open at any time. Returns 1 if an
+ * entry was dropped, 0 otherwise.
+ */
+int dyncacheEvict(dyncache_t *pThis);
+
+/**
+ * Add @p pEntry as the most recently used entry under a copy of @p pName,
+ * which must not be cached yet. If the cache is full, the least recently
+ * used unreferenced entry is dropped first. On failure, @p pEntry still
+ * belongs to the caller.
+ */
+rsRetVal dyncacheInsert(dyncache_t *pThis, dyncache_entry_t *pEntry, const uchar *pName);
+
+/** Remove @p pEntry from the cache and drop it, no matter if it is referenced. */
+void dyncacheRemove(dyncache_t *pThis, dyncache_entry_t *pEntry);
+
+/** Drop all entries. */
+void dyncacheClear(dyncache_t *pThis);
+
+#endif /* #ifndef INCLUDED_DYNCACHE_H */
@@ -0,0 +1,562 @@
+/* filerotate.c - native rotation of output files
+ *
+ * See filerotate.h for the concept.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_PRCTL_H
+    #include <sys/prctl.h>
+#endif
+
+#include "rsyslog.h"
+#include "srUtils.h"
+#include "errmsg.h"
+#include "obj.h"
+#include "stream.h"
+#include "zlibw.h"
+#include "zstdw.h"
+#include "filerotate.h"
+
+DEFobjStaticHelpers;
+DEFobjCurrIf(zlibw) DEFobjCurrIf(zstdw)
+
+#define SEGMENT_STAMP_FMT "%Y%m%d-%H%M%S"
+#define SEGMENT_MAX_SEQ 999 /* segments with the same time stamp */
+
+/* files that may exist for a segment, besides the segment itself */
+static const char *const segmentSuffixes[] = {".gz", ".zst", ZSTDW_INDEX_SUFFIX, ".gz.tmp", ".zst.tmp", NULL};
+
+typedef struct rotateJob_s rotateJob_t;
+struct rotateJob_s {
+    char *pszFName; /* rotated file, its segments are processed */
+    fileRotateCompress_t compress;
+    int iKeep;
+    rotateJob_t *pNext;
+};
+
+/* a segment found by the directory scan */
+typedef struct {
+    char *pszName; /* segment name without compression suffix */
+    sbool bPlain; /* the uncompressed segment exists */
+} segment_t;
+
+static struct {
+    pthread_mutex_t mut;
+    pthread_cond_t condWork;
+    rotateJob_t *pHead; /* jobs in order of submission */
+    rotateJob_t *pTail;
+    pthread_t thrdID;
+    sbool bThrdRunning;
+    sbool bStop;
+    sbool bHaveZlibw;
+    sbool bHaveZstdw;
+} rot;
+
+
+rsRetVal fileRotateUseCompressor(const fileRotateCompress_t compress) {
+    DEFiRet;
+
+    pthread_mutex_lock(&rot.mut);
+    if (compress == FILEROTATE_COMPRESS_GZIP && !rot.bHaveZlibw) {
+        CHKiRet(objUse(zlibw, LM_ZLIBW_FILENAME));
+        rot.bHaveZlibw = 1;
+    } else if (compress == FILEROTATE_COMPRESS_ZSTD && !rot.bHaveZstdw) {
+        CHKiRet(objUse(zstdw, LM_ZSTDW_FILENAME));
+        rot.bHaveZstdw = 1;
+    }
+
+finalize_it:
+    pthread_mutex_unlock(&rot.mut);
+    RETiRet;
+}
+
+
+time_t fileRotatePeriodStart(const time_t tNow, const int iInterval) {
+    long gmtoff = 0;
+#if !defined(__sun) && !defined(__hpux) && !defined(_AIX)
+    struct tm tm;
+    if (localtime_r(&tNow, &tm) != NULL) {
+        gmtoff = tm.tm_gmtoff;
+    }
+#endif
+    return tNow - (time_t)((tNow + gmtoff) % iInterval);
+}
+
+
+static int ATTR_NONNULL() fileExists(const char *const pszName) {
+    struct stat st;
+    return lstat(pszName, &st) == 0;
+}
+
+
+/* does any file of segment pszSeg exist? */
+static int ATTR_NONNULL() segmentExists(const char *const pszSeg) {
+    char szName[MAXFNAME];
+
+    if (fileExists(pszSeg)) return 1;
+    for (int i = 0; segmentSuffixes[i] != NULL; ++i) {
+        snprintf(szName, sizeof(szName), "%s%s", pszSeg, segmentSuffixes[i]);
+        if (fileExists(szName)) return 1;
+    }
+    return 0;
+}
+
+
+static void ATTR_NONNULL() removeSegment(const char *const pszSeg) {
+    char szName[MAXFNAME];
+
+    DBGPRINTF("filerotate: removing segment '%s'\n", pszSeg);
+    if (unlink(pszSeg) != 0 && errno != ENOENT) {
+        LogError(errno, RS_RET_IO_ERROR, "cannot remove rotated file '%s'", pszSeg);
+    }
+    for (int i = 0; segmentSuffixes[i] != NULL; ++i) {
+        snprintf(szName, sizeof(szName), "%s%s", pszSeg, segmentSuffixes[i]);
+        if (unlink(szName) != 0 && errno != ENOENT) {
+            LogError(errno, RS_RET_IO_ERROR, "cannot remove rotated file '%s'", szName);
+        }
+    }
+}
+
+
+typedef struct {
+    int fd;
+    const char *pszName;
+} compressOut_t;
+
+static rsRetVal compressWriteOut(void *const pUsr, uchar *pBuf, size_t lenBuf) {
+    compressOut_t *const pOut = (compressOut_t *)pUsr;
+    DEFiRet;
+
+    while (lenBuf > 0) {
+        const ssize_t nWritten = write(pOut->fd, pBuf, lenBuf);
+        if (nWritten == -1) {
+            if (errno == EINTR) continue;
+            LogError(errno, RS_RET_IO_ERROR, "cannot write compressed file '%s'", pOut->pszName);
+            ABORT_FINALIZE(RS_RET_IO_ERROR);
+        }
+        pBuf += nWritten;
+        lenBuf -= nWritten;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* compress segment pszSeg into a temporary file, which replaces the
+ * segment once it is complete and on disk. If we are interrupted, the
+ * segment stays as it is and is picked up by the next scan.
+ */
+static void ATTR_NONNULL() compressSegment(const char *const pszSeg, const fileRotateCompress_t compress) {
+    const char *const pszSfx = (compress == FILEROTATE_COMPRESS_GZIP) ? ".gz" : ".zst";
+    char szTmp[MAXFNAME];
+    char szOut[MAXFNAME];
+    compressOut_t out = {-1, szTmp};
+    struct stat st;
+    int fdIn = -1;
+    rsRetVal localRet;
+
+    if ((compress == FILEROTATE_COMPRESS_GZIP && !rot.bHaveZlibw) ||
+        (compress == FILEROTATE_COMPRESS_ZSTD && !rot.bHaveZstdw)) {
+        return;
+    }
+    snprintf(szTmp, sizeof(szTmp), "%s%s.tmp", pszSeg, pszSfx);
+    snprintf(szOut, sizeof(szOut), "%s%s", pszSeg, pszSfx);
+
+    if ((fdIn = open(pszSeg, O_RDONLY | O_CLOEXEC | O_NOCTTY)) == -1 || fstat(fdIn, &st) != 0) {
+        LogError(errno, RS_RET_FILE_OPEN_ERROR, "cannot open rotated file '%s' for compression", pszSeg);
+        goto done;
+    }
+    out.fd = open(szTmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOCTTY, st.st_mode & 07777);
+    if (out.fd == -1) {
+        LogError(errno, RS_RET_FILE_OPEN_ERROR, "cannot create compressed file '%s'", szTmp);
+        goto done;
+    }
+    if (fchown(out.fd, st.st_uid, st.st_gid) != 0) {
+        DBGPRINTF("filerotate: cannot set owner of '%s', errno %d - ignored\n", szTmp, errno);
+    }
+
+    DBGPRINTF("filerotate: compressing '%s'\n", pszSeg);
+    if (compress == FILEROTATE_COMPRESS_GZIP) {
+        localRet = zlibw.CompressFile(fdIn, compressWriteOut, &out, &rot.bStop);
+    } else {
+        localRet = zstdw.CompressFile(fdIn, compressWriteOut, &out, &rot.bStop);
+    }
+    if (localRet == RS_RET_OK && fdatasync(out.fd) != 0) {
+        LogError(errno, RS_RET_IO_ERROR, "cannot sync compressed file '%s'", szTmp);
+        localRet = RS_RET_IO_ERROR;
+    }
+    close(out.fd);
+    out.fd = -1;
+    if (localRet != RS_RET_OK) {
+        if (localRet != RS_RET_TERMINATE_NOW) {
+            LogError(0, localRet, "error compressing rotated file '%s', left uncompressed", pszSeg);
+        }
+        unlink(szTmp);
+        goto done;
+    }
+    if (rename(szTmp, szOut) != 0) {
+        LogError(errno, RS_RET_IO_ERROR, "cannot rename '%s' to '%s'", szTmp, szOut);
+        unlink(szTmp);
+        goto done;
+    }
+    unlink(pszSeg);
+
+done:
+    if (fdIn != -1) close(fdIn);
+    if (out.fd != -1) close(out.fd);
+}
+
+
+/* check if pszEntry is a file of a segment of pszBase, and if so, return
+ * the length of the segment name, else 0. Segment names are
+ * "<base>.YYYYMMDD-HHMMSS[.NNN]", followed by nothing or one of the
+ * segment suffixes. *pbPlain tells if it is the segment itself.
+ */
+static size_t ATTR_NONNULL() segmentNameLen(const char *const pszEntry,
+                                            const char *const pszBase,
+                                            const size_t lenBase,
+                                            sbool *const pbPlain) {
+    static const char pattern[] = ".dddddddd-dddddd";
+    const char *p;
+    int i;
+
+    if (strncmp(pszEntry, pszBase, lenBase) != 0) return 0;
+    p = pszEntry + lenBase;
+    for (i = 0; pattern[i] != '\0'; ++i, ++p) {
+        if (pattern[i] == 'd' ? !isdigit((unsigned char)*p) : *p != pattern[i]) return 0;
+    }
+    if (p[0] == '.' && isdigit((unsigned char)p[1]) && isdigit((unsigned char)p[2]) && isdigit((unsigned char)p[3])) {
+        p += 4;
+    }
+    const size_t lenSeg = p - pszEntry;
+    if (*p == '\0') {
+        *pbPlain = 1;
+        return lenSeg;
+    }
+    for (i = 0; segmentSuffixes[i] != NULL; ++i) {
+        if (!strcmp(p, segmentSuffixes[i])) {
+            *pbPlain = 0;
+            return lenSeg;
+        }
+    }
+    return 0;
+}
+
+
+/* newest first; the time stamps and sequence numbers sort lexically */
+static int cmpSegments(const void *const a, const void *const b) {
+    return strcmp(((const segment_t *)b)->pszName, ((const segment_t *)a)->pszName);
+}
+
+
+/* find the segments of pszFName, newest first */
+static rsRetVal ATTR_NONNULL() scanSegments(const char *const pszFName,
+                                            segment_t **const ppSegs,
+                                            int *const pnSegs) {
+    char szDir[MAXFNAME];
+    const char *pszBase;
+    DIR *dir = NULL;
+    struct dirent *ent;
+    segment_t *segs = NULL;
+    segment_t *newSegs;
+    int nSegs = 0;
+    int maxSegs = 0;
+    int i, j;
+    sbool bPlain;
+    DEFiRet;
+
+    const char *const pSlash = strrchr(pszFName, '/');
+    if (pSlash == NULL) {
+        strcpy(szDir, ".");
+        pszBase = pszFName;
+    } else {
+        snprintf(szDir, sizeof(szDir), "%.*s", (int)(pSlash - pszFName), pszFName);
+        if (szDir[0] == '\0') strcpy(szDir, "/");
+        pszBase = pSlash + 1;
+    }
+    const size_t lenBase = strlen(pszBase);
+
+    if ((dir = opendir(szDir)) == NULL) {
+        LogError(errno, RS_RET_IO_ERROR, "cannot read directory '%s' to process rotated files", szDir);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    while ((ent = readdir(dir)) != NULL) {
+        const size_t lenSeg = segmentNameLen(ent->d_name, pszBase, lenBase, &bPlain);
+        if (lenSeg == 0) continue;
+        if (nSegs == maxSegs) {
+            maxSegs = (maxSegs == 0) ? 16 : 2 * maxSegs;
+            CHKmalloc(newSegs = realloc(segs, maxSegs * sizeof(segment_t)));
+            segs = newSegs;
+        }
+        CHKmalloc(segs[nSegs].pszName = malloc(strlen(szDir) + lenSeg + 2));
+        sprintf(segs[nSegs].pszName, "%s/%.*s", szDir, (int)lenSeg, ent->d_name);
+        segs[nSegs].bPlain = bPlain;
+        ++nSegs;
+    }
+
+    /* merge the files of each segment */
+    qsort(segs, nSegs, sizeof(segment_t), cmpSegments);
+    for (i = 0, j = 0; i < nSegs; ++i) {
+        if (j > 0 && !strcmp(segs[j - 1].pszName, segs[i].pszName)) {
+            segs[j - 1].bPlain |= segs[i].bPlain;
+            free(segs[i].pszName);
+        } else {
+            segs[j++] = segs[i];
+        }
+    }
+    nSegs = j;
+
+finalize_it:
+    if (dir != NULL) closedir(dir);
+    if (iRet == RS_RET_OK) {
+        *ppSegs = segs;
+        *pnSegs = nSegs;
+    } else {
+        for (i = 0; i < nSegs; ++i) {
+            free(segs[i].pszName);
+        }
+        free(segs);
+    }
+    RETiRet;
+}
+
+
+static void ATTR_NONNULL() processJob(const rotateJob_t *const pJob) {
+    segment_t *segs = NULL;
+    int nSegs = 0;
+    int i;
+
+    if (scanSegments(pJob->pszFName, &segs, &nSegs) != RS_RET_OK) return;
+    DBGPRINTF("filerotate: '%s' has %d rotated segments\n", pJob->pszFName, nSegs);
+    for (i = 0; i < nSegs && !rot.bStop; ++i) {
+        if (pJob->iKeep > 0 && i >= pJob->iKeep) {
+            removeSegment(segs[i].pszName);
+        } else if (segs[i].bPlain && pJob->compress != FILEROTATE_COMPRESS_NONE) {
+            compressSegment(segs[i].pszName, pJob->compress);
+        }
+    }
+    for (i = 0; i < nSegs; ++i) {
+        free(segs[i].pszName);
+    }
+    free(segs);
+}
+
+
+static void jobDestruct(rotateJob_t *const pJob) {
+    free(pJob->pszFName);
+    free(pJob);
+}
+
+
+static void *rotateThread(void __attribute__((unused)) * arg) {
+    rotateJob_t *pJob;
+    sigset_t sigSet;
+
+    /* signals are handled by the main thread only */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+#if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    if (prctl(PR_SET_NAME, "rs:filerotate", 0, 0, 0) != 0) {
+        DBGPRINTF("prctl failed, not setting thread name for '%s'\n", "filerotate");
+    }
+#endif
+    pthread_mutex_lock(&rot.mut);
+    while (1) {
+        while (!rot.bStop && rot.pHead == NULL) {
+            pthread_cond_wait(&rot.condWork, &rot.mut);
+        }
+        if (rot.bStop) break;
+        pJob = rot.pHead;
+        rot.pHead = pJob->pNext;
+        if (rot.pHead == NULL) rot.pTail = NULL;
+        pthread_mutex_unlock(&rot.mut);
+        processJob(pJob);
+        jobDestruct(pJob);
+        pthread_mutex_lock(&rot.mut);
+    }
+    pthread_mutex_unlock(&rot.mut);
+    return NULL;
+}
+
+
+/* queue processing of the segments of pszFName. A job that is still
+ * queued for the file covers the new segment as well.
+ */
+static rsRetVal ATTR_NONNULL() queueJob(const uchar *const pszFName, const fileRotateCompress_t compress, const int iKeep) {
+    rotateJob_t *pJob = NULL;
+    DEFiRet;
+
+    pthread_mutex_lock(&rot.mut);
+    for (pJob = rot.pHead; pJob != NULL; pJob = pJob->pNext) {
+        if (!strcmp(pJob->pszFName, (const char *)pszFName)) {
+            pJob->compress = compress;
+            pJob->iKeep = iKeep;
+            pJob = NULL;
+            FINALIZE;
+        }
+    }
+    if (!rot.bThrdRunning) {
+        if (pthread_create(&rot.thrdID, &default_thread_attr, rotateThread, NULL) != 0) {
+            LogError(errno, RS_RET_ERR, "filerotate: cannot create rotation thread");
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        rot.bThrdRunning = 1;
+    }
+    CHKmalloc(pJob = calloc(1, sizeof(rotateJob_t)));
+    CHKmalloc(pJob->pszFName = strdup((const char *)pszFName));
+    pJob->compress = compress;
+    pJob->iKeep = iKeep;
+    if (rot.pTail == NULL) {
+        rot.pHead = pJob;
+    } else {
+        rot.pTail->pNext = pJob;
+    }
+    rot.pTail = pJob;
+    pJob = NULL;
+    pthread_cond_signal(&rot.condWork);
+
+finalize_it:
+    pthread_mutex_unlock(&rot.mut);
+    if (pJob != NULL) {
+        jobDestruct(pJob);
+    }
+    RETiRet;
+}
+
+
+rsRetVal fileRotate(const uchar *const pszFName,
+                    const time_t tStamp,
+                    const fileRotateCompress_t compress,
+                    const int iKeep) {
+    char szStamp[32];
+    char szSeg[MAXFNAME];
+    char szFrom[MAXFNAME];
+    char szTo[MAXFNAME];
+    struct tm tm;
+    int i;
+    DEFiRet;
+
+    if (localtime_r(&tStamp, &tm) == NULL || strftime(szStamp, sizeof(szStamp), SEGMENT_STAMP_FMT, &tm) == 0) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    for (i = 0;; ++i) {
+        int len;
+        if (i == 0) {
+            len = snprintf(szSeg, sizeof(szSeg), "%s.%s", pszFName, szStamp);
+        } else {
+            len = snprintf(szSeg, sizeof(szSeg), "%s.%s.%03d", pszFName, szStamp, i);
+        }
+        /* leave room for the longest suffix */
+        if (len < 0 || (size_t)len + 16 >= sizeof(szSeg)) {
+            LogError(0, RS_RET_ERR, "file '%s': name too long for rotation", pszFName);
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        if (!segmentExists(szSeg)) break;
+        if (i == SEGMENT_MAX_SEQ) {
+            LogError(0, RS_RET_ERR, "file '%s': too many rotations within one second, not rotated", pszFName);
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+    }
+
+    if (rename((const char *)pszFName, szSeg) != 0) {
+        if (errno == ENOENT) {
+            FINALIZE; /* nothing was written (or someone else moved it away) */
+        }
+        LogError(errno, RS_RET_IO_ERROR, "file '%s': cannot rotate to '%s'", pszFName, szSeg);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    /* the frame index of a seekable zstd file belongs to it */
+    snprintf(szFrom, sizeof(szFrom), "%s%s", pszFName, ZSTDW_INDEX_SUFFIX);
+    snprintf(szTo, sizeof(szTo), "%s%s", szSeg, ZSTDW_INDEX_SUFFIX);
+    if (rename(szFrom, szTo) != 0 && errno != ENOENT) {
+        LogError(errno, RS_RET_IO_ERROR, "file '%s': cannot rotate to '%s'", szFrom, szTo);
+    }
+    DBGPRINTF("filerotate: rotated '%s' to '%s'\n", pszFName, szSeg);
+
+    if (compress != FILEROTATE_COMPRESS_NONE || iKeep > 0) {
+        CHKiRet(queueJob(pszFName, compress, iKeep));
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* the rotation thread does not survive fork(), so it is re-created on next use */
+static void fileRotateAtForkChild(void) {
+    pthread_mutex_init(&rot.mut, NULL);
+    pthread_cond_init(&rot.condWork, NULL);
+    rot.bThrdRunning = 0;
+}
+
+
+rsRetVal fileRotateClassInit(void) {
+    DEFiRet;
+
+    memset(&rot, 0, sizeof(rot));
+    pthread_mutex_init(&rot.mut, NULL);
+    pthread_cond_init(&rot.condWork, NULL);
+    CHKiRet(objGetObjInterface(&obj));
+    if (pthread_atfork(NULL, NULL, fileRotateAtForkChild) != 0) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* Segments that are still queued stay as they are. The next rotation of
+ * their file (in this or a later run) picks them up again.
+ */
+void fileRotateClassExit(void) {
+    rotateJob_t *pJob;
+
+    pthread_mutex_lock(&rot.mut);
+    rot.bStop = 1;
+    pthread_cond_signal(&rot.condWork);
+    pthread_mutex_unlock(&rot.mut);
+    if (rot.bThrdRunning) {
+        pthread_join(rot.thrdID, NULL);
+        rot.bThrdRunning = 0;
+    }
+    while ((pJob = rot.pHead) != NULL) {
+        rot.pHead = pJob->pNext;
+        jobDestruct(pJob);
+    }
+    rot.pTail = NULL;
+    /* the compression modules are not released, see stream.c */
+    pthread_cond_destroy(&rot.condWork);
+    pthread_mutex_destroy(&rot.mut);
+}
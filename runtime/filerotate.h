@@ -0,0 +1,79 @@
+/* filerotate.h - native rotation of output files
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file filerotate.h
+ * @brief Rotates output files without blocking the writer.
+ *
+ * A stream that is due for rotation closes its file and calls
+ * fileRotate(), which only renames the file to a segment name of the form
+ * "<file>.YYYYMMDD-HHMMSS" (plus ".NNN" if that name is taken). The time
+ * stamp is the time the segment ended: the end of its rotation period for
+ * time based rotation, the time of rotation otherwise. The next write then
+ * creates a fresh file.
+ *
+ * Everything that takes time is done by a single background thread:
+ * compressing the segment (to "<segment>.gz" or "<segment>.zst") and
+ * removing the oldest segments beyond the configured number to keep. The
+ * thread works on a directory scan, so segments left uncompressed by an
+ * earlier run (e.g. because rsyslog was stopped meanwhile) are compressed,
+ * too.
+ *
+ * The thread is started on first use. Compression is done by the lmzlibw
+ * and lmzstdw library modules, which must be made available via
+ * fileRotateUseCompressor() before rotations request them.
+ */
+#ifndef INCLUDED_FILEROTATE_H
+#define INCLUDED_FILEROTATE_H
+
+#include <time.h>
+
+/** compression applied to rotated segments */
+typedef enum {
+    FILEROTATE_COMPRESS_NONE = 0,
+    FILEROTATE_COMPRESS_GZIP = 1,
+    FILEROTATE_COMPRESS_ZSTD = 2
+} fileRotateCompress_t;
+
+/**
+ * Load the module that implements @p compress. Must be called from the
+ * main thread, e.g. while the config is loaded.
+ */
+rsRetVal fileRotateUseCompressor(fileRotateCompress_t compress);
+
+/**
+ * Move the (closed) file @p pszFName to a new segment name built from
+ * @p tStamp and queue the segment for compression and retention
+ * processing. At most @p iKeep segments are kept, 0 keeps all. Errors are
+ * reported; the file is then left in place and simply continued.
+ */
+rsRetVal fileRotate(const uchar *pszFName, time_t tStamp, fileRotateCompress_t compress, int iKeep);
+
+/**
+ * Start of the rotation period of length @p iInterval seconds that
+ * contains @p tNow. Periods are aligned to local midnight, so an interval
+ * of 86400 rotates at midnight and one of 3600 on the full hour.
+ */
+time_t fileRotatePeriodStart(time_t tNow, int iInterval);
+
+rsRetVal fileRotateClassInit(void);
+void fileRotateClassExit(void);
+
+#endif /* #ifndef INCLUDED_FILEROTATE_H */
@@ -149,6 +149,8 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"parser.permitslashinprogramname", eCmdHdlrBinary, 0},
     {"stdlog.channelspec", eCmdHdlrString, 0},
     {"janitor.interval", eCmdHdlrPositiveInt, 0},
+    {"workerpool.threads", eCmdHdlrNonNegInt, 0},
+    {"iouring.entries", eCmdHdlrNonNegInt, 0},
     {"senders.reportnew", eCmdHdlrBinary, 0},
     {"senders.reportgoneaway", eCmdHdlrBinary, 0},
     {"senders.timeoutafter", eCmdHdlrPositiveInt, 0},
@@ -189,6 +191,10 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"reverselookup.cache.ttl.default", eCmdHdlrNonNegInt, 0},
     {"reverselookup.cache.ttl.enable", eCmdHdlrBinary, 0},
     {"parser.supportcompressionextension", eCmdHdlrBinary, 0},
+    {"ruleset.batchexecution", eCmdHdlrBinary, 0},
+    {"script.profiling", eCmdHdlrBinary, 0},
+    {"script.profiling.dumpfile", eCmdHdlrString, 0},
+    {"regex.engine", eCmdHdlrGetWord, 0},
     {"shutdown.queue.doublesize", eCmdHdlrBinary, 0},
     {"debug.files", eCmdHdlrArray, 0},
     {"debug.whitelist", eCmdHdlrBinary, 0},
@@ -664,6 +670,27 @@ static rsRetVal ATTR_NONNULL() setReportChildProcessExits(const uchar *const mod
     RETiRet;
 }
 
+static rsRetVal ATTR_NONNULL() setRegexEngine(const uchar *const engine) {
+    DEFiRet;
+    if (!strcmp((char *)engine, "posix")) {
+        loadConf->globals.regexEngine = REGEX_ENGINE_POSIX;
+    } else if (!strcmp((char *)engine, "pcre2")) {
+#ifdef HAVE_PCRE2
+        loadConf->globals.regexEngine = REGEX_ENGINE_PCRE2;
+#else
+        LogError(0, RS_RET_CONF_PARAM_INVLD,
+                 "rsyslog wasn't compiled with PCRE2 support, "
+                 "global parameter regex.engine=\"pcre2\" is ignored");
+        iRet = RS_RET_CONF_PARAM_INVLD;
+#endif
+    } else {
+        LogError(0, RS_RET_CONF_PARAM_INVLD, "invalid value '%s' for global parameter regex.engine -- ignored",
+                 engine);
+        iRet = RS_RET_CONF_PARAM_INVLD;
+    }
+    RETiRet;
+}
+
 static int getDefPFFamily(rsconf_t *cnf) {
     return cnf->globals.iDefPFFamily;
 }
@@ -1088,6 +1115,16 @@ void glblProcessCnf(struct cnfobj *o) {
         } else if (!strcmp(paramblk.descr[i].name, "security.abortonidresolutionfail")) {
             loadConf->globals.abortOnIDResolutionFail = (int)cnfparamvals[i].val.d.n;
             cnfparamvals[i].bUsed = TRUE;
+        } else if (!strcmp(paramblk.descr[i].name, "regex.engine")) {
+            /* must be known before the first regex of the config is compiled */
+            uchar *const engine = (uchar *)es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
+            setRegexEngine(engine);
+            free(engine);
+            cnfparamvals[i].bUsed = TRUE;
+        } else if (!strcmp(paramblk.descr[i].name, "script.profiling")) {
+            /* must be known while statements are parsed, they record their file only if set */
+            loadConf->globals.bScriptProfiling = (int)cnfparamvals[i].val.d.n;
+            cnfparamvals[i].bUsed = TRUE;
         }
     }
 done:
@@ -1307,6 +1344,10 @@ rsRetVal glblDoneLoadCnf(void) {
             LogError(0, RS_RET_OK, "debug log file is '%s', fd %d", pszAltDbgFileName, altdbg);
         } else if (!strcmp(paramblk.descr[i].name, "janitor.interval")) {
             loadConf->globals.janitorInterval = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "workerpool.threads")) {
+            loadConf->globals.wrkPoolThreads = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "iouring.entries")) {
+            loadConf->globals.ioUringEntries = (int)cnfparamvals[i].val.d.n;
         } else if (!strcmp(paramblk.descr[i].name, "net.ipprotocol")) {
             char *proto = es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
             if (!strcmp(proto, "unspecified")) {
@@ -1414,6 +1455,15 @@ rsRetVal glblDoneLoadCnf(void) {
             loadConf->globals.dnscacheEnableTTL = cnfparamvals[i].val.d.n;
         } else if (!strcmp(paramblk.descr[i].name, "parser.supportcompressionextension")) {
             loadConf->globals.bSupportCompressionExtension = cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "ruleset.batchexecution")) {
+            loadConf->globals.bRulesetBatchExec = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "script.profiling")) {
+            /* already processed in glblProcessCnf() */
+        } else if (!strcmp(paramblk.descr[i].name, "script.profiling.dumpfile")) {
+            free(loadConf->globals.pszScriptProfDumpFile);
+            loadConf->globals.pszScriptProfDumpFile = (uchar *)es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
+        } else if (!strcmp(paramblk.descr[i].name, "regex.engine")) {
+            /* already processed in glblProcessCnf() */
         } else {
             dbgprintf(
                 "glblDoneLoadCnf: program error, non-handled "
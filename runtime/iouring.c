@@ -0,0 +1,474 @@
+/* iouring.c - shared io_uring for stream writes
+ *
+ * See iouring.h for the concept. We use the raw system calls and the ring
+ * layout from linux/io_uring.h. Entries are only ever added under ring.mut
+ * and submitted right away, so the submission queue never holds entries
+ * between calls. The number of completions in flight is kept below the
+ * size of the completion queue, so that it can never overflow.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_PRCTL_H
+    #include <sys/prctl.h>
+#endif
+#if defined(HAVE_LINUX_IO_URING_H) && defined(HAVE_SYSCALL)
+    #include <sys/syscall.h>
+    #include <sys/mman.h>
+    #include <linux/io_uring.h>
+    #if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_RW_CUR_POS)
+        #define USE_IOURING 1
+    #endif
+#endif
+
+#include "rsyslog.h"
+#include "srUtils.h"
+#include "errmsg.h"
+#include "rsconf.h"
+#include "iouring.h"
+
+/* user_data of the fsync entries of a request is tagged with this bit, so
+ * that their completions can be told from the one of the write. A user_data
+ * of 0 is the NOP that stops the completion thread.
+ */
+#define IOURING_TAG_SYNC ((uint64_t)1)
+
+static struct {
+    pthread_mutex_t mut;
+    pthread_cond_t condDone; /* a request without callback is done */
+    unsigned nInFlight; /* completions the kernel still owes us */
+    sbool bSetupDone; /* setup was attempted (successful if fd != -1) */
+    sbool bThrdRunning;
+    sbool bStop;
+    pthread_t thrdID;
+#ifdef USE_IOURING
+    int fd;
+    unsigned cqEntries;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    struct io_uring_sqe *sqes;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+    void *sqRing;
+    size_t sqRingLen;
+    void *cqRing; /* same as sqRing with IORING_FEAT_SINGLE_MMAP */
+    size_t cqRingLen;
+    size_t sqesLen;
+#endif
+} ring;
+
+
+#ifdef USE_IOURING
+static int sysEnter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, ring.fd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+
+/* create the ring. ring.mut must be locked. */
+static rsRetVal iouringSetup(void) {
+    struct io_uring_params p;
+    DEFiRet;
+
+    memset(&p, 0, sizeof(p));
+    /* a request takes up to 3 entries, so very small rings are useless */
+    const unsigned entries = (runConf->globals.ioUringEntries < 8) ? 8 : (unsigned)runConf->globals.ioUringEntries;
+    ring.fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (ring.fd < 0) {
+        LogError(errno, RS_RET_ERR, "io_uring: cannot set up ring, using regular writes");
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        LogError(0, RS_RET_NOT_IMPLEMENTED,
+                 "io_uring: kernel does not support writes at the current file "
+                 "position, using regular writes");
+        ABORT_FINALIZE(RS_RET_NOT_IMPLEMENTED);
+    }
+
+    ring.sqRingLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring.cqRingLen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring.cqRingLen > ring.sqRingLen) ring.sqRingLen = ring.cqRingLen;
+        ring.cqRingLen = ring.sqRingLen;
+    }
+    ring.sqRing = mmap(NULL, ring.sqRingLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd,
+                       IORING_OFF_SQ_RING);
+    if (ring.sqRing == MAP_FAILED) {
+        ring.sqRing = NULL;
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring.cqRing = ring.sqRing;
+    } else {
+        ring.cqRing = mmap(NULL, ring.cqRingLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd,
+                           IORING_OFF_CQ_RING);
+        if (ring.cqRing == MAP_FAILED) {
+            ring.cqRing = NULL;
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+    }
+    ring.sqesLen = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring.sqes = mmap(NULL, ring.sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (ring.sqes == MAP_FAILED) {
+        ring.sqes = NULL;
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
+    ring.sqTail = (unsigned *)((char *)ring.sqRing + p.sq_off.tail);
+    ring.sqMask = (unsigned *)((char *)ring.sqRing + p.sq_off.ring_mask);
+    ring.sqArray = (unsigned *)((char *)ring.sqRing + p.sq_off.array);
+    ring.cqHead = (unsigned *)((char *)ring.cqRing + p.cq_off.head);
+    ring.cqTail = (unsigned *)((char *)ring.cqRing + p.cq_off.tail);
+    ring.cqMask = (unsigned *)((char *)ring.cqRing + p.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)((char *)ring.cqRing + p.cq_off.cqes);
+    ring.cqEntries = (p.cq_entries < p.sq_entries) ? p.cq_entries : p.sq_entries;
+    DBGPRINTF("io_uring: ring set up with %u entries, features 0x%x\n", p.sq_entries, p.features);
+
+finalize_it:
+    if (iRet != RS_RET_OK && ring.fd >= 0) {
+        if (iRet == RS_RET_ERR) {
+            LogError(errno, RS_RET_ERR, "io_uring: cannot map ring, using regular writes");
+        }
+        if (ring.sqes != NULL) munmap(ring.sqes, ring.sqesLen);
+        if (ring.cqRing != NULL && ring.cqRing != ring.sqRing) munmap(ring.cqRing, ring.cqRingLen);
+        if (ring.sqRing != NULL) munmap(ring.sqRing, ring.sqRingLen);
+        ring.sqes = NULL;
+        ring.sqRing = ring.cqRing = NULL;
+        close(ring.fd);
+        ring.fd = -1;
+    }
+    RETiRet;
+}
+
+
+static struct io_uring_sqe *getSqe(unsigned *const pTail) {
+    const unsigned idx = *pTail & *ring.sqMask;
+    struct io_uring_sqe *const sqe = &ring.sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sqArray[idx] = idx;
+    ++*pTail;
+    return sqe;
+}
+
+
+/* add entries to the submission queue and submit them. ring.mut must be locked. */
+static rsRetVal submitEntries(unsigned tail, const unsigned nEntries) {
+    int r;
+    DEFiRet;
+
+    __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+    do {
+        r = sysEnter(nEntries, 0, 0);
+    } while (r < 0 && errno == EINTR);
+    if (r < 0) {
+        /* nothing was consumed, so we can take the entries back */
+        __atomic_store_n(ring.sqTail, tail - nEntries, __ATOMIC_RELEASE);
+        DBGPRINTF("io_uring: submission failed, errno %d\n", errno);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    ring.nInFlight += nEntries;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* submit (the remainder of) pReq. ring.mut must be locked. */
+static rsRetVal submitReq(iouring_req_t *const pReq) {
+    struct io_uring_sqe *sqe;
+    unsigned tail;
+    size_t len;
+    DEFiRet;
+
+    const sbool bSyncDir = pReq->bSync && pReq->fdDir != -1;
+    const unsigned nEntries = 1 + (pReq->bSync ? 1 : 0) + (bSyncDir ? 1 : 0);
+    if (ring.nInFlight + nEntries > ring.cqEntries) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
+    tail = *ring.sqTail;
+    len = pReq->lenBuf - pReq->nWritten;
+    sqe = getSqe(&tail);
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = pReq->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(pReq->pBuf + pReq->nWritten);
+    sqe->len = (len > UINT_MAX) ? UINT_MAX : (unsigned)len;
+    sqe->off = (uint64_t)-1; /* current file position, keeps O_APPEND semantics */
+    sqe->user_data = (uint64_t)(uintptr_t)pReq;
+    if (pReq->bSync) {
+        sqe->flags = IOSQE_IO_LINK;
+        sqe = getSqe(&tail);
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = pReq->fd;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->user_data = (uint64_t)(uintptr_t)pReq | IOURING_TAG_SYNC;
+        if (bSyncDir) {
+            sqe->flags = IOSQE_IO_LINK;
+            sqe = getSqe(&tail);
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = pReq->fdDir;
+            sqe->user_data = (uint64_t)(uintptr_t)pReq | IOURING_TAG_SYNC;
+        }
+    }
+    CHKiRet(submitEntries(tail, nEntries));
+    pReq->nPending = nEntries;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* process all available completions. Requests that are done and have a
+ * callback are returned in *ppDone. ring.mut must be locked.
+ */
+static void reapCompletions(iouring_req_t **const ppDone) {
+    unsigned head = *ring.cqHead;
+    const unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe *const cqe = &ring.cqes[head & *ring.cqMask];
+        const uint64_t userData = cqe->user_data;
+        const int res = cqe->res;
+        iouring_req_t *const pReq = (iouring_req_t *)(uintptr_t)(userData & ~IOURING_TAG_SYNC);
+
+        --ring.nInFlight;
+        if (pReq == NULL) continue; /* stop NOP */
+        if (userData & IOURING_TAG_SYNC) {
+            /* like syncFile(), we do not fail the write if the sync fails */
+            if (res < 0 && res != -ECANCELED) {
+                DBGPRINTF("io_uring: sync for fd %d failed with error %d - ignoring\n", pReq->fd, -res);
+            }
+        } else if (res > 0) {
+            pReq->nWritten += res;
+            if (pReq->nWritten < pReq->lenBuf) pReq->bRetry = 1;
+        } else if (res == -EINTR || res == -EAGAIN) {
+            pReq->bRetry = 1;
+        } else {
+            pReq->err = (res == 0) ? EIO : -res;
+        }
+
+        if (--pReq->nPending > 0) continue;
+        if (pReq->bRetry && pReq->err == 0) {
+            pReq->bRetry = 0;
+            if (submitReq(pReq) == RS_RET_OK) continue;
+            pReq->err = EAGAIN; /* the caller writes the remainder */
+        }
+        pReq->bDone = 1;
+        if (pReq->cb == NULL) {
+            pthread_cond_broadcast(&ring.condDone);
+        } else {
+            pReq->pNext = *ppDone;
+            *ppDone = pReq;
+        }
+    }
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+}
+
+
+static void *iouringThread(void __attribute__((unused)) * arg) {
+    iouring_req_t *pDone;
+    iouring_req_t *pNext;
+    sigset_t sigSet;
+    sbool bStop = 0;
+
+    /* signals are handled by the main thread only */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+    #if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    if (prctl(PR_SET_NAME, "rs:iouring", 0, 0, 0) != 0) {
+        DBGPRINTF("prctl failed, not setting thread name for '%s'\n", "iouring");
+    }
+    #endif
+
+    while (!bStop) {
+        if (sysEnter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            DBGPRINTF("io_uring: waiting for completions failed, errno %d\n", errno);
+            srSleep(0, 100000);
+        }
+        pDone = NULL;
+        pthread_mutex_lock(&ring.mut);
+        reapCompletions(&pDone);
+        bStop = ring.bStop && ring.nInFlight == 0;
+        pthread_mutex_unlock(&ring.mut);
+        for (; pDone != NULL; pDone = pNext) {
+            pNext = pDone->pNext; /* pDone may be gone once the callback returns */
+            pDone->cb(pDone);
+        }
+    }
+    return NULL;
+}
+
+
+/* set up the ring and start the completion thread if not yet done.
+ * ring.mut must be locked.
+ */
+static rsRetVal iouringStart(void) {
+    DEFiRet;
+
+    if (!ring.bSetupDone) {
+        ring.bSetupDone = 1;
+        iouringSetup();
+    }
+    if (ring.fd == -1 || ring.bStop) ABORT_FINALIZE(RS_RET_ERR);
+    if (!ring.bThrdRunning) {
+        if (pthread_create(&ring.thrdID, &default_thread_attr, iouringThread, NULL) != 0) {
+            LogError(errno, RS_RET_ERR, "io_uring: cannot create completion thread");
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        ring.bThrdRunning = 1;
+    }
+
+finalize_it:
+    RETiRet;
+}
+#endif /* #ifdef USE_IOURING */
+
+
+int iouringEnabled(void) {
+    if (runConf == NULL || runConf->globals.ioUringEntries == 0) return 0;
+#ifdef USE_IOURING
+    return 1;
+#else
+    static sbool bWarned = 0;
+    if (!bWarned) {
+        bWarned = 1;
+        LogError(0, RS_RET_NOT_IMPLEMENTED, "io_uring is not supported on this platform, ioUring.entries ignored");
+    }
+    return 0;
+#endif
+}
+
+
+rsRetVal iouringSubmit(iouring_req_t *const pReq) {
+    DEFiRet;
+
+#ifdef USE_IOURING
+    pthread_mutex_lock(&ring.mut);
+    pReq->nWritten = 0;
+    pReq->err = 0;
+    pReq->bRetry = 0;
+    pReq->bDone = 0;
+    if ((iRet = iouringStart()) == RS_RET_OK) {
+        iRet = submitReq(pReq);
+    }
+    pthread_mutex_unlock(&ring.mut);
+#else
+    (void)pReq;
+    iRet = RS_RET_NOT_IMPLEMENTED;
+#endif
+
+    RETiRet;
+}
+
+
+rsRetVal iouringWriteWait(iouring_req_t *const pReq) {
+    DEFiRet;
+
+    assert(pReq->cb == NULL);
+#ifdef USE_IOURING
+    /* a callback would wait for itself */
+    if (ring.bThrdRunning && pthread_equal(pthread_self(), ring.thrdID)) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+#endif
+    CHKiRet(iouringSubmit(pReq));
+    pthread_mutex_lock(&ring.mut);
+    while (!pReq->bDone) {
+        pthread_cond_wait(&ring.condDone, &ring.mut);
+    }
+    pthread_mutex_unlock(&ring.mut);
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* the completion thread does not survive fork(), so it is re-created on next use */
+static void iouringAtForkChild(void) {
+    pthread_mutex_init(&ring.mut, NULL);
+    pthread_cond_init(&ring.condDone, NULL);
+    ring.bThrdRunning = 0;
+}
+
+
+rsRetVal iouringClassInit(void) {
+    DEFiRet;
+
+    memset(&ring, 0, sizeof(ring));
+    pthread_mutex_init(&ring.mut, NULL);
+    pthread_cond_init(&ring.condDone, NULL);
+#ifdef USE_IOURING
+    ring.fd = -1;
+#endif
+    if (pthread_atfork(NULL, NULL, iouringAtForkChild) != 0) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* All streams have been closed when this is called, so there is nothing in flight. */
+void iouringClassExit(void) {
+#ifdef USE_IOURING
+    struct io_uring_sqe *sqe;
+    unsigned tail;
+
+    pthread_mutex_lock(&ring.mut);
+    ring.bStop = 1;
+    if (ring.bThrdRunning) {
+        /* a NOP wakes up the completion thread */
+        tail = *ring.sqTail;
+        sqe = getSqe(&tail);
+        sqe->opcode = IORING_OP_NOP;
+        if (submitEntries(tail, 1) != RS_RET_OK) {
+            DBGPRINTF("io_uring: cannot wake up completion thread, not waiting for it\n");
+            ring.bThrdRunning = 0;
+        }
+    }
+    pthread_mutex_unlock(&ring.mut);
+    if (ring.bThrdRunning) {
+        pthread_join(ring.thrdID, NULL);
+        ring.bThrdRunning = 0;
+    }
+    if (ring.fd != -1) {
+        munmap(ring.sqes, ring.sqesLen);
+        if (ring.cqRing != ring.sqRing) munmap(ring.cqRing, ring.cqRingLen);
+        munmap(ring.sqRing, ring.sqRingLen);
+        close(ring.fd);
+        ring.fd = -1;
+    }
+#endif
+    pthread_cond_destroy(&ring.condDone);
+    pthread_mutex_destroy(&ring.mut);
+}
@@ -0,0 +1,94 @@
+/* iouring.h - shared io_uring for stream writes
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file iouring.h
+ * @brief One io_uring that carries the writes of many streams.
+ *
+ * With the global "ioUring.entries" setting, streams hand their buffers to
+ * a single process-wide io_uring instead of calling write() (and
+ * fdatasync()) themselves. A write with sync requested is submitted as a
+ * linked write + fdatasync chain (plus an fsync of the directory, if the
+ * stream keeps it open), so it costs one submission instead of two or
+ * three system calls.
+ *
+ * Completions are reaped by a single thread, which also finishes short
+ * writes by resubmitting the remainder. Asynchronous streams are notified
+ * via a callback on that thread, so they do not need a writer thread of
+ * their own. Synchronous callers can instead wait for their request.
+ *
+ * The ring is set up and its thread started on first use. If that fails,
+ * or if too many requests are in flight, submission fails and the caller
+ * does a regular write() instead.
+ *
+ * The ring is driven via the raw system calls, so no liburing is needed.
+ * Without linux/io_uring.h, all submissions fail.
+ */
+#ifndef INCLUDED_IOURING_H
+#define INCLUDED_IOURING_H
+
+typedef struct iouring_req_s iouring_req_t;
+
+/** A write request. Owned by the caller, usually embedded into its object. */
+struct iouring_req_s {
+    int fd; /**< file to write to, at its current position */
+    int fdDir; /**< directory to fsync after the data, -1 if none */
+    sbool bSync; /**< fdatasync the file after the write */
+    const uchar *pBuf;
+    size_t lenBuf;
+    /** called on the completion thread when the request is done, NULL to
+     * wait via iouringWriteWait(). The request is no longer accessed by the
+     * ring once the callback was entered.
+     */
+    void (*cb)(iouring_req_t *pReq);
+    void *pUsr; /**< for use by the callback */
+    /* results, valid once the request is done */
+    size_t nWritten; /**< bytes written */
+    int err; /**< errno of the failed write, 0 if none */
+    /* internal state */
+    int nPending; /**< completions outstanding for the current submission */
+    int nSqes; /**< entries used by the current submission */
+    sbool bRetry; /**< submit the remainder once nPending drops to 0 */
+    sbool bDone;
+    iouring_req_t *pNext;
+};
+
+/** Is the io_uring enabled in the running config (it may still fail to set up)? */
+int iouringEnabled(void);
+
+/**
+ * Submit @p pReq. On success, @p pReq must not be touched until its
+ * callback was called. Fails if the ring is unavailable or full, in which
+ * case the caller shall write directly.
+ */
+rsRetVal iouringSubmit(iouring_req_t *pReq);
+
+/**
+ * Submit @p pReq (whose cb must be NULL) and wait until it is done. Returns
+ * RS_RET_OK if it was processed by the ring, even if the write itself
+ * failed (see pReq->err). On any other return, nothing was written. Always
+ * fails when called from a completion callback.
+ */
+rsRetVal iouringWriteWait(iouring_req_t *pReq);
+
+rsRetVal iouringClassInit(void);
+void iouringClassExit(void);
+
+#endif /* #ifndef INCLUDED_IOURING_H */
@@ -30,13 +30,33 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <errno.h>
 #include <pthread.h>
+#include <signal.h>
+#if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    #include <sys/prctl.h>
+#endif
 
 #include "rsyslog.h"
+#include "errmsg.h"
 #include "janitor.h"
+#include "timerwheel.h"
 
 static struct janitorEtry *janitorRoot = NULL;
 static pthread_mutex_t janitorMut = PTHREAD_MUTEX_INITIALIZER;
+static timerwheel_timer_t janitorTimer;
+static long janitorIntervalMs;
+/* The janitor callbacks may do slow I/O (e.g. omfile closes and syncs
+ * files), so they must not run on the shared timer thread, which would
+ * delay all other timers. The timer just wakes our own thread. The wakeup
+ * state has its own mutex, as janitorMut is held while callbacks run.
+ */
+static pthread_mutex_t janitorWakeMut = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t janitorWakeCond = PTHREAD_COND_INITIALIZER;
+static pthread_t janitorThrdID;
+static int bJanitorThrdRunning = 0;
+static int bJanitorDue = 0; /* protected by janitorWakeMut */
+static int bJanitorStopped = 0; /* protected by janitorWakeMut */
 
 rsRetVal janitorAddEtry(void (*cb)(void *), const char *id, void *pUsr) {
     struct janitorEtry *etry = NULL;
@@ -93,3 +113,70 @@ void janitorRun(void) {
     }
     pthread_mutex_unlock(&janitorMut);
 }
+
+static void janitorTimerCB(void __attribute__((unused)) * pUsr) {
+    int bStopped;
+
+    pthread_mutex_lock(&janitorWakeMut);
+    bJanitorDue = 1;
+    pthread_cond_signal(&janitorWakeCond);
+    bStopped = bJanitorStopped;
+    pthread_mutex_unlock(&janitorWakeMut);
+    if (!bStopped) timerwheelArm(&janitorTimer, janitorIntervalMs);
+}
+
+static void *janitorThrd(void __attribute__((unused)) * arg) {
+    sigset_t sigSet;
+
+    /* signals are handled by the main thread only */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+#if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    if (prctl(PR_SET_NAME, "rs:janitor", 0, 0, 0) != 0) {
+        DBGPRINTF("prctl failed, not setting thread name for '%s'\n", "janitor");
+    }
+#endif
+    pthread_mutex_lock(&janitorWakeMut);
+    while (1) {
+        while (!bJanitorDue && !bJanitorStopped) pthread_cond_wait(&janitorWakeCond, &janitorWakeMut);
+        if (bJanitorStopped) break;
+        bJanitorDue = 0;
+        pthread_mutex_unlock(&janitorWakeMut);
+        janitorRun();
+        pthread_mutex_lock(&janitorWakeMut);
+    }
+    pthread_mutex_unlock(&janitorWakeMut);
+    return NULL;
+}
+
+/* run the janitor every intervalMinutes on its own thread, woken by the
+ * shared timer wheel
+ */
+rsRetVal janitorStart(const int intervalMinutes) {
+    DEFiRet;
+
+    janitorIntervalMs = (long)intervalMinutes * 60 * 1000;
+    if (pthread_create(&janitorThrdID, &default_thread_attr, janitorThrd, NULL) != 0) {
+        LogError(errno, RS_RET_ERR, "janitor: cannot create janitor thread");
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    bJanitorThrdRunning = 1;
+    timerwheelTimerInit(&janitorTimer, janitorTimerCB, NULL);
+    CHKiRet(timerwheelArm(&janitorTimer, janitorIntervalMs));
+
+finalize_it:
+    RETiRet;
+}
+
+void janitorStop(void) {
+    pthread_mutex_lock(&janitorWakeMut);
+    bJanitorStopped = 1;
+    pthread_cond_signal(&janitorWakeCond);
+    pthread_mutex_unlock(&janitorWakeMut);
+    timerwheelCancelSync(&janitorTimer);
+    if (bJanitorThrdRunning) {
+        pthread_join(janitorThrdID, NULL);
+        bJanitorThrdRunning = 0;
+    }
+}
@@ -0,0 +1,388 @@
+/* jsonlazy.c - selective ("lazy") JSON parsing
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file jsonlazy.c
+ * @brief Reference collection and selective parser for lazy JSON parsing.
+ *
+ * The structural scan only checks what is needed to find member boundaries
+ * (strings, nesting, separators). Values of members that are not referenced
+ * are thus not fully validated; e.g. an invalid number literal in an unused
+ * member is not detected. All members that are materialized are parsed by
+ * json-c as usual.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "rsyslog.h"
+#include "rsconf.h"
+#include "ruleset.h"
+#include "template.h"
+#include "rainerscript.h"
+#include "unicode-helper.h"
+#include "jsonlazy.h"
+
+/* key sets waiting for jsonlazyResolveAll(). Only modified during config
+ * load, which is single-threaded.
+ */
+static jsonlazy_keys_t *pendingRoot = NULL;
+
+/* default nesting limit of the json tokener */
+#define JSONLAZY_MAX_DEPTH 32
+
+
+rsRetVal jsonlazyRegister(const uchar *const container, jsonlazy_keys_t **const ppKeys) {
+    jsonlazy_keys_t *pKeys = NULL;
+    DEFiRet;
+
+    CHKmalloc(pKeys = calloc(1, sizeof(jsonlazy_keys_t)));
+    CHKmalloc(pKeys->container = ustrdup((*container == '$') ? container + 1 : container));
+    pKeys->bFull = 1; /* until resolved, be safe */
+    pKeys->nextPending = pendingRoot;
+    pendingRoot = pKeys;
+    *ppKeys = pKeys;
+
+finalize_it:
+    if (iRet != RS_RET_OK && pKeys != NULL) {
+        free(pKeys);
+    }
+    RETiRet;
+}
+
+
+static rsRetVal addKey(jsonlazy_keys_t *const pKeys, const uchar *const key, const size_t lenKey) {
+    char *newKey = NULL;
+    DEFiRet;
+
+    for (int i = 0; i < pKeys->nKeys; ++i) {
+        if (strlen(pKeys->keys[i]) == lenKey && !memcmp(pKeys->keys[i], key, lenKey)) FINALIZE;
+    }
+    if (pKeys->nKeys == pKeys->maxKeys) {
+        const int newMax = (pKeys->maxKeys == 0) ? 8 : pKeys->maxKeys * 2;
+        char **newKeys;
+        CHKmalloc(newKeys = realloc(pKeys->keys, newMax * sizeof(char *)));
+        pKeys->keys = newKeys;
+        pKeys->maxKeys = newMax;
+    }
+    CHKmalloc(newKey = malloc(lenKey + 1));
+    memcpy(newKey, key, lenKey);
+    newKey[lenKey] = '\0';
+    pKeys->keys[pKeys->nKeys++] = newKey;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* A reference "covers" the container if it names the container itself or
+ * one of its parents - then the full tree is needed. A reference below the
+ * container adds its first path component (minus an array index) as key.
+ */
+void jsonlazyAddRef(jsonlazy_keys_t *const pKeys, const propid_t id, const uchar *name) {
+    const uchar *c = pKeys->container;
+    uchar root;
+
+    if (pKeys->bFull) return;
+    switch (id) {
+        case PROP_CEE:
+            root = '!';
+            break;
+        case PROP_LOCAL_VAR:
+            root = '.';
+            break;
+        case PROP_GLOBAL_VAR:
+            root = '/';
+            break;
+        case PROP_CEE_ALL_JSON:
+        case PROP_CEE_ALL_JSON_PLAIN:
+        case PROP_JSONMESG:
+            if (*c == '!') pKeys->bFull = 1;
+            return;
+        default:
+            return;
+    }
+    if (*c++ != root) return;
+    if (name == NULL) {
+        pKeys->bFull = 1;
+        return;
+    }
+    if (*name == root) ++name;
+    if (*name == '!') ++name;
+    if (*c == '!') ++c;
+
+    while (*c != '\0') {
+        const size_t lenC = strcspn((const char *)c, "!");
+        const size_t lenN = strcspn((const char *)name, "!");
+        if (*name == '\0') {
+            pKeys->bFull = 1; /* parent of container */
+            return;
+        }
+        if (lenN < lenC || memcmp(c, name, lenC) != 0) return; /* unrelated */
+        if (lenN > lenC) {
+            if (name[lenC] == '[') pKeys->bFull = 1; /* array access to container */
+            return;
+        }
+        c += lenC;
+        name += lenN;
+        if (*c == '!') ++c;
+        if (*name == '!') ++name;
+    }
+    if (*name == '\0') {
+        pKeys->bFull = 1; /* the container itself */
+        return;
+    }
+    if (addKey(pKeys, name, strcspn((const char *)name, "![")) != RS_RET_OK) pKeys->bFull = 1;
+}
+
+
+static int cmpKeys(const void *const a, const void *const b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+
+DEFFUNC_llExecFunc(doResolveRuleset) {
+    cnfstmtCollectJSONRefs(((ruleset_t *)pData)->root, (jsonlazy_keys_t *)pParam);
+    return RS_RET_OK;
+}
+
+rsRetVal jsonlazyResolveAll(rsconf_t *const conf) {
+    jsonlazy_keys_t *pKeys;
+    DEFiRet;
+
+    while ((pKeys = pendingRoot) != NULL) {
+        pendingRoot = pKeys->nextPending;
+        pKeys->nextPending = NULL;
+        pKeys->bFull = 0;
+        CHKiRet(llExecFunc(&(conf->rulesets.llRulesets), doResolveRuleset, pKeys));
+        tplCollectJSONRefs(conf, pKeys);
+        if (pKeys->nKeys > 1) qsort(pKeys->keys, pKeys->nKeys, sizeof(char *), cmpKeys);
+        pKeys->bResolved = 1;
+        DBGPRINTF("jsonlazy: container '%s': %s, %d referenced members\n", pKeys->container,
+                  pKeys->bFull ? "full parse (used as a whole)" : "lazy", pKeys->nKeys);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+static const char *skipWS(const char *p, const char *const end) {
+    while (p < end && isspace((uchar)*p)) ++p;
+    return p;
+}
+
+/* p points to the opening quote. Returns pointer after the closing quote or
+ * NULL if the string is unterminated. *pbEscaped is set if escapes occur.
+ */
+static const char *skipString(const char *p, const char *const end, int *const pbEscaped) {
+    for (++p; p < end; ++p) {
+        if (*p == '\\') {
+            *pbEscaped = 1;
+            if (++p == end) return NULL;
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return NULL;
+}
+
+/* skip a single JSON value of any type. Returns NULL on structural error.
+ * Nesting deeper than the tokener's default limit is rejected, as a full
+ * parse would reject it as well.
+ */
+static const char *skipValue(const char *p, const char *const end) {
+    char closing[JSONLAZY_MAX_DEPTH];
+    int bEscaped;
+    int depth = 0;
+
+    if (p == end) return NULL;
+    if (*p == '"') return skipString(p, end, &bEscaped);
+    if (*p != '{' && *p != '[') { /* scalar */
+        const char *const start = p;
+        while (p < end && *p != ',' && *p != '}' && *p != ']' && !isspace((uchar)*p)) ++p;
+        return (p == start) ? NULL : p;
+    }
+    while (p < end) {
+        switch (*p) {
+            case '"':
+                if ((p = skipString(p, end, &bEscaped)) == NULL) return NULL;
+                continue;
+            case '{':
+            case '[':
+                if (depth == JSONLAZY_MAX_DEPTH) return NULL;
+                closing[depth++] = (*p == '{') ? '}' : ']';
+                break;
+            case '}':
+            case ']':
+                if (*p != closing[--depth]) return NULL;
+                if (depth == 0) return p + 1;
+                break;
+            default:
+                break;
+        }
+        ++p;
+    }
+    return NULL;
+}
+
+static int isReferenced(const jsonlazy_keys_t *const pKeys, const char *const key) {
+    return bsearch(&key, pKeys->keys, pKeys->nKeys, sizeof(char *), cmpKeys) != NULL;
+}
+
+/* parse a single, complete value with json-c. One extra byte (the delimiter
+ * following the value) is handed to the tokener so that numbers at the end
+ * of the buffer are known to be complete.
+ */
+static struct json_object *parseValue(struct json_tokener *const tokener,
+                                      const char *const start,
+                                      const size_t len,
+                                      const size_t lenAvail) {
+    struct json_object *json;
+
+    json_tokener_reset(tokener);
+    json = json_tokener_parse_ex(tokener, start, (int)((lenAvail > len) ? len + 1 : len));
+    if (json != NULL && (size_t)tokener->char_offset != len) {
+        json_object_put(json);
+        json = NULL;
+    }
+    return json;
+}
+
+static rsRetVal parseFull(struct json_tokener *const tokener,
+                          const char *const text,
+                          const size_t len,
+                          struct json_object **const ppJson) {
+    struct json_object *json;
+    DEFiRet;
+
+    json_tokener_reset(tokener);
+    if ((json = json_tokener_parse_ex(tokener, text, (int)len)) == NULL) ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+    if (skipWS(text + tokener->char_offset, text + len) != text + len) {
+        json_object_put(json);
+        ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+    }
+    *ppJson = json;
+
+finalize_it:
+    RETiRet;
+}
+
+/* keys up to this size are copied to the stack for the lookup */
+#define JSONLAZY_KEYBUF_SIZE 256
+
+rsRetVal jsonlazyParse(const jsonlazy_keys_t *const pKeys,
+                       struct json_tokener *const tokener,
+                       const char *const text,
+                       const size_t len,
+                       struct json_object **const ppJson) {
+    struct json_object *json = NULL;
+    const char *const end = text + len;
+    const char *p;
+    char keybuf[JSONLAZY_KEYBUF_SIZE];
+    char *key = NULL;
+    DEFiRet;
+
+    p = skipWS(text, end);
+    if (pKeys == NULL || pKeys->bFull || p == end || *p != '{') {
+        CHKiRet(parseFull(tokener, text, len, ppJson));
+        FINALIZE;
+    }
+
+    CHKmalloc(json = json_object_new_object());
+    p = skipWS(p + 1, end);
+    if (p < end && *p == '}') {
+        ++p;
+    } else {
+        for (;;) {
+            int bEscaped = 0;
+            const char *keyStart, *keyEnd, *valStart, *valEnd;
+
+            if (p == end || *p != '"') ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+            keyStart = p + 1;
+            if ((p = skipString(p, end, &bEscaped)) == NULL) ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+            if (bEscaped) {
+                /* keys with escapes are rare; let json-c handle the details */
+                json_object_put(json);
+                json = NULL;
+                CHKiRet(parseFull(tokener, text, len, ppJson));
+                FINALIZE;
+            }
+            keyEnd = p - 1;
+            p = skipWS(p, end);
+            if (p == end || *p != ':') ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+            valStart = skipWS(p + 1, end);
+            if ((valEnd = skipValue(valStart, end)) == NULL) ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+
+            if (keyEnd - keyStart < JSONLAZY_KEYBUF_SIZE) {
+                key = keybuf;
+            } else {
+                CHKmalloc(key = malloc(keyEnd - keyStart + 1));
+            }
+            memcpy(key, keyStart, keyEnd - keyStart);
+            key[keyEnd - keyStart] = '\0';
+            if (isReferenced(pKeys, key)) {
+                struct json_object *const val = parseValue(tokener, valStart, valEnd - valStart, end - valStart);
+                if (val == NULL) ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+                json_object_object_add(json, key, val);
+            }
+            if (key != keybuf) free(key);
+            key = NULL;
+
+            p = skipWS(valEnd, end);
+            if (p == end) ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+            if (*p == '}') {
+                ++p;
+                break;
+            }
+            if (*p != ',') ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+            p = skipWS(p + 1, end);
+        }
+    }
+    if (skipWS(p, end) != end) ABORT_FINALIZE(RS_RET_JSON_PARSE_ERR);
+    *ppJson = json;
+    json = NULL;
+
+finalize_it:
+    if (key != keybuf) free(key);
+    if (json != NULL) json_object_put(json);
+    RETiRet;
+}
+
+
+void jsonlazyKeysDestruct(jsonlazy_keys_t **const ppKeys) {
+    jsonlazy_keys_t *const pKeys = *ppKeys;
+    jsonlazy_keys_t **pp;
+
+    if (pKeys == NULL) return;
+    /* may still be pending if config load was aborted */
+    for (pp = &pendingRoot; *pp != NULL; pp = &(*pp)->nextPending) {
+        if (*pp == pKeys) {
+            *pp = pKeys->nextPending;
+            break;
+        }
+    }
+    for (int i = 0; i < pKeys->nKeys; ++i) free(pKeys->keys[i]);
+    free(pKeys->keys);
+    free(pKeys->container);
+    free(pKeys);
+    *ppKeys = NULL;
+}
@@ -0,0 +1,81 @@
+/* jsonlazy.h - selective ("lazy") JSON parsing
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file jsonlazy.h
+ * @brief Parse only those members of a JSON object the config references.
+ *
+ * A consumer that stores parsed JSON into a message variable container
+ * (e.g. parse_json() into "$!") registers the container while the config is
+ * loaded. Once loading is complete, jsonlazyResolveAll() collects all
+ * variable references of the config (RainerScript and templates) and keeps
+ * the names of the container's top-level members that are actually used.
+ *
+ * jsonlazyParse() then scans the raw JSON object once, only checking its
+ * structure, and builds json-c objects just for the referenced members. If
+ * the config references the container as a whole (e.g. "$!" in a template,
+ * or "$!all-json"), a full parse is done instead.
+ */
+#ifndef INCLUDED_JSONLAZY_H
+#define INCLUDED_JSONLAZY_H
+
+#include <json.h>
+
+/** Referenced top-level member names for one container. */
+struct jsonlazy_keys_s {
+    uchar *container; /**< container name without '$', e.g. "!" or "!sub" */
+    int bResolved; /**< set by jsonlazyResolveAll() */
+    int bFull; /**< container is used as a whole: do full parse */
+    int nKeys;
+    int maxKeys;
+    char **keys; /**< sorted after resolution */
+    jsonlazy_keys_t *nextPending; /**< list of keys awaiting resolution */
+};
+
+/**
+ * Create a key set for @p container and queue it for resolution at the end
+ * of config load. The caller owns the returned object.
+ */
+rsRetVal jsonlazyRegister(const uchar *container, jsonlazy_keys_t **ppKeys);
+
+/** Resolve all pending key sets against the now complete config. */
+rsRetVal jsonlazyResolveAll(rsconf_t *conf);
+
+/**
+ * Account a variable reference found in the config. Called by the config
+ * walkers of RainerScript and templates while resolving.
+ */
+void jsonlazyAddRef(jsonlazy_keys_t *pKeys, propid_t id, const uchar *name);
+
+/**
+ * Parse @p len bytes of @p text, which must contain exactly one JSON value.
+ * If it is an object and @p pKeys permits, only referenced members are
+ * materialized. @p tokener is the caller's (per-worker) tokener; it is reset
+ * before each use. Returns RS_RET_JSON_PARSE_ERR for invalid input.
+ */
+rsRetVal jsonlazyParse(const jsonlazy_keys_t *pKeys,
+                       struct json_tokener *tokener,
+                       const char *text,
+                       size_t len,
+                       struct json_object **ppJson);
+
+void jsonlazyKeysDestruct(jsonlazy_keys_t **ppKeys);
+
+#endif /* #ifndef INCLUDED_JSONLAZY_H */
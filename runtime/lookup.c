@@ -40,6 +40,11 @@
 #include "unicode-helper.h"
 #include "regexp.h"
 
+/* regex tables with at least this many entries use the literal prefilter */
+#define LOOKUP_REGEX_PREFILTER_MIN 4
+/* candidate bitmap size (in 64 bit words) that lives on the stack */
+#define LOOKUP_REGEX_CAND_STACK_WORDS 64
+
 PRAGMA_IGNORE_Wdeprecated_declarations
     /* definitions for objects we access */
     DEFobjStaticHelpers;
@@ -221,6 +226,7 @@ static void destructTable_regex(lookup_t *pThis) {
         }
     }
     free(entries);
+    rxprefilterDestruct(&pThis->table.regex->prefilter);
     free(pThis->table.regex);
 }
 #endif
@@ -408,13 +414,44 @@ static es_str_t *lookupKey_sprsArr(lookup_t *pThis, lookup_key_t key) {
 }
 
 #ifdef FEATURE_REGEXP
+/* Only regexes the prefilter selected as candidates are executed. They are
+ * tried in table order, so the first matching entry wins as before.
+ */
+static const char *lookupKey_regex_prefiltered(lookup_t *pThis, lookup_key_t key) {
+    const lookup_regex_tab_t *const tab = pThis->table.regex;
+    uint64_t candBuf[LOOKUP_REGEX_CAND_STACK_WORDS];
+    uint64_t *cand = candBuf;
+    const char *r = NULL;
+
+    const uint32_t nWords = rxprefilterNWords(tab->prefilter);
+    if (nWords > sizeof(candBuf) / sizeof(candBuf[0])) {
+        if ((cand = malloc(nWords * sizeof(uint64_t))) == NULL) return NULL;
+    }
+    rxprefilterScan(tab->prefilter, key.k_str, cand);
+    for (uint32_t w = 0; w < nWords && r == NULL; ++w) {
+        for (uint64_t bits = cand[w]; bits != 0; bits &= bits - 1) {
+            const uint32_t i = w * RXPREFILTER_WORDBITS + (uint32_t)__builtin_ctzll(bits);
+            if (regexp.regexec(&tab->entries[i].regex, (char *)key.k_str, 0, NULL, 0) == 0) {
+                r = (const char *)tab->entries[i].interned_val_ref;
+                break;
+            }
+        }
+    }
+    if (cand != candBuf) free(cand);
+    return (r == NULL) ? defaultVal(pThis) : r;
+}
+
 static es_str_t *lookupKey_regex(lookup_t *pThis, lookup_key_t key) {
-    const char *r = defaultVal(pThis);
+    const char *r = NULL;
 
-    for (uint32_t i = 0; i < pThis->nmemb; ++i) {
-        if (regexp.regexec(&pThis->table.regex->entries[i].regex, (char *)key.k_str, 0, NULL, 0) == 0) {
-            r = (const char *)pThis->table.regex->entries[i].interned_val_ref;
-            break;
+    if (pThis->table.regex->prefilter != NULL) r = lookupKey_regex_prefiltered(pThis, key);
+    if (r == NULL) { /* no prefilter or out of memory */
+        r = defaultVal(pThis);
+        for (uint32_t i = 0; i < pThis->nmemb; ++i) {
+            if (regexp.regexec(&pThis->table.regex->entries[i].regex, (char *)key.k_str, 0, NULL, 0) == 0) {
+                r = (const char *)pThis->table.regex->entries[i].interned_val_ref;
+                break;
+            }
         }
     }
     return es_newStrFromCStr(r, strlen(r));
@@ -650,6 +687,17 @@ static rsRetVal build_RegexTable(lookup_t *pThis, struct json_object *jtab, cons
         }
     }
 
+    if (pThis->nmemb >= LOOKUP_REGEX_PREFILTER_MIN) {
+        CHKiRet(rxprefilterConstruct(&pThis->table.regex->prefilter, pThis->nmemb));
+        for (i = 0; i < pThis->nmemb; i++) {
+            CHKiRet(rxprefilterAdd(pThis->table.regex->prefilter, i,
+                                   (const char *)pThis->table.regex->entries[i].regex_str));
+        }
+        CHKiRet(rxprefilterFinalize(pThis->table.regex->prefilter));
+        DBGPRINTF("lookup table '%s': %u of %u regexes are covered by the literal prefilter\n", name,
+                  pThis->nmemb - rxprefilterNAlways(pThis->table.regex->prefilter), pThis->nmemb);
+    }
+
     pThis->lookup = lookupKey_regex;
     pThis->key_type = LOOKUP_KEY_TYPE_STRING;
 
@@ -22,6 +22,7 @@
 #define INCLUDED_LOOKUP_H
 #include <libestr.h>
 #include <regex.h>
+#include "rxprefilter.h"
 
 #define STRING_LOOKUP_TABLE 1
 #define ARRAY_LOOKUP_TABLE 2
@@ -70,6 +71,7 @@ struct lookup_regex_tab_entry_s {
 
 struct lookup_regex_tab_s {
     lookup_regex_tab_entry_t *entries;
+    rxprefilter_t *prefilter; /* NULL if table too small to benefit */
 };
 
 struct lookup_ref_s {
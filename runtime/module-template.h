@@ -245,6 +245,53 @@
     RETiRet;                 \
     }
 
+/* submitTransaction()
+ * Optional asynchronous variant of commitTransaction(). The module starts
+ * processing the batch and returns without waiting for its outcome.
+ * RS_RET_OK means the batch was accepted; any other return code means it
+ * was not, in which case the core processes it via commitTransaction().
+ * pParams stays valid until the transaction's completion was reported by
+ * pollTransactions(). txCookie is opaque and must be handed back there.
+ * When the transaction completed, the module calls the host entry point
+ * "actionAsyncTxNotify" with txCookie (from any thread), so that the core
+ * knows it is time to poll. endTransaction() is not called for submitted
+ * transactions.
+ * Modules that provide this entry point must also provide
+ * pollTransactions() and commitTransaction().
+ */
+#define BEGINsubmitTransaction                                                                     \
+    static rsRetVal submitTransaction(wrkrInstanceData_t __attribute__((unused)) *const pWrkrData, \
+                                      actWrkrIParams_t *const pParams, const unsigned nParams,     \
+                                      void *const txCookie) {                                      \
+        DEFiRet;
+
+#define CODESTARTsubmitTransaction /* currently empty, but may be extended */
+
+#define ENDsubmitTransaction \
+    RETiRet;                 \
+    }
+
+/* pollTransactions()
+ * Report completed asynchronous transactions. Waits up to timeoutMs
+ * milliseconds (0: do not wait) until at least one submitted transaction
+ * completes, then stores up to maxCompl completion records in pCompl and
+ * their number in *pnCompl. Each submitted transaction must be reported
+ * exactly once. A non-OK return tells the core that the outcome of all
+ * outstanding transactions is unknown; the module must forget them and
+ * the core re-processes them via commitTransaction().
+ */
+#define BEGINpollTransactions                                                                     \
+    static rsRetVal pollTransactions(wrkrInstanceData_t __attribute__((unused)) *const pWrkrData, \
+                                     const int timeoutMs, omTxCompletion_t *const pCompl,         \
+                                     const unsigned maxCompl, unsigned *const pnCompl) {          \
+        DEFiRet;
+
+#define CODESTARTpollTransactions *pnCompl = 0;
+
+#define ENDpollTransactions \
+    RETiRet;                \
+    }
+
 /* endTransaction()
  * introduced in v4.3.3 -- rgerhards, 2009-04-27
  */
@@ -594,6 +641,17 @@
         *pEtryPoint = endTransaction;                \
     }
 
+/**
+ * \brief For output modules with asynchronous transaction support.
+ */
+#define CODEqueryEtryPt_ASYNCTX_OMOD_QUERIES          \
+    if (!strcmp((char *)name, "submitTransaction")) { \
+        *pEtryPoint = submitTransaction;              \
+    }                                                 \
+    if (!strcmp((char *)name, "pollTransactions")) {  \
+        *pEtryPoint = pollTransactions;               \
+    }
+
 /**
  * \brief Optional support for feature compatibility query.
  */
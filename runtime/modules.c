@@ -54,6 +54,7 @@
 #include "cfsysline.h"
 #include "rsconf.h"
 #include "modules.h"
+#include "action.h"
 #include "errmsg.h"
 #include "parser.h"
 #include "strgen.h"
@@ -276,6 +277,8 @@ static rsRetVal queryHostEtryPt(uchar *name, rsRetVal (**pEtryPoint)()) {
         *pEtryPoint = OMSRgetSupportedTplOpts;
     } else if (!strcmp((char *)name, "queryCoreFeatureSupport")) {
         *pEtryPoint = queryCoreFeatureSupport;
+    } else if (!strcmp((char *)name, "actionAsyncTxNotify")) {
+        *pEtryPoint = actionAsyncTxNotify;
     } else {
         *pEtryPoint = NULL; /* to  be on the safe side */
         ABORT_FINALIZE(RS_RET_ENTRY_POINT_NOT_FOUND);
@@ -675,6 +678,31 @@ static rsRetVal doModInit(pModInit_t modInit, uchar *name, void *pModHdlr, modIn
             }
 
 
+            localRet = (*pNew->modQueryEtryPt)((uchar *)"submitTransaction", &pNew->mod.om.submitTransaction);
+            if (localRet == RS_RET_MODULE_ENTRY_POINT_NOT_FOUND) {
+                pNew->mod.om.submitTransaction = NULL;
+            } else if (localRet != RS_RET_OK) {
+                ABORT_FINALIZE(localRet);
+            }
+
+            localRet = (*pNew->modQueryEtryPt)((uchar *)"pollTransactions", &pNew->mod.om.pollTransactions);
+            if (localRet == RS_RET_MODULE_ENTRY_POINT_NOT_FOUND) {
+                pNew->mod.om.pollTransactions = NULL;
+            } else if (localRet != RS_RET_OK) {
+                ABORT_FINALIZE(localRet);
+            }
+
+            if ((pNew->mod.om.submitTransaction == NULL) != (pNew->mod.om.pollTransactions == NULL) ||
+                (pNew->mod.om.submitTransaction != NULL && pNew->mod.om.commitTransaction == NULL)) {
+                LogError(0, RS_RET_INVLD_OMOD,
+                         "module %s provides an incomplete asynchronous transaction "
+                         "interface (needs submitTransaction(), pollTransactions() and "
+                         "commitTransaction()) - using synchronous interface only",
+                         name);
+                pNew->mod.om.submitTransaction = NULL;
+                pNew->mod.om.pollTransactions = NULL;
+            }
+
             localRet = (*pNew->modQueryEtryPt)((uchar *)"endTransaction", &pNew->mod.om.endTransaction);
             if (localRet == RS_RET_MODULE_ENTRY_POINT_NOT_FOUND) {
                 pNew->mod.om.endTransaction = dummyEndTransaction;
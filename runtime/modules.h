@@ -90,6 +90,14 @@ struct dlhandle_s {
 /* should this module be kept linked? */
 typedef enum eModKeepType_ { eMOD_NOKEEP, eMOD_KEEP } eModKeepType_t;
 
+/* completion record of an asynchronous transaction, returned by an output
+ * module's pollTransactions() entry point.
+ */
+struct omTxCompletion_s {
+    void *txCookie; /* cookie that was passed to submitTransaction() */
+    rsRetVal result; /* outcome, same semantics as commitTransaction() return */
+};
+
 struct modInfo_s {
     struct modInfo_s *pPrev; /* support for creating a double linked module list */
     struct modInfo_s *pNext; /* support for creating a linked module list */
@@ -137,6 +145,9 @@ struct modInfo_s {
             rsRetVal (*commitTransaction)(void *const, actWrkrIParams_t *const, const unsigned);
             rsRetVal (*doAction)(void **params, void *pWrkrData);
             rsRetVal (*endTransaction)(void *);
+            /* optional asynchronous transaction interface, see module-template.h */
+            rsRetVal (*submitTransaction)(void *const, actWrkrIParams_t *const, const unsigned, void *const);
+            rsRetVal (*pollTransactions)(void *const, const int, omTxCompletion_t *const, const unsigned, unsigned *const);
             rsRetVal (*parseSelectorAct)(uchar **, void **, omodStringRequest_t **);
             rsRetVal (*newActInst)(uchar *modName, struct nvlst *lst, void **, omodStringRequest_t **);
             rsRetVal (*SetShutdownImmdtPtr)(void *pData, void *pPtr);
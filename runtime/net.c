@@ -1208,7 +1208,8 @@ static rsRetVal ATTR_NONNULL(1, 2) create_single_udp_socket(int *const s, /* soc
                                                             const int rcvbuf,
                                                             const int sndbuf,
                                                             const int ipfreebind,
-                                                            const char *const device) {
+                                                            const char *const device,
+                                                            const int bReusePort) {
     const int on = 1;
     int sockflags;
     int actrcvbuf;
@@ -1261,6 +1262,16 @@ static rsRetVal ATTR_NONNULL(1, 2) create_single_udp_socket(int *const s, /* soc
         ABORT_FINALIZE(RS_RET_ERR);
     }
 
+    if (bReusePort) {
+#if defined(SO_REUSEPORT)
+        if (setsockopt(*s, SOL_SOCKET, SO_REUSEPORT, (char *)&on, sizeof(on)) < 0)
+#endif
+        {
+            LogError(errno, RS_RET_ERR, "create UDP socket failed to set REUSEPORT");
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+    }
+
     /* We need to enable BSD compatibility. Otherwise an attacker
      * could flood our log files by sending us tons of ICMP errors.
      */
@@ -1402,6 +1413,9 @@ finalize_it:
  * are blocking.
  * param rcvbuf indicates desired rcvbuf size; 0 means OS default,
  * similar for sndbuf.
+ * If bReusePort is set, SO_REUSEPORT is set before binding, so that the
+ * same address can be bound by several sockets (the kernel then distributes
+ * the received datagrams across them).
  */
 static int *create_udp_socket(uchar *hostname,
                               uchar *pszPort,
@@ -1409,7 +1423,8 @@ static int *create_udp_socket(uchar *hostname,
                               const int rcvbuf,
                               const int sndbuf,
                               const int ipfreebind,
-                              char *device) {
+                              char *device,
+                              const int bReusePort) {
     struct addrinfo hints, *res, *r;
     int error, maxs, *s, *socks;
     rsRetVal localRet;
@@ -1450,7 +1465,8 @@ static int *create_udp_socket(uchar *hostname,
     *socks = 0; /* num of sockets counter at start of array */
     s = socks + 1;
     for (r = res; r != NULL; r = r->ai_next) {
-        localRet = create_single_udp_socket(s, r, hostname, bIsServer, rcvbuf, sndbuf, ipfreebind, device);
+        localRet =
+            create_single_udp_socket(s, r, hostname, bIsServer, rcvbuf, sndbuf, ipfreebind, device, bReusePort);
         if (localRet == RS_RET_OK) {
             (*socks)++;
             s++;
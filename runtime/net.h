@@ -152,7 +152,7 @@ BEGINinterface(net) /* name must also be changed in ENDinterface macro! */
     void (*clearAllowedSenders)(uchar *);
     void (*debugListenInfo)(int fd, char *type);
     int *(*create_udp_socket)(uchar *hostname, uchar *LogPort, int bIsServer, int rcvbuf, int sndbuf, int ipfreebind,
-                              char *device);
+                              char *device, int bReusePort);
     void (*closeUDPListenSockets)(int *finet);
     int (*isAllowedSender)(uchar *pszType, struct sockaddr *pFrom, const char *pszFromHost); /* deprecated! */
     rsRetVal (*getLocalHostname)(rsconf_t *const, uchar **);
@@ -228,8 +228,9 @@ BEGINinterface(net) /* name must also be changed in ENDinterface macro! */
      *          that fd and reset the value to -1.
      */
     rsRetVal (*netns_restore)(int *fd);
+    /* v12 create_udp_socket() got bReusePort (see net.c) -- 2026-10-18 */
 ENDinterface(net)
-#define netCURR_IF_VERSION 11 /* increment whenever you change the interface structure! */
+#define netCURR_IF_VERSION 12 /* increment whenever you change the interface structure! */
 
 /* prototypes */
 PROTOTYPEObj(net);
@@ -628,6 +628,14 @@ static rsRetVal ATTR_NONNULL(1, 3, 5) LstnInit(netstrms_t *const pNS,
             sock = -1;
             continue;
         }
+#ifdef SO_REUSEPORT
+        if (cnf_params->bReusePort && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char *)&on, sizeof(on)) < 0) {
+            LogError(errno, NO_ERRCODE, "error setting SO_REUSEPORT on tcp listen socket");
+            close(sock);
+            sock = -1;
+            continue;
+        }
+#endif
 
         /* We use non-blocking IO! */
         if ((sockflags = fcntl(sock, F_GETFL)) != -1) {
@@ -208,6 +208,8 @@
 #include "statsobj.h"
 #include "parserif.h"
 #include "rsconf.h"
+#include "cpuaffinity.h"
+#include "wrkpool.h"
 
 #ifdef OS_SOLARIS
     #include <sched.h>
@@ -278,7 +280,12 @@ static struct cnfparamdescr cnfpdescr[] = {{"queue.filename", eCmdHdlrGetWord, 0
                                            {"queue.dequeuetimeend", eCmdHdlrInt, 0},
                                            {"queue.cry.provider", eCmdHdlrGetWord, 0},
                                            {"queue.samplinginterval", eCmdHdlrInt, 0},
-                                           {"queue.takeflowctlfrommsg", eCmdHdlrBinary, 0}};
+                                           {"queue.takeflowctlfrommsg", eCmdHdlrBinary, 0},
+                                           {"queue.cpuset", eCmdHdlrString, 0},
+                                           {"queue.numanode", eCmdHdlrNonNegInt, 0},
+                                           {"queue.sharedworkerpool", eCmdHdlrBinary, 0},
+                                           {"queue.spintime", eCmdHdlrNonNegInt, 0},
+                                           {"queue.directio", eCmdHdlrBinary, 0}};
 static struct cnfparamblk pblk = {CNFPARAMBLK_VERSION, sizeof(cnfpdescr) / sizeof(struct cnfparamdescr), cnfpdescr};
 
 /* support to detect duplicate queue file names */
@@ -449,6 +456,8 @@ void qqueueDbgPrint(qqueue_t *pThis) {
     dbgoprint((obj_t *)pThis, "queue.maxfilesize: %lld\n", pThis->iMaxFileSize);
     dbgoprint((obj_t *)pThis, "queue.saveonshutdown: %d\n", pThis->bSaveOnShutdown);
     dbgoprint((obj_t *)pThis, "queue.dequeueslowdown: %d\n", pThis->iDeqSlowdown);
+    dbgoprint((obj_t *)pThis, "queue.spintime: %d\n", pThis->iSpinUsec);
+    dbgoprint((obj_t *)pThis, "queue.directio: %d\n", pThis->bDirectIO);
     dbgoprint((obj_t *)pThis, "queue.dequeuetimebegin: %d\n", pThis->iDeqtWinFromHr);
     dbgoprint((obj_t *)pThis, "queue.dequeuetimeend: %d\n", pThis->iDeqtWinToHr);
 }
@@ -472,6 +481,14 @@ static int getLogicalQueueSize(qqueue_t *pThis) {
 }
 
 
+/* check for work without holding the mutex. This is used by idle workers
+ * while they spin (see wtiSpinForWork()), so the result is only a hint.
+ */
+static int qqueueHasWork(qqueue_t *pThis) {
+    return (int)PREFER_FETCH_32BIT(pThis->iQueueSize) - (int)PREFER_FETCH_32BIT(pThis->nLogDeq) > 0;
+}
+
+
 /* This function drains the queue in cases where this needs to be done. The most probable
  * reason is a HUP which needs to discard data (because the queue is configured to be lossy).
  * During a shutdown, this is typically not needed, as the OS frees up ressources and does
@@ -582,6 +599,7 @@ static rsRetVal StartDA(qqueue_t *pThis) {
     CHKiRet(qqueueSetSpoolDir(pThis->pqDA, pThis->pszSpoolDir, pThis->lenSpoolDir));
     CHKiRet(qqueueSetiPersistUpdCnt(pThis->pqDA, pThis->iPersistUpdCnt));
     CHKiRet(qqueueSetbSyncQueueFiles(pThis->pqDA, pThis->bSyncQueueFiles));
+    CHKiRet(qqueueSetbDirectIO(pThis->pqDA, pThis->bDirectIO));
     CHKiRet(qqueueSettoActShutdown(pThis->pqDA, pThis->toActShutdown));
     CHKiRet(qqueueSettoEnq(pThis->pqDA, pThis->toEnq));
     CHKiRet(qqueueSetiDeqtWinFromHr(pThis->pqDA, pThis->iDeqtWinFromHr));
@@ -591,8 +609,10 @@ static rsRetVal StartDA(qqueue_t *pThis) {
     CHKiRet(qqueueSetiDiscardMrk(pThis->pqDA, 0));
     pThis->pqDA->iDeqBatchSize = pThis->iDeqBatchSize;
     pThis->pqDA->iMinDeqBatchSize = pThis->iMinDeqBatchSize;
+    pThis->pqDA->pfAdaptiveDeqBatchSize = pThis->pfAdaptiveDeqBatchSize;
     pThis->pqDA->iMinMsgsPerWrkr = pThis->iMinMsgsPerWrkr;
     pThis->pqDA->iLowWtrMrk = pThis->iLowWtrMrk;
+    pThis->pqDA->pAffinity = pThis->pAffinity; /* still owned by us */
     if (pThis->useCryprov) {
         /* hand over cryprov to DA queue - in-mem queue does no longer need it
          * and DA queue will be kept active from now on until termination.
@@ -668,6 +688,7 @@ static rsRetVal ATTR_NONNULL() InitDA(qqueue_t *const pThis, const int bLockMute
     CHKiRet(wtpSetiNumWorkerThreads(pThis->pWtpDA, 1));
     CHKiRet(wtpSettoWrkShutdown(pThis->pWtpDA, pThis->toWrkShutdown));
     CHKiRet(wtpSetpUsr(pThis->pWtpDA, pThis));
+    CHKiRet(wtpSetpAffinity(pThis->pWtpDA, pThis->pAffinity));
     CHKiRet(wtpConstructFinalize(pThis->pWtpDA));
     /* if we reach this point, we have a "good" DA worker pool */
 
@@ -1069,6 +1090,7 @@ static rsRetVal qConstructDisk(qqueue_t *pThis) {
     CHKiRet(strm.SetiMaxFileSize(pThis->tVars.disk.pWrite, pThis->iMaxFileSize));
     CHKiRet(strm.SetiMaxFileSize(pThis->tVars.disk.pReadDeq, pThis->iMaxFileSize));
     CHKiRet(strm.SetiMaxFileSize(pThis->tVars.disk.pReadDel, pThis->iMaxFileSize));
+    CHKiRet(strm.SetbDirectIO(pThis->tVars.disk.pWrite, pThis->bDirectIO));
 
 finalize_it:
     RETiRet;
@@ -1584,6 +1606,7 @@ rsRetVal qqueueConstruct(qqueue_t **ppThis,
     pThis->iDeqBatchSize = 8; /* conservative default, should still provide good performance */
     pThis->iMinDeqBatchSize = 0; /* conservative default, should still provide good performance */
     pThis->isRunning = 0;
+    pThis->iNumaNode = CPUAFFINITY_NO_NODE;
 
     pThis->pszFilePrefix = NULL;
     pThis->qType = qType;
@@ -1630,6 +1653,7 @@ void qqueueSetDefaultsActionQueue(qqueue_t *pThis) {
     pThis->iDeqtWinFromHr = 0;
     pThis->iDeqtWinToHr = 25; /* disable time-windowed dequeuing by default */
     pThis->iSmpInterval = 0; /* disable sampling */
+    pThis->bSharedWrkPool = 1; /* use the shared worker pool, if configured */
 }
 
 
@@ -1661,6 +1685,11 @@ void qqueueSetDefaultsRulesetQueue(qqueue_t *pThis) {
     pThis->iDeqtWinFromHr = 0;
     pThis->iDeqtWinToHr = 25; /* disable time-windowed dequeuing by default */
     pThis->iSmpInterval = 0; /* disable sampling */
+    /* Our workers enqueue into action queues and block while one is full. On
+     * the pool, they would keep pool threads the draining action workers
+     * need, so by default they keep dedicated threads.
+     */
+    pThis->bSharedWrkPool = 0;
 }
 
 
@@ -1906,13 +1935,18 @@ static rsRetVal ATTR_NONNULL() DequeueConsumableElements(qqueue_t *const pThis,
         pThis->tVars.disk.deqFileNumIn = strmGetCurrFileNum(pThis->tVars.disk.pReadDeq);
     }
 
+    int iDeqBatchSize = pThis->iDeqBatchSize;
+    if (pThis->pfAdaptiveDeqBatchSize != NULL) {
+        const int iAdaptive = pThis->pfAdaptiveDeqBatchSize(pThis->pAction);
+        if (iAdaptive < iDeqBatchSize) iDeqBatchSize = iAdaptive;
+    }
     /* work-around clang static analyzer false positive, we need a const value */
-    const int iMinDeqBatchSize = pThis->iMinDeqBatchSize;
+    const int iMinDeqBatchSize = (pThis->pfAdaptiveDeqBatchSize == NULL) ? pThis->iMinDeqBatchSize : iDeqBatchSize;
     if (iMinDeqBatchSize > 0) {
         timeoutComp(&timeout, pThis->toMinDeqBatchSize); /* get absolute timeout */
     }
 
-    while ((iQueueSize = getLogicalQueueSize(pThis)) > 0 && nDequeued < pThis->iDeqBatchSize) {
+    while ((iQueueSize = getLogicalQueueSize(pThis)) > 0 && nDequeued < iDeqBatchSize) {
         int rd_fd = -1;
         int64_t rd_offs = 0;
         int wr_fd = -1;
@@ -1977,7 +2011,7 @@ static rsRetVal ATTR_NONNULL() DequeueConsumableElements(qqueue_t *const pThis,
             }
         }
         if (keep_running) {
-            keep_running = (getLogicalQueueSize(pThis) > 0) && (nDequeued < pThis->iDeqBatchSize);
+            keep_running = (getLogicalQueueSize(pThis) > 0) && (nDequeued < iDeqBatchSize);
         }
     }
 
@@ -2219,17 +2253,24 @@ static rsRetVal ConsumerReg(qqueue_t *pThis, wti_t *pWti) {
     ISOBJ_TYPE_assert(pThis, qqueue);
     ISOBJ_TYPE_assert(pWti, wti);
 
-    iRet = DequeueForConsumer(pThis, pWti, &skippedMsgs);
-    if (iRet == RS_RET_FILE_NOT_FOUND) {
-        /* This is a fatal condition and means the queue is almost unusable */
-        d_pthread_mutex_unlock(pThis->mut);
-        DBGOPRINT((obj_t *)pThis, "got 'file not found' error %d, queue defunct\n", iRet);
-        iRet = queueSwitchToEmergencyMode(pThis, iRet);
-        // TODO: think about what to return as iRet -- keep RS_RET_FILE_NOT_FOUND?
-        d_pthread_mutex_lock(pThis->mut);
-    }
-    if (iRet != RS_RET_OK) {
-        FINALIZE;
+    if (pWti->bRetryResume) {
+        /* the worker was parked while its action waited for a retry, so
+         * it continues the batch it kept (see wtiRetryPark())
+         */
+        pWti->bRetryResume = 0;
+    } else {
+        iRet = DequeueForConsumer(pThis, pWti, &skippedMsgs);
+        if (iRet == RS_RET_FILE_NOT_FOUND) {
+            /* This is a fatal condition and means the queue is almost unusable */
+            d_pthread_mutex_unlock(pThis->mut);
+            DBGOPRINT((obj_t *)pThis, "got 'file not found' error %d, queue defunct\n", iRet);
+            iRet = queueSwitchToEmergencyMode(pThis, iRet);
+            // TODO: think about what to return as iRet -- keep RS_RET_FILE_NOT_FOUND?
+            d_pthread_mutex_lock(pThis->mut);
+        }
+        if (iRet != RS_RET_OK) {
+            FINALIZE;
+        }
     }
 
     /* we now have a non-idle batch of work, so we can release the queue mutex and process it */
@@ -2250,7 +2291,13 @@ static rsRetVal ConsumerReg(qqueue_t *pThis, wti_t *pWti) {
 
 
     pWti->pbShutdownImmediate = &pThis->bShutdownImmediate;
-    CHKiRet(pThis->pConsumer(pThis->pAction, &pWti->batch, pWti));
+    iRet = pThis->pConsumer(pThis->pAction, &pWti->batch, pWti);
+    if (iRet == RS_RET_RETRY_PARKED) {
+        /* keep the batch, the worker continues it once the retry is due */
+        pthread_setcancelstate(iCancelStateSave, NULL);
+        FINALIZE;
+    }
+    CHKiRet(iRet);
 
     /* we now need to check if we should deliberately delay processing a bit
      * and, if so, do that. -- rgerhards, 2008-01-30
@@ -2554,6 +2601,17 @@ rsRetVal qqueueStart(rsconf_t *cnf, qqueue_t *pThis) /* this is the Construction
     CHKiRet(wtpSetiNumWorkerThreads(pThis->pWtpReg, pThis->iNumWorkerThreads));
     CHKiRet(wtpSettoWrkShutdown(pThis->pWtpReg, pThis->toWrkShutdown));
     CHKiRet(wtpSetpUsr(pThis->pWtpReg, pThis));
+    CHKiRet(wtpSetpAffinity(pThis->pWtpReg, pThis->pAffinity));
+    CHKiRet(wtpSetiSpinUsec(pThis->pWtpReg, pThis->iSpinUsec));
+    CHKiRet(wtpSetpfHasWork(pThis->pWtpReg, (int (*)(void *pUsr))qqueueHasWork));
+    /* Workers that sleep on their own (slowdown, time window, minimum or adaptive
+     * batch) or are pinned keep dedicated threads. So does the DA worker.
+     */
+    if (pThis->bSharedWrkPool && wrkpoolEnabled(cnf) && pThis->iDeqSlowdown == 0 && pThis->iDeqtWinToHr == 25 &&
+        pThis->iMinDeqBatchSize == 0 && pThis->pfAdaptiveDeqBatchSize == NULL && pThis->pAffinity == NULL) {
+        DBGOPRINT((obj_t *)pThis, "workers run on the shared worker pool\n");
+        CHKiRet(wtpSetbPooled(pThis->pWtpReg, 1));
+    }
     CHKiRet(wtpConstructFinalize(pThis->pWtpReg));
 
     /* Validate queue configuration before starting */
@@ -2877,6 +2935,8 @@ BEGINobjDestruct(qqueue) /* be sure to specify the object type also in END and C
 
     free(pThis->pszFilePrefix);
     free(pThis->pszSpoolDir);
+    free(pThis->pszCpuset);
+    if (pThis->pqParent == NULL) cpuaffinityDestruct(&pThis->pAffinity);
     if (pThis->useCryprov) {
         pThis->cryprov.Destruct(&pThis->cryprovData);
         obj.ReleaseObj(__FILE__, pThis->cryprovNameFull + 2, pThis->cryprovNameFull, (void *)&pThis->cryprov);
@@ -3517,6 +3577,17 @@ rsRetVal qqueueApplyCnfParam(qqueue_t *pThis, struct nvlst *lst) {
             pThis->iSmpInterval = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "queue.takeflowctlfrommsg")) {
             pThis->takeFlowCtlFromMsg = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.cpuset")) {
+            free(pThis->pszCpuset);
+            pThis->pszCpuset = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(pblk.descr[i].name, "queue.numanode")) {
+            pThis->iNumaNode = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.sharedworkerpool")) {
+            pThis->bSharedWrkPool = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.spintime")) {
+            pThis->iSpinUsec = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.directio")) {
+            pThis->bDirectIO = pvals[i].val.d.n;
         } else {
             DBGPRINTF(
                 "queue: program error, non-handled "
@@ -3558,6 +3629,15 @@ rsRetVal qqueueApplyCnfParam(qqueue_t *pThis, struct nvlst *lst) {
         initCryprov(pThis, lst);
     }
 
+    if (pThis->qType != QUEUETYPE_DIRECT && (pThis->pszCpuset != NULL || pThis->iNumaNode != CPUAFFINITY_NO_NODE)) {
+        cpuaffinityDestruct(&pThis->pAffinity);
+        if (cpuaffinityConstruct(&pThis->pAffinity, (char *)pThis->pszCpuset, pThis->iNumaNode,
+                                 (char *)obj.GetName((obj_t *)pThis)) != RS_RET_OK) {
+            LogError(0, RS_RET_CONF_PARAM_INVLD, "queue '%s': worker threads will not be pinned",
+                     obj.GetName((obj_t *)pThis));
+        }
+    }
+
     cnfparamvalsDestruct(pvals, &pblk);
 finalize_it:
     RETiRet;
@@ -3574,7 +3654,8 @@ int queuesEqual(qqueue_t *pOld, qqueue_t *pNew) {
             NUM_EQUALS(iMinMsgsPerWrkr) && NUM_EQUALS(iMaxFileSize) && NUM_EQUALS(bSaveOnShutdown) &&
             NUM_EQUALS(iDeqSlowdown) && NUM_EQUALS(iDeqtWinFromHr) && NUM_EQUALS(iDeqtWinToHr) &&
             NUM_EQUALS(iSmpInterval) && NUM_EQUALS(takeFlowCtlFromMsg) && USTR_EQUALS(pszFilePrefix) &&
-            USTR_EQUALS(cryprovName));
+            USTR_EQUALS(cryprovName) && USTR_EQUALS(pszCpuset) && NUM_EQUALS(iNumaNode) &&
+            NUM_EQUALS(bSharedWrkPool) && NUM_EQUALS(iSpinUsec) && NUM_EQUALS(bDirectIO));
 }
 
 
@@ -3586,6 +3667,7 @@ int queuesEqual(qqueue_t *pOld, qqueue_t *pNew) {
  * reformatted by clang-format;
  */
 DEFpropSetMeth(qqueue, bSyncQueueFiles, int);
+DEFpropSetMeth(qqueue, bDirectIO, int);
 DEFpropSetMeth(qqueue, iPersistUpdCnt, int);
 DEFpropSetMeth(qqueue, iDeqtWinFromHr, int);
 DEFpropSetMeth(qqueue, iDeqtWinToHr, int);
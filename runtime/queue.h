@@ -118,6 +118,9 @@ struct queue_s {
         int iDeqBatchSize; /* max number of elements that shall be dequeued at once */
         int iMinDeqBatchSize; /* min number of elements that shall be dequeued at once */
         int toMinDeqBatchSize; /* timeout for MinDeqBatchSize, in ms */
+        /* if set, returns the action's adaptive commit size (action.batch.targetLatency), which
+         * then is both the dequeue and the minimum batch size (capped by iDeqBatchSize) */
+        int (*pfAdaptiveDeqBatchSize)(action_t *pAction);
         /* rate limiting settings (will be expanded) */
         int iDeqSlowdown; /* slow down dequeue by specified nbr of microseconds */
         /* end rate limiting */
@@ -213,6 +216,12 @@ struct queue_s {
         STATSCOUNTER_DEF(ctrNFDscrd, mutCtrNFDscrd)
         int ctrMaxqsize; /* NOT guarded by a mutex */
         int iSmpInterval; /* line interval of sampling logs */
+        uchar *pszCpuset; /* CPUs to run workers on, NULL if not set */
+        int iNumaNode; /* NUMA node to run workers on, CPUAFFINITY_NO_NODE if not set */
+        cpuaffinity_t *pAffinity; /* placement built from the above, NULL if none */
+        sbool bSharedWrkPool; /* may the workers run on the shared worker pool? */
+        int iSpinUsec; /* max time idle workers spin before they wait, in us (0 = off) */
+        sbool bDirectIO; /* write queue files with direct I/O (O_DIRECT)? */
         int isRunning;
 };
 
@@ -248,6 +257,7 @@ void qqueueCorrectParams(qqueue_t *pThis);
 PROTOTYPEObjClassInit(qqueue);
 PROTOTYPEpropSetMeth(qqueue, iPersistUpdCnt, int);
 PROTOTYPEpropSetMeth(qqueue, bSyncQueueFiles, int);
+PROTOTYPEpropSetMeth(qqueue, bDirectIO, int);
 PROTOTYPEpropSetMeth(qqueue, iDeqtWinFromHr, int);
 PROTOTYPEpropSetMeth(qqueue, iDeqtWinToHr, int);
 PROTOTYPEpropSetMeth(qqueue, toQShutdown, long);
@@ -36,6 +36,11 @@
 #include "errmsg.h"
 #include "hashtable.h"
 #include "hashtable_itr.h"
+#include "rsconf.h"
+#ifdef HAVE_PCRE2
+    #define PCRE2_CODE_UNIT_WIDTH 8
+    #include <pcre2.h>
+#endif
 
 MODULE_TYPE_LIB
 MODULE_TYPE_NOKEEP;
@@ -281,6 +286,282 @@ static size_t _regerror(int errcode, const regex_t *preg, char *errbuf, size_t e
     return ret;
 }
 
+#ifdef HAVE_PCRE2
+/* PCRE2 engine
+ *
+ * If the config selects regex.engine="pcre2", extended regular expressions
+ * are compiled with PCRE2 and, where the platform supports it, JIT-compiled.
+ * The compiled code is referenced from the caller-provided regex_t itself (see
+ * pcre2_preg_t), so the regexp interface stays the same for all users and
+ * regexec() finds it without any lock or lookup. Compiled PCRE2 code is
+ * read-only while matching and is shared by all threads; match data and JIT
+ * stack must not be shared and are kept per thread, so no allocation is done
+ * per match. As with POSIX regex_t, regfree() must not be called while the
+ * same regex is still in use by regexec().
+ * Basic (non-extended) regular expressions always use the POSIX engine, as
+ * their syntax is not compatible with PCRE2.
+ */
+    #define PCRE2_DFLT_OVECTOR 50 /* pairs, same limit re_extract() uses */
+    #define PCRE2_JIT_STACK_MIN (32 * 1024)
+    #define PCRE2_JIT_STACK_MAX (512 * 1024)
+
+typedef struct pcre2_regex pcre2_regex_t;
+struct pcre2_regex {
+    pcre2_code *code;
+    int cflags;
+    pcre2_regex_t *pNext; /* registry of live objects, protected by mutPcre2Live */
+    pcre2_regex_t *pPrev;
+};
+
+/* What pcre2_regcomp() stores in the caller's regex_t. regexec() must tell it
+ * apart from a POSIX-compiled regex_t, whose contents are opaque to us. So
+ * besides a magic, a check value derived from rx is stored; a POSIX regex_t
+ * matching both by chance is practically impossible. The tag does not depend
+ * on the address of the regex_t, so the regex_t may be copied or moved.
+ * regfree() additionally looks rx up in the registry of live objects before
+ * it frees anything; regexec() does not, so that matching needs no lock.
+ */
+typedef struct pcre2_preg {
+    uint64_t magic;
+    pcre2_regex_t *rx;
+    uint64_t check;
+} pcre2_preg_t;
+    #define PCRE2_PREG_MAGIC 0x72737973504352ULL /* "rsysPCR" */
+/* pcre2_preg_t must fit into every libc's regex_t */
+typedef char pcre2_preg_fits_regex_t[(sizeof(pcre2_preg_t) <= sizeof(regex_t)) ? 1 : -1];
+
+typedef struct pcre2_thrd_data {
+    pcre2_match_data *md;
+    uint32_t ovecsize; /* number of pairs md can hold */
+    pcre2_match_context *mctx;
+    pcre2_jit_stack *jitStack;
+} pcre2_thrd_data_t;
+
+static pthread_key_t key_pcre2_thrd;
+static pcre2_regex_t *pcre2Live = NULL;
+static pthread_mutex_t mutPcre2Live = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t pcre2_preg_check(const pcre2_regex_t *const rx) {
+    return PCRE2_PREG_MAGIC ^ ((uint64_t)(uintptr_t)rx * 0x9e3779b97f4a7c15ULL);
+}
+
+
+static void pcre2_regex_destruct(void *const v) {
+    pcre2_regex_t *const rx = (pcre2_regex_t *)v;
+    if (rx == NULL) return;
+    pcre2_code_free(rx->code);
+    free(rx);
+}
+
+static void pcre2_thrd_data_destruct(void *const v) {
+    pcre2_thrd_data_t *const td = (pcre2_thrd_data_t *)v;
+    if (td == NULL) return;
+    pcre2_match_data_free(td->md);
+    pcre2_match_context_free(td->mctx);
+    pcre2_jit_stack_free(td->jitStack);
+    free(td);
+}
+
+/* get the calling thread's match data, able to hold at least nPairs
+ * ovector pairs. Returns NULL on out of memory.
+ */
+static pcre2_thrd_data_t *get_pcre2_thrd_data(const uint32_t nPairs) {
+    pcre2_thrd_data_t *td = pthread_getspecific(key_pcre2_thrd);
+
+    if (td == NULL) {
+        if ((td = calloc(1, sizeof(*td))) == NULL) return NULL;
+        td->mctx = pcre2_match_context_create(NULL);
+        td->jitStack = pcre2_jit_stack_create(PCRE2_JIT_STACK_MIN, PCRE2_JIT_STACK_MAX, NULL);
+        if (td->mctx == NULL) {
+            pcre2_thrd_data_destruct(td);
+            return NULL;
+        }
+        if (td->jitStack != NULL) pcre2_jit_stack_assign(td->mctx, NULL, td->jitStack);
+        pthread_setspecific(key_pcre2_thrd, td);
+    }
+    if (td->md == NULL || td->ovecsize < nPairs) {
+        const uint32_t newSize = (nPairs > PCRE2_DFLT_OVECTOR) ? nPairs : PCRE2_DFLT_OVECTOR;
+        pcre2_match_data *const md = pcre2_match_data_create(newSize, NULL);
+        if (md == NULL) return NULL;
+        pcre2_match_data_free(td->md);
+        td->md = md;
+        td->ovecsize = newSize;
+    }
+    return td;
+}
+
+/* returns the pcre2 regex for preg or NULL, if preg was compiled by POSIX */
+static pcre2_regex_t *find_pcre2_regex(const regex_t *const preg) {
+    pcre2_preg_t pp;
+
+    memcpy(&pp, preg, sizeof(pp));
+    if (pp.magic != PCRE2_PREG_MAGIC || pp.check != pcre2_preg_check(pp.rx)) return NULL;
+    return pp.rx;
+}
+
+static void pcre2_live_add(pcre2_regex_t *const rx) {
+    pthread_mutex_lock(&mutPcre2Live);
+    rx->pPrev = NULL;
+    rx->pNext = pcre2Live;
+    if (pcre2Live != NULL) pcre2Live->pPrev = rx;
+    pcre2Live = rx;
+    pthread_mutex_unlock(&mutPcre2Live);
+}
+
+/* unlink rx from the registry. Returns 0 if it is not a live object. */
+static int pcre2_live_remove(pcre2_regex_t *const rx) {
+    pcre2_regex_t *p;
+
+    pthread_mutex_lock(&mutPcre2Live);
+    for (p = pcre2Live; p != NULL && p != rx; p = p->pNext)
+        ;
+    if (p != NULL) {
+        if (rx->pPrev == NULL) {
+            pcre2Live = rx->pNext;
+        } else {
+            rx->pPrev->pNext = rx->pNext;
+        }
+        if (rx->pNext != NULL) rx->pNext->pPrev = rx->pPrev;
+    }
+    pthread_mutex_unlock(&mutPcre2Live);
+    return p != NULL;
+}
+
+/* returns 1 if preg was compiled by PCRE2 (and is now freed), 0 otherwise */
+static int pcre2_regfree(regex_t *const preg) {
+    pcre2_regex_t *const rx = find_pcre2_regex(preg);
+
+    if (rx == NULL) return 0;
+    memset(preg, 0, sizeof(*preg));
+    if (pcre2_live_remove(rx)) {
+        pcre2_regex_destruct(rx);
+    } else {
+        /* a copy of a regex_t that was already freed, it is not POSIX either */
+        DBGPRINTF("regexp: regfree() of a PCRE2 regex that is no longer live, ignored\n");
+    }
+    return 1;
+}
+
+static int pcre2_regcomp(regex_t *preg, const char *regex, int cflags) {
+    pcre2_regex_t *rx = NULL;
+    pcre2_preg_t pp;
+    uint32_t options = 0;
+    int errcode;
+    PCRE2_SIZE erroffs;
+
+    if (cflags & REG_ICASE) options |= PCRE2_CASELESS;
+    if (cflags & REG_NEWLINE) {
+        options |= PCRE2_MULTILINE;
+    } else {
+        /* POSIX: '.' matches newline, '$' only at end of string */
+        options |= PCRE2_DOTALL | PCRE2_DOLLAR_ENDONLY;
+    }
+    if (cflags & REG_NOSUB) options |= PCRE2_NO_AUTO_CAPTURE;
+
+    if ((rx = calloc(1, sizeof(*rx))) == NULL) return REG_ESPACE;
+    rx->cflags = cflags;
+    rx->code = pcre2_compile((PCRE2_SPTR)regex, PCRE2_ZERO_TERMINATED, options, &errcode, &erroffs, NULL);
+    if (rx->code == NULL) {
+        PCRE2_UCHAR errbuf[256];
+        pcre2_get_error_message(errcode, errbuf, sizeof(errbuf));
+        LogError(0, RS_RET_ERR, "regexp: PCRE2 cannot compile '%s' at offset %zu: %s", regex, (size_t)erroffs,
+                 (char *)errbuf);
+        free(rx);
+        return REG_BADPAT;
+    }
+    if ((errcode = pcre2_jit_compile(rx->code, PCRE2_JIT_COMPLETE)) != 0) {
+        DBGPRINTF("regexp: PCRE2 JIT not available for '%s' (%d), using interpreter\n", regex, errcode);
+    }
+
+    pcre2_live_add(rx);
+    memset(preg, 0, sizeof(*preg));
+    pp.magic = PCRE2_PREG_MAGIC;
+    pp.rx = rx;
+    pp.check = pcre2_preg_check(rx);
+    memcpy(preg, &pp, sizeof(pp));
+    return 0;
+}
+
+static int pcre2_regexec(const pcre2_regex_t *const rx,
+                         const char *string,
+                         size_t nmatch,
+                         regmatch_t pmatch[],
+                         int eflags) {
+    pcre2_thrd_data_t *td;
+    uint32_t options = 0;
+    size_t i;
+    int rc;
+
+    if (rx->cflags & REG_NOSUB) nmatch = 0;
+    if ((td = get_pcre2_thrd_data((uint32_t)nmatch)) == NULL) return REG_ESPACE;
+    if (eflags & REG_NOTBOL) options |= PCRE2_NOTBOL;
+    if (eflags & REG_NOTEOL) options |= PCRE2_NOTEOL;
+
+    rc = pcre2_match(rx->code, (PCRE2_SPTR)string, PCRE2_ZERO_TERMINATED, 0, options, td->md, td->mctx);
+    if (rc == PCRE2_ERROR_NOMATCH) return REG_NOMATCH;
+    if (rc < 0) {
+        DBGPRINTF("regexp: pcre2_match failed with %d\n", rc);
+        return REG_ESPACE;
+    }
+
+    if (nmatch > 0) {
+        const PCRE2_SIZE *const ovector = pcre2_get_ovector_pointer(td->md);
+        /* rc == 0 means ovector too small; all its pairs are set then */
+        const size_t nSet = (rc == 0) ? td->ovecsize : (size_t)rc;
+        for (i = 0; i < nmatch; ++i) {
+            if (i < nSet && ovector[2 * i] != PCRE2_UNSET) {
+                pmatch[i].rm_so = (regoff_t)ovector[2 * i];
+                pmatch[i].rm_eo = (regoff_t)ovector[2 * i + 1];
+            } else {
+                pmatch[i].rm_so = -1;
+                pmatch[i].rm_eo = -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int usePcre2(const int cflags) {
+    const rsconf_t *const cnf = (loadConf != NULL) ? loadConf : runConf;
+    return (cflags & REG_EXTENDED) && cnf != NULL && cnf->globals.regexEngine == REGEX_ENGINE_PCRE2;
+}
+
+/* The following functions dispatch to either the PCRE2 or the POSIX engine.
+ * They are only used if PCRE2 support is compiled in.
+ */
+static int rx_regcomp(regex_t *preg, const char *regex, int cflags) {
+    if (usePcre2(cflags)) {
+        return pcre2_regcomp(preg, regex, cflags);
+    }
+    return USE_PERTHREAD_REGEX ? _regcomp(preg, regex, cflags) : regcomp(preg, regex, cflags);
+}
+
+static int rx_regexec(const regex_t *preg, const char *string, size_t nmatch, regmatch_t pmatch[], int eflags) {
+    const pcre2_regex_t *const rx = find_pcre2_regex(preg);
+    if (rx != NULL) return pcre2_regexec(rx, string, nmatch, pmatch, eflags);
+    return USE_PERTHREAD_REGEX ? _regexec(preg, string, nmatch, pmatch, eflags)
+                               : regexec(preg, string, nmatch, pmatch, eflags);
+}
+
+static size_t rx_regerror(int errcode, const regex_t *preg, char *errbuf, size_t errbuf_size) {
+    /* PCRE2 compile errors are reported in detail by pcre2_regcomp(); the
+     * POSIX error text for the returned REG_* code is good enough here.
+     */
+    if (find_pcre2_regex(preg) != NULL) return regerror(errcode, preg, errbuf, errbuf_size);
+    return USE_PERTHREAD_REGEX ? _regerror(errcode, preg, errbuf, errbuf_size)
+                               : regerror(errcode, preg, errbuf, errbuf_size);
+}
+
+static void rx_regfree(regex_t *preg) {
+    if (preg == NULL || pcre2_regfree(preg)) return;
+    if (USE_PERTHREAD_REGEX)
+        _regfree(preg);
+    else
+        regfree(preg);
+}
+#endif /* #ifdef HAVE_PCRE2 */
+
+
 /* queryInterface function
  * rgerhards, 2008-03-05
  */
@@ -295,6 +576,12 @@ BEGINobjQueryInterface(regexp)
      * work here (if we can support an older interface version - that,
      * of course, also affects the "if" above).
      */
+#ifdef HAVE_PCRE2
+    pIf->regcomp = rx_regcomp;
+    pIf->regexec = rx_regexec;
+    pIf->regerror = rx_regerror;
+    pIf->regfree = rx_regfree;
+#else
     if (USE_PERTHREAD_REGEX) {
         pIf->regcomp = _regcomp;
         pIf->regexec = _regexec;
@@ -306,6 +593,7 @@ BEGINobjQueryInterface(regexp)
         pIf->regerror = regerror;
         pIf->regfree = regfree;
     }
+#endif
 
 finalize_it:
 ENDobjQueryInterface(regexp)
@@ -334,6 +622,12 @@ BEGINAbstractObjClassInit(regexp, 1, OBJ_IS_LOADABLE_MODULE) /* class, version *
             ABORT_FINALIZE(RS_RET_INTERNAL_ERROR);
         }
     }
+#ifdef HAVE_PCRE2
+    if (pthread_key_create(&key_pcre2_thrd, pcre2_thrd_data_destruct) != 0) {
+        LogError(0, RS_RET_INTERNAL_ERROR, "regexp: cannot create thread key for PCRE2 match data");
+        ABORT_FINALIZE(RS_RET_INTERNAL_ERROR);
+    }
+#endif
 
 ENDObjClassInit(regexp)
 
@@ -347,6 +641,9 @@ BEGINObjClassExit(regexp, OBJ_IS_LOADABLE_MODULE) /* class, version */
         if (regex_to_uncomp) hashtable_destroy(regex_to_uncomp, 1);
         if (perthread_regexs) hashtable_destroy(perthread_regexs, 1);
     }
+#ifdef HAVE_PCRE2
+    pthread_key_delete(key_pcre2_thrd);
+#endif
 ENDObjClassExit(regexp)
 
 
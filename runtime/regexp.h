@@ -25,7 +25,11 @@
 
 #include <regex.h>
 
-/* interfaces */
+/* interfaces
+ * As with the C library functions, a compiled regex_t may be copied or
+ * moved, but all copies refer to the same compiled expression: regfree()
+ * must be called for only one of them, and none may be used afterwards.
+ */
 BEGINinterface(regexp) /* name must also be changed in ENDinterface macro! */
     int (*regcomp)(regex_t *preg, const char *regex, int cflags);
     int (*regexec)(const regex_t *preg, const char *string, size_t nmatch, regmatch_t pmatch[], int eflags);
@@ -69,6 +69,8 @@
 #include "dirty.h"
 #include "template.h"
 #include "timezones.h"
+#include "scriptprof.h"
+#include "jsonlazy.h"
 
 extern char *yytext;
 /* static data */
@@ -192,6 +194,8 @@ static void cnfSetDefaults(rsconf_t *pThis) {
     pThis->globals.bActionReportSuspension = 1;
     pThis->globals.bActionReportSuspensionCont = 0;
     pThis->globals.janitorInterval = 10;
+    pThis->globals.wrkPoolThreads = 0;
+    pThis->globals.ioUringEntries = 0;
     pThis->globals.reportNewSenders = 0;
     pThis->globals.reportGoneAwaySenders = 0;
     pThis->globals.senderStatsTimeout = 12 * 60 * 60; /* 12 hr timeout for senders */
@@ -225,6 +229,10 @@ static void cnfSetDefaults(rsconf_t *pThis) {
     pThis->globals.shutdownQueueDoubleSize = 0;
     pThis->globals.optionDisallowWarning = 1;
     pThis->globals.bSupportCompressionExtension = 1;
+    pThis->globals.bRulesetBatchExec = 0;
+    pThis->globals.bScriptProfiling = 0;
+    pThis->globals.pszScriptProfDumpFile = NULL;
+    pThis->globals.regexEngine = REGEX_ENGINE_POSIX;
 #ifdef ENABLE_LIBLOGGING_STDLOG
     pThis->globals.stdlog_hdl = stdlog_open("rsyslogd", 0, STDLOG_SYSLOG, NULL);
     pThis->globals.stdlog_chanspec = NULL;
@@ -321,6 +329,7 @@ BEGINobjDestruct(rsconf) /* be sure to specify the object type also in END and C
     tplDeleteAll(pThis);
     dynstats_destroyAllBuckets();
     perctileBucketsDestruct();
+    scriptprofDestruct();
     ochDeleteAll();
     freeTimezones(pThis);
     parser.DestructParserList(&pThis->parsers.pDfltParsLst);
@@ -328,6 +337,7 @@ BEGINobjDestruct(rsconf) /* be sure to specify the object type also in END and C
     free(pThis->globals.mainQ.pszMainMsgQFName);
     free(pThis->globals.pszConfDAGFile);
     free(pThis->globals.pszWorkDir);
+    free(pThis->globals.pszScriptProfDumpFile);
     free(pThis->globals.operatingStateFile);
     free(pThis->globals.pszDfltNetstrmDrvrCAF);
     free(pThis->globals.pszDfltNetstrmDrvrCRLF);
@@ -1416,6 +1426,10 @@ static rsRetVal load(rsconf_t **cnf, uchar *confFile) {
     DBGPRINTF("Number of actions in this configuration: %d\n", loadConf->actions.iActionNbr);
 
     CHKiRet(tellCoreConfigLoadDone());
+    if (loadConf->globals.bScriptProfiling) {
+        CHKiRet(rulesetProfileAll(loadConf));
+    }
+    CHKiRet(jsonlazyResolveAll(loadConf));
     tellModulesConfigLoadDone();
 
     tellModulesCheckConfig();
@@ -36,6 +36,9 @@
 #define REPORT_CHILD_PROCESS_EXITS_ERRORS 1
 #define REPORT_CHILD_PROCESS_EXITS_ALL 2
 
+#define REGEX_ENGINE_POSIX 0
+#define REGEX_ENGINE_PCRE2 1
+
 #ifndef DFLT_INT_MSGS_SEV_FILTER
     #define DFLT_INT_MSGS_SEV_FILTER 6 /* Warning level and more important */
 #endif
@@ -124,6 +127,8 @@ struct globals_s {
     int bActionReportSuspension;
     int bActionReportSuspensionCont;
     short janitorInterval; /* interval (in minutes) at which the janitor runs */
+    int wrkPoolThreads; /* size of the shared queue worker pool, 0 = disabled */
+    int ioUringEntries; /* size of the shared io_uring for stream writes, 0 = disabled */
     int reportNewSenders;
     int reportGoneAwaySenders;
     int senderStatsTimeout;
@@ -158,6 +163,10 @@ struct globals_s {
     int shutdownQueueDoubleSize;
     int optionDisallowWarning; /* complain if message from disallowed sender is received */
     int bSupportCompressionExtension;
+    int bRulesetBatchExec; /* run rulesets statement-at-a-time across the whole batch */
+    int bScriptProfiling; /* collect per-statement/function execution profile */
+    uchar *pszScriptProfDumpFile; /* where to write the profile on HUP, NULL: don't */
+    int regexEngine; /* REGEX_ENGINE_* to use for extended regular expressions */
 #ifdef ENABLE_LIBLOGGING_STDLOG
     stdlog_channel_t stdlog_hdl; /* handle to be used for stdlog */
     uchar *stdlog_chanspec;
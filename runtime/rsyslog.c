@@ -82,6 +82,12 @@
 #include "statsobj.h"
 #include "atomic.h"
 #include "srUtils.h"
+#include "scriptprof.h"
+#include "timerwheel.h"
+#include "wrkpool.h"
+#include "iouring.h"
+#include "filerotate.h"
+#include "statestore.h"
 
 pthread_attr_t default_thread_attr;
 #ifdef HAVE_PTHREAD_SETSCHEDPARAM
@@ -231,6 +237,18 @@ rsRetVal rsrtInit(const char **ppErrObj, obj_if_t *pObjIF) {
         CHKiRet(dynstatsClassInit());
         if (ppErrObj != NULL) *ppErrObj = "perctile_stats";
         CHKiRet(perctileClassInit());
+        if (ppErrObj != NULL) *ppErrObj = "scriptprof";
+        CHKiRet(scriptprofClassInit());
+        if (ppErrObj != NULL) *ppErrObj = "timerwheel";
+        CHKiRet(timerwheelClassInit());
+        if (ppErrObj != NULL) *ppErrObj = "wrkpool";
+        CHKiRet(wrkpoolClassInit());
+        if (ppErrObj != NULL) *ppErrObj = "iouring";
+        CHKiRet(iouringClassInit());
+        if (ppErrObj != NULL) *ppErrObj = "filerotate";
+        CHKiRet(fileRotateClassInit());
+        if (ppErrObj != NULL) *ppErrObj = "statestore";
+        CHKiRet(statestoreClassInit());
 
         /* dummy "classes" */
         if (ppErrObj != NULL) *ppErrObj = "str";
@@ -257,6 +275,11 @@ rsRetVal rsrtExit(void) {
 
     if (iRefCount == 1) {
         /* do actual de-init only if we are the last runtime user */
+        statestoreClassExit();
+        fileRotateClassExit();
+        iouringClassExit();
+        wrkpoolClassExit();
+        timerwheelClassExit();
         confClassExit();
         glblClassExit();
         rulesetClassExit();
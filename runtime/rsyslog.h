@@ -734,6 +734,7 @@ enum rsRetVal_ {
     RS_RET_SYSTEMD_VERSION_ERR = -2463, /**< systemd version doesn't support journal namespacing */
     RS_RET_NO_TEMPLATE_SUPPORT_ERR = -2464, /**< journald namespace doesn't support template yet */
     RS_RET_SERVER_NO_TLS = -2465, /**< server received TLS handshake but is not configured for TLS */
+    RS_RET_RETRY_PARKED = -2466, /**< worker parked until an action retry is due, a state, not an error */
 
     /* RainerScript error messages (range 1000.. 1999) */
     RS_RET_SYSVAR_NOT_FOUND = 1001, /**< system variable could not be found (maybe misspelled) */
@@ -31,6 +31,7 @@
  */
 #include "config.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <ctype.h>
 
@@ -49,6 +50,7 @@
 #include "srUtils.h"
 #include "modules.h"
 #include "wti.h"
+#include "scriptprof.h"
 #include "dirty.h" /* for main ruleset queue creation */
 
 
@@ -493,6 +495,53 @@ finalize_it:
     RETiRet;
 }
 
+/* execute a single statement for a single message */
+static rsRetVal ATTR_NONNULL() scriptExecStmt(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti) {
+    DEFiRet;
+    switch (stmt->nodetype) {
+        case S_NOP:
+            break;
+        case S_STOP:
+            ABORT_FINALIZE(RS_RET_DISCARDMSG);
+            break;
+        case S_ACT:
+            CHKiRet(execAct(stmt, pMsg, pWti));
+            break;
+        case S_SET:
+            CHKiRet(execSet(stmt, pMsg, pWti));
+            break;
+        case S_UNSET:
+            CHKiRet(execUnset(stmt, pMsg));
+            break;
+        case S_CALL:
+            CHKiRet(execCall(stmt, pMsg, pWti));
+            break;
+        case S_CALL_INDIRECT:
+            CHKiRet(execCallIndirect(stmt, pMsg, pWti));
+            break;
+        case S_IF:
+            CHKiRet(execIf(stmt, pMsg, pWti));
+            break;
+        case S_FOREACH:
+            CHKiRet(execForeach(stmt, pMsg, pWti));
+            break;
+        case S_PRIFILT:
+            CHKiRet(execPRIFILT(stmt, pMsg, pWti));
+            break;
+        case S_PROPFILT:
+            CHKiRet(execPROPFILT(stmt, pMsg, pWti));
+            break;
+        case S_RELOAD_LOOKUP_TABLE:
+            CHKiRet(execReloadLookupTable(stmt));
+            break;
+        default:
+            dbgprintf("error: unknown stmt type %u during exec\n", (unsigned)stmt->nodetype);
+            break;
+    }
+finalize_it:
+    RETiRet;
+}
+
 /* The rainerscript execution engine. It is debatable if that would be better
  * contained in grammer/rainerscript.c, HOWEVER, that file focusses primarily
  * on the parsing and object creation part. So as an actual executor, it is
@@ -513,52 +562,457 @@ static rsRetVal ATTR_NONNULL(2, 3) scriptExec(struct cnfstmt *const root, smsg_t
         if (Debug) {
             cnfstmtPrintOnly(stmt, 2, 0);
         }
+        if (stmt->prof == NULL) {
+            CHKiRet(scriptExecStmt(stmt, pMsg, pWti));
+        } else {
+            const uint64_t profStart = scriptprofGetTicks();
+            const rsRetVal localRet = scriptExecStmt(stmt, pMsg, pWti);
+            scriptprofRecord(stmt->prof, profStart, 1);
+            CHKiRet(localRet);
+        }
+    }
+finalize_it:
+    RETiRet;
+}
+
+
+/* ---------- batch-at-a-time script execution ---------- */
+
+/* Batch execution mode (global ruleset.batchExecution="on").
+ * Instead of running the full script for one message before starting the
+ * next one, each statement is applied to all messages of the batch before
+ * the next statement is processed. That way, statement dispatch, debug
+ * output and branch decisions are paid once per statement and batch, and
+ * the filter loops (most importantly PRI filters) become tight loops over
+ * the batch which the compiler can optimize well.
+ *
+ * Two masks drive execution:
+ * - alive[] is shared by the whole batch and cleared when processing of an
+ *   element ends early (stop statement or error). This is the equivalent
+ *   of scriptExec() returning before the end of the script. If an action
+ *   reports suspension, the element is set to BATCH_EXEC_RETRY instead and
+ *   the full script is re-run for it on the per-message path once the batch
+ *   pass is done, just like processBatch() does in regular mode.
+ * - sel[] is local to the current statement list and tells which elements
+ *   took the branch that lead to it (similar to eltState in action
+ *   processing).
+ * An element is processed by a statement only if both are set.
+ *
+ * The masks live in per-worker scratch buffers, one set per nesting level of
+ * branches, which are sized to the largest batch seen and then reused.
+ *
+ * Note: as statements are now interleaved between messages, the order in
+ * which *different* actions see messages changes (each action still sees
+ * them in batch order). Global variables ($/) are also updated in a different
+ * sequence. Everything per-message behaves exactly like in scriptExec().
+ */
+/* values of alive[] */
+#define BATCH_EXEC_DEAD 0
+#define BATCH_EXEC_ALIVE 1
+#define BATCH_EXEC_RETRY 2 /* an action was suspended, re-run on the per-message path */
+
+#define batchExecElemActive(sel, alive, i) ((sel)[(i)] && (alive)[(i)] == BATCH_EXEC_ALIVE)
+
+/* number of masks (of nElem entries each) per nesting level */
+#define BATCH_EXEC_MASKS_PER_LEVEL 3
+
+/* Size the worker's scratch masks for a batch of nElem messages. Must only be
+ * called while no level is in use, as existing buffers may be freed.
+ */
+static void batchExecPrepareMasks(wti_t *const pWti, const int nElem) {
+    if (nElem <= pWti->batchExecMaskElems) return;
+    for (int i = 0; i < pWti->nBatchExecMasks; ++i) {
+        free(pWti->batchExecMasks[i]);
+        pWti->batchExecMasks[i] = NULL;
+    }
+    pWti->batchExecMaskElems = nElem;
+}
+
+/* Obtain the cleared masks of the next nesting level. On success, the level
+ * must be released via batchExecPopMasks().
+ */
+static rsRetVal ATTR_NONNULL() batchExecPushMasks(wti_t *const pWti, const int nElem, sbool **const ppMasks) {
+    const int level = pWti->batchExecDepth;
+    sbool **newMasks;
+    DEFiRet;
+
+    assert(nElem <= pWti->batchExecMaskElems);
+    if (level == pWti->nBatchExecMasks) {
+        CHKmalloc(newMasks = realloc(pWti->batchExecMasks, (level + 1) * sizeof(sbool *)));
+        newMasks[level] = NULL;
+        pWti->batchExecMasks = newMasks;
+        pWti->nBatchExecMasks = level + 1;
+    }
+    if (pWti->batchExecMasks[level] == NULL) {
+        CHKmalloc(pWti->batchExecMasks[level] =
+                      malloc(BATCH_EXEC_MASKS_PER_LEVEL * (size_t)pWti->batchExecMaskElems * sizeof(sbool)));
+    }
+    memset(pWti->batchExecMasks[level], 0, BATCH_EXEC_MASKS_PER_LEVEL * (size_t)nElem * sizeof(sbool));
+    *ppMasks = pWti->batchExecMasks[level];
+    pWti->batchExecDepth = level + 1;
+
+finalize_it:
+    RETiRet;
+}
+
+static void ATTR_NONNULL() batchExecPopMasks(wti_t *const pWti) {
+    assert(pWti->batchExecDepth > 0);
+    --pWti->batchExecDepth;
+}
+
+static rsRetVal ATTR_NONNULL()
+    scriptExecBatch(struct cnfstmt *root, batch_t *pBatch, const sbool *sel, sbool *alive, wti_t *pWti);
+
+/* record the per-message outcome of a statement. Returns RS_RET_FORCE_TERM if
+ * the whole batch must be abandoned, RS_RET_OK otherwise.
+ */
+static rsRetVal batchExecElemResult(sbool *const alive, const int i, const rsRetVal localRet) {
+    if (localRet == RS_RET_OK) return RS_RET_OK;
+    if (localRet == RS_RET_FORCE_TERM) return RS_RET_FORCE_TERM;
+    /* stop and errors end processing of this message only */
+    alive[i] = (localRet == RS_RET_SUSPENDED) ? BATCH_EXEC_RETRY : BATCH_EXEC_DEAD;
+    return RS_RET_OK;
+}
+
+/* execute a then/else construct for all selected elements. masks[] is the
+ * current nesting level (see batchExecPushMasks()); the condition result has
+ * already been computed into its first mask. Both branches receive their own
+ * selection mask, so the called code can run independently of each other.
+ */
+static rsRetVal ATTR_NONNULL(1, 2, 3, 4, 5) execBranchBatch(batch_t *const pBatch,
+                                                             const sbool *const sel,
+                                                             sbool *const alive,
+                                                             sbool *const masks,
+                                                             wti_t *const pWti,
+                                                             struct cnfstmt *const t_then,
+                                                             struct cnfstmt *const t_else) {
+    const int nElem = batchNumMsgs(pBatch);
+    const sbool *const cond = masks;
+    sbool *const selThen = masks + nElem;
+    sbool *const selElse = masks + 2 * nElem;
+    int nThen = 0;
+    int nElse = 0;
+    DEFiRet;
+
+    for (int i = 0; i < nElem; ++i) {
+        if (!batchExecElemActive(sel, alive, i)) continue;
+        if (cond[i]) {
+            selThen[i] = 1;
+            ++nThen;
+        } else {
+            selElse[i] = 1;
+            ++nElse;
+        }
+    }
+
+    if (t_then != NULL && nThen > 0) CHKiRet(scriptExecBatch(t_then, pBatch, selThen, alive, pWti));
+    if (t_else != NULL && nElse > 0) CHKiRet(scriptExecBatch(t_else, pBatch, selElse, alive, pWti));
+
+finalize_it:
+    RETiRet;
+}
+
+/* PRI filter over the whole batch. This is the hot path for traditional
+ * configs and thus kept as a tight, branch-light loop.
+ */
+static rsRetVal ATTR_NONNULL()
+    execPRIFILTBatch(struct cnfstmt *stmt, batch_t *pBatch, const sbool *sel, sbool *alive, wti_t *pWti) {
+    const int nElem = batchNumMsgs(pBatch);
+    const uchar *const pmask = stmt->d.s_prifilt.pmask;
+    sbool *masks;
+    DEFiRet;
+
+    CHKiRet(batchExecPushMasks(pWti, nElem, &masks));
+    for (int i = 0; i < nElem; ++i) {
+        const smsg_t *const pMsg = pBatch->pElem[i].pMsg;
+        const uchar m = pmask[pMsg->iFacility];
+        masks[i] = (m != TABLE_NOPRI) && ((m & (1 << pMsg->iSeverity)) != 0);
+    }
+    iRet = execBranchBatch(pBatch, sel, alive, masks, pWti, stmt->d.s_prifilt.t_then, stmt->d.s_prifilt.t_else);
+    batchExecPopMasks(pWti);
+
+finalize_it:
+    RETiRet;
+}
+
+static rsRetVal ATTR_NONNULL()
+    execPROPFILTBatch(struct cnfstmt *stmt, batch_t *pBatch, const sbool *sel, sbool *alive, wti_t *pWti) {
+    const int nElem = batchNumMsgs(pBatch);
+    sbool *masks;
+    DEFiRet;
+
+    CHKiRet(batchExecPushMasks(pWti, nElem, &masks));
+    for (int i = 0; i < nElem; ++i) {
+        if (batchExecElemActive(sel, alive, i)) masks[i] = evalPROPFILT(stmt, pBatch->pElem[i].pMsg);
+    }
+    iRet = execBranchBatch(pBatch, sel, alive, masks, pWti, stmt->d.s_propfilt.t_then, NULL);
+    batchExecPopMasks(pWti);
+
+finalize_it:
+    RETiRet;
+}
+
+static rsRetVal ATTR_NONNULL()
+    execIfBatch(struct cnfstmt *stmt, batch_t *pBatch, const sbool *sel, sbool *alive, wti_t *pWti) {
+    const int nElem = batchNumMsgs(pBatch);
+    sbool *masks;
+    DEFiRet;
+
+    CHKiRet(batchExecPushMasks(pWti, nElem, &masks));
+    for (int i = 0; i < nElem; ++i) {
+        if (batchExecElemActive(sel, alive, i))
+            masks[i] = cnfexprEvalBool(stmt->d.s_if.expr, pBatch->pElem[i].pMsg, pWti);
+    }
+    iRet = execBranchBatch(pBatch, sel, alive, masks, pWti, stmt->d.s_if.t_then, stmt->d.s_if.t_else);
+    batchExecPopMasks(pWti);
+
+finalize_it:
+    RETiRet;
+}
+
+/* execute a statement that has no batch-specific implementation by calling
+ * its regular per-message executor for each selected element.
+ */
+static rsRetVal ATTR_NONNULL()
+    execPerMsgBatch(struct cnfstmt *stmt, batch_t *pBatch, const sbool *sel, sbool *alive, wti_t *pWti) {
+    rsRetVal localRet;
+    DEFiRet;
+
+    for (int i = 0; i < batchNumMsgs(pBatch); ++i) {
+        if (!batchExecElemActive(sel, alive, i)) continue;
+        smsg_t *const pMsg = pBatch->pElem[i].pMsg;
         switch (stmt->nodetype) {
-            case S_NOP:
-                break;
-            case S_STOP:
-                ABORT_FINALIZE(RS_RET_DISCARDMSG);
-                break;
             case S_ACT:
-                CHKiRet(execAct(stmt, pMsg, pWti));
+                localRet = execAct(stmt, pMsg, pWti);
                 break;
             case S_SET:
-                CHKiRet(execSet(stmt, pMsg, pWti));
+                localRet = execSet(stmt, pMsg, pWti);
                 break;
             case S_UNSET:
-                CHKiRet(execUnset(stmt, pMsg));
+                localRet = execUnset(stmt, pMsg);
                 break;
             case S_CALL:
-                CHKiRet(execCall(stmt, pMsg, pWti));
+                localRet = execCall(stmt, pMsg, pWti);
                 break;
             case S_CALL_INDIRECT:
-                CHKiRet(execCallIndirect(stmt, pMsg, pWti));
-                break;
-            case S_IF:
-                CHKiRet(execIf(stmt, pMsg, pWti));
+                localRet = execCallIndirect(stmt, pMsg, pWti);
                 break;
             case S_FOREACH:
-                CHKiRet(execForeach(stmt, pMsg, pWti));
-                break;
-            case S_PRIFILT:
-                CHKiRet(execPRIFILT(stmt, pMsg, pWti));
-                break;
-            case S_PROPFILT:
-                CHKiRet(execPROPFILT(stmt, pMsg, pWti));
-                break;
-            case S_RELOAD_LOOKUP_TABLE:
-                CHKiRet(execReloadLookupTable(stmt));
+                localRet = execForeach(stmt, pMsg, pWti);
                 break;
             default:
-                dbgprintf("error: unknown stmt type %u during exec\n", (unsigned)stmt->nodetype);
+                dbgprintf("error: unknown stmt type %u during batch exec\n", (unsigned)stmt->nodetype);
+                localRet = RS_RET_OK;
                 break;
         }
+        CHKiRet(batchExecElemResult(alive, i, localRet));
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+/* The reload is triggered asynchronously, so once per batch is sufficient. It is
+ * only done if some message actually reaches the statement. As on the per-message
+ * path, a failure to trigger it ends processing of these messages.
+ */
+static rsRetVal ATTR_NONNULL()
+    execReloadLookupTableBatch(struct cnfstmt *stmt, batch_t *pBatch, const sbool *sel, sbool *alive) {
+    const int nElem = batchNumMsgs(pBatch);
+    rsRetVal localRet;
+    int i;
+    DEFiRet;
+
+    i = 0;
+    while (i < nElem && !batchExecElemActive(sel, alive, i)) ++i;
+    if (i == nElem) FINALIZE; /* no message reaches the statement */
+
+    localRet = execReloadLookupTable(stmt);
+    for (; i < nElem; ++i) {
+        if (batchExecElemActive(sel, alive, i)) CHKiRet(batchExecElemResult(alive, i, localRet));
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+/* execute a single (non-stop) statement for the selected batch elements */
+static rsRetVal ATTR_NONNULL() scriptExecBatchStmt(struct cnfstmt *const stmt,
+                                                   batch_t *const pBatch,
+                                                   const sbool *const sel,
+                                                   sbool *const alive,
+                                                   wti_t *const pWti) {
+    DEFiRet;
+    switch (stmt->nodetype) {
+        case S_NOP:
+            break;
+        case S_ACT:
+            if (actionIsDisabled(stmt->d.act)) {
+                DBGPRINTF("action %d died, do NOT execute\n", stmt->d.act->iActionNbr);
+                break;
+            }
+            CHKiRet(execPerMsgBatch(stmt, pBatch, sel, alive, pWti));
+            break;
+        case S_SET:
+        case S_UNSET:
+        case S_CALL_INDIRECT:
+        case S_FOREACH:
+            CHKiRet(execPerMsgBatch(stmt, pBatch, sel, alive, pWti));
+            break;
+        case S_CALL:
+            if (stmt->d.s_call.ruleset == NULL) {
+                CHKiRet(scriptExecBatch(stmt->d.s_call.stmt, pBatch, sel, alive, pWti));
+            } else {
+                CHKiRet(execPerMsgBatch(stmt, pBatch, sel, alive, pWti));
+            }
+            break;
+        case S_IF:
+            CHKiRet(execIfBatch(stmt, pBatch, sel, alive, pWti));
+            break;
+        case S_PRIFILT:
+            CHKiRet(execPRIFILTBatch(stmt, pBatch, sel, alive, pWti));
+            break;
+        case S_PROPFILT:
+            CHKiRet(execPROPFILTBatch(stmt, pBatch, sel, alive, pWti));
+            break;
+        case S_RELOAD_LOOKUP_TABLE:
+            CHKiRet(execReloadLookupTableBatch(stmt, pBatch, sel, alive));
+            break;
+        default:
+            dbgprintf("error: unknown stmt type %u during exec\n", (unsigned)stmt->nodetype);
+            break;
+    }
+finalize_it:
+    RETiRet;
+}
+
+/* batch-mode counterpart of scriptExec(), see description above.
+ * Returns RS_RET_FORCE_TERM if shutdown was requested; all other per-message
+ * conditions are recorded in alive[].
+ */
+static rsRetVal ATTR_NONNULL()
+    scriptExecBatch(struct cnfstmt *const root, batch_t *const pBatch, const sbool *const sel, sbool *const alive,
+                    wti_t *const pWti) {
+    struct cnfstmt *stmt;
+    DEFiRet;
+
+    for (stmt = root; stmt != NULL; stmt = stmt->next) {
+        if (*pWti->pbShutdownImmediate) {
+            DBGPRINTF(
+                "scriptExecBatch: ShutdownImmediate set, "
+                "force terminating\n");
+            ABORT_FINALIZE(RS_RET_FORCE_TERM);
+        }
+        if (Debug) {
+            cnfstmtPrintOnly(stmt, 2, 0);
+        }
+        if (stmt->nodetype == S_STOP) {
+            for (int i = 0; i < batchNumMsgs(pBatch); ++i) {
+                if (batchExecElemActive(sel, alive, i)) alive[i] = BATCH_EXEC_DEAD;
+            }
+            FINALIZE; /* nothing in this list can be reached any longer */
+        }
+        if (stmt->prof == NULL) {
+            CHKiRet(scriptExecBatchStmt(stmt, pBatch, sel, alive, pWti));
+        } else {
+            unsigned nActive = 0;
+            for (int i = 0; i < batchNumMsgs(pBatch); ++i) {
+                nActive += batchExecElemActive(sel, alive, i);
+            }
+            const uint64_t profStart = scriptprofGetTicks();
+            const rsRetVal localRet = scriptExecBatchStmt(stmt, pBatch, sel, alive, pWti);
+            scriptprofRecord(stmt->prof, profStart, nActive);
+            CHKiRet(localRet);
+        }
     }
 finalize_it:
     RETiRet;
 }
 
 
+/* Run the script for batch element i on the per-message path, retrying while
+ * an action reports suspension (like the regular loop in processBatch()).
+ * Returns RS_RET_FORCE_TERM if shutdown was requested, RS_RET_OK otherwise.
+ */
+static rsRetVal ATTR_NONNULL() processBatchElem(batch_t *const pBatch, const int i, wti_t *const pWti) {
+    smsg_t *const pMsg = pBatch->pElem[i].pMsg;
+    ruleset_t *const pRuleset = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
+    rsRetVal localRet;
+
+    do {
+        if (*(pWti->pbShutdownImmediate)) return RS_RET_FORCE_TERM;
+        localRet = scriptExec(pRuleset->root, pMsg, pWti);
+    } while (localRet == RS_RET_SUSPENDED);
+
+    if (localRet == RS_RET_OK) batchSetElemState(pBatch, i, BATCH_STATE_COMM);
+    return RS_RET_OK;
+}
+
+
+/* Process a batch in batch-execution mode. Messages of a batch may be bound
+ * to different rulesets, so we run each ruleset once over the subset of
+ * messages that belong to it.
+ * Elements whose action was suspended are re-run on the per-message path. The
+ * same is done for the live elements of a ruleset pass that failed (this can
+ * only happen if scratch memory could not be allocated), so that no message is
+ * dropped; as with suspension, their earlier statements are then run again.
+ * An error is returned only if nothing was executed, the caller must then use
+ * the per-message path for the whole batch.
+ */
+static rsRetVal processBatchColumnar(batch_t *pBatch, wti_t *pWti) {
+    const int nElem = batchNumMsgs(pBatch);
+    sbool *sel;
+    sbool *alive;
+    sbool *done;
+    ruleset_t *pRuleset;
+    rsRetVal localRet;
+    int nDone = 0;
+    DEFiRet;
+
+    if (nElem == 0) FINALIZE;
+    assert(pWti->batchExecDepth == 0);
+    batchExecPrepareMasks(pWti, nElem);
+    CHKiRet(batchExecPushMasks(pWti, nElem, &sel));
+    alive = sel + nElem;
+    done = alive + nElem;
+
+    for (int first = 0; nDone < nElem && !*(pWti->pbShutdownImmediate); ++first) {
+        if (done[first]) continue;
+        pRuleset = (pBatch->pElem[first].pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt
+                                                                  : pBatch->pElem[first].pMsg->pRuleset;
+        for (int i = first; i < nElem; ++i) {
+            const smsg_t *const pMsg = pBatch->pElem[i].pMsg;
+            ruleset_t *const pRs = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
+            sel[i] = (!done[i] && pRs == pRuleset);
+            if (sel[i]) {
+                alive[i] = BATCH_EXEC_ALIVE;
+                done[i] = 1;
+                ++nDone;
+            }
+        }
+        DBGPRINTF("processBATCH: columnar execution of ruleset '%s'\n", pRuleset->pszName);
+        localRet = scriptExecBatch(pRuleset->root, pBatch, sel, alive, pWti);
+        if (localRet == RS_RET_FORCE_TERM) {
+            /* do NOT flag anything of this ruleset as committed, see processBatch() */
+            break;
+        }
+        for (int i = first; i < nElem; ++i) {
+            if (!sel[i]) continue;
+            sel[i] = 0;
+            if (alive[i] == BATCH_EXEC_RETRY || (localRet != RS_RET_OK && alive[i] == BATCH_EXEC_ALIVE)) {
+                if (processBatchElem(pBatch, i, pWti) == RS_RET_FORCE_TERM) break;
+            } else if (alive[i] == BATCH_EXEC_ALIVE) {
+                batchSetElemState(pBatch, i, BATCH_STATE_COMM);
+            }
+        }
+    }
+    batchExecPopMasks(pWti);
+
+finalize_it:
+    RETiRet;
+}
+
+
 /* Process (consume) a batch of messages. Calls the actions configured.
  * This is called by MAIN queues.
  */
@@ -574,20 +1028,24 @@ static rsRetVal processBatch(batch_t *pBatch, wti_t *pWti) {
     wtiResetExecState(pWti, pBatch);
 
     /* execution phase */
-    for (i = 0; i < batchNumMsgs(pBatch) && !*(pWti->pbShutdownImmediate); ++i) {
-        pMsg = pBatch->pElem[i].pMsg;
-        DBGPRINTF("processBATCH: next msg %d: %.128s\n", i, pMsg->pszRawMsg);
-        pRuleset = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
-        localRet = scriptExec(pRuleset->root, pMsg, pWti);
-        /* the most important case here is that processing may be aborted
-         * due to pbShutdownImmediate, in which case we MUST NOT flag this
-         * message as committed. If we would do so, the message would
-         * potentially be lost.
-         */
-        if (localRet == RS_RET_OK)
-            batchSetElemState(pBatch, i, BATCH_STATE_COMM);
-        else if (localRet == RS_RET_SUSPENDED)
-            --i;
+    if (runConf->globals.bRulesetBatchExec && processBatchColumnar(pBatch, pWti) == RS_RET_OK) {
+        i = batchNumMsgs(pBatch);
+    } else {
+        for (i = 0; i < batchNumMsgs(pBatch) && !*(pWti->pbShutdownImmediate); ++i) {
+            pMsg = pBatch->pElem[i].pMsg;
+            DBGPRINTF("processBATCH: next msg %d: %.128s\n", i, pMsg->pszRawMsg);
+            pRuleset = (pMsg->pRuleset == NULL) ? runConf->rulesets.pDflt : pMsg->pRuleset;
+            localRet = scriptExec(pRuleset->root, pMsg, pWti);
+            /* the most important case here is that processing may be aborted
+             * due to pbShutdownImmediate, in which case we MUST NOT flag this
+             * message as committed. If we would do so, the message would
+             * potentially be lost.
+             */
+            if (localRet == RS_RET_OK)
+                batchSetElemState(pBatch, i, BATCH_STATE_COMM);
+            else if (localRet == RS_RET_SUSPENDED)
+                --i;
+        }
     }
 
     /* commit phase */
@@ -856,6 +1314,22 @@ rsRetVal rulesetOptimizeAll(rsconf_t *conf) {
 }
 
 
+/* helper for rulesetProfileAll(), registers a single ruleset */
+DEFFUNC_llExecFunc(doRulesetProfileAll) {
+    return cnfstmtProfileRegister(((ruleset_t *)pData)->root);
+}
+/* set up the script profiler for all rulesets. Must be called after the
+ * optimizer has run (statements are changed during optimization).
+ */
+rsRetVal rulesetProfileAll(rsconf_t *conf) {
+    DEFiRet;
+    CHKiRet(llExecFunc(&(conf->rulesets.llRulesets), doRulesetProfileAll, NULL));
+    CHKiRet(scriptprofInitStats());
+finalize_it:
+    RETiRet;
+}
+
+
 /* Create a ruleset-specific "main" queue for this ruleset. If one is already
  * defined, an error message is emitted but nothing else is done.
  * Note: we use the main message queue parameters for queue creation and access
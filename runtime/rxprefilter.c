@@ -0,0 +1,382 @@
+/* rxprefilter.c - literal prefilter for sets of regular expressions
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file rxprefilter.c
+ * @brief Literal extraction and Aho-Corasick scan for regex sets.
+ *
+ * Literal extraction is deliberately conservative: whenever the regex
+ * contains a construct that is not fully understood (top-level alternation,
+ * PCRE inline options, backslash-letter escapes, ...), no literal is used
+ * and the regex becomes an "always" candidate. This keeps the prefilter
+ * correct for both the POSIX and the PCRE2 regex engine.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "rsyslog.h"
+#include "rxprefilter.h"
+
+/* Aho-Corasick automaton node. Index 0 is the root; as the root is never a
+ * child, 0 also means "none" for child/sibling/dictLink.
+ */
+typedef struct acnode_s {
+    uint32_t child; /* first child */
+    uint32_t sibling; /* next child of our parent */
+    uint32_t fail; /* longest proper suffix that is also in the trie */
+    uint32_t dictLink; /* next node on the fail chain with outputs */
+    uint32_t out; /* first output, index into outs[], 0: none */
+    uchar c;
+} acnode_t;
+
+/* output list entry: regex idx ends at a node */
+typedef struct acout_s {
+    uint32_t idx;
+    uint32_t next;
+} acout_t;
+
+struct rxprefilter_s {
+    uint32_t nRegex;
+    uint32_t nWords;
+    uint32_t nAlways; /* number of regexes without literal */
+    uint64_t *always; /* bitmap of regexes without literal */
+    acnode_t *nodes;
+    uint32_t nNodes;
+    uint32_t maxNodes;
+    acout_t *outs; /* entry 0 is unused */
+    uint32_t nOuts;
+    uint32_t maxOuts;
+    uint32_t rootNext[256]; /* dense transitions for the root node */
+};
+
+
+/* skip a bracket expression, p points to the opening '['. Returns pointer
+ * after the closing ']' or NULL if the expression cannot be handled.
+ */
+static const char *skipBracket(const char *p) {
+    ++p;
+    if (*p == '^') ++p;
+    if (*p == ']') ++p; /* literal ']' as first member */
+    while (*p != '\0' && *p != ']') {
+        if (*p == '\\') {
+            return NULL; /* escape in POSIX, but not in PCRE2 - we cannot tell */
+        } else if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+            const char term[3] = {p[1], ']', '\0'};
+            if ((p = strstr(p + 2, term)) == NULL) return NULL;
+            p += 2;
+        } else {
+            ++p;
+        }
+    }
+    return (*p == ']') ? p + 1 : NULL;
+}
+
+
+/* Extract the longest literal that every match of the extended regular
+ * expression regex must contain. Both buffers must be strlen(regex)+1
+ * bytes in size. Returns the literal length, 0 if there is none.
+ */
+static size_t extractLiteral(const char *const regex, uchar *const best, uchar *const cur) {
+    const char *p = regex;
+    size_t bestLen = 0;
+    size_t curLen = 0;
+    int depth = 0;
+
+#define COMMIT_RUN                        \
+    do {                                  \
+        if (curLen > bestLen) {           \
+            memcpy(best, cur, curLen);    \
+            bestLen = curLen;             \
+        }                                 \
+        curLen = 0;                       \
+    } while (0)
+
+    if (strstr(regex, "(?") != NULL) return 0; /* PCRE options may change case sensitivity */
+
+    while (*p != '\0') {
+        if (depth > 0) { /* group contents are not required to match */
+            switch (*p) {
+                case '\\':
+                    if (p[1] == '\0') return 0;
+                    p += 2;
+                    break;
+                case '[':
+                    if ((p = skipBracket(p)) == NULL) return 0;
+                    break;
+                case '(':
+                    ++depth;
+                    ++p;
+                    break;
+                case ')':
+                    --depth;
+                    ++p;
+                    break;
+                default:
+                    ++p;
+                    break;
+            }
+            continue;
+        }
+        switch (*p) {
+            case '|':
+                return 0;
+            case ')':
+                return 0; /* unbalanced */
+            case '(':
+                COMMIT_RUN;
+                ++depth;
+                ++p;
+                break;
+            case '[':
+                COMMIT_RUN;
+                if ((p = skipBracket(p)) == NULL) return 0;
+                break;
+            case '*':
+            case '?':
+                /* previous char is optional */
+                if (curLen > 0) --curLen;
+                COMMIT_RUN;
+                ++p;
+                break;
+            case '{':
+                if (curLen > 0) --curLen;
+                COMMIT_RUN;
+                if ((p = strchr(p, '}')) == NULL) return 0;
+                ++p;
+                break;
+            case '+':
+                /* previous char is required, but may repeat */
+                COMMIT_RUN;
+                ++p;
+                break;
+            case '.':
+            case '^':
+            case '$':
+                COMMIT_RUN;
+                ++p;
+                break;
+            case '\\':
+                if (p[1] == '\0' || isalnum((uchar)p[1])) return 0;
+                cur[curLen++] = (uchar)p[1];
+                p += 2;
+                break;
+            default:
+                cur[curLen++] = (uchar)*p;
+                ++p;
+                break;
+        }
+    }
+    if (depth != 0) return 0;
+    COMMIT_RUN;
+#undef COMMIT_RUN
+    return bestLen;
+}
+
+
+static uint32_t findChild(const rxprefilter_t *const pThis, const uint32_t node, const uchar c) {
+    uint32_t child;
+    for (child = pThis->nodes[node].child; child != 0; child = pThis->nodes[child].sibling) {
+        if (pThis->nodes[child].c == c) break;
+    }
+    return child;
+}
+
+
+static rsRetVal addNode(rxprefilter_t *const pThis, const uint32_t parent, const uchar c, uint32_t *const pNode) {
+    DEFiRet;
+    if (pThis->nNodes == pThis->maxNodes) {
+        const uint32_t newMax = pThis->maxNodes * 2;
+        acnode_t *newNodes;
+        CHKmalloc(newNodes = realloc(pThis->nodes, newMax * sizeof(acnode_t)));
+        pThis->nodes = newNodes;
+        pThis->maxNodes = newMax;
+    }
+    const uint32_t node = pThis->nNodes++;
+    memset(&pThis->nodes[node], 0, sizeof(acnode_t));
+    pThis->nodes[node].c = c;
+    pThis->nodes[node].sibling = pThis->nodes[parent].child;
+    pThis->nodes[parent].child = node;
+    *pNode = node;
+finalize_it:
+    RETiRet;
+}
+
+
+static rsRetVal addOutput(rxprefilter_t *const pThis, const uint32_t node, const uint32_t idx) {
+    DEFiRet;
+    if (pThis->nOuts == pThis->maxOuts) {
+        const uint32_t newMax = pThis->maxOuts * 2;
+        acout_t *newOuts;
+        CHKmalloc(newOuts = realloc(pThis->outs, newMax * sizeof(acout_t)));
+        pThis->outs = newOuts;
+        pThis->maxOuts = newMax;
+    }
+    const uint32_t out = pThis->nOuts++;
+    pThis->outs[out].idx = idx;
+    pThis->outs[out].next = pThis->nodes[node].out;
+    pThis->nodes[node].out = out;
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal rxprefilterConstruct(rxprefilter_t **const ppThis, const uint32_t nRegex) {
+    rxprefilter_t *pThis = NULL;
+    DEFiRet;
+
+    CHKmalloc(pThis = calloc(1, sizeof(rxprefilter_t)));
+    pThis->nRegex = nRegex;
+    pThis->nWords = (nRegex + RXPREFILTER_WORDBITS - 1) / RXPREFILTER_WORDBITS;
+    CHKmalloc(pThis->always = calloc((pThis->nWords == 0) ? 1 : pThis->nWords, sizeof(uint64_t)));
+    pThis->maxNodes = 256;
+    CHKmalloc(pThis->nodes = calloc(pThis->maxNodes, sizeof(acnode_t)));
+    pThis->nNodes = 1; /* root */
+    pThis->maxOuts = 64;
+    CHKmalloc(pThis->outs = calloc(pThis->maxOuts, sizeof(acout_t)));
+    pThis->nOuts = 1; /* entry 0 means "none" */
+    *ppThis = pThis;
+
+finalize_it:
+    if (iRet != RS_RET_OK) rxprefilterDestruct(&pThis);
+    RETiRet;
+}
+
+
+rsRetVal rxprefilterAdd(rxprefilter_t *const pThis, const uint32_t idx, const char *const regex) {
+    uchar *best = NULL;
+    uchar *cur = NULL;
+    size_t lenLit;
+    uint32_t node = 0;
+    DEFiRet;
+
+    const size_t lenRegex = strlen(regex);
+    CHKmalloc(best = malloc(lenRegex + 1));
+    CHKmalloc(cur = malloc(lenRegex + 1));
+    lenLit = extractLiteral(regex, best, cur);
+    if (lenLit == 0) {
+        pThis->always[idx / RXPREFILTER_WORDBITS] |= (uint64_t)1 << (idx % RXPREFILTER_WORDBITS);
+        ++pThis->nAlways;
+        DBGPRINTF("rxprefilter: regex %u '%s' has no literal, always evaluated\n", idx, regex);
+        FINALIZE;
+    }
+
+    for (size_t i = 0; i < lenLit; ++i) {
+        uint32_t next = findChild(pThis, node, best[i]);
+        if (next == 0) CHKiRet(addNode(pThis, node, best[i], &next));
+        node = next;
+    }
+    CHKiRet(addOutput(pThis, node, idx));
+
+finalize_it:
+    free(best);
+    free(cur);
+    RETiRet;
+}
+
+
+rsRetVal rxprefilterFinalize(rxprefilter_t *const pThis) {
+    uint32_t *queue = NULL;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t child;
+    DEFiRet;
+
+    for (child = pThis->nodes[0].child; child != 0; child = pThis->nodes[child].sibling) {
+        pThis->rootNext[pThis->nodes[child].c] = child;
+    }
+
+    /* breadth-first, so that fail targets are always complete before use */
+    CHKmalloc(queue = malloc(pThis->nNodes * sizeof(uint32_t)));
+    for (child = pThis->nodes[0].child; child != 0; child = pThis->nodes[child].sibling) {
+        pThis->nodes[child].fail = 0;
+        queue[tail++] = child;
+    }
+    while (head < tail) {
+        const uint32_t node = queue[head++];
+        for (child = pThis->nodes[node].child; child != 0; child = pThis->nodes[child].sibling) {
+            const uchar c = pThis->nodes[child].c;
+            uint32_t f = pThis->nodes[node].fail;
+            uint32_t target;
+            while (f != 0 && findChild(pThis, f, c) == 0) f = pThis->nodes[f].fail;
+            target = (f == 0) ? pThis->rootNext[c] : findChild(pThis, f, c);
+            pThis->nodes[child].fail = target;
+            pThis->nodes[child].dictLink = (pThis->nodes[target].out != 0) ? target : pThis->nodes[target].dictLink;
+            queue[tail++] = child;
+        }
+    }
+    DBGPRINTF("rxprefilter: %u regexes, %u trie nodes, %u without literal\n", pThis->nRegex, pThis->nNodes,
+              pThis->nAlways);
+
+finalize_it:
+    free(queue);
+    RETiRet;
+}
+
+
+uint32_t rxprefilterNWords(const rxprefilter_t *const pThis) {
+    return pThis->nWords;
+}
+
+
+uint32_t rxprefilterNAlways(const rxprefilter_t *const pThis) {
+    return pThis->nAlways;
+}
+
+
+void rxprefilterScan(const rxprefilter_t *const pThis, const uchar *str, uint64_t *const cand) {
+    uint32_t state = 0;
+
+    memcpy(cand, pThis->always, pThis->nWords * sizeof(uint64_t));
+    for (; *str != '\0'; ++str) {
+        const uchar c = *str;
+        for (;;) {
+            if (state == 0) {
+                state = pThis->rootNext[c];
+                break;
+            }
+            const uint32_t next = findChild(pThis, state, c);
+            if (next != 0) {
+                state = next;
+                break;
+            }
+            state = pThis->nodes[state].fail;
+        }
+        uint32_t n = (pThis->nodes[state].out != 0) ? state : pThis->nodes[state].dictLink;
+        for (; n != 0; n = pThis->nodes[n].dictLink) {
+            for (uint32_t o = pThis->nodes[n].out; o != 0; o = pThis->outs[o].next) {
+                const uint32_t idx = pThis->outs[o].idx;
+                cand[idx / RXPREFILTER_WORDBITS] |= (uint64_t)1 << (idx % RXPREFILTER_WORDBITS);
+            }
+        }
+    }
+}
+
+
+void rxprefilterDestruct(rxprefilter_t **const ppThis) {
+    rxprefilter_t *const pThis = *ppThis;
+    if (pThis == NULL) return;
+    free(pThis->always);
+    free(pThis->nodes);
+    free(pThis->outs);
+    free(pThis);
+    *ppThis = NULL;
+}
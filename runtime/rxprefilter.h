@@ -0,0 +1,75 @@
+/* rxprefilter.h - literal prefilter for sets of regular expressions
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file rxprefilter.h
+ * @brief Select candidate regexes of a regex set with a single scan.
+ *
+ * For each (POSIX extended) regular expression of a set, the longest
+ * literal string that every match must contain is extracted. All literals
+ * are compiled into one Aho-Corasick automaton. Scanning a subject string
+ * once yields a bitmap of regexes that can possibly match; only these need
+ * to be executed. Regexes without a usable literal are always candidates.
+ *
+ * The prefilter never rejects a regex that would match, so evaluating the
+ * candidates in index order gives the same result as trying all regexes.
+ */
+#ifndef INCLUDED_RXPREFILTER_H
+#define INCLUDED_RXPREFILTER_H
+
+#include <stdint.h>
+
+typedef struct rxprefilter_s rxprefilter_t;
+
+/** Number of bits in one candidate bitmap word. */
+#define RXPREFILTER_WORDBITS 64
+
+/** Test if regex @p idx is set in candidate bitmap @p cand. */
+#define rxprefilterIsCand(cand, idx) (((cand)[(idx) / RXPREFILTER_WORDBITS] >> ((idx) % RXPREFILTER_WORDBITS)) & 1)
+
+/**
+ * Create an empty prefilter for @p nRegex regular expressions.
+ */
+rsRetVal rxprefilterConstruct(rxprefilter_t **ppThis, uint32_t nRegex);
+
+/**
+ * Add regex number @p idx (0 <= idx < nRegex) to the prefilter. Each index
+ * must be added exactly once, before rxprefilterFinalize() is called.
+ */
+rsRetVal rxprefilterAdd(rxprefilter_t *pThis, uint32_t idx, const char *regex);
+
+/** Build the automaton. Must be called once after all regexes were added. */
+rsRetVal rxprefilterFinalize(rxprefilter_t *pThis);
+
+/** Number of uint64_t words a candidate bitmap for this prefilter needs. */
+uint32_t rxprefilterNWords(const rxprefilter_t *pThis);
+
+/**
+ * Scan @p str and store the bitmap of candidate regexes in @p cand, which
+ * must hold rxprefilterNWords() words. Thread-safe after finalization.
+ */
+void rxprefilterScan(const rxprefilter_t *pThis, const uchar *str, uint64_t *cand);
+
+/** Number of regexes that are candidates for every string. */
+uint32_t rxprefilterNAlways(const rxprefilter_t *pThis);
+
+void rxprefilterDestruct(rxprefilter_t **ppThis);
+
+#endif /* #ifndef INCLUDED_RXPREFILTER_H */
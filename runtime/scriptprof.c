@@ -0,0 +1,182 @@
+/* scriptprof.c - RainerScript execution profiler
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file scriptprof.c
+ * @brief Registry, impstats reporting and HUP dump for the script profiler.
+ *
+ * The registry is a simple singly-linked list. It is built once while the
+ * config is activated and is read-only afterwards, so no locking is needed
+ * for list traversal. Counter updates are done with atomics by the script
+ * engine (see scriptprofRecord()).
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "rsyslog.h"
+#include "errmsg.h"
+#include "rsconf.h"
+#include "unicode-helper.h"
+#include "scriptprof.h"
+
+/* definitions for objects we access */
+DEFobjStaticHelpers;
+DEFobjCurrIf(statsobj)
+
+static scriptprof_ctr_t *profRoot = NULL;
+static int nProfCtrs = 0;
+static statsobj_t *profStats = NULL;
+
+rsRetVal scriptprofClassInit(void) {
+    DEFiRet;
+    CHKiRet(objGetObjInterface(&obj));
+    CHKiRet(objUse(statsobj, CORE_COMPONENT));
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal scriptprofRegister(const char *const kind,
+                            const char *const srcfile,
+                            const int lineno,
+                            scriptprof_ctr_t **const ppCtr) {
+    scriptprof_ctr_t *ctr = NULL;
+    DEFiRet;
+
+    CHKmalloc(ctr = calloc(1, sizeof(scriptprof_ctr_t)));
+    INIT_ATOMIC_HELPER_MUT64(ctr->mutCtr);
+    if (asprintf((char **)&ctr->label, "%s:%d:%s", (srcfile == NULL) ? "-" : srcfile, lineno, kind) == -1) {
+        ctr->label = NULL;
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    }
+    ctr->next = profRoot;
+    profRoot = ctr;
+    ++nProfCtrs;
+    *ppCtr = ctr;
+
+finalize_it:
+    if (iRet != RS_RET_OK) free(ctr);
+    RETiRet;
+}
+
+
+/* add a counter named "<label>.<suffix>" to the profiler stats object */
+static rsRetVal addProfCounter(scriptprof_ctr_t *const ctr, const char *const suffix, intctr_t *const pVal) {
+    char ctrName[1024];
+    DEFiRet;
+    snprintf(ctrName, sizeof(ctrName), "%s.%s", (char *)ctr->label, suffix);
+    CHKiRet(statsobj.AddCounter(profStats, (uchar *)ctrName, ctrType_IntCtr, CTR_FLAG_NONE, pVal));
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal scriptprofInitStats(void) {
+    DEFiRet;
+
+    if (profRoot == NULL) FINALIZE;
+    CHKiRet(statsobj.Construct(&profStats));
+    CHKiRet(statsobj.SetName(profStats, (uchar *)"rainerscript-profile"));
+    CHKiRet(statsobj.SetOrigin(profStats, (uchar *)"rainerscript"));
+    for (scriptprof_ctr_t *ctr = profRoot; ctr != NULL; ctr = ctr->next) {
+        CHKiRet(addProfCounter(ctr, "executions", &ctr->ctrExec));
+        CHKiRet(addProfCounter(ctr, "ticks", &ctr->ctrTicks));
+    }
+    CHKiRet(statsobj.ConstructFinalize(profStats));
+    DBGPRINTF("scriptprof: %d statements and function calls are profiled\n", nProfCtrs);
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* counter values as of the start of a dump; sorting must not see the live
+ * counters, which workers keep updating
+ */
+typedef struct scriptprof_snap_s {
+    intctr_t nExec;
+    intctr_t nTicks;
+    const char *label;
+} scriptprof_snap_t;
+
+static int cmpProfSnap(const void *const a, const void *const b) {
+    const scriptprof_snap_t *const sa = (const scriptprof_snap_t *)a;
+    const scriptprof_snap_t *const sb = (const scriptprof_snap_t *)b;
+    if (sa->nTicks == sb->nTicks) return 0;
+    return (sa->nTicks < sb->nTicks) ? 1 : -1;
+}
+
+
+/* Write a snapshot of all counters, sorted by accumulated ticks (most
+ * expensive first), to the configured dump file. The file is rewritten on
+ * each HUP. Counters are read without locking, so executions and ticks of a
+ * statement may be slightly inconsistent while workers are active; the sort
+ * itself only works on the copied values.
+ */
+void scriptprofDoHUP(void) {
+    const char *const fn = (char *)runConf->globals.pszScriptProfDumpFile;
+    scriptprof_snap_t *snap = NULL;
+    FILE *fp = NULL;
+    int i;
+
+    if (profRoot == NULL || fn == NULL) goto done;
+
+    if ((snap = malloc(nProfCtrs * sizeof(scriptprof_snap_t))) == NULL) goto done;
+    i = 0;
+    for (scriptprof_ctr_t *ctr = profRoot; ctr != NULL; ctr = ctr->next) {
+        snap[i].nExec = ctr->ctrExec;
+        snap[i].nTicks = ctr->ctrTicks;
+        snap[i].label = (const char *)ctr->label;
+        ++i;
+    }
+    qsort(snap, nProfCtrs, sizeof(scriptprof_snap_t), cmpProfSnap);
+
+    if ((fp = fopen(fn, "w")) == NULL) {
+        LogError(errno, RS_RET_FILE_OPEN_ERROR, "script profiler: cannot open dump file '%s'", fn);
+        goto done;
+    }
+    fprintf(fp, "# ticks executions ticks/execution location\n");
+    for (i = 0; i < nProfCtrs; ++i) {
+        fprintf(fp, "%llu %llu %llu %s\n", (unsigned long long)snap[i].nTicks, (unsigned long long)snap[i].nExec,
+                (unsigned long long)((snap[i].nExec == 0) ? 0 : snap[i].nTicks / snap[i].nExec), snap[i].label);
+    }
+
+done:
+    if (fp != NULL) fclose(fp);
+    free(snap);
+}
+
+
+void scriptprofDestruct(void) {
+    scriptprof_ctr_t *ctr;
+
+    if (profStats != NULL) statsobj.Destruct(&profStats);
+    while (profRoot != NULL) {
+        ctr = profRoot;
+        profRoot = ctr->next;
+        DESTROY_ATOMIC_HELPER_MUT64(ctr->mutCtr);
+        free(ctr->label);
+        free(ctr);
+    }
+    nProfCtrs = 0;
+}
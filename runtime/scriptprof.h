@@ -0,0 +1,94 @@
+/* scriptprof.h - RainerScript execution profiler
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file scriptprof.h
+ * @brief Opt-in profiler for RainerScript statements and function calls.
+ *
+ * When global(script.profiling="on") is set, each statement and each
+ * function call site of the active config receives a scriptprof_ctr_t.
+ * The script engine counts executions and accumulates elapsed ticks into
+ * it. Counters are reported via impstats (object "rainerscript-profile")
+ * and can be dumped, sorted by cost, to script.profiling.dumpFile on HUP.
+ *
+ * Ticks are CPU cycles (TSC) on x86 and nanoseconds elsewhere. Statement
+ * times are inclusive, e.g. an "if" includes the cost of its branches.
+ */
+#ifndef INCLUDED_SCRIPTPROF_H
+#define INCLUDED_SCRIPTPROF_H
+
+#include <time.h>
+#include "statsobj.h"
+
+/** Profiling counters for a single statement or function call site. */
+struct scriptprof_ctr_s {
+    intctr_t ctrExec; /**< number of executions */
+    intctr_t ctrTicks; /**< accumulated ticks (cycles or ns) */
+    DEF_ATOMIC_HELPER_MUT64(mutCtr);
+    uchar *label; /**< "file:line:kind", used as counter name prefix */
+    scriptprof_ctr_t *next; /**< registry list link */
+};
+
+/** Return the current value of the profiling clock. */
+static inline uint64_t __attribute__((unused)) scriptprofGetTicks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint64_t)__builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * Account @p nExec executions that began at tick value @p start.
+ * Counters are updated even if impstats is not loaded, so that the HUP
+ * dump works stand-alone.
+ */
+static inline void __attribute__((unused)) scriptprofRecord(scriptprof_ctr_t *const ctr,
+                                                            const uint64_t start,
+                                                            const unsigned nExec) {
+    const uint64_t elapsed = scriptprofGetTicks() - start;
+    ATOMIC_ADD_uint64(&ctr->ctrExec, &ctr->mutCtr, nExec);
+    ATOMIC_ADD_uint64(&ctr->ctrTicks, &ctr->mutCtr, elapsed);
+}
+
+/**
+ * Create and register a counter block.
+ *
+ * @param kind    statement type or function name (e.g. "if", "re_match()")
+ * @param srcfile config file the item was defined in, may be NULL
+ * @param lineno  line number inside srcfile
+ * @param ppCtr   receives the new counter block, owned by the registry
+ */
+rsRetVal scriptprofRegister(const char *kind, const char *srcfile, int lineno, scriptprof_ctr_t **ppCtr);
+
+/** Create the impstats object for all registered counters. */
+rsRetVal scriptprofInitStats(void);
+
+/** Write all counters, most expensive first, to the configured dump file. */
+void scriptprofDoHUP(void);
+
+/** Free all registered counters and the stats object. */
+void scriptprofDestruct(void);
+
+rsRetVal scriptprofClassInit(void);
+
+#endif /* #ifndef INCLUDED_SCRIPTPROF_H */
@@ -0,0 +1,865 @@
+/* statestore.c - log-structured key/value store for input module state
+ *
+ * See statestore.h for the concept.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_PRCTL_H
+    #include <sys/prctl.h>
+#endif
+
+#include "rsyslog.h"
+#include "srUtils.h"
+#include "errmsg.h"
+#include "hashtable.h"
+#include "glbl.h"
+#include "statestore.h"
+
+#define STATESTORE_HEADER "rsyslog-statestore 1\n"
+#define STATESTORE_INIT_TAB_SIZE 1024
+#define STATESTORE_MIN_COMPACT_SIZE (64 * 1024) /* smaller files are never compacted */
+
+typedef struct statestore_entry_s statestore_entry_t;
+struct statestore_entry_s {
+    char *pszKey; /* owned by the hash table */
+    size_t lenKey;
+    char *pszVal; /* NULL if deleted, but the delete is not yet committed */
+    size_t lenVal;
+    sbool bDirty; /* changed since the last commit */
+    statestore_entry_t *pNextDirty;
+    statestore_entry_t *pPrev; /* list of all entries, for compaction */
+    statestore_entry_t *pNext;
+};
+
+/* a growing buffer for serialized records */
+typedef struct {
+    char *pBuf;
+    size_t len;
+    size_t size;
+} recbuf_t;
+
+struct statestore_s {
+    statestore_t *pNext; /* registry of open stores */
+    char *pszFile;
+    int nRefs;
+    int iCommitInterval; /* ms */
+    pthread_mutex_t mut; /* protects the entries */
+    pthread_mutex_t mutCommit; /* serializes commits, protects the file */
+    struct hashtable *ht; /* key -> entry */
+    statestore_entry_t *pHead; /* all entries */
+    statestore_entry_t *pDirty; /* entries to write with the next commit */
+    size_t lenLive; /* size of a compacted file */
+    int fd;
+    off_t lenFile;
+    sbool bRewrite; /* a write failed, the file must be rewritten as a whole */
+    sbool bErrReported;
+};
+
+static struct {
+    pthread_mutex_t mut;
+    pthread_cond_t cond;
+    statestore_t *pRoot;
+    pthread_t thrdID;
+    sbool bThrdRunning;
+    sbool bStop;
+} reg;
+
+
+static size_t numLen(size_t n) {
+    size_t len = 1;
+    while (n >= 10) {
+        n /= 10;
+        ++len;
+    }
+    return len;
+}
+
+
+/* size of the record that describes the current state of pEntry */
+static size_t ATTR_NONNULL() recLen(const statestore_entry_t *const pEntry) {
+    if (pEntry->pszVal == NULL) {
+        return 1 + numLen(pEntry->lenKey) + 1 + pEntry->lenKey + 1;
+    }
+    return 1 + numLen(pEntry->lenKey) + 1 + numLen(pEntry->lenVal) + 1 + pEntry->lenKey + pEntry->lenVal + 1;
+}
+
+
+static rsRetVal ATTR_NONNULL() recbufReserve(recbuf_t *const pBuf, const size_t len) {
+    char *pNew;
+    size_t newSize;
+    DEFiRet;
+
+    if (pBuf->len + len > pBuf->size) {
+        newSize = (pBuf->size == 0) ? 4096 : pBuf->size;
+        while (newSize < pBuf->len + len) {
+            newSize *= 2;
+        }
+        CHKmalloc(pNew = realloc(pBuf->pBuf, newSize));
+        pBuf->pBuf = pNew;
+        pBuf->size = newSize;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+static rsRetVal ATTR_NONNULL() recbufAddRec(recbuf_t *const pBuf, const statestore_entry_t *const pEntry) {
+    const size_t len = recLen(pEntry);
+    char *p;
+    DEFiRet;
+
+    CHKiRet(recbufReserve(pBuf, len + 1)); /* sprintf() needs room for the NUL */
+    p = pBuf->pBuf + pBuf->len;
+    if (pEntry->pszVal == NULL) {
+        p += sprintf(p, "-%zu ", pEntry->lenKey);
+        memcpy(p, pEntry->pszKey, pEntry->lenKey);
+        p += pEntry->lenKey;
+    } else {
+        p += sprintf(p, "+%zu %zu ", pEntry->lenKey, pEntry->lenVal);
+        memcpy(p, pEntry->pszKey, pEntry->lenKey);
+        p += pEntry->lenKey;
+        memcpy(p, pEntry->pszVal, pEntry->lenVal);
+        p += pEntry->lenVal;
+    }
+    *p = '\n';
+    pBuf->len += len;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* entry handling; all of these must be called with pThis->mut held (or
+ * while the store is not yet shared).
+ */
+static rsRetVal ATTR_NONNULL()
+    entryAdd(statestore_t *const pThis, const char *const pKey, const size_t lenKey, statestore_entry_t **ppEntry) {
+    statestore_entry_t *pEntry = NULL;
+    char *pszKey = NULL;
+    DEFiRet;
+
+    CHKmalloc(pEntry = calloc(1, sizeof(statestore_entry_t)));
+    CHKmalloc(pszKey = malloc(lenKey + 1));
+    memcpy(pszKey, pKey, lenKey);
+    pszKey[lenKey] = '\0';
+    if (!hashtable_insert(pThis->ht, pszKey, pEntry)) {
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    }
+    pEntry->pszKey = pszKey;
+    pEntry->lenKey = lenKey;
+    pEntry->pNext = pThis->pHead;
+    if (pThis->pHead != NULL) {
+        pThis->pHead->pPrev = pEntry;
+    }
+    pThis->pHead = pEntry;
+    *ppEntry = pEntry;
+
+finalize_it:
+    if (iRet != RS_RET_OK) {
+        free(pszKey);
+        free(pEntry);
+    }
+    RETiRet;
+}
+
+
+static void ATTR_NONNULL() entryRemove(statestore_t *const pThis, statestore_entry_t *const pEntry) {
+    if (pEntry->pszVal != NULL) {
+        pThis->lenLive -= recLen(pEntry);
+        free(pEntry->pszVal);
+    }
+    if (pEntry->pPrev == NULL) {
+        pThis->pHead = pEntry->pNext;
+    } else {
+        pEntry->pPrev->pNext = pEntry->pNext;
+    }
+    if (pEntry->pNext != NULL) {
+        pEntry->pNext->pPrev = pEntry->pPrev;
+    }
+    /* the hash table owns the key and frees it here */
+    hashtable_remove(pThis->ht, pEntry->pszKey);
+    free(pEntry);
+}
+
+
+static rsRetVal ATTR_NONNULL()
+    entrySetVal(statestore_t *const pThis, statestore_entry_t *const pEntry, const char *const pVal, const size_t lenVal) {
+    char *pszVal;
+    DEFiRet;
+
+    CHKmalloc(pszVal = malloc(lenVal + 1));
+    memcpy(pszVal, pVal, lenVal);
+    pszVal[lenVal] = '\0';
+    if (pEntry->pszVal != NULL) {
+        pThis->lenLive -= recLen(pEntry);
+        free(pEntry->pszVal);
+    }
+    pEntry->pszVal = pszVal;
+    pEntry->lenVal = lenVal;
+    pThis->lenLive += recLen(pEntry);
+
+finalize_it:
+    RETiRet;
+}
+
+
+static void ATTR_NONNULL() entryMarkDirty(statestore_t *const pThis, statestore_entry_t *const pEntry) {
+    if (!pEntry->bDirty) {
+        pEntry->bDirty = 1;
+        pEntry->pNextDirty = pThis->pDirty;
+        pThis->pDirty = pEntry;
+    }
+}
+
+
+static rsRetVal ATTR_NONNULL() writeAll(const int fd, const char *const pBuf, const size_t len) {
+    size_t written = 0;
+    ssize_t r;
+    DEFiRet;
+
+    while (written < len) {
+        r = write(fd, pBuf + written, len - written);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            ABORT_FINALIZE(RS_RET_IO_ERROR);
+        }
+        written += r;
+    }
+    if (fdatasync(fd) != 0) {
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* make a rename or creation of pszFile durable */
+static void ATTR_NONNULL() syncDir(const char *const pszFile) {
+    char szDir[MAXFNAME];
+    const char *const pSlash = strrchr(pszFile, '/');
+    int fd;
+
+    if (pSlash == NULL) {
+        strcpy(szDir, ".");
+    } else if (pSlash == pszFile) {
+        strcpy(szDir, "/");
+    } else {
+        snprintf(szDir, sizeof(szDir), "%.*s", (int)(pSlash - pszFile), pszFile);
+    }
+    fd = open(szDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1 || fsync(fd) != 0) {
+        LogError(errno, RS_RET_IO_ERROR, "statestore: cannot sync directory '%s'", szDir);
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+
+static void ATTR_NONNULL() reportWriteResult(statestore_t *const pThis, const rsRetVal iRet, const int err) {
+    if (iRet != RS_RET_OK) {
+        if (!pThis->bErrReported) {
+            LogError(err, iRet,
+                     "statestore: cannot write state to '%s' - changes are kept "
+                     "in memory and written once this works again",
+                     pThis->pszFile);
+            pThis->bErrReported = 1;
+        }
+    } else if (pThis->bErrReported) {
+        LogMsg(0, RS_RET_OK, LOG_INFO, "statestore: state is written to '%s' again", pThis->pszFile);
+        pThis->bErrReported = 0;
+    }
+}
+
+
+/* Rewrite the file with the live records only. The new file is written
+ * under a temporary name and then renamed, so a crash leaves either the old
+ * or the new file. Must be called with pThis->mutCommit held.
+ */
+static rsRetVal ATTR_NONNULL() compact(statestore_t *const pThis) {
+    char szTmp[MAXFNAME];
+    recbuf_t buf = {NULL, 0, 0};
+    statestore_entry_t *pEntry;
+    int fd = -1;
+    int err = 0;
+    DEFiRet;
+
+    DBGPRINTF("statestore: compacting '%s', %lld bytes\n", pThis->pszFile, (long long)pThis->lenFile);
+    snprintf(szTmp, sizeof(szTmp), "%s.tmp", pThis->pszFile);
+    pthread_mutex_lock(&pThis->mut);
+    iRet = recbufReserve(&buf, sizeof(STATESTORE_HEADER) - 1);
+    if (iRet == RS_RET_OK) {
+        memcpy(buf.pBuf, STATESTORE_HEADER, sizeof(STATESTORE_HEADER) - 1);
+        buf.len = sizeof(STATESTORE_HEADER) - 1;
+    }
+    for (pEntry = pThis->pHead; pEntry != NULL && iRet == RS_RET_OK; pEntry = pEntry->pNext) {
+        if (pEntry->pszVal != NULL) {
+            iRet = recbufAddRec(&buf, pEntry);
+        }
+    }
+    pthread_mutex_unlock(&pThis->mut);
+    CHKiRet(iRet);
+
+    fd = open(szTmp, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC | O_NOCTTY, 0600);
+    if (fd == -1) {
+        err = errno;
+        ABORT_FINALIZE(RS_RET_FILE_OPEN_ERROR);
+    }
+    if (writeAll(fd, buf.pBuf, buf.len) != RS_RET_OK || rename(szTmp, pThis->pszFile) != 0) {
+        err = errno;
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    syncDir(pThis->pszFile);
+    close(pThis->fd);
+    pThis->fd = fd;
+    fd = -1;
+    pThis->lenFile = buf.len;
+
+finalize_it:
+    if (fd != -1) {
+        close(fd);
+        unlink(szTmp);
+    }
+    reportWriteResult(pThis, iRet, err);
+    free(buf.pBuf);
+    RETiRet;
+}
+
+
+rsRetVal statestoreCommit(statestore_t *const pThis) {
+    recbuf_t buf = {NULL, 0, 0};
+    statestore_entry_t *pEntry;
+    size_t lenLive;
+    int err = 0;
+    DEFiRet;
+
+    pthread_mutex_lock(&pThis->mutCommit);
+    pthread_mutex_lock(&pThis->mut);
+    while ((pEntry = pThis->pDirty) != NULL) {
+        if (recbufAddRec(&buf, pEntry) != RS_RET_OK) {
+            /* the rest stays dirty; what is not written now is covered by a rewrite */
+            pThis->bRewrite = 1;
+            break;
+        }
+        pThis->pDirty = pEntry->pNextDirty;
+        pEntry->pNextDirty = NULL;
+        pEntry->bDirty = 0;
+        if (pEntry->pszVal == NULL) {
+            entryRemove(pThis, pEntry);
+        }
+    }
+    lenLive = pThis->lenLive + sizeof(STATESTORE_HEADER) - 1;
+    pthread_mutex_unlock(&pThis->mut);
+
+    if (buf.len > 0 && !pThis->bRewrite) {
+        iRet = writeAll(pThis->fd, buf.pBuf, buf.len);
+        if (iRet == RS_RET_OK) {
+            pThis->lenFile += buf.len;
+            reportWriteResult(pThis, iRet, 0);
+        } else {
+            err = errno;
+            /* drop what made it into the file, it is part of the rewrite */
+            if (ftruncate(pThis->fd, pThis->lenFile) != 0) {
+                DBGPRINTF("statestore: ftruncate of '%s' failed, errno %d\n", pThis->pszFile, errno);
+            }
+            reportWriteResult(pThis, iRet, err);
+            pThis->bRewrite = 1;
+        }
+    }
+    if (pThis->bRewrite ||
+        (pThis->lenFile > STATESTORE_MIN_COMPACT_SIZE && (size_t)pThis->lenFile > 2 * lenLive)) {
+        iRet = compact(pThis);
+        pThis->bRewrite = (iRet != RS_RET_OK);
+    }
+
+    pthread_mutex_unlock(&pThis->mutCommit);
+    free(buf.pBuf);
+    RETiRet;
+}
+
+
+/* Parse the record at pRec. RS_RET_INVALID_VALUE means the record is
+ * incomplete or malformed. In that case, *pLenRec is the length the header
+ * claims if it could be parsed and fits into the buffer, else 0.
+ */
+static rsRetVal ATTR_NONNULL() parseRec(char *const pRec,
+                                        const size_t lenAvail,
+                                        char **const ppKey,
+                                        size_t *const pLenKey,
+                                        size_t *const pLenVal,
+                                        size_t *const pLenRec) {
+    char *p = pRec + 1;
+    char *pEnd;
+    size_t lenKey;
+    size_t lenVal = 0;
+    size_t lenRec;
+    DEFiRet;
+
+    *pLenRec = 0;
+    if (lenAvail < 4 || (*pRec != '+' && *pRec != '-')) {
+        ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    }
+    /* the buffer is NUL-terminated, so strtoull() stops at its end */
+    lenKey = strtoull(p, &pEnd, 10);
+    if (pEnd == p || *pEnd != ' ') ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    p = pEnd + 1;
+    if (*pRec == '+') {
+        lenVal = strtoull(p, &pEnd, 10);
+        if (pEnd == p || *pEnd != ' ') ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+        p = pEnd + 1;
+    }
+    if (lenKey > lenAvail || lenVal > lenAvail || (size_t)(p - pRec) + lenKey + lenVal + 1 > lenAvail) {
+        ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    }
+    lenRec = (p - pRec) + lenKey + lenVal + 1;
+    if (lenKey == 0 || p[lenKey + lenVal] != '\n') {
+        *pLenRec = lenRec;
+        ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    }
+    *ppKey = p;
+    *pLenKey = lenKey;
+    *pLenVal = lenVal;
+    *pLenRec = lenRec;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* Parse the record at pRec and apply it. RS_RET_INVALID_VALUE means the
+ * record is incomplete or malformed.
+ */
+static rsRetVal ATTR_NONNULL()
+    loadRec(statestore_t *const pThis, char *const pRec, const size_t lenAvail, size_t *const pLenRec) {
+    statestore_entry_t *pEntry;
+    char *p;
+    char cSave;
+    size_t lenKey;
+    size_t lenVal;
+    DEFiRet;
+
+    CHKiRet(parseRec(pRec, lenAvail, &p, &lenKey, &lenVal, pLenRec));
+
+    /* terminate the key in place for the lookup */
+    cSave = p[lenKey];
+    p[lenKey] = '\0';
+    pEntry = hashtable_search(pThis->ht, p);
+    p[lenKey] = cSave;
+    if (*pRec == '+') {
+        if (pEntry == NULL) {
+            CHKiRet(entryAdd(pThis, p, lenKey, &pEntry));
+        }
+        iRet = entrySetVal(pThis, pEntry, p + lenKey, lenVal);
+        if (iRet != RS_RET_OK && pEntry->pszVal == NULL) {
+            entryRemove(pThis, pEntry);
+        }
+        CHKiRet(iRet);
+    } else if (pEntry != NULL) {
+        entryRemove(pThis, pEntry);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* Find the next valid record after the malformed one at offs. It is first
+ * looked for behind the length the malformed record claims, then after each
+ * line end. Returns 0 if there is none, i.e. the bad data extends to the
+ * end of the file.
+ */
+static size_t ATTR_NONNULL() findNextRec(char *const pBuf, const size_t len, const size_t offs,
+                                         const size_t lenClaimed) {
+    char *pKey;
+    char *pNL;
+    size_t lenKey;
+    size_t lenVal;
+    size_t lenRec;
+    size_t next;
+
+    if (lenClaimed > 0 && offs + lenClaimed < len &&
+        parseRec(pBuf + offs + lenClaimed, len - offs - lenClaimed, &pKey, &lenKey, &lenVal, &lenRec) == RS_RET_OK) {
+        return offs + lenClaimed;
+    }
+    for (next = offs + 1; next < len; next = pNL - pBuf + 1) {
+        if ((pNL = memchr(pBuf + next, '\n', len - next)) == NULL || (size_t)(pNL - pBuf) + 1 >= len) {
+            break;
+        }
+        if (parseRec(pNL + 1, len - (pNL - pBuf) - 1, &pKey, &lenKey, &lenVal, &lenRec) == RS_RET_OK) {
+            return pNL - pBuf + 1;
+        }
+    }
+    return 0;
+}
+
+
+/* open the file and replay its records */
+static rsRetVal ATTR_NONNULL() loadFile(statestore_t *const pThis) {
+    const size_t lenHdr = sizeof(STATESTORE_HEADER) - 1;
+    struct stat sb;
+    char *pBuf = NULL;
+    size_t len = 0;
+    size_t offs;
+    size_t lenRec;
+    size_t next;
+    ssize_t r;
+    DEFiRet;
+
+    pThis->fd = open(pThis->pszFile, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC | O_NOCTTY, 0600);
+    if (pThis->fd == -1 || fstat(pThis->fd, &sb) != 0) {
+        LogError(errno, RS_RET_FILE_OPEN_ERROR, "statestore: cannot open state store '%s'", pThis->pszFile);
+        ABORT_FINALIZE(RS_RET_FILE_OPEN_ERROR);
+    }
+
+    if (sb.st_size == 0) {
+        DBGPRINTF("statestore: creating '%s'\n", pThis->pszFile);
+        if (writeAll(pThis->fd, STATESTORE_HEADER, lenHdr) != RS_RET_OK) {
+            LogError(errno, RS_RET_IO_ERROR, "statestore: cannot write state store '%s'", pThis->pszFile);
+            ABORT_FINALIZE(RS_RET_IO_ERROR);
+        }
+        syncDir(pThis->pszFile);
+        pThis->lenFile = lenHdr;
+        FINALIZE;
+    }
+
+    CHKmalloc(pBuf = malloc(sb.st_size + 1));
+    while (len < (size_t)sb.st_size) {
+        r = pread(pThis->fd, pBuf + len, sb.st_size - len, len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            LogError(errno, RS_RET_IO_ERROR, "statestore: cannot read state store '%s'", pThis->pszFile);
+            ABORT_FINALIZE(RS_RET_IO_ERROR);
+        }
+        len += r;
+    }
+    pBuf[len] = '\0';
+    if (len < lenHdr || memcmp(pBuf, STATESTORE_HEADER, lenHdr)) {
+        LogError(0, RS_RET_INVALID_VALUE, "statestore: '%s' is not a state store, not touching it", pThis->pszFile);
+        ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    }
+
+    for (offs = lenHdr; offs < len; offs += lenRec) {
+        iRet = loadRec(pThis, pBuf + offs, len - offs, &lenRec);
+        if (iRet != RS_RET_INVALID_VALUE) {
+            CHKiRet(iRet);
+            continue;
+        }
+        iRet = RS_RET_OK;
+        if ((next = findNextRec(pBuf, len, offs, lenRec)) == 0) {
+            /* a crash during a write leaves a torn record at the end */
+            LogMsg(0, RS_RET_INVALID_VALUE, LOG_WARNING,
+                   "statestore: '%s' ends in an incomplete record, discarding its "
+                   "last %zu bytes",
+                   pThis->pszFile, len - offs);
+            if (ftruncate(pThis->fd, offs) != 0) {
+                LogError(errno, RS_RET_IO_ERROR, "statestore: cannot truncate '%s'", pThis->pszFile);
+                ABORT_FINALIZE(RS_RET_IO_ERROR);
+            }
+            break;
+        }
+        /* keep the records behind it; the next commit rewrites the file without it */
+        LogMsg(0, RS_RET_INVALID_VALUE, LOG_WARNING,
+               "statestore: '%s' contains a malformed record at offset %zu, skipping %zu bytes", pThis->pszFile,
+               offs, next - offs);
+        pThis->bRewrite = 1;
+        lenRec = next - offs;
+    }
+    pThis->lenFile = offs;
+    DBGPRINTF("statestore: loaded %u records from '%s'\n", hashtable_count(pThis->ht), pThis->pszFile);
+
+finalize_it:
+    free(pBuf);
+    RETiRet;
+}
+
+
+static void storeDestruct(statestore_t *const pThis) {
+    statestore_entry_t *pEntry;
+
+    while ((pEntry = pThis->pHead) != NULL) {
+        pThis->pHead = pEntry->pNext;
+        free(pEntry->pszVal);
+        free(pEntry);
+    }
+    if (pThis->ht != NULL) {
+        hashtable_destroy(pThis->ht, 0); /* frees the keys */
+    }
+    if (pThis->fd != -1) {
+        close(pThis->fd);
+    }
+    pthread_mutex_destroy(&pThis->mutCommit);
+    pthread_mutex_destroy(&pThis->mut);
+    free(pThis->pszFile);
+    free(pThis);
+}
+
+
+static rsRetVal ATTR_NONNULL()
+    storeConstruct(statestore_t **const ppThis, const char *const pszFile, const int iCommitInterval) {
+    statestore_t *pThis = NULL;
+    DEFiRet;
+
+    CHKmalloc(pThis = calloc(1, sizeof(statestore_t)));
+    pthread_mutex_init(&pThis->mut, NULL);
+    pthread_mutex_init(&pThis->mutCommit, NULL);
+    pThis->fd = -1;
+    pThis->nRefs = 1;
+    pThis->iCommitInterval = iCommitInterval;
+    CHKmalloc(pThis->pszFile = strdup(pszFile));
+    CHKmalloc(pThis->ht = create_hashtable(STATESTORE_INIT_TAB_SIZE, hash_from_string, key_equals_string, NULL));
+    CHKiRet(loadFile(pThis));
+    *ppThis = pThis;
+
+finalize_it:
+    if (iRet != RS_RET_OK && pThis != NULL) {
+        storeDestruct(pThis);
+    }
+    RETiRet;
+}
+
+
+rsRetVal statestoreGet(statestore_t *const pThis, const char *const pszKey, char **const ppszVal) {
+    statestore_entry_t *pEntry;
+    DEFiRet;
+
+    pthread_mutex_lock(&pThis->mut);
+    pEntry = hashtable_search(pThis->ht, (void *)pszKey);
+    if (pEntry == NULL || pEntry->pszVal == NULL) {
+        ABORT_FINALIZE(RS_RET_NOT_FOUND);
+    }
+    CHKmalloc(*ppszVal = strdup(pEntry->pszVal));
+
+finalize_it:
+    pthread_mutex_unlock(&pThis->mut);
+    RETiRet;
+}
+
+
+rsRetVal statestoreSet(statestore_t *const pThis, const char *const pszKey, const char *const pszVal) {
+    statestore_entry_t *pEntry;
+    const size_t lenVal = strlen(pszVal);
+    DEFiRet;
+
+    pthread_mutex_lock(&pThis->mut);
+    pEntry = hashtable_search(pThis->ht, (void *)pszKey);
+    if (pEntry == NULL) {
+        CHKiRet(entryAdd(pThis, pszKey, strlen(pszKey), &pEntry));
+    } else if (pEntry->pszVal != NULL && pEntry->lenVal == lenVal && !memcmp(pEntry->pszVal, pszVal, lenVal)) {
+        FINALIZE; /* unchanged, nothing to write */
+    }
+    iRet = entrySetVal(pThis, pEntry, pszVal, lenVal);
+    if (iRet != RS_RET_OK) {
+        if (pEntry->pszVal == NULL && !pEntry->bDirty) {
+            entryRemove(pThis, pEntry);
+        }
+        FINALIZE;
+    }
+    entryMarkDirty(pThis, pEntry);
+
+finalize_it:
+    pthread_mutex_unlock(&pThis->mut);
+    RETiRet;
+}
+
+
+rsRetVal statestoreDelete(statestore_t *const pThis, const char *const pszKey) {
+    statestore_entry_t *pEntry;
+
+    pthread_mutex_lock(&pThis->mut);
+    pEntry = hashtable_search(pThis->ht, (void *)pszKey);
+    if (pEntry != NULL && pEntry->pszVal != NULL) {
+        pThis->lenLive -= recLen(pEntry);
+        free(pEntry->pszVal);
+        pEntry->pszVal = NULL;
+        pEntry->lenVal = 0;
+        entryMarkDirty(pThis, pEntry);
+    }
+    pthread_mutex_unlock(&pThis->mut);
+    return RS_RET_OK;
+}
+
+
+/* Commits the open stores periodically. Commits are done with reg.mut
+ * held, so a store cannot be closed while it is committed. This only
+ * delays opening and closing stores, not their use.
+ */
+static void *commitThread(void __attribute__((unused)) * arg) {
+    statestore_t *pStore;
+    struct timespec t;
+    int iInterval;
+    sigset_t sigSet;
+
+    /* signals are handled by the main thread only */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+#if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    if (prctl(PR_SET_NAME, "rs:statestore", 0, 0, 0) != 0) {
+        DBGPRINTF("prctl failed, not setting thread name for '%s'\n", "statestore");
+    }
+#endif
+    pthread_mutex_lock(&reg.mut);
+    while (!reg.bStop) {
+        iInterval = STATESTORE_DFLT_COMMIT_INTERVAL;
+        for (pStore = reg.pRoot; pStore != NULL; pStore = pStore->pNext) {
+            if (pStore == reg.pRoot || pStore->iCommitInterval < iInterval) {
+                iInterval = pStore->iCommitInterval;
+            }
+        }
+        timeoutComp(&t, iInterval);
+        pthread_cond_timedwait(&reg.cond, &reg.mut, &t);
+        if (reg.bStop) break;
+        for (pStore = reg.pRoot; pStore != NULL; pStore = pStore->pNext) {
+            statestoreCommit(pStore);
+        }
+    }
+    pthread_mutex_unlock(&reg.mut);
+    return NULL;
+}
+
+
+rsRetVal statestoreOpen(statestore_t **const ppThis, rsconf_t *const pConf, const char *const pszName,
+                        int iCommitInterval) {
+    statestore_t *pThis;
+    char pszFile[MAXFNAME];
+    const uchar *pszDir;
+    int lenFile;
+    DEFiRet;
+
+    pthread_mutex_lock(&reg.mut);
+    /* all users resolve a relative name the same way, so that a store shared
+     * by name is also the same file.
+     */
+    if (pszName[0] == '/') {
+        lenFile = snprintf(pszFile, sizeof(pszFile), "%s", pszName);
+    } else {
+        pszDir = glblGetWorkDirRaw(pConf);
+        lenFile = snprintf(pszFile, sizeof(pszFile), "%s/%s", (pszDir == NULL) ? "." : (const char *)pszDir, pszName);
+    }
+    if (lenFile < 0 || lenFile >= (int)sizeof(pszFile)) {
+        LogError(0, RS_RET_INVALID_PARAMS, "statestore: path for store '%s' is too long", pszName);
+        ABORT_FINALIZE(RS_RET_INVALID_PARAMS);
+    }
+
+    if (iCommitInterval <= 0) {
+        iCommitInterval = STATESTORE_DFLT_COMMIT_INTERVAL;
+    }
+    for (pThis = reg.pRoot; pThis != NULL; pThis = pThis->pNext) {
+        if (!strcmp(pThis->pszFile, pszFile)) {
+            ++pThis->nRefs;
+            if (iCommitInterval < pThis->iCommitInterval) {
+                pThis->iCommitInterval = iCommitInterval;
+                pthread_cond_signal(&reg.cond);
+            }
+            FINALIZE;
+        }
+    }
+    if (!reg.bThrdRunning) {
+        if (pthread_create(&reg.thrdID, &default_thread_attr, commitThread, NULL) != 0) {
+            LogError(errno, RS_RET_ERR, "statestore: cannot create commit thread");
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        reg.bThrdRunning = 1;
+    }
+    CHKiRet(storeConstruct(&pThis, pszFile, iCommitInterval));
+    pThis->pNext = reg.pRoot;
+    reg.pRoot = pThis;
+    pthread_cond_signal(&reg.cond);
+
+finalize_it:
+    pthread_mutex_unlock(&reg.mut);
+    if (iRet == RS_RET_OK) {
+        *ppThis = pThis;
+    }
+    RETiRet;
+}
+
+
+void statestoreClose(statestore_t **const ppThis) {
+    statestore_t *pThis = *ppThis;
+    statestore_t **ppPrev;
+
+    if (pThis == NULL) return;
+    pthread_mutex_lock(&reg.mut);
+    if (--pThis->nRefs == 0) {
+        for (ppPrev = &reg.pRoot; *ppPrev != pThis; ppPrev = &(*ppPrev)->pNext) {
+            /* just search */
+        }
+        *ppPrev = pThis->pNext;
+    } else {
+        pThis = NULL;
+    }
+    pthread_mutex_unlock(&reg.mut);
+    if (pThis != NULL) {
+        statestoreCommit(pThis);
+        storeDestruct(pThis);
+    }
+    *ppThis = NULL;
+}
+
+
+/* the commit thread does not survive fork(), so it is re-created on next use */
+static void statestoreAtForkChild(void) {
+    pthread_mutex_init(&reg.mut, NULL);
+    pthread_cond_init(&reg.cond, NULL);
+    reg.bThrdRunning = 0;
+}
+
+
+rsRetVal statestoreClassInit(void) {
+    DEFiRet;
+
+    memset(&reg, 0, sizeof(reg));
+    pthread_mutex_init(&reg.mut, NULL);
+    pthread_cond_init(&reg.cond, NULL);
+    if (pthread_atfork(NULL, NULL, statestoreAtForkChild) != 0) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* Stores are closed by their users before. */
+void statestoreClassExit(void) {
+    pthread_mutex_lock(&reg.mut);
+    reg.bStop = 1;
+    pthread_cond_signal(&reg.cond);
+    pthread_mutex_unlock(&reg.mut);
+    if (reg.bThrdRunning) {
+        pthread_join(reg.thrdID, NULL);
+        reg.bThrdRunning = 0;
+    }
+    pthread_cond_destroy(&reg.cond);
+    pthread_mutex_destroy(&reg.mut);
+}
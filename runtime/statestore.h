@@ -0,0 +1,84 @@
+/* statestore.h - log-structured key/value store for input module state
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file statestore.h
+ * @brief Keeps small state records (e.g. read offsets) in a single file.
+ *
+ * Input modules that persist their position per source (imfile per file,
+ * imjournal per journal) traditionally write one state file per source.
+ * With many sources, that means many file writes per persist cycle. A
+ * state store keeps all records in memory and appends changes to a single
+ * log file instead:
+ *
+ *     rsyslog-statestore 1\n
+ *     +<keylen> <vallen> <key><value>\n     (set)
+ *     -<keylen> <key>\n                     (delete)
+ *
+ * Later records override earlier ones. On load, the file is replayed; a
+ * torn record at the end (from a crash during a write) is discarded.
+ *
+ * Changes are not written when they are made. A background thread commits
+ * all changes of a store once per commit interval with a single write and
+ * fdatasync(), so the cost of durability does not depend on the number of
+ * sources. statestoreCommit() commits synchronously, e.g. for users that
+ * need each update on disk. Once the file has grown to more than twice the
+ * size of its live records, it is rewritten with the live records only.
+ *
+ * Stores are shared: opening the same file twice (e.g. from imfile and
+ * imjournal) returns the same store. Keys should thus be prefixed by the
+ * module name. All functions are thread-safe.
+ */
+#ifndef INCLUDED_STATESTORE_H
+#define INCLUDED_STATESTORE_H
+
+typedef struct statestore_s statestore_t;
+
+/** default commit interval in milliseconds */
+#define STATESTORE_DFLT_COMMIT_INTERVAL 1000
+
+/**
+ * Open the store named @p pszName (created if missing), or obtain another
+ * reference to it if it is already open. A relative name is relative to the
+ * work directory of @p pConf. Changes are committed at least every
+ * @p iCommitInterval milliseconds; if users request different intervals,
+ * the shortest is used.
+ */
+rsRetVal statestoreOpen(statestore_t **ppThis, rsconf_t *pConf, const char *pszName, int iCommitInterval);
+
+/** Drop a reference. The last one commits pending changes and closes the store. */
+void statestoreClose(statestore_t **ppThis);
+
+/** Obtain a copy of the value for @p pszKey, to be freed by the caller. RS_RET_NOT_FOUND if not present. */
+rsRetVal statestoreGet(statestore_t *pThis, const char *pszKey, char **ppszVal);
+
+/** Set @p pszKey to @p pszVal, which must not contain a NUL byte. Takes effect on disk with the next commit. */
+rsRetVal statestoreSet(statestore_t *pThis, const char *pszKey, const char *pszVal);
+
+/** Remove @p pszKey, if present. Takes effect on disk with the next commit. */
+rsRetVal statestoreDelete(statestore_t *pThis, const char *pszKey);
+
+/** Write all changes made so far and sync them to disk. */
+rsRetVal statestoreCommit(statestore_t *pThis);
+
+rsRetVal statestoreClassInit(void);
+void statestoreClassExit(void);
+
+#endif /* #ifndef INCLUDED_STATESTORE_H */
@@ -42,11 +42,13 @@
 #include <string.h>
 #include <assert.h>
 #include <signal.h>
+#include <setjmp.h>
 #include <pthread.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h> /* required for HP UX */
+#include <sys/mman.h>
 #include <errno.h>
 #include <pthread.h>
 #include <poll.h>
@@ -74,6 +76,12 @@
 #ifndef HAVE_LSEEK64
     #define lseek64(fd, offset, whence) lseek(fd, offset, whence)
 #endif
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+    #define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* file data mapped at once in mmap read mode */
+#define STRM_MMAP_WINDOW (1024 * 1024)
 
 /* static data */
 DEFobjStaticHelpers;
@@ -85,10 +93,18 @@ static rsRetVal strmWrite(strm_t *__restrict__ const pThis, const uchar *__restr
 static rsRetVal strmOpenFile(strm_t *pThis);
 static rsRetVal strmCloseFile(strm_t *pThis);
 static void *asyncWriterThread(void *pPtr);
+static void strmFlushTimerCB(void *pUsr);
+static void strmUringKick(strm_t *pThis, sbool bMayBlock);
+static void strmUringFlushNoBlock(strm_t *pThis);
+static void strmUringReap(strm_t *pThis, sbool bMayBlock);
+static void strmUringWaitDone(strm_t *pThis);
+static void strmUringReapNoBlock(strm_t *pThis);
+static void strmUnlockAsync(strm_t *pThis);
 static rsRetVal doZipWrite(strm_t *pThis, uchar *pBuf, size_t lenBuf, int bFlush);
 static rsRetVal doZipFinish(strm_t *pThis);
 static rsRetVal strmPhysWrite(strm_t *pThis, uchar *pBuf, size_t lenBuf);
 static rsRetVal strmSeekCurrOffs(strm_t *pThis);
+static void mmapRelease(strm_t *const pThis);
 
 
 /* methods */
@@ -207,8 +223,49 @@ finalize_it:
 }
 
 
+/* Rotate the current file natively: close it and move it out of the way.
+ * Compression and retention are handled by the rotation thread, and the
+ * next write creates a new file. So rotation costs us a close and a
+ * rename, no matter how large the file is. If the rename fails, we simply
+ * continue to write to the file. tStamp is the time the segment is named
+ * after, see fileRotate().
+ */
+static rsRetVal strmRotate(strm_t *const pThis, const time_t tStamp) {
+    uchar *pszCurrFName = NULL;
+    DEFiRet;
+
+    /* strmCloseFile() destroys the current file name */
+    CHKmalloc(pszCurrFName = ustrdup(pThis->pszCurrFName));
+    CHKiRet(strmCloseFile(pThis));
+    fileRotate(pszCurrFName, tStamp, pThis->rotateCompress, pThis->iRotateKeep);
+
+finalize_it:
+    free(pszCurrFName);
+    RETiRet;
+}
+
+
+/* A file that we are about to open for writing and which was last written
+ * in an earlier rotation period is rotated before we write to it, so that
+ * periods are not mixed if we were not running (or the file was closed)
+ * at the period boundary. Its segment is named after the end of the period
+ * it was last written in, just as if it had been rotated on time.
+ */
+static void strmRotateIfStale(strm_t *const pThis, const time_t tPeriodStart) {
+    struct stat st;
+
+    if (stat((char *)pThis->pszCurrFName, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        st.st_mtime < tPeriodStart) {
+        DBGPRINTF("file '%s' is from an earlier rotation period, rotating it\n", pThis->pszCurrFName);
+        const time_t tPeriodEnd = fileRotatePeriodStart(st.st_mtime, pThis->iRotateInterval) + pThis->iRotateInterval;
+        fileRotate(pThis->pszCurrFName, tPeriodEnd, pThis->rotateCompress, pThis->iRotateKeep);
+    }
+}
+
+
 /* Check if the file has grown beyond the configured omfile iSizeLimit
- * and, if so, initiate processing.
+ * and, if so, initiate processing. With native rotation enabled and no size limit
+ * command, the file is rotated natively.
  */
 static rsRetVal doSizeLimitProcessing(strm_t *pThis) {
     uchar *pszCurrFName = NULL;
@@ -219,6 +276,10 @@ static rsRetVal doSizeLimitProcessing(strm_t *pThis) {
     assert(pThis->fd != -1);
 
     if (pThis->iCurrOffs >= pThis->iSizeLimit) {
+        if (pThis->bRotate && pThis->pszSizeLimitCmd == NULL && !pThis->bAsyncWrite) {
+            CHKiRet(strmRotate(pThis, time(NULL)));
+            FINALIZE;
+        }
         /* strmCloseFile() destroys the current file name, so we
          * need to preserve it.
          */
@@ -239,6 +300,218 @@ finalize_it:
  * strm instance object.
  */
 
+/* Direct I/O support.
+ * With O_DIRECT, writes must start at a block aligned offset and consist of
+ * whole blocks from a block aligned buffer. So data is gathered in an aligned
+ * staging buffer, which always starts with the partial last block of the file
+ * (the "tail"). Whole blocks are written directly. The tail that remains is
+ * written through the page cache, so that the file always has its exact size
+ * and readers see all data. It is written again directly once its block is
+ * complete, which also drops it from the page cache.
+ * As we write at explicit offsets, writes start at iCurrOffs, and the tail is
+ * re-read from the file whenever the stream was positioned elsewhere.
+ */
+#define DIO_ALIGN 4096 /* a multiple of the logical block size of all common devices */
+
+/* preallocate the file up to its maximum size, so that it gets large
+ * contiguous extents even though we bypass the page cache (and thus delayed
+ * allocation). Space beyond EOF is released again when the file is closed.
+ */
+static void dioPreallocate(strm_t *const pThis) {
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+    const int64 limit = (pThis->sType == STREAMTYPE_FILE_CIRCULAR) ? pThis->iMaxFileSize : (int64)pThis->iSizeLimit;
+    if (limit <= pThis->iCurrOffs) return;
+    if (fallocate(pThis->fd, FALLOC_FL_KEEP_SIZE, pThis->iCurrOffs, limit - pThis->iCurrOffs) == 0) {
+        pThis->dio.prealloc = limit;
+    } else {
+        DBGPRINTF("file '%s': fallocate failed with errno %d, not preallocated\n", pThis->pszCurrFName, errno);
+    }
+#else
+    (void)pThis;
+#endif
+}
+
+
+/* release preallocated space beyond EOF. Truncating to the current size
+ * does that on the common file systems.
+ */
+static void dioReleasePrealloc(strm_t *const pThis) {
+    if (pThis->dio.prealloc > pThis->iCurrOffs) {
+        if (ftruncate(pThis->fd, pThis->iCurrOffs) != 0) {
+            DBGPRINTF("file '%s': ftruncate failed with errno %d, preallocated space not released\n",
+                      pThis->pszCurrFName, errno);
+        }
+    }
+    pThis->dio.prealloc = 0;
+}
+
+
+/* switch O_DIRECT on or off for the open file */
+static rsRetVal dioSetDirect(strm_t *const pThis, const int bDirect) {
+    DEFiRet;
+#ifdef O_DIRECT
+    const int flags = bDirect ? pThis->dio.fdFlags : (pThis->dio.fdFlags & ~O_DIRECT);
+    if (fcntl(pThis->fd, F_SETFL, flags) != 0) {
+        LogError(errno, RS_RET_IO_ERROR, "file '%s': cannot %s direct I/O", pThis->pszCurrFName,
+                 bDirect ? "enable" : "disable");
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+finalize_it:
+#else
+    (void)pThis;
+    (void)bDirect;
+#endif
+    RETiRet;
+}
+
+
+/* write all of pBuf at offs */
+static rsRetVal dioWriteAll(strm_t *const pThis, const uchar *pBuf, size_t lenBuf, int64 offs) {
+    ssize_t iWritten;
+    DEFiRet;
+
+    while (lenBuf > 0) {
+        iWritten = pwrite(pThis->fd, pBuf, lenBuf, (off_t)offs);
+        if (iWritten < 0) {
+            if (errno == EINTR) continue;
+            LogError(errno, RS_RET_IO_ERROR,
+                     "file '%s'[%d] write error - see "
+                     "https://www.rsyslog.com/solving-rsyslog-write-errors/ for help "
+                     "OS error",
+                     pThis->pszCurrFName, pThis->fd);
+            ABORT_FINALIZE(RS_RET_IO_ERROR);
+        }
+        pBuf += iWritten;
+        lenBuf -= iWritten;
+        offs += iWritten;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* make the staging buffer start with the partial last block before iCurrOffs */
+static rsRetVal dioLoadTail(strm_t *const pThis) {
+    ssize_t lenRead;
+    DEFiRet;
+
+    pThis->dio.offs = pThis->iCurrOffs & ~(int64)(DIO_ALIGN - 1);
+    pThis->dio.lenTail = pThis->iCurrOffs - pThis->dio.offs;
+    if (pThis->dio.lenTail > 0) {
+        memset(pThis->dio.pBuf, 0, DIO_ALIGN);
+        do {
+            lenRead = pread(pThis->fd, pThis->dio.pBuf, DIO_ALIGN, (off_t)pThis->dio.offs);
+        } while (lenRead < 0 && errno == EINTR);
+        if (lenRead < 0) {
+            LogError(errno, RS_RET_IO_ERROR, "file '%s': cannot read back last block for direct I/O",
+                     pThis->pszCurrFName);
+            ABORT_FINALIZE(RS_RET_IO_ERROR);
+        }
+    }
+    pThis->dio.bValid = 1;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* Direct writes go to explicit offsets, so anything another writer appended
+ * to the file since our last write would be overwritten (and a truncation
+ * would leave a hole). So before each write of a file opened for appending,
+ * we check that its size still is what we wrote. If not, the file is shared
+ * and we switch back to regular appending writes for as long as it is open.
+ */
+static rsRetVal dioCheckOwned(strm_t *const pThis) {
+    struct stat st;
+    DEFiRet;
+
+    if (pThis->tOperationsMode != STREAMMODE_WRITE_APPEND) FINALIZE; /* queue files are always exclusive */
+    if (fstat(pThis->fd, &st) != 0) {
+        LogError(errno, RS_RET_IO_ERROR, "file '%s': cannot stat for direct I/O", pThis->pszCurrFName);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    if (st.st_size == pThis->iCurrOffs) FINALIZE;
+
+#ifdef O_DIRECT
+    if (fcntl(pThis->fd, F_SETFL, (pThis->dio.fdFlags & ~O_DIRECT) | O_APPEND) != 0) {
+        LogError(errno, RS_RET_IO_ERROR, "file '%s': cannot switch from direct I/O to appending writes",
+                 pThis->pszCurrFName);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+#endif
+    if (!pThis->bDirectWarned) {
+        pThis->bDirectWarned = 1;
+        LogMsg(0, RS_RET_OK, LOG_WARNING,
+               "file '%s': size changed from %lld to %lld bytes by another writer, direct I/O is "
+               "disabled for this file and it is written through the page cache",
+               pThis->pszCurrFName, (long long)pThis->iCurrOffs, (long long)st.st_size);
+    }
+    /* we must not truncate a file others write to, so preallocated space is kept */
+    pThis->dio.prealloc = 0;
+    pThis->dio.bValid = 0;
+    pThis->bDirectActive = 0;
+    pThis->iCurrOffs = st.st_size;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* write pBuf at iCurrOffs, see comment above. On error, nothing counts as
+ * written: as we write at explicit offsets, a retry simply rewrites the
+ * same data.
+ */
+static rsRetVal ATTR_NONNULL() doDirectWrite(strm_t *const pThis, const uchar *const pBuf, size_t *const pLenBuf) {
+    const size_t lenBuf = *pLenBuf;
+    size_t lenDone = 0;
+    DEFiRet;
+
+    if (pThis->dio.pBuf == NULL) {
+        /* one extra block, as the buffer starts with the tail */
+        pThis->dio.sizeBuf = ((pThis->sIOBufSize + DIO_ALIGN - 1) & ~(size_t)(DIO_ALIGN - 1)) + DIO_ALIGN;
+        if (posix_memalign((void **)&pThis->dio.pBuf, DIO_ALIGN, pThis->dio.sizeBuf) != 0) {
+            pThis->dio.pBuf = NULL;
+            ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+        }
+        pThis->dio.bValid = 0;
+    }
+    if (!pThis->dio.bValid || pThis->dio.offs + (int64)pThis->dio.lenTail != pThis->iCurrOffs) {
+        CHKiRet(dioLoadTail(pThis));
+    }
+
+    while (lenDone < lenBuf) {
+        size_t len = pThis->dio.sizeBuf - pThis->dio.lenTail;
+        if (len > lenBuf - lenDone) len = lenBuf - lenDone;
+        memcpy(pThis->dio.pBuf + pThis->dio.lenTail, pBuf + lenDone, len);
+        pThis->dio.lenTail += len;
+        lenDone += len;
+
+        const size_t lenBlocks = pThis->dio.lenTail & ~(size_t)(DIO_ALIGN - 1);
+        if (lenBlocks > 0) {
+            CHKiRet(dioWriteAll(pThis, pThis->dio.pBuf, lenBlocks, pThis->dio.offs));
+            pThis->dio.lenTail -= lenBlocks;
+            memmove(pThis->dio.pBuf, pThis->dio.pBuf + lenBlocks, pThis->dio.lenTail);
+            pThis->dio.offs += lenBlocks;
+        }
+    }
+
+    if (pThis->dio.lenTail > 0) {
+        CHKiRet(dioSetDirect(pThis, 0));
+        const rsRetVal localRet = dioWriteAll(pThis, pThis->dio.pBuf, pThis->dio.lenTail, pThis->dio.offs);
+        CHKiRet(dioSetDirect(pThis, 1));
+        CHKiRet(localRet);
+    }
+
+finalize_it:
+    if (iRet != RS_RET_OK) {
+        pThis->dio.bValid = 0;
+        *pLenBuf = 0;
+    }
+    RETiRet;
+}
+
+
 /* do the physical open() call on a file.
  */
 static rsRetVal doPhysOpen(strm_t *pThis) {
@@ -270,9 +543,43 @@ static rsRetVal doPhysOpen(strm_t *pThis) {
         DBGPRINTF("Note: stream '%s' is a named pipe, open with O_NONBLOCK\n", pThis->pszCurrFName);
         iFlags |= O_NONBLOCK;
     }
+#ifdef O_DIRECT
+    /* direct writes go to explicit offsets, and the partial last block needs
+     * to be read back after a reopen, so there is no O_APPEND and we need
+     * read access.
+     */
+    const int iDirectFlags = (iFlags & ~(O_WRONLY | O_APPEND)) | O_RDWR | O_DIRECT;
+    const sbool bTryDirect =
+        pThis->bDirectIO && pThis->tOperationsMode != STREAMMODE_READ && pThis->sType != STREAMTYPE_NAMED_PIPE;
+#endif
 
     if (pThis->bAsyncWrite) d_pthread_mutex_lock(&pThis->mut);
-    pThis->fd = open((char *)pThis->pszCurrFName, iFlags | O_LARGEFILE, pThis->tOpenMode);
+    pThis->bDirectActive = 0;
+    pThis->dio.bValid = 0;
+    pThis->dio.prealloc = 0;
+#ifdef O_DIRECT
+    if (bTryDirect) {
+        pThis->fd = open((char *)pThis->pszCurrFName, iDirectFlags | O_LARGEFILE, pThis->tOpenMode);
+        if (pThis->fd != -1) {
+            pThis->bDirectActive = 1;
+            pThis->dio.fdFlags = iDirectFlags;
+        } else if (errno == EINVAL || errno == EACCES || errno == EPERM || errno == EOPNOTSUPP) {
+            /* EINVAL: the file system does not support O_DIRECT. The others are reported
+             * by some file systems and security modules, or because we lack the read
+             * permission only the direct mode needs.
+             */
+            if (!pThis->bDirectWarned) {
+                pThis->bDirectWarned = 1;
+                LogMsg(errno, RS_RET_OK, LOG_WARNING,
+                       "file '%s': cannot open for direct I/O, direct I/O is disabled for this file "
+                       "and it is written through the page cache",
+                       pThis->pszCurrFName);
+            }
+            pThis->fd = open((char *)pThis->pszCurrFName, iFlags | O_LARGEFILE, pThis->tOpenMode);
+        }
+    } else
+#endif
+        pThis->fd = open((char *)pThis->pszCurrFName, iFlags | O_LARGEFILE, pThis->tOpenMode);
     if (pThis->bAsyncWrite) d_pthread_mutex_unlock(&pThis->mut);
 
     const int errno_save = errno; /* dbgprintf can mangle it! */
@@ -303,6 +610,7 @@ static rsRetVal doPhysOpen(strm_t *pThis) {
     if (!ustrcmp(pThis->pszCurrFName, UCHAR_CONSTANT(_PATH_CONSOLE)) || isatty(pThis->fd)) {
         DBGPRINTF("file %d is a tty-type file\n", pThis->fd);
         pThis->bIsTTY = 1;
+        pThis->bDirectActive = 0;
     } else {
         pThis->bIsTTY = 0;
     }
@@ -380,10 +688,20 @@ static rsRetVal strmOpenFile(strm_t *pThis) {
 
     CHKiRet(strmSetCurrFName(pThis));
 
+    if (pThis->iRotateInterval != 0 && pThis->tOperationsMode != STREAMMODE_READ) {
+        const time_t tPeriodStart = fileRotatePeriodStart(time(NULL), pThis->iRotateInterval);
+        strmRotateIfStale(pThis, tPeriodStart);
+        pThis->tRotateNext = tPeriodStart + pThis->iRotateInterval;
+    }
+
     CHKiRet(doPhysOpen(pThis));
 
     pThis->iCurrOffs = 0;
     pThis->iBufPtrMax = 0;
+    if (pThis->bMmap) {
+        struct stat statBuf;
+        pThis->map.bActive = fstat(pThis->fd, &statBuf) == 0 && S_ISREG(statBuf.st_mode);
+    }
     CHKiRet(getFileSize(pThis->pszCurrFName, &offset));
     if (pThis->tOperationsMode == STREAMMODE_WRITE_APPEND) {
         pThis->iCurrOffs = offset;
@@ -396,6 +714,10 @@ static rsRetVal strmOpenFile(strm_t *pThis) {
         }
     }
 
+    if (pThis->bDirectActive) {
+        dioPreallocate(pThis);
+    }
+
     DBGOPRINT((obj_t *)pThis, "opened file '%s' for %s as %d\n", pThis->pszCurrFName,
               (pThis->tOperationsMode == STREAMMODE_READ) ? "READ" : "WRITE", pThis->fd);
 
@@ -424,6 +746,14 @@ static void strmWaitAsyncWriterDone(strm_t *pThis) {
     if (pThis->bAsyncWrite) {
         /* awake writer thread and make it write out everything */
         while (pThis->iCnt > 0) {
+            if (pThis->bUringWriter) {
+                if (pThis->bUringBusy) {
+                    strmUringWaitDone(pThis);
+                } else {
+                    strmUringKick(pThis, 1);
+                }
+                continue;
+            }
             pthread_cond_signal(&pThis->notEmpty);
             d_pthread_cond_wait(&pThis->isEmpty, &pThis->mut);
         }
@@ -434,10 +764,20 @@ static void strmWaitAsyncWriterDone(strm_t *pThis) {
  * is called!). Note that the mutex must be locked! -- rgerhards, 2009-07-06
  */
 static void stopWriter(strm_t *const pThis) {
-    pThis->bStopWriter = 1;
-    pthread_cond_signal(&pThis->notEmpty);
-    d_pthread_mutex_unlock(&pThis->mut);
-    pthread_join(pThis->writerThreadID, NULL);
+    if (pThis->bUringWriter) {
+        /* there is no thread, we just need to wait until the ring is done with us */
+        strmWaitAsyncWriterDone(pThis);
+        pthread_mutex_lock(&pThis->mutUringDone);
+        while (pThis->bUringCbActive) pthread_cond_wait(&pThis->uringDone, &pThis->mutUringDone);
+        pthread_mutex_unlock(&pThis->mutUringDone);
+        d_pthread_mutex_unlock(&pThis->mut);
+    } else {
+        pThis->bStopWriter = 1;
+        pthread_cond_signal(&pThis->notEmpty);
+        d_pthread_mutex_unlock(&pThis->mut);
+        pthread_join(pThis->writerThreadID, NULL);
+    }
+    timerwheelCancelSync(&pThis->flushTimer);
 }
 
 
@@ -484,12 +824,22 @@ static rsRetVal strmCloseFile(strm_t *pThis) {
         }
     }
 
+    mmapRelease(pThis);
+    pThis->map.lenTail = 0;
+
     /* the file may already be closed (or never have opened), so guard
      * against this. -- rgerhards, 2010-03-19
      */
     if (pThis->fd != -1) {
         DBGOPRINT((obj_t *)pThis, "file %d(%s) closing\n", pThis->fd, getFileDebugName(pThis));
-        currOffs = lseek64(pThis->fd, 0, SEEK_CUR);
+        if (pThis->bDirectActive) {
+            /* direct writes do not move the file position */
+            currOffs = pThis->iCurrOffs;
+            dioReleasePrealloc(pThis);
+            pThis->bDirectActive = 0;
+        } else {
+            currOffs = lseek64(pThis->fd, 0, SEEK_CUR);
+        }
         close(pThis->fd);
         pThis->fd = -1;
         pThis->inode = 0;
@@ -655,6 +1005,213 @@ finalize_it:
 }
 
 
+/* mmap read mode
+ * Regular files may be read through a memory mapping instead of read() into
+ * pIOBuf. pIOBuf then points into a window of up to STRM_MMAP_WINDOW bytes of
+ * the mapped file, so the line readers scan the page cache directly and copy
+ * each record only once, into its string. The fd position is kept at the end
+ * of the window, so seeking and reopening work just as in read() mode.
+ *
+ * Accessing a mapped page that is no longer backed by the file (because the
+ * file was truncated meanwhile, e.g. by "copytruncate" rotation) raises
+ * SIGBUS. Each access to a window is therefore guarded: a sigsetjmp() point
+ * is set in the accessing function and the window is registered for the
+ * thread. For a fault inside it, strmSigbusHandler() does nothing but
+ * siglongjmp() back, where the access is abandoned and mmapFaulted is set.
+ * The line readers then discard the record that was being read and continue
+ * at its start, where they will see the new, shorter file. Bytes past the
+ * new end of file within its last page read as zeros without a fault;
+ * mmapReadBuf() warns if it finds the file shorter than what was already read.
+ *
+ * Signal dispositions belong to the application, so the handler is installed
+ * by rsyslogd. If it is not, mmap read mode is not used. Input threads run
+ * with SIGBUS blocked, and a blocked synchronous SIGBUS terminates the
+ * process, so a thread unblocks it before it first accesses a window.
+ */
+static pthread_once_t mmapInitOnce = PTHREAD_ONCE_INIT;
+static size_t mmapPageSize;
+static __thread sigjmp_buf mmapJmp; /* recovery point of the current guarded access */
+static __thread const uchar *volatile mmapGuardStart; /* window guarded on this thread, NULL if none */
+static __thread volatile size_t mmapGuardLen;
+static __thread sbool mmapFaulted; /* a page of the window was lost */
+static __thread sbool mmapSigbusUnblocked;
+
+void strmSigbusHandler(int sig, siginfo_t *si, void __attribute__((unused)) * ctx) {
+    const uchar *const addr = (const uchar *)si->si_addr;
+
+    if (mmapGuardStart != NULL && addr >= mmapGuardStart && addr < mmapGuardStart + mmapGuardLen) {
+        mmapGuardStart = NULL;
+        siglongjmp(mmapJmp, 1);
+    }
+    /* not ours: re-executing the faulting access now terminates us, as it would have without the handler */
+    signal(sig, SIG_DFL);
+}
+
+static void mmapInit(void) {
+    mmapPageSize = (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/* is the SIGBUS handler in place, i.e. can mmap read mode be used? */
+static int mmapHandlerInstalled(void) {
+    struct sigaction sigAct;
+
+    return sigaction(SIGBUS, NULL, &sigAct) == 0 && (sigAct.sa_flags & SA_SIGINFO) &&
+           sigAct.sa_sigaction == strmSigbusHandler;
+}
+
+/* register the current window of pThis as guarded for this thread. Must be
+ * called right after the sigsetjmp() of the access it guards.
+ */
+static void mmapGuard(const strm_t *const pThis) {
+    sigset_t sigSet;
+
+    if (!mmapSigbusUnblocked) {
+        sigemptyset(&sigSet);
+        sigaddset(&sigSet, SIGBUS);
+        pthread_sigmask(SIG_UNBLOCK, &sigSet, NULL);
+        mmapSigbusUnblocked = 1;
+    }
+    mmapGuardLen = pThis->map.len;
+    mmapGuardStart = pThis->map.pBase;
+}
+
+static void mmapUnguard(void) {
+    mmapGuardStart = NULL;
+}
+
+/* called where the guarded access jumped back to after a lost page */
+static rsRetVal mmapLostPage(void) {
+    mmapUnguard();
+    mmapFaulted = 1;
+    return RS_RET_FILE_TRUNCATED;
+}
+
+/* drop the current window, if any */
+static void mmapRelease(strm_t *const pThis) {
+    if (pThis->map.pBase == NULL) return;
+    if (mmapGuardStart == pThis->map.pBase) {
+        mmapUnguard();
+    }
+    munmap(pThis->map.pBase, pThis->map.len);
+    pThis->map.pBase = NULL;
+    pThis->map.len = 0;
+    pThis->pIOBuf = pThis->map.pIOBuf;
+    pThis->iBufPtr = pThis->iBufPtrMax = 0;
+}
+
+/* Handle a lost page (see above) at the end of a line read. The record that
+ * began at offset offs is discarded (the caller destructs what it holds) and
+ * reading continues there.
+ */
+static void mmapHandleFault(strm_t *const pThis, const int64 offs) {
+    mmapFaulted = 0;
+    LogMsg(0, RS_RET_FILE_TRUNCATED, LOG_WARNING,
+           "file '%s': truncated while being read - discarding partial record "
+           "at offset %lld",
+           pThis->pszCurrFName, (long long)offs);
+    mmapRelease(pThis);
+    if (pThis->prevLineSegment != NULL) {
+        cstrDestruct(&pThis->prevLineSegment);
+    }
+    pThis->iUngetC = -1;
+    pThis->iCurrOffs = offs;
+    if (pThis->fd != -1 && lseek64(pThis->fd, offs, SEEK_SET) != offs) {
+        /* the next read then detects the truncation (if enabled) or sees EOF */
+        DBGPRINTF("file '%s': could not seek to %lld after lost page\n", pThis->pszCurrFName, (long long)offs);
+    }
+}
+
+/* mmap read mode equivalent of read() plus checkTruncation(): map the next
+ * window of the file. *pLenRead receives the number of bytes available in
+ * pIOBuf, 0 at EOF. If the file cannot be mapped, mmap read mode is switched
+ * off for it and read() is used instead (*pLenRead is then -1).
+ * Truncation is detected by the file being shorter than our position or by
+ * a change of the tail of the previous window, which is kept in the regular
+ * read buffer for that purpose (the read() path compares the whole previous
+ * buffer, which is the same size).
+ */
+static rsRetVal ATTR_NONNULL() mmapReadBuf(strm_t *const pThis, long *const pLenRead) {
+    struct stat statBuf;
+    const sbool bHadWindow = (pThis->map.pBase != NULL);
+    DEFiRet;
+
+    if (bHadWindow && pThis->bReopenOnTruncate) {
+        const size_t lenTail = (pThis->iBufPtrMax < pThis->sIOBufSize) ? pThis->iBufPtrMax : pThis->sIOBufSize;
+        if (sigsetjmp(mmapJmp, 0) != 0) {
+            /* the data we just read is gone, so the file has been truncated */
+            mmapUnguard();
+            ABORT_FINALIZE(rereadTruncated(pThis, 0, "last block no longer mapped", 0));
+        }
+        mmapGuard(pThis);
+        memcpy(pThis->map.pIOBuf, pThis->pIOBuf + pThis->iBufPtrMax - lenTail, lenTail);
+        mmapUnguard();
+        pThis->map.lenTail = lenTail;
+        pThis->map.offsTail = pThis->map.offs + pThis->iBufPtrMax - lenTail;
+    }
+    mmapRelease(pThis);
+
+    const off64_t offs = lseek64(pThis->fd, 0, SEEK_CUR);
+    if (offs < 0 || fstat(pThis->fd, &statBuf) != 0) {
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+
+    if (bHadWindow && statBuf.st_size < offs) {
+        /* bytes past the new end in the last partially used page read as zeros without a SIGBUS */
+        LogMsg(0, RS_RET_FILE_TRUNCATED, LOG_WARNING,
+               "file '%s': truncated to %lld bytes while being read - data read "
+               "after this offset may contain NUL bytes",
+               pThis->pszCurrFName, (long long)statBuf.st_size);
+    }
+    if (pThis->bReopenOnTruncate) {
+        if (statBuf.st_size < offs) {
+            ABORT_FINALIZE(rereadTruncated(pThis, 0, "file is shorter than read position", (long long)offs));
+        }
+        if (pThis->map.lenTail > 0) {
+            const ssize_t lenRead =
+                pread(pThis->fd, pThis->pIOBuf_truncation, pThis->map.lenTail, (off_t)pThis->map.offsTail);
+            if (lenRead != (ssize_t)pThis->map.lenTail) {
+                ABORT_FINALIZE(rereadTruncated(pThis, errno, "last block could not be re-read", lenRead));
+            }
+            if (memcmp(pThis->pIOBuf_truncation, pThis->map.pIOBuf, pThis->map.lenTail)) {
+                ABORT_FINALIZE(rereadTruncated(pThis, 0, "last block data different", 0));
+            }
+        }
+    }
+
+    if (statBuf.st_size <= offs) {
+        *pLenRead = 0;
+        FINALIZE;
+    }
+
+    const off64_t offsMap = offs & ~(off64_t)(mmapPageSize - 1);
+    const size_t lenData = (statBuf.st_size - offs > STRM_MMAP_WINDOW) ? STRM_MMAP_WINDOW
+                                                                      : (size_t)(statBuf.st_size - offs);
+    const size_t lenMap = (size_t)(offs - offsMap) + lenData;
+    void *const pBase = mmap(NULL, lenMap, PROT_READ, MAP_SHARED, pThis->fd, (off_t)offsMap);
+    if (pBase == MAP_FAILED) {
+        DBGPRINTF("file '%s': mmap failed with errno %d, using read()\n", pThis->pszCurrFName, errno);
+        pThis->map.bActive = 0;
+        *pLenRead = -1;
+        FINALIZE;
+    }
+    if (lseek64(pThis->fd, offs + lenData, SEEK_SET) < 0) {
+        munmap(pBase, lenMap);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(pBase, lenMap, MADV_SEQUENTIAL);
+#endif
+    pThis->map.pBase = pBase;
+    pThis->map.len = lenMap;
+    pThis->map.offs = offs;
+    pThis->pIOBuf = pThis->map.pBase + (offs - offsMap);
+    *pLenRead = (long)lenData;
+
+finalize_it:
+    RETiRet;
+}
+
+
 /* read the next buffer from disk
  * rgerhards, 2008-02-13
  */
@@ -685,14 +1242,24 @@ static rsRetVal strmReadBuf(strm_t *pThis, int *padBytes) {
                 toRead = (size_t)bytesLeft;
             }
         }
-        if (pThis->bReopenOnTruncate) {
-            rsRetVal localRet = checkTruncation(pThis);
+        iLenRead = -1;
+        if (pThis->map.bActive) {
+            rsRetVal localRet = mmapReadBuf(pThis, &iLenRead);
             if (localRet == RS_RET_FILE_TRUNCATED) {
                 continue;
             }
             CHKiRet(localRet);
         }
-        iLenRead = read(pThis->fd, pThis->pIOBuf, toRead);
+        if (iLenRead == -1) {
+            if (pThis->bReopenOnTruncate) {
+                rsRetVal localRet = checkTruncation(pThis);
+                if (localRet == RS_RET_FILE_TRUNCATED) {
+                    continue;
+                }
+                CHKiRet(localRet);
+            }
+            iLenRead = read(pThis->fd, pThis->pIOBuf, toRead);
+        }
         DBGOPRINT((obj_t *)pThis, "file %d read %ld bytes\n", pThis->fd, iLenRead);
         DBGOPRINT((obj_t *)pThis, "file %d read %*s\n", pThis->fd, (unsigned)iLenRead, (char *)pThis->pIOBuf);
         /* end crypto */
@@ -766,7 +1333,16 @@ static rsRetVal strmReadChar(strm_t *pThis, uchar *pC) {
 
     /* if we reach this point, we have data available in the buffer */
 
-    *pC = pThis->pIOBuf[pThis->iBufPtr++];
+    if (pThis->map.pBase != NULL) {
+        if (sigsetjmp(mmapJmp, 0) != 0) {
+            ABORT_FINALIZE(mmapLostPage());
+        }
+        mmapGuard(pThis);
+        *pC = pThis->pIOBuf[pThis->iBufPtr++];
+        mmapUnguard();
+    } else {
+        *pC = pThis->pIOBuf[pThis->iBufPtr++];
+    }
     ++pThis->iCurrOffs; /* one more octet read */
 
 finalize_it:
@@ -790,6 +1366,61 @@ static rsRetVal strmUnreadChar(strm_t *pThis, uchar c) {
     return RS_RET_OK;
 }
 
+/* helper to strmAppendUntilLF(): append the characters in the read buffer up
+ * to, but not including, the next LF. A window of a mapped file is accessed
+ * guarded; the sigsetjmp() point must be in the function doing the access,
+ * so it is kept in this small one.
+ */
+static rsRetVal ATTR_NONNULL() strmAppendSpanUntilLF(strm_t *const pThis, cstr_t *const pStr) {
+    const uchar *const pStart = pThis->pIOBuf + pThis->iBufPtr;
+    const size_t avail = pThis->iBufPtrMax - pThis->iBufPtr;
+    const uchar *pLF;
+    size_t len;
+    rsRetVal localRet;
+
+    if (pThis->map.pBase != NULL) {
+        if (sigsetjmp(mmapJmp, 0) != 0) {
+            return mmapLostPage();
+        }
+        mmapGuard(pThis);
+    }
+    pLF = memchr(pStart, '\n', avail);
+    len = (pLF == NULL) ? avail : (size_t)(pLF - pStart);
+    localRet = (len > 0) ? rsCStrAppendStrWithLen(pStr, pStart, len) : RS_RET_OK;
+    mmapUnguard();
+    if (localRet == RS_RET_OK) {
+        pThis->iBufPtr += len;
+        pThis->iCurrOffs += len;
+    }
+    return localRet;
+}
+
+/* Append c and all following characters up to, but not including, the next
+ * LF to pStr. This is the same as
+ *     while(c != '\n') { cstrAppendChar(pStr, c); strmReadChar(pThis, &c); }
+ * but the read buffer is scanned with memchr(), which is vectorized by the
+ * C library, and whole spans are appended at once. On return, the LF has
+ * been read and is in *pC. On error (most importantly EOF), everything read
+ * so far has been appended, exactly as the loop would have done.
+ */
+static rsRetVal ATTR_NONNULL() strmAppendUntilLF(strm_t *const pThis, cstr_t *const pStr, uchar *const pC) {
+    uchar c = *pC;
+    DEFiRet;
+
+    while (c != '\n') {
+        CHKiRet(cstrAppendChar(pStr, c));
+        if (pThis->iUngetC == -1 && pThis->iBufPtr < pThis->iBufPtrMax) {
+            CHKiRet(strmAppendSpanUntilLF(pThis, pStr));
+        }
+        CHKiRet(strmReadChar(pThis, &c));
+    }
+
+finalize_it:
+    *pC = c;
+    RETiRet;
+}
+
+
 /* read a 'paragraph' from a strm file.
  * A paragraph may be terminated by a LF, by a LFLF, or by LF<not whitespace> depending on the option set.
  * The termination LF characters are read, but are
@@ -828,10 +1459,7 @@ static rsRetVal ATTR_NONNULL(1, 2) strmReadLine(strm_t *const pThis,
         cstrDestruct(&pThis->prevLineSegment);
     }
     if (mode == 0) {
-        while (c != '\n') {
-            CHKiRet(cstrAppendChar(*ppCStr, c));
-            CHKiRet(strmReadChar(pThis, &c));
-        }
+        CHKiRet(strmAppendUntilLF(pThis, *ppCStr, &c));
         if (trimLineOverBytes > 0 && (uint32_t)cstrLen(*ppCStr) > trimLineOverBytes) {
             /* Truncate long line at trimLineOverBytes position */
             dbgprintf("Truncate long line at %u, mode %d\n", trimLineOverBytes, mode);
@@ -843,9 +1471,8 @@ static rsRetVal ATTR_NONNULL(1, 2) strmReadLine(strm_t *const pThis,
         finished = 0;
         while (finished == 0) {
             if (c != '\n') {
-                CHKiRet(cstrAppendChar(*ppCStr, c));
-                CHKiRet(strmReadChar(pThis, &c));
                 pThis->bPrevWasNL = 0;
+                CHKiRet(strmAppendUntilLF(pThis, *ppCStr, &c));
             } else {
                 if ((((*ppCStr)->iStrLen) > 0)) {
                     if (pThis->bPrevWasNL && escapeLFString_len > 0) {
@@ -915,10 +1542,10 @@ static rsRetVal ATTR_NONNULL(1, 2) strmReadLine(strm_t *const pThis,
                         } else {
                             CHKiRet(cstrAppendChar(*ppCStr, c));
                         }
+                        CHKiRet(strmReadChar(pThis, &c));
                     } else {
-                        CHKiRet(cstrAppendChar(*ppCStr, c));
+                        CHKiRet(strmAppendUntilLF(pThis, *ppCStr, &c));
                     }
-                    CHKiRet(strmReadChar(pThis, &c));
                 }
             }
         }
@@ -933,6 +1560,13 @@ static rsRetVal ATTR_NONNULL(1, 2) strmReadLine(strm_t *const pThis,
     }
 
 finalize_it:
+    if (mmapFaulted) {
+        mmapHandleFault(pThis, pThis->strtOffs);
+        if (*ppCStr != NULL) {
+            cstrDestruct(ppCStr);
+        }
+        iRet = RS_RET_EOF;
+    }
     if (iRet == RS_RET_OK) {
         if (strtOffs != NULL) {
             *strtOffs = pThis->strtOffs;
@@ -993,9 +1627,11 @@ rsRetVal ATTR_NONNULL(1, 2) strmReadMultiLine(strm_t *pThis,
     rsRetVal readCharRet;
     const time_t tCurr = pThis->readTimeout ? getTime(NULL) : 0;
     size_t maxMsgSize = glblGetMaxLine(runConf);
+    int64 lineStrtOffs = 0;
     DEFiRet;
 
     do {
+        lineStrtOffs = pThis->iCurrOffs - ((pThis->prevLineSegment == NULL) ? 0 : cstrLen(pThis->prevLineSegment));
         CHKiRet(strmReadChar(pThis, &c)); /* immediately exit on EOF */
         pThis->lastRead = tCurr;
         CHKiRet(cstrConstruct(&thisLine));
@@ -1005,14 +1641,11 @@ rsRetVal ATTR_NONNULL(1, 2) strmReadMultiLine(strm_t *pThis,
             cstrDestruct(&pThis->prevLineSegment);
         }
 
-        while (c != '\n') {
-            CHKiRet(cstrAppendChar(thisLine, c));
-            readCharRet = strmReadChar(pThis, &c);
-            if (readCharRet == RS_RET_EOF) { /* end of file reached without \n? */
-                CHKiRet(rsCStrConstructFromCStr(&pThis->prevLineSegment, thisLine));
-            }
-            CHKiRet(readCharRet);
+        readCharRet = strmAppendUntilLF(pThis, thisLine, &c);
+        if (readCharRet == RS_RET_EOF) { /* end of file reached without \n? */
+            CHKiRet(rsCStrConstructFromCStr(&pThis->prevLineSegment, thisLine));
         }
+        CHKiRet(readCharRet);
         cstrFinalize(thisLine);
 
         /* we have a line, now let's assemble the message */
@@ -1108,6 +1741,11 @@ rsRetVal ATTR_NONNULL(1, 2) strmReadMultiLine(strm_t *pThis,
     } while (finished == 0);
 
 finalize_it:
+    if (mmapFaulted) {
+        /* only this line can contain lost data, prior lines of the message are kept */
+        mmapHandleFault(pThis, lineStrtOffs);
+        iRet = RS_RET_EOF;
+    }
     *strtOffs = pThis->strtOffs;
     if (thisLine != NULL) {
         cstrDestruct(&thisLine);
@@ -1136,6 +1774,7 @@ BEGINobjConstruct(strm) /* be sure to specify the object type also in END macro!
     pThis->iCurrFNum = 1;
     pThis->fd = -1;
     pThis->fdDir = -1;
+    pThis->zstd.fdIdx = -1;
     pThis->iUngetC = -1;
     pThis->bVeryReliableZip = 0;
     pThis->sType = STREAMTYPE_FILE_SINGLE;
@@ -1166,6 +1805,11 @@ static rsRetVal strmConstructFinalize(strm_t *pThis) {
     assert(pThis != NULL);
 
     pThis->iBufPtrMax = 0; /* results in immediate read request */
+    if (pThis->bMmap && (pThis->tOperationsMode != STREAMMODE_READ || pThis->cryprov != NULL)) {
+        DBGPRINTF("file stream %s: mmap read mode needs an unencrypted file opened for reading - "
+                  "not used\n", getFileDebugName(pThis));
+        pThis->bMmap = 0;
+    }
     if (pThis->iZipLevel) { /* do we need a zip buf? */
         if (pThis->compressionDriver == STRM_COMPRESS_ZSTD) {
             localRet = objUse(zstdw, LM_ZSTDW_FILENAME);
@@ -1211,6 +1855,15 @@ static rsRetVal strmConstructFinalize(strm_t *pThis) {
         pThis->bAsyncWrite = 1;
     }
 
+    if (pThis->tOperationsMode != STREAMMODE_READ && !pThis->bDirectIO && iouringEnabled()) {
+        pThis->bIoUring = 1;
+        /* the ring writes the buffers as they are, so zip, crypto and file
+         * rotation still need the writer thread
+         */
+        pThis->bUringWriter = pThis->bAsyncWrite && pThis->iZipLevel == 0 && pThis->cryprov == NULL &&
+                              pThis->sType != STREAMTYPE_FILE_CIRCULAR;
+    }
+
     DBGPRINTF("file stream %s params: flush interval %d, async write %d\n", getFileDebugName(pThis),
               pThis->iFlushInterval, pThis->bAsyncWrite);
 
@@ -1225,18 +1878,35 @@ static rsRetVal strmConstructFinalize(strm_t *pThis) {
         pthread_cond_init(&pThis->notFull, 0);
         pthread_cond_init(&pThis->notEmpty, 0);
         pthread_cond_init(&pThis->isEmpty, 0);
+        pthread_mutex_init(&pThis->mutUringDone, NULL);
+        pthread_cond_init(&pThis->uringDone, 0);
+        pThis->bUringDone = 0;
+        pThis->bUringCbActive = 0;
         pThis->iCnt = pThis->iEnq = pThis->iDeq = 0;
         for (i = 0; i < STREAM_ASYNC_NUMBUFS; ++i) {
             CHKmalloc(pThis->asyncBuf[i].pBuf = (uchar *)malloc(pThis->sIOBufSize));
         }
         pThis->pIOBuf = pThis->asyncBuf[0].pBuf;
         pThis->bStopWriter = 0;
-        if (pthread_create(&pThis->writerThreadID, &default_thread_attr, asyncWriterThread, pThis) != 0)
+        timerwheelTimerInit(&pThis->flushTimer, strmFlushTimerCB, pThis);
+        if (pThis->bUringWriter) {
+            DBGPRINTF("file stream %s: async writes via io_uring\n", getFileDebugName(pThis));
+        } else if (pthread_create(&pThis->writerThreadID, &default_thread_attr, asyncWriterThread, pThis) != 0) {
             DBGPRINTF("ERROR: stream %p cold not create writer thread\n", pThis);
+        }
     } else {
         /* we work synchronously, so we need to alloc a fixed pIOBuf */
         CHKmalloc(pThis->pIOBuf = (uchar *)malloc(pThis->sIOBufSize));
         CHKmalloc(pThis->pIOBuf_truncation = (char *)malloc(pThis->sIOBufSize));
+        pThis->map.pIOBuf = pThis->pIOBuf;
+        if (pThis->bMmap) {
+            pthread_once(&mmapInitOnce, mmapInit);
+            if (!mmapHandlerInstalled()) {
+                DBGPRINTF("file stream %s: no SIGBUS handler installed - mmap read mode not used\n",
+                          getFileDebugName(pThis));
+                pThis->bMmap = 0;
+            }
+        }
     }
 
 finalize_it:
@@ -1258,10 +1928,13 @@ BEGINobjDestruct(strm) /* be sure to specify the object type also in END and COD
     strmCloseFile(pThis);
 
     if (pThis->bAsyncWrite) {
+        timerwheelCancelSync(&pThis->flushTimer);
         pthread_mutex_destroy(&pThis->mut);
         pthread_cond_destroy(&pThis->notFull);
         pthread_cond_destroy(&pThis->notEmpty);
         pthread_cond_destroy(&pThis->isEmpty);
+        pthread_mutex_destroy(&pThis->mutUringDone);
+        pthread_cond_destroy(&pThis->uringDone);
         for (i = 0; i < STREAM_ASYNC_NUMBUFS; ++i) {
             free(pThis->asyncBuf[i].pBuf);
         }
@@ -1281,6 +1954,7 @@ BEGINobjDestruct(strm) /* be sure to specify the object type also in END and COD
     if (pThis->prevMsgSegment) cstrDestruct(&pThis->prevMsgSegment);
     free(pThis->pszDir);
     free(pThis->pZipBuf);
+    free(pThis->dio.pBuf);
     free(pThis->pszCurrFName);
     free(pThis->pszFName);
     free(pThis->pszSizeLimitCmd);
@@ -1455,6 +2129,20 @@ finalize_it:
 }
 
 
+/* hand the current buffer with lenBuf bytes over to the async writer and switch
+ * to the next free one. Must be called with the mutex locked and a free buffer.
+ */
+static void strmAsyncBufQueue(strm_t *const pThis, const size_t lenBuf, const int bFlushZip) {
+    pThis->asyncBuf[pThis->iEnq % STREAM_ASYNC_NUMBUFS].lenBuf = lenBuf;
+    pThis->pIOBuf = pThis->asyncBuf[++pThis->iEnq % STREAM_ASYNC_NUMBUFS].pBuf;
+    if (!pThis->bFlushNow) /* if we already need to flush, do not overwrite */
+        pThis->bFlushNow = bFlushZip;
+
+    pThis->bDoTimedWait = 0; /* everything written, no need to timeout partial buffer writes */
+    ++pThis->iCnt;
+}
+
+
 /* This function is called to "do" an async write call, what primarily means that
  * the data is handed over to the writer thread (which will then do the actual write
  * in parallel). Note that the stream mutex has already been locked by the
@@ -1472,15 +2160,22 @@ static rsRetVal doAsyncWriteInternal(strm_t *pThis, size_t lenBuf, const int bFl
               "iCnt %d, iEnq %d, bFlushZip %d\n",
               pThis->fd, getFileDebugName(pThis), pThis->iCnt, pThis->iEnq, bFlushZip);
     /* the -1 below is important, because we need one buffer for the main thread! */
-    while (pThis->iCnt >= STREAM_ASYNC_NUMBUFS - 1) d_pthread_cond_wait(&pThis->notFull, &pThis->mut);
-
-    pThis->asyncBuf[pThis->iEnq % STREAM_ASYNC_NUMBUFS].lenBuf = lenBuf;
-    pThis->pIOBuf = pThis->asyncBuf[++pThis->iEnq % STREAM_ASYNC_NUMBUFS].pBuf;
-    if (!pThis->bFlushNow) /* if we already need to flush, do not overwrite */
-        pThis->bFlushNow = bFlushZip;
+    while (pThis->iCnt >= STREAM_ASYNC_NUMBUFS - 1) {
+        if (pThis->bUringWriter) {
+            if (pThis->bUringBusy) {
+                strmUringWaitDone(pThis);
+            } else {
+                strmUringKick(pThis, 1);
+            }
+        } else {
+            d_pthread_cond_wait(&pThis->notFull, &pThis->mut);
+        }
+    }
 
-    pThis->bDoTimedWait = 0; /* everything written, no need to timeout partial buffer writes */
-    if (++pThis->iCnt == 1) {
+    strmAsyncBufQueue(pThis, lenBuf, bFlushZip);
+    if (pThis->bUringWriter) {
+        strmUringKick(pThis, 1);
+    } else if (pThis->iCnt == 1) {
         pthread_cond_signal(&pThis->notEmpty);
         DBGOPRINT((obj_t *)pThis, "doAsyncWriteInternal signaled notEmpty\n");
     }
@@ -1527,6 +2222,189 @@ finalize_it:
 /* This is the writer thread for asynchronous mode.
  * -- rgerhards, 2009-07-06
  */
+/* flush interval timer callback, runs on the timer wheel thread */
+static void strmFlushTimerCB(void *pUsr) {
+    strm_t *const pThis = (strm_t *)pUsr;
+    d_pthread_mutex_lock(&pThis->mut);
+    if (pThis->bUringWriter) {
+        strmUringFlushNoBlock(pThis);
+    } else {
+        pThis->bFlushDue = 1;
+        pthread_cond_signal(&pThis->notEmpty);
+    }
+    strmUnlockAsync(pThis);
+}
+
+
+/* a queued async buffer has been written. Must be called with the mutex locked. */
+static void strmAsyncBufDone(strm_t *const pThis) {
+    ++pThis->iDeq;
+    --pThis->iCnt;
+    pthread_cond_signal(&pThis->notFull);
+    if (pThis->iCnt == 0) pthread_cond_broadcast(&pThis->isEmpty);
+}
+
+
+/* flush the partial buffer from a timer or completion callback, which must
+ * not block. If there is no free buffer or the writer is stalled, the
+ * flush is done once the write in flight completed or by the next caller
+ * of the regular write path. Must be called with the mutex locked.
+ */
+static void strmUringFlushNoBlock(strm_t *const pThis) {
+    if (pThis->iBufPtr == 0) return;
+    if (pThis->iCnt >= STREAM_ASYNC_NUMBUFS - 1 || pThis->bUringStalled) {
+        pThis->bFlushDue = 1;
+        return;
+    }
+    const size_t lenBuf = pThis->iBufPtr;
+    pThis->iBufPtr = 0;
+    strmAsyncBufQueue(pThis, lenBuf, 1);
+    strmUringKick(pThis, 0);
+}
+
+
+/* io_uring completion callback of an async buffer write, runs on the
+ * io_uring completion thread, which is shared by all streams. So this must
+ * never wait for the stream mutex: producers hold it across blocking writes
+ * and flushes, and one stalled stream would hold up the completions of all
+ * others. The completion is only published via bUringDone. If the stream
+ * mutex is free, we also process it right away to keep the writes going;
+ * otherwise its holder does so when it unlocks (see strmUnlockAsync()).
+ */
+static void strmUringWriteDone(iouring_req_t *const pReq) {
+    strm_t *const pThis = (strm_t *)pReq->pUsr;
+
+    pthread_mutex_lock(&pThis->mutUringDone);
+    pThis->bUringDone = 1;
+    pThis->bUringCbActive = 1;
+    pthread_cond_broadcast(&pThis->uringDone);
+    pthread_mutex_unlock(&pThis->mutUringDone);
+
+    strmUringReapNoBlock(pThis);
+
+    /* stopWriter() waits for this, pThis may be gone once it is cleared */
+    pthread_mutex_lock(&pThis->mutUringDone);
+    pThis->bUringCbActive = 0;
+    pthread_cond_broadcast(&pThis->uringDone);
+    pthread_mutex_unlock(&pThis->mutUringDone);
+}
+
+
+/* process a published io_uring completion and hand the next buffer to the
+ * ring. Must be called with the mutex locked. Does nothing if there is no
+ * completion to process.
+ */
+static void strmUringReap(strm_t *const pThis, const sbool bMayBlock) {
+    iouring_req_t *const pReq = &pThis->uringReq;
+    sbool bDone;
+
+    pthread_mutex_lock(&pThis->mutUringDone);
+    bDone = pThis->bUringDone;
+    pThis->bUringDone = 0;
+    pthread_mutex_unlock(&pThis->mutUringDone);
+    if (!bDone) return;
+
+    pThis->bUringBusy = 0;
+    pThis->iCurrOffs += pReq->nWritten;
+    if (pThis->pUsrWCntr != NULL) *pThis->pUsrWCntr += pReq->nWritten;
+    if (pReq->err != 0) {
+        DBGOPRINT((obj_t *)pThis, "file %d(%s) io_uring write failed with error %d, producer retries directly\n",
+                  pThis->fd, getFileDebugName(pThis), pReq->err);
+        pThis->lenUringDone += pReq->nWritten;
+        pThis->bUringStalled = 1;
+    } else {
+        pThis->lenUringDone = 0;
+        strmAsyncBufDone(pThis);
+        if (pThis->bFlushDue) {
+            pThis->bFlushDue = 0;
+            strmUringFlushNoBlock(pThis);
+        }
+    }
+    strmUringKick(pThis, bMayBlock);
+}
+
+
+/* wait until the write in flight completed and process it. Must be called
+ * with the mutex locked and bUringBusy set.
+ */
+static void strmUringWaitDone(strm_t *const pThis) {
+    pthread_mutex_lock(&pThis->mutUringDone);
+    while (!pThis->bUringDone) pthread_cond_wait(&pThis->uringDone, &pThis->mutUringDone);
+    pthread_mutex_unlock(&pThis->mutUringDone);
+    strmUringReap(pThis, 1);
+}
+
+
+/* process a published completion if the stream mutex can be obtained
+ * without waiting. Must be called without holding the mutex. Whoever holds
+ * it when a completion is published calls this after unlocking, so no
+ * completion is left unprocessed.
+ */
+static void strmUringReapNoBlock(strm_t *const pThis) {
+    sbool bDone;
+
+    while (1) {
+        pthread_mutex_lock(&pThis->mutUringDone);
+        bDone = pThis->bUringDone;
+        pthread_mutex_unlock(&pThis->mutUringDone);
+        if (!bDone || pthread_mutex_trylock(&pThis->mut) != 0) return;
+        strmUringReap(pThis, 0);
+        d_pthread_mutex_unlock(&pThis->mut);
+    }
+}
+
+
+/* unlock the mutex at the end of a producer side call */
+static void strmUnlockAsync(strm_t *const pThis) {
+    d_pthread_mutex_unlock(&pThis->mut);
+    if (pThis->bUringWriter) strmUringReapNoBlock(pThis);
+}
+
+
+/* hand the next queued async buffer to the io_uring, unless a write is
+ * already in flight (this keeps the writes of a file in order). Must be
+ * called with the mutex locked.
+ *
+ * Everything that may block (opening the file, writing directly after the
+ * ring failed or did not accept a buffer) is only done if bMayBlock is set,
+ * that is on the producer side. Callbacks pass 0; if they cannot submit,
+ * they mark the stream as stalled and the next producer side call does
+ * the work.
+ */
+static void strmUringKick(strm_t *const pThis, const sbool bMayBlock) {
+    while (pThis->iCnt > 0 && !pThis->bUringBusy) {
+        const int iDeq = pThis->iDeq % STREAM_ASYNC_NUMBUFS;
+        if (!pThis->bUringStalled) {
+            if (pThis->fd == -1 && bMayBlock) strmOpenFile(pThis); /* errors are handled below */
+            if (pThis->fd != -1 && !pThis->bIsTTY) {
+                iouring_req_t *const pReq = &pThis->uringReq;
+                pReq->fd = pThis->fd;
+                pReq->fdDir = pThis->fdDir;
+                pReq->bSync = pThis->bSync;
+                pReq->pBuf = pThis->asyncBuf[iDeq].pBuf;
+                pReq->lenBuf = pThis->asyncBuf[iDeq].lenBuf;
+                pReq->cb = strmUringWriteDone;
+                pReq->pUsr = pThis;
+                if (iouringSubmit(pReq) == RS_RET_OK) {
+                    pThis->bUringBusy = 1;
+                    return;
+                }
+            }
+        }
+        if (!bMayBlock) {
+            pThis->bUringStalled = 1;
+            return;
+        }
+        /* let the regular write path report errors and try to recover */
+        doWriteInternal(pThis, pThis->asyncBuf[iDeq].pBuf + pThis->lenUringDone,
+                        pThis->asyncBuf[iDeq].lenBuf - pThis->lenUringDone, 0);
+        pThis->lenUringDone = 0;
+        pThis->bUringStalled = 0;
+        strmAsyncBufDone(pThis);
+    }
+}
+
+
 static void *asyncWriterThread(void *pPtr) {
     int iDeq;
     struct timespec t;
@@ -1563,7 +2441,17 @@ static void *asyncWriterThread(void *pPtr) {
                 continue;
             }
             bTimedOut = 0;
-            if (pThis->bDoTimedWait) {
+            if (pThis->bDoTimedWait && timerwheelArm(&pThis->flushTimer, pThis->iFlushInterval * 1000) == RS_RET_OK) {
+                pThis->bFlushDue = 0;
+                d_pthread_cond_wait(&pThis->notEmpty, &pThis->mut);
+                if (pThis->bFlushDue) {
+                    DBGOPRINT((obj_t *)pThis, "file %d(%s) asyncWriterThread timed out\n", pThis->fd,
+                              getFileDebugName(pThis));
+                    bTimedOut = 1;
+                } else {
+                    timerwheelCancel(&pThis->flushTimer);
+                }
+            } else if (pThis->bDoTimedWait) {
                 timeoutComp(&t, pThis->iFlushInterval * 1000); /* 1000 *millisconds* */
                 if ((err = pthread_cond_timedwait(&pThis->notEmpty, &pThis->mut, &t)) != 0) {
                     DBGOPRINT((obj_t *)pThis, "file %d(%s) asyncWriterThread timed out\n", pThis->fd,
@@ -1650,6 +2538,33 @@ finalize_it:
 }
 #undef SYNCCALL
 
+/* write and sync a buffer with a single linked io_uring submission. Whatever
+ * the ring could not write is written (and synced) the regular way, which
+ * also does the error handling.
+ */
+static rsRetVal strmUringWriteSync(strm_t *const pThis, uchar *const pBuf, size_t *const pLenBuf) {
+    iouring_req_t req;
+    size_t lenRest = 0;
+    DEFiRet;
+
+    memset(&req, 0, sizeof(req));
+    req.fd = pThis->fd;
+    req.fdDir = pThis->fdDir;
+    req.bSync = 1;
+    req.pBuf = pBuf;
+    req.lenBuf = *pLenBuf;
+    if (iouringWriteWait(&req) == RS_RET_OK && req.err == 0) FINALIZE;
+
+    lenRest = *pLenBuf - req.nWritten;
+    CHKiRet(doWriteCall(pThis, pBuf + req.nWritten, &lenRest));
+    CHKiRet(syncFile(pThis));
+
+finalize_it:
+    *pLenBuf = req.nWritten + lenRest;
+    RETiRet;
+}
+
+
 /* physically write to the output file. the provided data is ready for
  * writing (e.g. zipped if we are requested to do that).
  * Note that if the write() API fails, we do not reset any pointers, but return
@@ -1671,13 +2586,23 @@ static rsRetVal strmPhysWrite(strm_t *pThis, uchar *pBuf, size_t lenBuf) {
     /* end crypto */
 
     iWritten = lenBuf;
-    CHKiRet(doWriteCall(pThis, pBuf, &iWritten));
+    if (pThis->bDirectActive) {
+        CHKiRet(dioCheckOwned(pThis));
+    }
+    const sbool bUringSync = pThis->bIoUring && pThis->bSync && !pThis->bIsTTY && !pThis->bDirectActive;
+    if (pThis->bDirectActive) {
+        CHKiRet(doDirectWrite(pThis, pBuf, &iWritten));
+    } else if (bUringSync) {
+        CHKiRet(strmUringWriteSync(pThis, pBuf, &iWritten));
+    } else {
+        CHKiRet(doWriteCall(pThis, pBuf, &iWritten));
+    }
 
     pThis->iCurrOffs += iWritten;
     /* update user counter, if provided */
     if (pThis->pUsrWCntr != NULL) *pThis->pUsrWCntr += iWritten;
 
-    if (pThis->bSync) {
+    if (pThis->bSync && !bUringSync) {
         CHKiRet(syncFile(pThis));
     }
 
@@ -1732,6 +2657,11 @@ static rsRetVal strmFlushInternal(strm_t *pThis, int bFlushZip) {
     DBGOPRINT((obj_t *)pThis, "strmFlushinternal: file %d(%s) flush, buflen %ld%s\n", pThis->fd,
               getFileDebugName(pThis), (long)pThis->iBufPtr, (pThis->iBufPtr == 0) ? " (no need to flush)" : "");
 
+    if (pThis->bUringWriter) {
+        /* process a completion the callback could not, or writes it left to us */
+        strmUringReap(pThis, 1);
+        if (pThis->bUringStalled && !pThis->bUringBusy) strmUringKick(pThis, 1);
+    }
     if (pThis->tOperationsMode != STREAMMODE_READ && pThis->iBufPtr > 0) {
         iRet = strmSchedWrite(pThis, pThis->pIOBuf, pThis->iBufPtr, bFlushZip);
     }
@@ -1757,7 +2687,7 @@ static rsRetVal strmFlush(strm_t *pThis) {
     CHKiRet(strmFlushInternal(pThis, 1));
 
 finalize_it:
-    if (pThis->bAsyncWrite) d_pthread_mutex_unlock(&pThis->mut);
+    if (pThis->bAsyncWrite) strmUnlockAsync(pThis);
 
     RETiRet;
 }
@@ -1788,6 +2718,7 @@ static rsRetVal ATTR_NONNULL() strmSeek(strm_t *pThis, const off64_t offs) {
     }
     pThis->strtOffs = pThis->iCurrOffs = offs; /* we are now at *this* offset */
     pThis->iBufPtr = 0; /* buffer invalidated */
+    mmapRelease(pThis);
 
 finalize_it:
     RETiRet;
@@ -1899,7 +2830,7 @@ static rsRetVal strmWriteChar(strm_t *__restrict__ const pThis, const uchar c) {
     pThis->iBufPtr++;
 
 finalize_it:
-    if (pThis->bAsyncWrite) d_pthread_mutex_unlock(&pThis->mut);
+    if (pThis->bAsyncWrite) strmUnlockAsync(pThis);
 
     RETiRet;
 }
@@ -1953,6 +2884,11 @@ static rsRetVal ATTR_NONNULL(1, 2)
 
     if (pThis->bAsyncWrite) d_pthread_mutex_lock(&pThis->mut);
 
+    /* rotate before the data of a new period is buffered */
+    if (pThis->iRotateInterval != 0 && pThis->fd != -1 && !pThis->bAsyncWrite && time(NULL) >= pThis->tRotateNext) {
+        CHKiRet(strmRotate(pThis, pThis->tRotateNext));
+    }
+
     iOffset = 0;
     do {
         if (pThis->iBufPtr == pThis->sIOBufSize) {
@@ -1984,9 +2920,13 @@ finalize_it:
              * writer thread that it can set and pick up timeouts.
              */
             pThis->bDoTimedWait = 1;
-            pthread_cond_signal(&pThis->notEmpty);
+            if (pThis->bUringWriter) {
+                timerwheelArm(&pThis->flushTimer, pThis->iFlushInterval * 1000);
+            } else {
+                pthread_cond_signal(&pThis->notEmpty);
+            }
         }
-        d_pthread_mutex_unlock(&pThis->mut);
+        strmUnlockAsync(pThis);
     }
 
     RETiRet;
@@ -2003,6 +2943,7 @@ DEFpropSetMeth(strm, iMaxFileSize, int64) DEFpropSetMeth(strm, iFileNumDigits, i
                     DEFpropSetMeth(strm, sIOBufSize, size_t) DEFpropSetMeth(strm, iSizeLimit, off_t)
                         DEFpropSetMeth(strm, iFlushInterval, int) DEFpropSetMeth(strm, pszSizeLimitCmd, uchar *)
                             DEFpropSetMeth(strm, cryprov, cryprov_if_t *) DEFpropSetMeth(strm, cryprovData, void *)
+                                DEFpropSetMeth(strm, bDirectIO, int) DEFpropSetMeth(strm, bMmap, int)
 
     /* sets timeout in seconds */
     void ATTR_NONNULL() strmSetReadTimeout(strm_t *const __restrict__ pThis, const int val) {
@@ -2234,6 +3175,36 @@ static rsRetVal SetCompressionWorkers(strm_t *const pThis, int num_wrkrs) {
 }
 
 
+/* enable seekable zstd output: frames are ended once they hold frameSize
+ * uncompressed bytes or are frameInterval seconds old, and each frame is
+ * recorded in an index file. 0 disables the respective limit.
+ */
+static rsRetVal SetZstdFrameLimits(strm_t *const pThis, const int64 frameSize, const int frameInterval) {
+    ISOBJ_TYPE_assert(pThis, strm);
+    pThis->zstd.frameSize = (frameSize < 0) ? 0 : frameSize;
+    pThis->zstd.frameInterval = (frameInterval < 0) ? 0 : frameInterval;
+    return RS_RET_OK;
+}
+
+
+/* enable native rotation of a file that is written: it is rotated when it
+ * reaches the size limit, unless a size limit command is set, and on the
+ * first write after each multiple of iInterval seconds (0 = never). Rotated
+ * files are compressed as requested, and iKeep of them are kept (0 = all).
+ */
+static rsRetVal SetRotation(strm_t *const pThis,
+                            const int iInterval,
+                            const fileRotateCompress_t compress,
+                            const int iKeep) {
+    ISOBJ_TYPE_assert(pThis, strm);
+    pThis->bRotate = 1;
+    pThis->iRotateInterval = (iInterval < 0) ? 0 : iInterval;
+    pThis->rotateCompress = compress;
+    pThis->iRotateKeep = (iKeep < 0) ? 0 : iKeep;
+    return RS_RET_OK;
+}
+
+
 /* set a user write-counter. This counter is initialized to zero and
  * receives the number of bytes written. It is accurate only after a
  * flush(). This hook is provided as a means to control disk size usage.
@@ -2357,6 +3328,8 @@ BEGINobjQueryInterface(strm)
     pIf->GetCurrOffset = strmGetCurrOffset;
     pIf->Dup = strmDup;
     pIf->SetCompressionWorkers = SetCompressionWorkers;
+    pIf->SetZstdFrameLimits = SetZstdFrameLimits;
+    pIf->SetRotation = SetRotation;
     pIf->SetWCntr = strmSetWCntr;
     pIf->CheckFileChange = CheckFileChange;
     /* set methods */
@@ -2378,6 +3351,8 @@ BEGINobjQueryInterface(strm)
     pIf->SetpszSizeLimitCmd = strmSetpszSizeLimitCmd;
     pIf->Setcryprov = strmSetcryprov;
     pIf->SetcryprovData = strmSetcryprovData;
+    pIf->SetbDirectIO = strmSetbDirectIO;
+    pIf->SetbMmap = strmSetbMmap;
 finalize_it:
 ENDobjQueryInterface(strm)
 
@@ -69,6 +69,7 @@ typedef struct strm_s strm_t; /* forward reference because of zlib... */
 
 #include <regex.h>  // TODO: fix via own module
 #include <pthread.h>
+#include <signal.h>
 #include <stdint.h>
 #include <time.h>
 #include "obj-types.h"
@@ -76,6 +77,9 @@ typedef struct strm_s strm_t; /* forward reference because of zlib... */
 #include "stream.h"
 #include "zlibw.h"
 #include "cryprov.h"
+#include "timerwheel.h"
+#include "iouring.h"
+#include "filerotate.h"
 
 /* stream types */
 typedef enum {
@@ -148,6 +152,40 @@ struct strm_s {
         pthread_cond_t notFull;
         pthread_cond_t notEmpty;
         pthread_cond_t isEmpty;
+        timerwheel_timer_t flushTimer; /* fires when the flush interval expired */
+        sbool bFlushDue; /* set by flushTimer */
+        sbool bIoUring; /* synced writes go through the shared io_uring */
+        sbool bUringWriter; /* async writes go through the io_uring instead of a writer thread */
+        sbool bUringBusy; /* uringReq is in flight (or completed, but not yet reaped) */
+        pthread_mutex_t mutUringDone; /* protects the two flags below, never held across I/O */
+        pthread_cond_t uringDone; /* signaled when bUringDone or bUringCbActive changes */
+        sbool bUringDone; /* uringReq completed, the result waits for strmUringReap() */
+        sbool bUringCbActive; /* the completion callback still accesses this stream */
+        sbool bUringStalled; /* a callback could not continue, the producer side must (see strmUringKick) */
+        size_t lenUringDone; /* bytes of the oldest async buffer written before its io_uring write failed */
+        iouring_req_t uringReq;
+        sbool bDirectIO; /* write with O_DIRECT if the file system supports it */
+        sbool bDirectActive; /* the current file is open with O_DIRECT */
+        sbool bDirectWarned; /* we already reported that direct I/O is not possible for this file */
+        sbool bMmap; /* read regular files through mmap() instead of read(), see mmapReadBuf() */
+        struct {
+            sbool bActive; /* the current file is read through mmap() */
+            uchar *pBase; /* current window, NULL if none */
+            size_t len; /* length of the window */
+            int64 offs; /* file offset of the window's data (pIOBuf[0]) */
+            uchar *pIOBuf; /* the allocated read buffer, pIOBuf points here while nothing is mapped */
+            size_t lenTail; /* tail of the previous window kept in the read buffer for truncation checks */
+            int64 offsTail; /* file offset of that tail */
+        } map; /* mmap read mode support */
+        struct {
+            uchar *pBuf; /* block aligned staging buffer, starts with the partial last block of the file */
+            size_t sizeBuf;
+            size_t lenTail; /* bytes in pBuf */
+            int64 offs; /* file offset of pBuf[0], block aligned */
+            sbool bValid; /* is pBuf in sync with the file? */
+            int64 prealloc; /* file space is preallocated up to here, 0 if none */
+            int fdFlags; /* file status flags of fd (with O_DIRECT) */
+        } dio; /* direct I/O support, see doDirectWrite() */
         unsigned short iEnq; /* this MUST be unsigned as we use module arithmetic (else invalid indexing happens!) */
         unsigned short iDeq; /* this MUST be unsigned as we use module arithmetic (else invalid indexing happens!) */
         cryprov_if_t *cryprov; /* ptr to crypto provider; NULL = do not encrypt */
@@ -162,11 +200,26 @@ struct strm_s {
         struct {
             int num_wrkrs; /* nbr of worker threads */
             void *cctx;
+            /* seekable mode: frames are ended at these limits and indexed */
+            int64 frameSize; /* uncompressed bytes per frame, 0 = no limit */
+            int frameInterval; /* seconds per frame, 0 = no limit */
+            int fdIdx; /* frame index file, -1 if not open */
+            int64 frameIn; /* uncompressed bytes in current frame */
+            int64 frameOut; /* compressed bytes of current frame */
+            time_t frameFirst; /* when the current frame got its first data */
+            time_t frameLast; /* when the current frame got its last data */
+            sbool bAtRecordEnd; /* last data compressed ended with LF */
         } zstd; /* supporting per-instance data if zstd is used */
         pthread_t writerThreadID;
         /* support for omfile size-limiting commands, special counters, NOT persisted! */
         off_t iSizeLimit; /* file size limit, 0 = no limit */
         uchar *pszSizeLimitCmd; /* command to carry out when size limit is reached */
+        /* native rotation (see filerotate.h), NOT persisted! */
+        sbool bRotate; /* rotate natively on size limit if there is no size limit command */
+        int iRotateInterval; /* rotate at multiples of this many seconds, 0 = never */
+        int iRotateKeep; /* rotated files to keep, 0 = all */
+        fileRotateCompress_t rotateCompress; /* compression of rotated files */
+        time_t tRotateNext; /* rotate the current file on the first write from then on */
         sbool bIsTTY; /* is this a tty file? */
         cstr_t *prevLineSegment; /* for ReadLine, previous, unprocessed part of file */
         cstr_t *prevMsgSegment; /* for ReadMultiLine, previous, yet unprocessed part of msg */
@@ -226,8 +279,16 @@ BEGINinterface(strm) /* name must also be changed in ENDinterface macro! */
     /* v9 added  2013-04-04 */
     INTERFACEpropSetMeth(strm, cryprov, cryprov_if_t *);
     INTERFACEpropSetMeth(strm, cryprovData, void *);
+    /* v15 added 2026-10-18 */
+    rsRetVal (*SetZstdFrameLimits)(strm_t *pThis, int64 frameSize, int frameInterval);
+    /* v16 added 2026-10-18 */
+    INTERFACEpropSetMeth(strm, bDirectIO, int);
+    /* v17 added 2026-10-18 */
+    rsRetVal (*SetRotation)(strm_t *pThis, int iInterval, fileRotateCompress_t compress, int iKeep);
+    /* v18 added 2026-10-18 */
+    INTERFACEpropSetMeth(strm, bMmap, int);
 ENDinterface(strm)
-#define strmCURR_IF_VERSION 14 /* increment whenever you change the interface structure! */
+#define strmCURR_IF_VERSION 18 /* increment whenever you change the interface structure! */
     /* V10, 2013-09-10: added new parameter bEscapeLF, changed mode to uint8_t (rgerhards) */
     /* V11, 2015-12-03: added new parameter bReopenOnTruncate */
     /* V12, 2015-12-11: added new parameter trimLineOverBytes, changed mode to uint32_t */
@@ -254,5 +315,9 @@ void strmSetReadTimeout(strm_t *const __restrict__ pThis, const int val);
 const uchar *ATTR_NONNULL() strmGetPrevLineSegment(strm_t *const pThis);
 const uchar *ATTR_NONNULL() strmGetPrevMsgSegment(strm_t *const pThis);
 int ATTR_NONNULL() strmGetPrevWasNL(const strm_t *const pThis);
+/* SIGBUS handler needed for mmap read mode, to be installed by the application
+ * with SA_SIGINFO | SA_NODEFER. Without it, mmap read mode is not used.
+ */
+void strmSigbusHandler(int sig, siginfo_t *si, void *ctx);
 
 #endif /* #ifndef STREAM_H_INCLUDED */
@@ -57,9 +57,7 @@
 #if HAVE_FCNTL_H
     #include <fcntl.h>
 #endif
-#if !defined(ENABLE_IMTCP_EPOLL)
-    #include <sys/poll.h>
-#endif
+#include <sys/poll.h>
 #include "rsyslog.h"
 #include "dirty.h"
 #include "cfsysline.h"
@@ -111,20 +109,21 @@ static void enqueueWork(tcpsrv_io_descr_t *const pioDescr);
  */
 #if defined(ENABLE_IMTCP_EPOLL)
 
-static rsRetVal ATTR_NONNULL() eventNotify_init(tcpsrv_t *const pThis) {
+/* create an epoll set; also used for the per-worker sets (bWrkrReusePort) */
+static rsRetVal ATTR_NONNULL() epollCreate(int *const pEfd) {
     DEFiRet;
     #if defined(ENABLE_IMTCP_EPOLL) && defined(EPOLL_CLOEXEC) && defined(HAVE_EPOLL_CREATE1)
     DBGPRINTF("tcpsrv uses epoll_create1()\n");
-    pThis->evtdata.epoll.efd = epoll_create1(EPOLL_CLOEXEC);
-    if (pThis->evtdata.epoll.efd < 0 && errno == ENOSYS)
+    *pEfd = epoll_create1(EPOLL_CLOEXEC);
+    if (*pEfd < 0 && errno == ENOSYS)
     #endif
     {
         DBGPRINTF("tcpsrv uses epoll_create()\n");
-        pThis->evtdata.epoll.efd = epoll_create(100);
+        *pEfd = epoll_create(100);
         /* size is ignored in newer kernels, but 100 is not bad... */
     }
 
-    if (pThis->evtdata.epoll.efd < 0) {
+    if (*pEfd < 0) {
         DBGPRINTF("epoll_create1() could not create fd\n");
         ABORT_FINALIZE(RS_RET_IO_ERROR);
     }
@@ -133,6 +132,11 @@ finalize_it:
 }
 
 
+static rsRetVal ATTR_NONNULL() eventNotify_init(tcpsrv_t *const pThis) {
+    return epollCreate(&pThis->evtdata.epoll.efd);
+}
+
+
 static rsRetVal ATTR_NONNULL() eventNotify_exit(tcpsrv_t *const pThis) {
     DEFiRet;
     close(pThis->evtdata.epoll.efd);
@@ -140,9 +144,8 @@ static rsRetVal ATTR_NONNULL() eventNotify_exit(tcpsrv_t *const pThis) {
 }
 
 
-/* Modify socket set */
-static rsRetVal ATTR_NONNULL()
-    epoll_Ctl(tcpsrv_t *const pThis, tcpsrv_io_descr_t *const pioDescr, const int isLstn, const int op) {
+/* Modify the socket set pioDescr->efd */
+static rsRetVal ATTR_NONNULL() epoll_Ctl(tcpsrv_io_descr_t *const pioDescr, const int isLstn, const int op) {
     DEFiRet;
 
     const int id = pioDescr->id;
@@ -153,12 +156,12 @@ static rsRetVal ATTR_NONNULL()
         dbgprintf("adding epoll entry %d, socket %d\n", id, sock);
         pioDescr->event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
         pioDescr->event.data.ptr = (void *)pioDescr;
-        if (epoll_ctl(pThis->evtdata.epoll.efd, EPOLL_CTL_ADD, sock, &pioDescr->event) < 0) {
+        if (epoll_ctl(pioDescr->efd, EPOLL_CTL_ADD, sock, &pioDescr->event) < 0) {
             LogError(errno, RS_RET_ERR_EPOLL_CTL, "epoll_ctl failed on fd %d, isLstn %d\n", sock, isLstn);
         }
     } else if (op == EPOLL_CTL_DEL) {
         dbgprintf("removing epoll entry %d, socket %d\n", id, sock);
-        if (epoll_ctl(pThis->evtdata.epoll.efd, EPOLL_CTL_DEL, sock, NULL) < 0) {
+        if (epoll_ctl(pioDescr->efd, EPOLL_CTL_DEL, sock, NULL) < 0) {
             if (errno == EBADF || errno == ENOENT) {
                 /* already gone-away, everything is well */
                 DBGPRINTF("epoll_ctl: fd %d already removed, isLstn %d", sock, isLstn);
@@ -178,7 +181,7 @@ finalize_it:
 }
 
 
-/* Wait for io to become ready. After the successful call, idRdy contains the
+/* Wait for io to become ready on epoll set efd. After the successful call, idRdy contains the
  * id set by the caller for that i/o event, ppUsr is a pointer to a location
  * where the user pointer shall be stored.
  * numEntries contains the maximum number of entries on entry and the actual
@@ -186,7 +189,7 @@ finalize_it:
  * rgerhards, 2009-11-18
  */
 static rsRetVal ATTR_NONNULL()
-    epoll_Wait(tcpsrv_t *const pThis, const int timeout, int *const numEntries, tcpsrv_io_descr_t *pWorkset[]) {
+    epoll_Wait(const int efd, const int timeout, int *const numEntries, tcpsrv_io_descr_t *pWorkset[]) {
     struct epoll_event event[NSPOLL_MAX_EVENTS_PER_WAIT];
     int nfds;
     int i;
@@ -196,7 +199,7 @@ static rsRetVal ATTR_NONNULL()
 
     if (*numEntries > NSPOLL_MAX_EVENTS_PER_WAIT) *numEntries = NSPOLL_MAX_EVENTS_PER_WAIT;
     DBGPRINTF("doing epoll_wait for max %d events\n", *numEntries);
-    nfds = epoll_wait(pThis->evtdata.epoll.efd, event, *numEntries, timeout);
+    nfds = epoll_wait(efd, event, *numEntries, timeout);
     if (nfds == -1) {
         if (errno == EINTR) {
             ABORT_FINALIZE(RS_RET_EINTR);
@@ -213,7 +216,7 @@ static rsRetVal ATTR_NONNULL()
     for (i = 0; i < nfds; ++i) {
         pWorkset[i] = event[i].data.ptr;
         /* default is no error, on error we terminate, so we need only to set in error case! */
-        if (event[i].events & EPOLLERR) {
+        if ((event[i].events & EPOLLERR) && pWorkset[i] != NULL) {
             ATOMIC_STORE_1_TO_INT(&pWorkset[i]->isInError, &pWorkset[i]->mut_isInError);
         }
     }
@@ -545,9 +548,11 @@ static void ATTR_NONNULL() deinit_tcp_listener(tcpsrv_t *const pThis) {
         free(pDel);
     }
 
-    /* finally close our listen streams */
+    /* finally close our listen streams (a failed bWrkrReusePort worker may already have closed its own) */
     for (i = 0; i < pThis->iLstnCurr; ++i) {
-        netstrm.Destruct(pThis->ppLstn + i);
+        if (pThis->ppLstn[i] != NULL) {
+            netstrm.Destruct(pThis->ppLstn + i);
+        }
     }
 }
 
@@ -567,6 +572,7 @@ static rsRetVal ATTR_NONNULL() addTcpLstn(void *pUsr, netstrm_t *const pLstn) {
 
     pThis->ppLstn[pThis->iLstnCurr] = pLstn;
     pThis->ppLstnPort[pThis->iLstnCurr] = pPortList;
+    pThis->piLstnWrkr[pThis->iLstnCurr] = pThis->iLstnInitWrkr;
     ++pThis->iLstnCurr;
 
 finalize_it:
@@ -592,31 +598,78 @@ finalize_it:
 }
 
 
-/* Initialize TCP sockets (for listener) and listens on them */
+/* If per-worker listeners are bound to a dynamic port ("0"), replace the port
+ * by the one the first worker's listener iLstn actually got, so that the
+ * listeners of the other workers join the same SO_REUSEPORT group.
+ */
+static rsRetVal ATTR_NONNULL() fixDynLstnPort(tcpsrv_t *const pThis, tcpLstnPortList_t *const pEntry, const int iLstn) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    char portbuf[8];
+    uchar *pszPort;
+    int sock;
+    DEFiRet;
+
+    if (strcmp((const char *)pEntry->cnf_params->pszPort, "0")) {
+        FINALIZE;
+    }
+
+    CHKiRet(netstrm.GetSock(pThis->ppLstn[iLstn], &sock));
+    if (getsockname(sock, (struct sockaddr *)&addr, &len) < 0) {
+        LogError(errno, RS_RET_IO_ERROR, "tcpsrv: could not obtain dynamic listen port");
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    snprintf(portbuf, sizeof(portbuf), "%u",
+             ntohs((addr.ss_family == AF_INET6) ? ((struct sockaddr_in6 *)&addr)->sin6_port
+                                                : ((struct sockaddr_in *)&addr)->sin_port));
+    CHKmalloc(pszPort = ustrdup((uchar *)portbuf));
+    free((void *)pEntry->cnf_params->pszPort);
+    pEntry->cnf_params->pszPort = pszPort;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* Initialize TCP sockets (for listener) and listens on them. With bWrkrReusePort,
+ * each worker gets its own set of listeners for each configured port.
+ */
 static rsRetVal ATTR_NONNULL() create_tcp_socket(tcpsrv_t *const pThis) {
     DEFiRet;
     rsRetVal localRet;
     tcpLstnPortList_t *pEntry;
+    const int numLstnWrkrs = pThis->bWrkrReusePort ? (int)pThis->workQueue.numWrkr : 1;
 
     ISOBJ_TYPE_assert(pThis, tcpsrv);
 
     /* init all configured ports */
     pEntry = pThis->pLstnPorts;
     while (pEntry != NULL) {
-        localRet = initTCPListener(pThis, pEntry);
-        if (localRet != RS_RET_OK) {
-            char *ns = pEntry->cnf_params->pszNetworkNamespace;
-
-            LogError(
-                0, localRet,
-                "Could not create tcp listener, ignoring port "
-                "%s bind-address %s%s%s.",
-                (pEntry->cnf_params->pszPort == NULL) ? "**UNSPECIFIED**" : (const char *)pEntry->cnf_params->pszPort,
-                (pEntry->cnf_params->pszAddr == NULL) ? "**UNSPECIFIED**" : (const char *)pEntry->cnf_params->pszAddr,
-                (ns == NULL) ? "" : " namespace ", (ns == NULL) ? "" : ns);
+        pEntry->cnf_params->bReusePort = pThis->bWrkrReusePort;
+        for (int i = 0; i < numLstnWrkrs; ++i) {
+            const int iFirstLstn = pThis->iLstnCurr;
+            pThis->iLstnInitWrkr = i;
+            localRet = initTCPListener(pThis, pEntry);
+            if (localRet == RS_RET_OK && i == 0 && numLstnWrkrs > 1) {
+                localRet = fixDynLstnPort(pThis, pEntry, iFirstLstn);
+            }
+            if (localRet != RS_RET_OK) {
+                char *ns = pEntry->cnf_params->pszNetworkNamespace;
+
+                LogError(0, localRet,
+                         "Could not create tcp listener, ignoring port "
+                         "%s bind-address %s%s%s.",
+                         (pEntry->cnf_params->pszPort == NULL) ? "**UNSPECIFIED**"
+                                                               : (const char *)pEntry->cnf_params->pszPort,
+                         (pEntry->cnf_params->pszAddr == NULL) ? "**UNSPECIFIED**"
+                                                               : (const char *)pEntry->cnf_params->pszAddr,
+                         (ns == NULL) ? "" : " namespace ", (ns == NULL) ? "" : ns);
+                break;
+            }
         }
         pEntry = pEntry->pNext;
     }
+    pThis->iLstnInitWrkr = 0;
 
     /* OK, we had success. Now it is also time to
      * initialize our connections
@@ -824,7 +877,7 @@ static ATTR_NONNULL() rsRetVal closeSess(tcpsrv_t *const pThis, tcpsrv_io_descr_
     /* note: we do not check the result of epoll_Ctl because we cannot do
      * anything against a failure BUT we need to do the cleanup in any case.
      */
-    epoll_Ctl(pThis, pioDescr, 0, EPOLL_CTL_DEL);
+    epoll_Ctl(pioDescr, 0, EPOLL_CTL_DEL);
 #endif
     assert(pThis->pOnRegularClose != NULL);
     pThis->pOnRegularClose(pSess);
@@ -850,7 +903,7 @@ static ATTR_NONNULL() rsRetVal closeSess(tcpsrv_t *const pThis, tcpsrv_io_descr_
  * given `pioDescr` so the same descriptor is delivered on the next event.
  *
  * @pre  `pioDescr` is valid; `pioDescr->sock` and
- *       `pioDescr->pSrv->evtdata.epoll.efd` refer to open fds.
+ *       `pioDescr->efd` refer to open fds.
  * @pre  `pioDescr->ioDirection` ∈ { `NSDSEL_RD`, `NSDSEL_WR` }.
  * @pre  Called by the thread that owns the descriptor (no concurrent epoll_ctl).
  *
@@ -869,12 +922,12 @@ static ATTR_NONNULL() rsRetVal rearmIoEvent(tcpsrv_io_descr_t *const pioDescr) {
 
     /* Debug-only invariants */
     assert(pioDescr->ioDirection == NSDSEL_RD || pioDescr->ioDirection == NSDSEL_WR);
-    assert(pioDescr->pSrv != NULL && pioDescr->pSrv->evtdata.epoll.efd >= 0);
+    assert(pioDescr->efd >= 0);
     assert(pioDescr->sock >= 0);
 
     const uint32_t waitIOEvent = (pioDescr->ioDirection == NSDSEL_WR) ? EPOLLOUT : EPOLLIN;
     struct epoll_event event = {.events = waitIOEvent | EPOLLET | EPOLLONESHOT, .data = {.ptr = pioDescr}};
-    if (epoll_ctl(pioDescr->pSrv->evtdata.epoll.efd, EPOLL_CTL_MOD, pioDescr->sock, &event) < 0) {
+    if (epoll_ctl(pioDescr->efd, EPOLL_CTL_MOD, pioDescr->sock, &event) < 0) {
         LogError(errno, RS_RET_ERR_EPOLL_CTL, "epoll_ctl failed re-arm socket %d", pioDescr->sock);
         ABORT_FINALIZE(RS_RET_ERR_EPOLL_CTL);
     }
@@ -891,11 +944,14 @@ finalize_it:
  * Flow:
  *  - Read via pThis->pRcvData(), forward to tcps_sess.DataRcvd().
  *  - Starvation: after `starvationMaxReads`, enqueue `pioDescr` (handoff) and return (no re-arm).
+ *    With bWrkrReusePort, the session stays with its worker: re-arm instead, so that the
+ *    other ready sessions of the worker's epoll set are served first.
  *  - Would-block (RS_RET_RETRY): re-arm EPOLLONESHOT and return.
  *  - Close/error: exit the loop and close the session after unlocking.
  *
  * Locking:
- *  - If workQueue.numWrkr > 1, this function locks `pSess->mut` on entry and always unlocks
+ *  - If workQueue.numWrkr > 1 and sessions are not pinned to a worker (bWrkrReusePort),
+ *    this function locks `pSess->mut` on entry and always unlocks
  *    before return (including close/error and starvation/handoff paths).
  *  - **Re-arm timing:** on the would-block path, `rearmIoEvent(pioDescr)` is called *before*
  *    unlocking `pSess->mut` to keep ownership until the EPOLL_CTL_MOD completes.
@@ -919,13 +975,14 @@ static rsRetVal ATTR_NONNULL(1)
     tcps_sess_t *const pSess = pioDescr->ptr.pSess;
     tcpsrv_t *const pThis = pioDescr->pSrv;
     const unsigned maxReads = pThis->starvationMaxReads;
+    const int bLockSess = pThis->workQueue.numWrkr > 1 && !pThis->bWrkrReusePort;
 
     ISOBJ_TYPE_assert(pThis, tcpsrv);
     const char *const peerIP = propGetSzStrOrDefault(pSess->fromHostIP, "(IP unknown)");
     const char *const peerPort = propGetSzStrOrDefault(pSess->fromHostPort, "(port unknown)");
     DBGPRINTF("netstream %p with new data from remote peer %s:%s\n", (pSess)->pStrm, peerIP, peerPort);
 
-    if (pThis->workQueue.numWrkr > 1) {
+    if (bLockSess) {
         pthread_mutex_lock(&pSess->mut);
     }
 
@@ -1008,8 +1065,12 @@ static rsRetVal ATTR_NONNULL(1)
 #if defined(ENABLE_IMTCP_EPOLL)
                 STATSCOUNTER_INC(wrkrData->ctrStarvation, wrkrData->mutCtrStarvation);
 #endif
-                enqueueWork(pioDescr);
-                state = RS_DONE_HANDOFF; /* queued behind existing work → exit, no re-arm */
+                if (pThis->bWrkrReusePort) {
+                    state = RS_DONE_REARM; /* fires again after the worker's other ready events */
+                } else {
+                    enqueueWork(pioDescr);
+                    state = RS_DONE_HANDOFF; /* queued behind existing work → exit, no re-arm */
+                }
                 break;
 
             default:
@@ -1027,11 +1088,11 @@ static rsRetVal ATTR_NONNULL(1)
         STATSCOUNTER_ADD(wrkrData->ctrRead, wrkrData->mutCtrRead, read_calls);
     }
     if (state == RS_DONE_REARM) {
-        rearmIoEvent(pioDescr); /* re-arm while still holding pSess->mut */
+        rearmIoEvent(pioDescr); /* re-arm while still holding pSess->mut (if locked) */
     }
 #endif
 
-    if (pThis->workQueue.numWrkr > 1) {
+    if (bLockSess) {
         pthread_mutex_unlock(&pSess->mut);
     }
 
@@ -1070,7 +1131,8 @@ static rsRetVal ATTR_NONNULL(1) doSingleAccept(tcpsrv_io_descr_t *const pioDescr
         pDescrNew->ioDirection = NSDSEL_RD;
         CHKiRet(netstrm.GetSock(pNewSess->pStrm, &pDescrNew->sock));
         pDescrNew->ptr.pSess = pNewSess;
-        CHKiRet(epoll_Ctl(pThis, pDescrNew, 0, EPOLL_CTL_ADD));
+        pDescrNew->efd = pioDescr->efd; /* sessions stay in their listener's epoll set */
+        CHKiRet(epoll_Ctl(pDescrNew, 0, EPOLL_CTL_ADD));
 #endif
 
         DBGPRINTF("New session created with NSD %p.\n", pNewSess);
@@ -1139,6 +1201,126 @@ static rsRetVal ATTR_NONNULL(1)
 }
 
 
+#if defined(ENABLE_IMTCP_EPOLL)
+/* add listener i to the epoll set efd */
+static rsRetVal ATTR_NONNULL() addLstnDescr(tcpsrv_t *const pThis, const int i, const int efd) {
+    DEFiRet;
+
+    DBGPRINTF("Trying to add listener %d, pUsr=%p\n", i, pThis->ppLstn);
+    CHKmalloc(pThis->ppioDescrPtr[i] = (tcpsrv_io_descr_t *)calloc(1, sizeof(tcpsrv_io_descr_t)));
+    pThis->ppioDescrPtr[i]->pSrv = pThis;
+    pThis->ppioDescrPtr[i]->id = i;
+    pThis->ppioDescrPtr[i]->isInError = 0;
+    pThis->ppioDescrPtr[i]->ioDirection = NSDSEL_RD;
+    pThis->ppioDescrPtr[i]->efd = efd;
+    INIT_ATOMIC_HELPER_MUT(pThis->ppioDescrPtr[i]->mut_isInError);
+    CHKiRet(netstrm.GetSock(pThis->ppLstn[i], &(pThis->ppioDescrPtr[i]->sock)));
+    pThis->ppioDescrPtr[i]->ptrType = NSD_PTR_TYPE_LSTN;
+    pThis->ppioDescrPtr[i]->ptr.ppLstn = pThis->ppLstn;
+    CHKiRet(epoll_Ctl(pThis->ppioDescrPtr[i], 1, EPOLL_CTL_ADD));
+    DBGPRINTF("Added listener %d\n", i);
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* remove listener i from its epoll set */
+static rsRetVal ATTR_NONNULL() removeLstnDescr(tcpsrv_t *const pThis, const int i) {
+    DEFiRet;
+
+    CHKiRet(epoll_Ctl(pThis->ppioDescrPtr[i], 1, EPOLL_CTL_DEL));
+    DESTROY_ATOMIC_HELPER_MUT(pThis->ppioDescrPtr[i]->mut_isInError);
+    free(pThis->ppioDescrPtr[i]);
+    pThis->ppioDescrPtr[i] = NULL;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/**
+ * @brief Event loop of a worker that owns its epoll set (bWrkrReusePort).
+ *
+ * The worker watches only its own SO_REUSEPORT listeners and the sessions accepted
+ * on them, so the kernel spreads connections over the workers and each session is
+ * served by a single worker for its lifetime. Ready items are processed inline;
+ * there is no work queue handoff and no session locking.
+ *
+ * The loop ends when stopWrkrPool() writes to the wakeup pipe, which is registered
+ * with a NULL user pointer.
+ */
+static rsRetVal ATTR_NONNULL()
+    wrkrRunEpoll(tcpsrv_t *const pThis, const int wrkrIdx, tcpsrvWrkrData_t *const wrkrData) {
+    tcpsrv_io_descr_t *workset[NSPOLL_MAX_EVENTS_PER_WAIT];
+    struct epoll_event event;
+    int numEntries;
+    int bRun = 1;
+    int i;
+    rsRetVal localRet;
+    DEFiRet;
+
+    wrkrData->efd = -1;
+    CHKiRet(epollCreate(&wrkrData->efd));
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(wrkrData->efd, EPOLL_CTL_ADD, pThis->workQueue.wakeupFds[0], &event) < 0) {
+        LogError(errno, RS_RET_IO_ERROR, "tcpsrv worker %d could not add wakeup pipe to its epoll set", wrkrIdx);
+        ABORT_FINALIZE(RS_RET_IO_ERROR);
+    }
+    for (i = 0; i < pThis->iLstnCurr; ++i) {
+        if (pThis->piLstnWrkr[i] == wrkrIdx) {
+            CHKiRet(addLstnDescr(pThis, i, wrkrData->efd));
+        }
+    }
+
+    while (bRun && glbl.GetGlobalInputTermState() == 0) {
+        numEntries = sizeof(workset) / sizeof(tcpsrv_io_descr_t *);
+        localRet = epoll_Wait(wrkrData->efd, -1, &numEntries, workset);
+        if (localRet == RS_RET_EINTR) {
+            continue;
+        }
+        /* any other epoll_wait() failure means the set itself is unusable; retrying
+         * would only spin, so we give up and hand our listeners back (see below).
+         */
+        CHKiRet(localRet);
+        for (i = 0; i < numEntries && bRun; ++i) {
+            if (workset[i] == NULL) {
+                bRun = 0; /* wakeup pipe: we shall terminate */
+            } else {
+                processWorksetItem(workset[i], wrkrData);
+                STATSCOUNTER_ADD(wrkrData->ctrRuns, wrkrData->mutCtrRuns, 1);
+            }
+        }
+    }
+
+finalize_it:
+    for (i = 0; i < pThis->iLstnCurr; ++i) {
+        if (pThis->piLstnWrkr[i] == wrkrIdx && pThis->ppioDescrPtr[i] != NULL) {
+            removeLstnDescr(pThis, i);
+        }
+    }
+    if (iRet != RS_RET_OK) {
+        /* Nobody else serves our SO_REUSEPORT listeners. As long as they stay bound,
+         * the kernel keeps hashing connections to them, which would then never be
+         * accepted. So we close them, the remaining workers receive all new connections.
+         */
+        LogError(0, iRet, "tcpsrv worker %d cannot run its epoll set, closing its listeners", wrkrIdx);
+        for (i = 0; i < pThis->iLstnCurr; ++i) {
+            if (pThis->piLstnWrkr[i] == wrkrIdx && pThis->ppLstn[i] != NULL) {
+                netstrm.Destruct(&pThis->ppLstn[i]);
+            }
+        }
+    }
+    if (wrkrData->efd != -1) {
+        close(wrkrData->efd);
+    }
+    RETiRet;
+}
+#endif
+
+
 /* work queue functions */
 
 static void ATTR_NONNULL() * wrkr(void *arg); /* forward-def of wrkr */
@@ -1165,8 +1347,9 @@ static void ATTR_NONNULL() * wrkr(void *arg); /* forward-def of wrkr */
  *
  *  ### Thread cancellation model
  *  If any threads were created before failure, we call `pthread_cancel()` and then
- *  `pthread_join()` on each. Worker threads block in `pthread_cond_wait()` which is
- *  a POSIX cancellation point, so cancellation is reliable here.
+ *  `pthread_join()` on each. Worker threads block in `pthread_cond_wait()` (or, with
+ *  bWrkrReusePort, in `epoll_wait()`), which are POSIX cancellation points, so
+ *  cancellation is reliable here.
  *
  *  @param pThis Server instance (must have `workQueue.numWrkr > 1`).
  *  @retval RS_RET_OK on success; error code on failure (resources cleaned up).
@@ -1183,6 +1366,7 @@ static rsRetVal ATTR_NONNULL() startWrkrPool(tcpsrv_t *const pThis) {
     /* Initialize queue state first. */
     queue->head = NULL;
     queue->tail = NULL;
+    queue->wakeupFds[0] = queue->wakeupFds[1] = -1;
 
     /* Allocate arrays. */
     CHKmalloc(queue->wrkr_tids = calloc(queue->numWrkr, sizeof(pthread_t)));
@@ -1199,6 +1383,11 @@ static rsRetVal ATTR_NONNULL() startWrkrPool(tcpsrv_t *const pThis) {
     }
     cond_initialized = 1;
 
+    if (pThis->bWrkrReusePort && pipe(queue->wakeupFds) != 0) {
+        queue->wakeupFds[0] = queue->wakeupFds[1] = -1;
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
     /* Spawn workers. */
     pThis->currWrkrs = 0;
     for (unsigned i = 0; i < queue->numWrkr; ++i) {
@@ -1230,6 +1419,10 @@ finalize_it:
         if (mut_initialized) {
             (void)pthread_mutex_destroy(&queue->mut);
         }
+        if (queue->wakeupFds[0] != -1) {
+            close(queue->wakeupFds[0]);
+            close(queue->wakeupFds[1]);
+        }
 
         /* Free arrays (they might be NULL if allocation failed early). */
         free(queue->wrkr_tids);
@@ -1259,6 +1452,12 @@ static void ATTR_NONNULL() stopWrkrPool(tcpsrv_t *const pThis) {
     pthread_mutex_lock(&queue->mut);
     pthread_cond_broadcast(&queue->workRdy);
     pthread_mutex_unlock(&queue->mut);
+    if (pThis->bWrkrReusePort) {
+        /* the pipe stays readable, so this single byte wakes all workers */
+        if (write(queue->wakeupFds[1], "", 1) != 1) {
+            LogError(errno, RS_RET_IO_ERROR, "tcpsrv: could not wake up worker threads");
+        }
+    }
 
     /* Wait for all worker threads to finish. */
     for (unsigned i = 0; i < queue->numWrkr; i++) {
@@ -1272,6 +1471,10 @@ static void ATTR_NONNULL() stopWrkrPool(tcpsrv_t *const pThis) {
     /* Destroy synchronization primitives. */
     pthread_mutex_destroy(&queue->mut);
     pthread_cond_destroy(&queue->workRdy);
+    if (pThis->bWrkrReusePort) {
+        close(queue->wakeupFds[0]);
+        close(queue->wakeupFds[1]);
+    }
 
     queue->wrkr_tids = NULL;
     queue->wrkr_data = NULL;
@@ -1428,7 +1631,13 @@ static void ATTR_NONNULL() * wrkr(void *arg) {
     }
 
     /**** main loop ****/
-    while (1) {
+#if defined(ENABLE_IMTCP_EPOLL)
+    if (pThis->bWrkrReusePort) {
+        /* result ignored: on failure, wrkrRunEpoll() reports and closes its listeners itself */
+        wrkrRunEpoll(pThis, wrkrIdx, wrkrData);
+    }
+#endif
+    while (!pThis->bWrkrReusePort) {
         pioDescr = dequeueWork(pThis);
         if (pioDescr == NULL) {
             break;
@@ -1610,23 +1819,12 @@ static rsRetVal ATTR_NONNULL() RunEpoll(tcpsrv_t *const pThis) {
 
     /* Add the TCP listen sockets to the list of sockets to monitor */
     for (i = 0; i < pThis->iLstnCurr; ++i) {
-        DBGPRINTF("Trying to add listener %d, pUsr=%p\n", i, pThis->ppLstn);
-        CHKmalloc(pThis->ppioDescrPtr[i] = (tcpsrv_io_descr_t *)calloc(1, sizeof(tcpsrv_io_descr_t)));
-        pThis->ppioDescrPtr[i]->pSrv = pThis;
-        pThis->ppioDescrPtr[i]->id = i;
-        pThis->ppioDescrPtr[i]->isInError = 0;
-        pThis->ppioDescrPtr[i]->ioDirection = NSDSEL_RD;
-        INIT_ATOMIC_HELPER_MUT(pThis->ppioDescrPtr[i]->mut_isInError);
-        CHKiRet(netstrm.GetSock(pThis->ppLstn[i], &(pThis->ppioDescrPtr[i]->sock)));
-        pThis->ppioDescrPtr[i]->ptrType = NSD_PTR_TYPE_LSTN;
-        pThis->ppioDescrPtr[i]->ptr.ppLstn = pThis->ppLstn;
-        CHKiRet(epoll_Ctl(pThis, pThis->ppioDescrPtr[i], 1, EPOLL_CTL_ADD));
-        DBGPRINTF("Added listener %d\n", i);
+        CHKiRet(addLstnDescr(pThis, i, pThis->evtdata.epoll.efd));
     }
 
     while (glbl.GetGlobalInputTermState() == 0) {
         numEntries = sizeof(workset) / sizeof(tcpsrv_io_descr_t *);
-        localRet = epoll_Wait(pThis, -1, &numEntries, workset);
+        localRet = epoll_Wait(pThis->evtdata.epoll.efd, -1, &numEntries, workset);
         if (glbl.GetGlobalInputTermState() == 1) {
             break; /* terminate input! */
         }
@@ -1645,9 +1843,7 @@ static rsRetVal ATTR_NONNULL() RunEpoll(tcpsrv_t *const pThis) {
 
     /* remove the tcp listen sockets from the epoll set */
     for (i = 0; i < pThis->iLstnCurr; ++i) {
-        CHKiRet(epoll_Ctl(pThis, pThis->ppioDescrPtr[i], 1, EPOLL_CTL_DEL));
-        DESTROY_ATOMIC_HELPER_MUT(pThis->ppioDescrPtr[i]->mut_isInError);
-        free(pThis->ppioDescrPtr[i]);
+        CHKiRet(removeLstnDescr(pThis, i));
     }
 
 finalize_it:
@@ -1679,15 +1875,32 @@ static rsRetVal ATTR_NONNULL() Run(tcpsrv_t *const pThis) {
     if (pThis->workQueue.numWrkr > 1) {
         iRet = startWrkrPool(pThis);
         if (iRet != RS_RET_OK) {
-            LogError(errno, iRet,
+            LogError(0, iRet,
                      "tcpsrv could not start worker pool "
                      "- now running single threaded '%s')",
                      (pThis->pszInputName == NULL) ? (uchar *)"*UNSET*" : pThis->pszInputName);
             pThis->workQueue.numWrkr = 1;
+            pThis->bWrkrReusePort = 0; /* RunEpoll() then serves all listeners */
         }
     }
 #if defined(ENABLE_IMTCP_EPOLL)
-    iRet = RunEpoll(pThis);
+    if (pThis->bWrkrReusePort) {
+        /* The workers run their own event loops, we just block until termination.
+         * Nobody writes to the wakeup pipe before stopWrkrPool(), so poll() returns
+         * only when the SIGTTIN of thrdTerminate() interrupts it.
+         */
+        struct pollfd pfd;
+        pfd.fd = pThis->workQueue.wakeupFds[0];
+        pfd.events = POLLIN;
+        while (glbl.GetGlobalInputTermState() == 0) {
+            if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+                LogError(errno, RS_RET_IO_ERROR, "tcpsrv could not wait for termination");
+                srSleep(1, 0);
+            }
+        }
+    } else {
+        iRet = RunEpoll(pThis);
+    }
 #else
     /* fall back to select */
     iRet = RunPoll(pThis);
@@ -1748,10 +1961,27 @@ static rsRetVal ATTR_NONNULL() tcpsrvConstructFinalize(tcpsrv_t *pThis) {
         CHKiRet(netstrms.SetDrvrGnutlsPriorityString(pThis->pNS, pThis->gnutlsPriorityString));
     CHKiRet(netstrms.ConstructFinalize(pThis->pNS));
 
+    if (pThis->bWrkrReusePort) {
+#if defined(ENABLE_IMTCP_EPOLL) && defined(SO_REUSEPORT)
+        if (pThis->workQueue.numWrkr > 1) {
+            pThis->iLstnMax *= pThis->workQueue.numWrkr; /* each worker has its own listeners */
+        } else {
+            pThis->bWrkrReusePort = 0;
+        }
+#else
+        LogError(0, RS_RET_NOT_IMPLEMENTED,
+                 "tcpsrv: per-worker listeners need epoll and SO_REUSEPORT, which are "
+                 "not available on this platform - using the shared work queue (inputname: '%s')",
+                 (pThis->pszInputName == NULL) ? (uchar *)"*UNSET*" : pThis->pszInputName);
+        pThis->bWrkrReusePort = 0;
+#endif
+    }
+
     /* set up listeners */
     CHKmalloc(pThis->ppLstn = calloc(pThis->iLstnMax, sizeof(netstrm_t *)));
     CHKmalloc(pThis->ppLstnPort = calloc(pThis->iLstnMax, sizeof(tcpLstnPortList_t *)));
     CHKmalloc(pThis->ppioDescrPtr = calloc(pThis->iLstnMax, sizeof(tcpsrv_io_descr_t *)));
+    CHKmalloc(pThis->piLstnWrkr = calloc(pThis->iLstnMax, sizeof(int)));
     iRet = pThis->OpenLstnSocks(pThis);
 
 finalize_it:
@@ -1763,6 +1993,8 @@ finalize_it:
         pThis->ppLstnPort = NULL;
         free(pThis->ppioDescrPtr);
         pThis->ppioDescrPtr = NULL;
+        free(pThis->piLstnWrkr);
+        pThis->piLstnWrkr = NULL;
 
         LogError(0, iRet, "tcpsrv could not create listener (inputname: '%s')",
                  (pThis->pszInputName == NULL) ? (uchar *)"*UNSET*" : pThis->pszInputName);
@@ -1792,6 +2024,7 @@ BEGINobjDestruct(tcpsrv) /* be sure to specify the object type also in END and C
     free(pThis->ppLstn);
     free(pThis->ppLstnPort);
     free(pThis->ppioDescrPtr);
+    free(pThis->piLstnWrkr);
     free(pThis->pszOrigin);
 ENDobjDestruct(tcpsrv)
 
@@ -2217,6 +2450,12 @@ static rsRetVal ATTR_NONNULL(1) SetStarvationMaxReads(tcpsrv_t *pThis, const uns
 }
 
 
+static rsRetVal ATTR_NONNULL(1) SetWrkrReusePort(tcpsrv_t *pThis, const int bReusePort) {
+    pThis->bWrkrReusePort = bReusePort;
+    return RS_RET_OK;
+}
+
+
 static rsRetVal ATTR_NONNULL(1) SetNumWrkr(tcpsrv_t *pThis, const int numWrkr) {
     pThis->workQueue.numWrkr = numWrkr;
     return RS_RET_OK;
@@ -2293,6 +2532,7 @@ BEGINobjQueryInterface(tcpsrv)
     pIf->SetDrvrTlsVerifyDepth = SetDrvrTlsVerifyDepth;
     pIf->SetSynBacklog = SetSynBacklog;
     pIf->SetNumWrkr = SetNumWrkr;
+    pIf->SetWrkrReusePort = SetWrkrReusePort;
     pIf->SetStarvationMaxReads = SetStarvationMaxReads;
 
 finalize_it:
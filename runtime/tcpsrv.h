@@ -53,6 +53,7 @@ struct tcpLstnParams_s {
     prop_t *pInputName;
     ruleset_t *pRuleset; /**< associated ruleset */
     uchar dfltTZ[8]; /**< default TZ if none in timestamp; '\0' =No Default */
+    sbool bReusePort; /**< set SO_REUSEPORT, so that several sockets can listen on the port */
 };
 
 /* list of tcp listen ports */
@@ -73,6 +74,7 @@ typedef struct tcpsrvWrkrData_s {
     STATSCOUNTER_DEF(ctrEmptyRead, mutCtrEmptyRead);
     STATSCOUNTER_DEF(ctrStarvation, mutCtrStarvation);
     STATSCOUNTER_DEF(ctrAccept, mutCtrAccept);
+    int efd; /**< with bWrkrReusePort: the worker's own epoll set */
 } tcpsrvWrkrData_t;
 
 typedef struct workQueue_s {
@@ -83,6 +85,7 @@ typedef struct workQueue_s {
     unsigned numWrkr; /* how many workers to spawn */
     pthread_t *wrkr_tids; /* array of thread IDs */
     tcpsrvWrkrData_t *wrkr_data;
+    int wakeupFds[2]; /* with bWrkrReusePort: pipe written to on stop, wakes all workers */
 } workQueue_t;
 
 /**
@@ -104,6 +107,7 @@ struct tcpsrv_io_descr_s {
     tcpsrv_io_descr_t *next; /* for use in workQueue_t */
 #if defined(ENABLE_IMTCP_EPOLL)
     struct epoll_event event; /* to re-enable EPOLLONESHOT */
+    int efd; /* the epoll set we are registered with */
 #endif
     DEF_ATOMIC_HELPER_MUT(mut_isInError);
 };
@@ -142,6 +146,8 @@ struct tcpsrv_s {
         sbool bSPFramingFix; /**< support work-around for broken Cisco ASA framing? */
         int iLstnCurr; /**< max nbr of listeners currently supported */
         netstrm_t **ppLstn; /**< our netstream listeners */
+        int *piLstnWrkr; /**< with bWrkrReusePort: the worker each listener belongs to */
+        int iLstnInitWrkr; /**< worker for which listeners are currently created */
         /* We could use conditional compilation, but that causes more complexity and is (proofen causing errors) */
         union {
             struct {
@@ -189,6 +195,7 @@ struct tcpsrv_s {
         /* work queue */
         workQueue_t workQueue;
         int currWrkrs;
+        sbool bWrkrReusePort; /**< each worker has its own epoll set and SO_REUSEPORT listeners */
 };
 
 
@@ -299,9 +306,11 @@ BEGINinterface(tcpsrv) /* name must also be changed in ENDinterface macro! */
      */
     rsRetVal (*SetNetworkNamespace)(tcpsrv_t *pThis, tcpLstnParams_t *const cnf_params,
                                     const char *const networkNamespace);
+    /* added v30 */
+    rsRetVal (*SetWrkrReusePort)(tcpsrv_t *pThis, int bReusePort);
 
 ENDinterface(tcpsrv)
-#define tcpsrvCURR_IF_VERSION 29 /* increment whenever you change the interface structure! */
+#define tcpsrvCURR_IF_VERSION 30 /* increment whenever you change the interface structure! */
 /* change for v4:
  * - SetAddtlFrameDelim() added -- rgerhards, 2008-12-10
  * - SetInputName() added -- rgerhards, 2008-12-10
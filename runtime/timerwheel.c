@@ -0,0 +1,331 @@
+/* timerwheel.c - shared hierarchical timer wheel
+ *
+ * The wheel has TW_LEVELS levels of TW_SIZE slots each. Level 0 holds
+ * timers due within the next TW_SIZE ticks, one slot per tick. Each
+ * higher level covers TW_SIZE times the range of the one below it. Whenever
+ * the level 0 index wraps, the current slot of the next level is
+ * "cascaded", that is its timers are re-inserted relative to the current
+ * time, which moves them one or more levels down. This is the classic
+ * scheme also used by the Linux kernel.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#ifdef HAVE_SYS_PRCTL_H
+    #include <sys/prctl.h>
+#endif
+
+#include "rsyslog.h"
+#include "srUtils.h"
+#include "errmsg.h"
+#include "timerwheel.h"
+
+#define TW_BITS 6
+#define TW_SIZE (1 << TW_BITS)
+#define TW_MASK (TW_SIZE - 1)
+#define TW_LEVELS 4
+/* timers further in the future are parked at the end of the wheel and
+ * re-inserted when they are cascaded (about 46 hours at 10ms ticks)
+ */
+#define TW_MAX_DELTA ((((uint64_t)1) << (TW_BITS * TW_LEVELS)) - 1)
+#define TW_IDLE UINT64_MAX
+
+static struct {
+    pthread_mutex_t mut;
+    pthread_cond_t condWake; /* wakes the timer thread */
+    pthread_cond_t condRunDone; /* a callback finished */
+    timerwheel_timer_t *slots[TW_LEVELS][TW_SIZE];
+    uint64_t now; /* next tick to process */
+    uint64_t nextWake; /* tick the timer thread sleeps until, TW_IDLE if none */
+    timerwheel_timer_t *running; /* timer whose callback is currently executed */
+    int nPending;
+    sbool bThrdRunning;
+    sbool bStop;
+    pthread_t thrdID;
+} tw;
+
+
+uint64_t timerwheelNowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* insert into the slot matching its expiry. tw.mut must be locked. */
+static void twLink(timerwheel_timer_t *const pTimer) {
+    uint64_t pos = (pTimer->expires > tw.now) ? pTimer->expires : tw.now;
+    uint64_t delta = pos - tw.now;
+    int lvl;
+
+    if (delta > TW_MAX_DELTA) {
+        delta = TW_MAX_DELTA;
+        pos = tw.now + TW_MAX_DELTA;
+    }
+    for (lvl = 0; lvl < TW_LEVELS - 1; ++lvl) {
+        if (delta < (((uint64_t)1) << (TW_BITS * (lvl + 1)))) break;
+    }
+    timerwheel_timer_t **const pSlot = &tw.slots[lvl][(pos >> (TW_BITS * lvl)) & TW_MASK];
+    pTimer->ppSlot = pSlot;
+    pTimer->prev = NULL;
+    pTimer->next = *pSlot;
+    if (*pSlot != NULL) (*pSlot)->prev = pTimer;
+    *pSlot = pTimer;
+}
+
+/* remove from its slot. tw.mut must be locked. */
+static void twUnlink(timerwheel_timer_t *const pTimer) {
+    if (pTimer->prev != NULL) {
+        pTimer->prev->next = pTimer->next;
+    } else {
+        *pTimer->ppSlot = pTimer->next;
+    }
+    if (pTimer->next != NULL) pTimer->next->prev = pTimer->prev;
+    pTimer->next = pTimer->prev = NULL;
+    pTimer->ppSlot = NULL;
+}
+
+/* re-insert all timers of the current slot of level lvl, returns the slot index */
+static int twCascade(const int lvl) {
+    const int idx = (tw.now >> (TW_BITS * lvl)) & TW_MASK;
+    timerwheel_timer_t *pTimer = tw.slots[lvl][idx];
+    timerwheel_timer_t *pNext;
+
+    tw.slots[lvl][idx] = NULL;
+    for (; pTimer != NULL; pTimer = pNext) {
+        pNext = pTimer->next;
+        twLink(pTimer);
+    }
+    return idx;
+}
+
+/* process one tick. Callbacks are called with tw.mut unlocked. */
+static void twRunTick(void) {
+    timerwheel_timer_t *pTimer;
+
+    if ((tw.now & TW_MASK) == 0) {
+        for (int lvl = 1; lvl < TW_LEVELS; ++lvl) {
+            if (twCascade(lvl) != 0) break;
+        }
+    }
+    while ((pTimer = tw.slots[0][tw.now & TW_MASK]) != NULL) {
+        twUnlink(pTimer);
+        pTimer->bPending = 0;
+        --tw.nPending;
+        tw.running = pTimer;
+        pthread_mutex_unlock(&tw.mut);
+        pTimer->cb(pTimer->pUsr);
+        pthread_mutex_lock(&tw.mut);
+        tw.running = NULL;
+        pthread_cond_broadcast(&tw.condRunDone);
+    }
+    ++tw.now;
+}
+
+/* earliest expiry of the timers in the slot list, TW_IDLE if empty */
+static uint64_t twSlotMin(const timerwheel_timer_t *pTimer) {
+    uint64_t minExp = TW_IDLE;
+    for (; pTimer != NULL; pTimer = pTimer->next) {
+        if (pTimer->expires < minExp) minExp = pTimer->expires;
+    }
+    return minExp;
+}
+
+/* tick at which the timer thread must wake up next, that is the earliest
+ * expiry of all pending timers. The slots of a level cover consecutive
+ * time ranges starting after the current slot, so on each level only the
+ * first non-empty slot needs to be looked at. The current slot of a higher
+ * level comes last, as it is cascaded only after a full round. A timer that
+ * was linked into a higher level earlier may well be due before a level 0
+ * one, so all levels are checked. Cascades due before the wakeup are done
+ * when the skipped ticks are processed.
+ */
+static uint64_t twNextWake(void) {
+    uint64_t next = TW_IDLE;
+
+    for (uint64_t tick = tw.now; tick < tw.now + TW_SIZE; ++tick) {
+        if (tw.slots[0][tick & TW_MASK] != NULL) {
+            next = tick;
+            break;
+        }
+    }
+    for (int lvl = 1; lvl < TW_LEVELS; ++lvl) {
+        const int cur = (tw.now >> (TW_BITS * lvl)) & TW_MASK;
+        for (int i = 1; i <= TW_SIZE; ++i) {
+            const timerwheel_timer_t *const pSlot = tw.slots[lvl][(cur + i) & TW_MASK];
+            if (pSlot != NULL) {
+                const uint64_t minExp = twSlotMin(pSlot);
+                if (minExp < next) next = minExp;
+                break;
+            }
+        }
+    }
+    return (next < tw.now) ? tw.now : next;
+}
+
+static void *twThread(void __attribute__((unused)) * arg) {
+    struct timespec t;
+    uint64_t nowMs;
+    sigset_t sigSet;
+
+    /* signals are handled by the main thread only */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+#if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    if (prctl(PR_SET_NAME, "rs:timerwheel", 0, 0, 0) != 0) {
+        DBGPRINTF("prctl failed, not setting thread name for '%s'\n", "timerwheel");
+    }
+#endif
+    pthread_mutex_lock(&tw.mut);
+    while (!tw.bStop) {
+        nowMs = timerwheelNowMs();
+        while (tw.now <= nowMs / TIMERWHEEL_TICK_MS && !tw.bStop) {
+            twRunTick();
+        }
+        if (tw.bStop) break;
+        if (tw.nPending == 0) {
+            tw.nextWake = TW_IDLE;
+            pthread_cond_wait(&tw.condWake, &tw.mut);
+        } else {
+            tw.nextWake = twNextWake();
+            nowMs = timerwheelNowMs();
+            if (tw.nextWake * TIMERWHEEL_TICK_MS > nowMs) {
+                timeoutComp(&t, (long)(tw.nextWake * TIMERWHEEL_TICK_MS - nowMs));
+                pthread_cond_timedwait(&tw.condWake, &tw.mut, &t);
+            }
+        }
+    }
+    pthread_mutex_unlock(&tw.mut);
+    return NULL;
+}
+
+
+void timerwheelTimerInit(timerwheel_timer_t *const pTimer, void (*cb)(void *), void *const pUsr) {
+    memset(pTimer, 0, sizeof(*pTimer));
+    pTimer->cb = cb;
+    pTimer->pUsr = pUsr;
+}
+
+rsRetVal timerwheelArm(timerwheel_timer_t *const pTimer, long ms) {
+    const uint64_t nowMs = timerwheelNowMs();
+    DEFiRet;
+
+    if (ms < 0) ms = 0;
+    pthread_mutex_lock(&tw.mut);
+    if (!tw.bThrdRunning) {
+        if (pthread_create(&tw.thrdID, &default_thread_attr, twThread, NULL) != 0) {
+            pthread_mutex_unlock(&tw.mut);
+            LogError(errno, RS_RET_ERR, "timerwheel: cannot create timer thread");
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        tw.bThrdRunning = 1;
+    }
+    if (pTimer->bPending) {
+        twUnlink(pTimer);
+        --tw.nPending;
+    } else if (tw.nPending == 0 && tw.running == NULL) {
+        /* wheel is empty and the thread sleeps: skip ticks nobody waits for */
+        tw.now = nowMs / TIMERWHEEL_TICK_MS;
+    }
+    pTimer->expires = (nowMs + ms + TIMERWHEEL_TICK_MS - 1) / TIMERWHEEL_TICK_MS;
+    twLink(pTimer);
+    pTimer->bPending = 1;
+    ++tw.nPending;
+    if (pTimer->expires < tw.nextWake) {
+        pthread_cond_signal(&tw.condWake);
+    }
+    pthread_mutex_unlock(&tw.mut);
+
+finalize_it:
+    RETiRet;
+}
+
+int timerwheelCancel(timerwheel_timer_t *const pTimer) {
+    int bWasPending;
+
+    pthread_mutex_lock(&tw.mut);
+    bWasPending = pTimer->bPending;
+    if (bWasPending) {
+        twUnlink(pTimer);
+        pTimer->bPending = 0;
+        --tw.nPending;
+    }
+    pthread_mutex_unlock(&tw.mut);
+    return bWasPending;
+}
+
+void timerwheelCancelSync(timerwheel_timer_t *const pTimer) {
+    pthread_mutex_lock(&tw.mut);
+    if (pTimer->bPending) {
+        twUnlink(pTimer);
+        pTimer->bPending = 0;
+        --tw.nPending;
+    }
+    while (tw.running == pTimer && !pthread_equal(pthread_self(), tw.thrdID)) {
+        pthread_cond_wait(&tw.condRunDone, &tw.mut);
+    }
+    pthread_mutex_unlock(&tw.mut);
+}
+
+/* the timer thread does not survive fork(), so it is re-created on next use */
+static void twAtForkChild(void) {
+    pthread_mutex_init(&tw.mut, NULL);
+    pthread_cond_init(&tw.condWake, NULL);
+    pthread_cond_init(&tw.condRunDone, NULL);
+    tw.bThrdRunning = 0;
+    tw.running = NULL;
+    tw.nextWake = TW_IDLE;
+}
+
+rsRetVal timerwheelClassInit(void) {
+    DEFiRet;
+
+    memset(&tw, 0, sizeof(tw));
+    pthread_mutex_init(&tw.mut, NULL);
+    pthread_cond_init(&tw.condWake, NULL);
+    pthread_cond_init(&tw.condRunDone, NULL);
+    tw.now = timerwheelNowMs() / TIMERWHEEL_TICK_MS;
+    tw.nextWake = TW_IDLE;
+    if (pthread_atfork(NULL, NULL, twAtForkChild) != 0) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+void timerwheelClassExit(void) {
+    pthread_mutex_lock(&tw.mut);
+    tw.bStop = 1;
+    pthread_cond_signal(&tw.condWake);
+    pthread_mutex_unlock(&tw.mut);
+    if (tw.bThrdRunning) {
+        pthread_join(tw.thrdID, NULL);
+        tw.bThrdRunning = 0;
+    }
+    pthread_cond_destroy(&tw.condRunDone);
+    pthread_cond_destroy(&tw.condWake);
+    pthread_mutex_destroy(&tw.mut);
+}
@@ -0,0 +1,93 @@
+/* timerwheel.h - shared hierarchical timer wheel
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file timerwheel.h
+ * @brief One thread that fires all timeouts of the runtime.
+ *
+ * Components that need to be notified after some time (idle worker
+ * shutdown, action retry waits, stream flush intervals, the janitor) embed
+ * a timerwheel_timer_t and arm it instead of doing their own timed waits.
+ * Timers are kept in a hierarchical wheel with a resolution of
+ * TIMERWHEEL_TICK_MS, so arming and cancelling are O(1), and the timer
+ * thread only wakes up when a timer is due.
+ *
+ * The wheel replaces timed waits, and with the shared worker pool also the
+ * waiting threads: a pooled worker whose action waits for a retry parks
+ * with its batch, and the wheel submits it again when the retry is due
+ * (see wtiRetryPark()). Other workers still wait in their own thread,
+ * woken by the wheel.
+ *
+ * Callbacks run on the timer thread without any timer wheel lock held.
+ * They must be short; typically they set a flag and signal a condition.
+ * The timer thread is started on first use, so that it exists only after
+ * rsyslogd has forked into the background.
+ */
+#ifndef INCLUDED_TIMERWHEEL_H
+#define INCLUDED_TIMERWHEEL_H
+
+#include <stdint.h>
+
+/** Resolution of the timer wheel in milliseconds. */
+#define TIMERWHEEL_TICK_MS 10
+
+typedef struct timerwheel_timer_s timerwheel_timer_t;
+
+/** A timer. Owned by the caller, usually embedded into its object. */
+struct timerwheel_timer_s {
+    timerwheel_timer_t *next; /**< bucket list, valid while pending */
+    timerwheel_timer_t *prev;
+    timerwheel_timer_t **ppSlot; /**< bucket the timer is linked into */
+    uint64_t expires; /**< expiry in ticks */
+    void (*cb)(void *pUsr);
+    void *pUsr;
+    sbool bPending;
+};
+
+/** Initialize @p pTimer. Must be done once before it is armed. */
+void timerwheelTimerInit(timerwheel_timer_t *pTimer, void (*cb)(void *), void *pUsr);
+
+/**
+ * Fire @p pTimer in @p ms milliseconds (or later by at most one tick). If
+ * the timer is already pending, it is rescheduled. May be called from
+ * within a callback, including the timer's own.
+ */
+rsRetVal timerwheelArm(timerwheel_timer_t *pTimer, long ms);
+
+/**
+ * Cancel @p pTimer if it is pending. Returns 1 if it was pending. The
+ * callback may still be running (or about to run) when this returns.
+ */
+int timerwheelCancel(timerwheel_timer_t *pTimer);
+
+/**
+ * Cancel @p pTimer and wait until a concurrently running callback of it
+ * has finished. Must be used before the timer's memory is freed. Must not
+ * be called with locks held that the callback acquires.
+ */
+void timerwheelCancelSync(timerwheel_timer_t *pTimer);
+
+/** Current value of the monotonic clock used by the wheel, in ms. */
+uint64_t timerwheelNowMs(void);
+
+rsRetVal timerwheelClassInit(void);
+void timerwheelClassExit(void);
+
+#endif /* #ifndef INCLUDED_TIMERWHEEL_H */
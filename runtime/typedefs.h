@@ -134,6 +134,11 @@ typedef struct dynstats_bucket_s dynstats_bucket_t;
 typedef struct dynstats_buckets_s dynstats_buckets_t;
 typedef struct perctile_buckets_s perctile_buckets_t;
 typedef struct dynstats_ctr_s dynstats_ctr_t;
+typedef struct scriptprof_ctr_s scriptprof_ctr_t;
+typedef struct jsonlazy_keys_s jsonlazy_keys_t;
+typedef struct omTxCompletion_s omTxCompletion_t;
+typedef struct actAsyncTx_s actAsyncTx_t;
+typedef struct cpuaffinity_s cpuaffinity_t;
 
 /* under Solaris (actually only SPARC), we need to redefine some types
  * to be void, so that we get void* pointers. Otherwise, we will see
@@ -0,0 +1,299 @@
+/* wrkpool.c - shared worker pool for queue workers
+ *
+ * See wrkpool.h for the concept. The pool threads are detached; at exit
+ * we wait until all of them have ended their loop.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#ifdef HAVE_SYS_PRCTL_H
+    #include <sys/prctl.h>
+#endif
+
+#include "rsyslog.h"
+#include "errmsg.h"
+#include "rsconf.h"
+#include "wti.h"
+#include "wtp.h"
+#include "wrkpool.h"
+
+/* one pool thread. cur is only ever compared, never dereferenced: once a
+ * worker ends, its queue may destruct it at any time.
+ */
+typedef struct {
+    pthread_t thrdID;
+    wti_t *cur; /* worker currently executed, NULL if none */
+} wrkpoolThrd_t;
+
+static struct {
+    pthread_mutex_t mut;
+    pthread_cond_t condWork; /* a worker was submitted or we shall stop */
+    pthread_cond_t condExit; /* a pool thread ended */
+    wti_t *pRunHead; /* run queue, linked via wti_t.pPoolNext */
+    wti_t *pRunTail;
+    wrkpoolThrd_t *thrds;
+    int nThrds; /* configured pool size */
+    int nRunning; /* pool threads currently alive */
+    sbool bStarted;
+    sbool bStop;
+} pool;
+
+
+static void *wrkpoolThread(void *arg);
+
+/* start the pool thread for slot i. pool.mut must be locked. */
+static rsRetVal wrkpoolStartThrd(const int i) {
+    pthread_attr_t attr;
+    pthread_t thrdID;
+    int r;
+    DEFiRet;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pool.thrds[i].cur = NULL;
+    r = pthread_create(&thrdID, &attr, wrkpoolThread, &pool.thrds[i]);
+    pthread_attr_destroy(&attr);
+    if (r != 0) {
+        LogError(r, RS_RET_ERR, "worker pool: cannot create pool thread");
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    pool.thrds[i].thrdID = thrdID;
+    ++pool.nRunning;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* Called when a pool thread ends. This is normally only at exit, but a
+ * pool thread is also cancelled if a worker it executes hangs during
+ * shutdown. In that case it is replaced, so that the remaining submitted
+ * workers still get run.
+ */
+static void wrkpoolThrdCleanup(void *arg) {
+    wrkpoolThrd_t *const pThrd = (wrkpoolThrd_t *)arg;
+
+    pthread_mutex_lock(&pool.mut);
+    pThrd->cur = NULL;
+    --pool.nRunning;
+    if (!pool.bStop) {
+        wrkpoolStartThrd(pThrd - pool.thrds);
+    }
+    pthread_cond_broadcast(&pool.condExit);
+    pthread_mutex_unlock(&pool.mut);
+}
+
+
+static void *wrkpoolThread(void *arg) {
+    wrkpoolThrd_t *const pThrd = (wrkpoolThrd_t *)arg;
+    wti_t *pWti;
+    sigset_t sigSet;
+
+    /* same signal setup as dedicated queue worker threads */
+    sigfillset(&sigSet);
+    sigdelset(&sigSet, SIGTTIN);
+    sigdelset(&sigSet, SIGSEGV);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+    /* cancellation is only acted on where the executed worker enables it */
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+#if defined(HAVE_PRCTL) && defined(PR_SET_NAME)
+    if (prctl(PR_SET_NAME, "rs:wrkpool", 0, 0, 0) != 0) {
+        DBGPRINTF("prctl failed, not setting thread name for '%s'\n", "wrkpool");
+    }
+#endif
+
+    pthread_cleanup_push(wrkpoolThrdCleanup, pThrd);
+    pthread_mutex_lock(&pool.mut);
+    while (1) {
+        while (pool.pRunHead == NULL && !pool.bStop) {
+            pthread_cond_wait(&pool.condWork, &pool.mut);
+        }
+        if (pool.pRunHead == NULL) break; /* stop requested and nothing left */
+        pWti = pool.pRunHead;
+        pool.pRunHead = pWti->pPoolNext;
+        if (pool.pRunHead == NULL) pool.pRunTail = NULL;
+        pWti->pPoolNext = NULL;
+        pThrd->cur = pWti;
+        pthread_mutex_unlock(&pool.mut);
+
+        wtpRunPooledWrkr(pWti);
+
+        pthread_mutex_lock(&pool.mut);
+        pThrd->cur = NULL;
+    }
+    pthread_mutex_unlock(&pool.mut);
+    pthread_cleanup_pop(1);
+    return NULL;
+}
+
+
+/* the pool thread that currently executes pWti, NULL if none.
+ * pool.mut must be locked.
+ */
+static wrkpoolThrd_t *wrkpoolFindExec(const wti_t *const pWti) {
+    for (int i = 0; i < pool.nThrds; ++i) {
+        if (pool.thrds[i].cur == pWti) return &pool.thrds[i];
+    }
+    return NULL;
+}
+
+
+int wrkpoolEnabled(const rsconf_t *const cnf) {
+    return cnf->globals.wrkPoolThreads > 0;
+}
+
+
+rsRetVal wrkpoolSubmit(wti_t *const pWti) {
+    DEFiRet;
+
+    pthread_mutex_lock(&pool.mut);
+    if (!pool.bStarted) {
+        /* the size can not change once the pool is started */
+        const int nThrds = runConf->globals.wrkPoolThreads;
+        if ((pool.thrds = calloc(nThrds, sizeof(wrkpoolThrd_t))) == NULL) {
+            pthread_mutex_unlock(&pool.mut);
+            ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+        }
+        pool.nThrds = nThrds;
+        for (int i = 0; i < pool.nThrds; ++i) {
+            if (wrkpoolStartThrd(i) != RS_RET_OK) break;
+        }
+        pool.bStarted = 1;
+        DBGPRINTF("worker pool: started %d threads\n", pool.nRunning);
+    }
+    if (pool.nRunning == 0) {
+        pthread_mutex_unlock(&pool.mut);
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+    pWti->pPoolNext = NULL;
+    if (pool.pRunTail == NULL) {
+        pool.pRunHead = pWti;
+    } else {
+        pool.pRunTail->pPoolNext = pWti;
+    }
+    pool.pRunTail = pWti;
+    pthread_cond_signal(&pool.condWork);
+    pthread_mutex_unlock(&pool.mut);
+
+finalize_it:
+    RETiRet;
+}
+
+
+int wrkpoolHaveWaiting(void) {
+    int bWaiting;
+
+    pthread_mutex_lock(&pool.mut);
+    bWaiting = pool.pRunHead != NULL;
+    pthread_mutex_unlock(&pool.mut);
+    return bWaiting;
+}
+
+
+int wrkpoolRevoke(wti_t *const pWti) {
+    int state = WRKPOOL_IDLE;
+    wti_t **ppPrev;
+    wti_t *pPrev = NULL;
+
+    pthread_mutex_lock(&pool.mut);
+    if (wrkpoolFindExec(pWti) != NULL) {
+        state = WRKPOOL_EXEC;
+    } else {
+        for (ppPrev = &pool.pRunHead; *ppPrev != NULL; pPrev = *ppPrev, ppPrev = &(*ppPrev)->pPoolNext) {
+            if (*ppPrev == pWti) {
+                *ppPrev = pWti->pPoolNext;
+                if (pool.pRunTail == pWti) pool.pRunTail = pPrev;
+                pWti->pPoolNext = NULL;
+                state = WRKPOOL_REVOKED;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&pool.mut);
+    return state;
+}
+
+
+int wrkpoolKill(wti_t *const pWti, const int bCancel) {
+    wrkpoolThrd_t *pThrd;
+
+    pthread_mutex_lock(&pool.mut);
+    if ((pThrd = wrkpoolFindExec(pWti)) != NULL) {
+        if (bCancel) {
+            pthread_cancel(pThrd->thrdID);
+        }
+        pthread_kill(pThrd->thrdID, SIGTTIN);
+    }
+    pthread_mutex_unlock(&pool.mut);
+    return pThrd != NULL;
+}
+
+
+/* the pool threads do not survive fork(), so they are re-created on next use */
+static void wrkpoolAtForkChild(void) {
+    pthread_mutex_init(&pool.mut, NULL);
+    pthread_cond_init(&pool.condWork, NULL);
+    pthread_cond_init(&pool.condExit, NULL);
+    pool.pRunHead = pool.pRunTail = NULL;
+    free(pool.thrds);
+    pool.thrds = NULL;
+    pool.nThrds = 0;
+    pool.nRunning = 0;
+    pool.bStarted = 0;
+}
+
+
+rsRetVal wrkpoolClassInit(void) {
+    DEFiRet;
+
+    memset(&pool, 0, sizeof(pool));
+    pthread_mutex_init(&pool.mut, NULL);
+    pthread_cond_init(&pool.condWork, NULL);
+    pthread_cond_init(&pool.condExit, NULL);
+    if (pthread_atfork(NULL, NULL, wrkpoolAtForkChild) != 0) {
+        ABORT_FINALIZE(RS_RET_ERR);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* All queues have been shut down when this is called, so the run queue
+ * is empty and all pool threads are idle.
+ */
+void wrkpoolClassExit(void) {
+    pthread_mutex_lock(&pool.mut);
+    pool.bStop = 1;
+    pthread_cond_broadcast(&pool.condWork);
+    while (pool.nRunning > 0) {
+        pthread_cond_wait(&pool.condExit, &pool.mut);
+    }
+    pthread_mutex_unlock(&pool.mut);
+    free(pool.thrds);
+    pool.thrds = NULL;
+    pthread_cond_destroy(&pool.condExit);
+    pthread_cond_destroy(&pool.condWork);
+    pthread_mutex_destroy(&pool.mut);
+}
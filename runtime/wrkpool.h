@@ -0,0 +1,84 @@
+/* wrkpool.h - shared worker pool for queue workers
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog runtime library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file wrkpool.h
+ * @brief Process-wide threads that execute the workers of many queues.
+ *
+ * Without the pool, every worker (wti_t) of a queue has a thread of its
+ * own, which mostly sleeps. With the global "workerPool.threads" setting,
+ * queues instead submit a worker to the pool when it has work. A pool
+ * thread then runs that worker until the queue is drained and the worker
+ * is "parked" (see wtiWorker()). A worker keeps its action worker
+ * instances while parked, and a worker is only ever run by one pool
+ * thread at a time. So the number of workers of a queue still caps its
+ * concurrency, exactly as queue.workerThreads did before.
+ *
+ * Runnable workers are kept in a single FIFO run queue. Workers are
+ * submitted by the enqueueing threads, which are not pool threads. So
+ * per-thread deques with work stealing would not save anything here.
+ *
+ * A worker that keeps finding work would never give its thread back. So
+ * once it has run for WRKPOOL_SLICE_USEC and other workers wait in the run
+ * queue, it yields: it re-submits itself to the tail of the run queue
+ * after the current batch. Each runnable worker thus gets a pool thread
+ * after at most ceil(runnable workers / pool threads) time slices (plus
+ * the time to finish the batches in progress).
+ */
+#ifndef INCLUDED_WRKPOOL_H
+#define INCLUDED_WRKPOOL_H
+
+/** time a pooled worker may run while others wait for a pool thread */
+#define WRKPOOL_SLICE_USEC 10000
+
+/** Shall the queues of @p cnf use the shared worker pool? */
+int wrkpoolEnabled(const rsconf_t *cnf);
+
+/**
+ * Queue @p pWti for execution by a pool thread. The pool threads are
+ * started on first use, sized by the running config.
+ */
+rsRetVal wrkpoolSubmit(wti_t *pWti);
+
+/** Do workers wait in the run queue for a pool thread? */
+int wrkpoolHaveWaiting(void);
+
+/** Pool state of a worker, as returned by wrkpoolRevoke(). */
+#define WRKPOOL_IDLE 0 /**< neither queued nor executing */
+#define WRKPOOL_REVOKED 1 /**< was queued, now removed from the run queue */
+#define WRKPOOL_EXEC 2 /**< currently executed by a pool thread */
+
+/**
+ * Take @p pWti out of the run queue if it is queued. Used when workers are
+ * cancelled at shutdown. Returns one of the WRKPOOL_* states.
+ */
+int wrkpoolRevoke(wti_t *pWti);
+
+/**
+ * Send SIGTTIN to the pool thread executing @p pWti and, if @p bCancel is
+ * set, cancel it. A NOP if @p pWti is not executing, so that a stale
+ * thread ID is never used. Returns 1 if it was executing.
+ */
+int wrkpoolKill(wti_t *pWti, int bCancel);
+
+rsRetVal wrkpoolClassInit(void);
+void wrkpoolClassExit(void);
+
+#endif /* #ifndef INCLUDED_WRKPOOL_H */
@@ -36,6 +36,8 @@
 #include <signal.h>
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
+#include <sched.h>
 
 #include "rsyslog.h"
 #include "stringbuf.h"
@@ -48,6 +50,21 @@
 #include "action.h"
 #include "atomic.h"
 #include "rsconf.h"
+#include "wrkpool.h"
+
+/* spinning of idle workers (see wtiSpinForWork) */
+#define SPIN_PAUSE_ITERATIONS 64 /* busy iterations before we start to yield the CPU */
+#define SPIN_MIN_DIVISOR 8 /* do not spin if the budget fell below 1/8 of the maximum */
+
+#define ASYNCTX_WAIT_MS 1000 /* max wait for async transaction completion before we poll anyway */
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define cpuRelax() __asm__ __volatile__("pause" ::: "memory")
+#elif defined(__aarch64__)
+    #define cpuRelax() __asm__ __volatile__("yield" ::: "memory")
+#else
+    #define cpuRelax() __asm__ __volatile__("" ::: "memory")
+#endif
 
 /* static data */
 DEFobjStaticHelpers;
@@ -130,7 +147,16 @@ rsRetVal wtiWakeupThrd(wti_t *pThis) {
 
     ISOBJ_TYPE_assert(pThis, wti);
 
-    if (wtiGetState(pThis)) {
+    /* end a wtiSleep() in progress */
+    pthread_mutex_lock(&pThis->mutSleep);
+    pThis->bSleepWakeup = 1;
+    pthread_cond_signal(&pThis->condSleep);
+    pthread_mutex_unlock(&pThis->mutSleep);
+
+    if (pThis->pWtp->bPooled) {
+        /* thrdID is only valid while a pool thread executes us */
+        wrkpoolKill(pThis, 0);
+    } else if (wtiGetState(pThis)) {
         /* we first try the cooperative "cancel" interface */
         pthread_kill(pThis->thrdID, SIGTTIN);
         DBGPRINTF("sent SIGTTIN to worker thread %p\n", (void *)pThis->thrdID);
@@ -140,6 +166,53 @@ rsRetVal wtiWakeupThrd(wti_t *pThis) {
 }
 
 
+/* cancel a worker that runs on the shared worker pool. If it is parked
+ * or waits in the run queue, we take it over and let it terminate on our
+ * own thread (the wtp is in immediate shutdown state by now, so it does not
+ * process anything). Only if a pool thread executes it, that thread is
+ * cancelled; the pool then replaces it.
+ */
+static void ATTR_NONNULL() wtiCancelPooled(wti_t *const pThis, const uchar *const cancelobj) {
+    wtp_t *const pWtp = pThis->pWtp;
+    int poolState;
+    int bOwn;
+    int nTries = 0;
+
+    while (wtiGetState(pThis) != WRKTHRD_STOPPED) {
+        d_pthread_mutex_lock(pWtp->pmutUsr);
+        poolState = wrkpoolRevoke(pThis);
+        bOwn = poolState == WRKPOOL_REVOKED ||
+               (poolState == WRKPOOL_IDLE && (pThis->bPoolParked || pThis->bRetryParked));
+        if (bOwn) {
+            pThis->bPoolParked = 0;
+            pThis->bIdleWaiting = 0;
+            pThis->bRetryParked = 0;
+        }
+        d_pthread_mutex_unlock(pWtp->pmutUsr);
+
+        if (bOwn) {
+            timerwheelCancelSync(&pThis->idleTimer);
+            timerwheelCancelSync(&pThis->retryTimer);
+            wtpRunPooledWrkr(pThis);
+        } else if (poolState == WRKPOOL_EXEC) {
+            if (nTries == 0) {
+                LogMsg(0, RS_RET_ERR, LOG_WARNING,
+                       "%s: need to do cooperative cancellation "
+                       "- some data may be lost, increase timeout?",
+                       cancelobj);
+            } else if (nTries == 5) {
+                LogMsg(0, RS_RET_ERR, LOG_WARNING, "%s: need to do hard cancellation", cancelobj);
+            }
+            wrkpoolKill(pThis, nTries >= 5);
+            ++nTries;
+            srSleep(0, 10000);
+        } else {
+            srSleep(0, 10000); /* just about to park or terminate */
+        }
+    }
+}
+
+
 /* Cancel the thread. If the thread is not running. But it is save and legal to
  * call wtiCancelThrd() in such situations. This function only returns when the
  * thread has terminated. Else we may get race conditions all over the code...
@@ -154,6 +227,11 @@ rsRetVal ATTR_NONNULL() wtiCancelThrd(wti_t *pThis, const uchar *const cancelobj
 
     ISOBJ_TYPE_assert(pThis, wti);
 
+    if (pThis->pWtp->bPooled) {
+        wtiCancelPooled(pThis, cancelobj);
+        FINALIZE;
+    }
+
     wtiJoinThrd(pThis);
     if (wtiGetState(pThis) != WRKTHRD_STOPPED) {
         LogMsg(0, RS_RET_ERR, LOG_WARNING,
@@ -185,6 +263,8 @@ rsRetVal ATTR_NONNULL() wtiCancelThrd(wti_t *pThis, const uchar *const cancelobj
     }
 
     wtiJoinThrd(pThis);
+
+finalize_it:
     RETiRet;
 }
 
@@ -212,6 +292,84 @@ finalize_it:
 }
 
 
+/* timer wheel callback: end idle processing if the worker still waits
+ * for the deadline this timer was armed for. A stale expiry (the worker
+ * received work in the meantime) finds a later deadline or no waiter.
+ */
+static void wtiIdleTimerCB(void *pUsr) {
+    wti_t *const pThis = (wti_t *)pUsr;
+    wtp_t *const pWtp = pThis->pWtp;
+
+    d_pthread_mutex_lock(pWtp->pmutUsr);
+    if (pThis->bIdleWaiting && timerwheelNowMs() >= pThis->idleDeadline) {
+        pThis->bIdleTimedOut = 1;
+        if (pThis->bPoolParked) {
+            /* let it run once more, so that it terminates */
+            pThis->bPoolParked = 0;
+            pThis->bIdleWaiting = 0;
+            wrkpoolSubmit(pThis);
+        } else {
+            pthread_cond_signal(&pThis->pcondBusy);
+        }
+    }
+    d_pthread_mutex_unlock(pWtp->pmutUsr);
+}
+
+static void wtiSleepTimerCB(void *pUsr) {
+    wti_t *const pThis = (wti_t *)pUsr;
+
+    pthread_mutex_lock(&pThis->mutSleep);
+    pThis->bSleepWakeup = 1;
+    pthread_cond_signal(&pThis->condSleep);
+    pthread_mutex_unlock(&pThis->mutSleep);
+}
+
+/* sleep for ms milliseconds, driven by the shared timer wheel. The sleep
+ * ends early if the worker is woken up via wtiWakeupThrd(), as is done
+ * during shutdown.
+ */
+void ATTR_NONNULL() wtiSleep(wti_t *const pThis, const long ms) {
+    pthread_mutex_lock(&pThis->mutSleep);
+    pThis->bSleepWakeup = 0;
+    if (timerwheelArm(&pThis->sleepTimer, ms) == RS_RET_OK) {
+        while (!pThis->bSleepWakeup) {
+            pthread_cond_wait(&pThis->condSleep, &pThis->mutSleep);
+        }
+    }
+    pthread_mutex_unlock(&pThis->mutSleep);
+    timerwheelCancel(&pThis->sleepTimer);
+}
+
+
+/* end the retry wait of a parked worker (see wtiRetryPark()) and queue it
+ * for the shared pool, so that it continues its batch. Used at shutdown, so
+ * that the worker does not wait for its retry timer. pmutUsr must be locked.
+ */
+void ATTR_NONNULL() wtiEndRetryWait(wti_t *const pThis) {
+    if (pThis->bRetryParked) {
+        pThis->bRetryParked = 0;
+        pThis->bRetryResume = 1;
+        timerwheelCancel(&pThis->retryTimer);
+        wrkpoolSubmit(pThis);
+    }
+}
+
+/* timer wheel callback: the action retry a parked worker waits for is due.
+ * A stale expiry (the worker was resumed early and parked again) finds a
+ * later deadline.
+ */
+static void wtiRetryTimerCB(void *pUsr) {
+    wti_t *const pThis = (wti_t *)pUsr;
+    wtp_t *const pWtp = pThis->pWtp;
+
+    d_pthread_mutex_lock(pWtp->pmutUsr);
+    if (pThis->bRetryParked && timerwheelNowMs() >= pThis->retryDeadline) {
+        wtiEndRetryWait(pThis);
+    }
+    d_pthread_mutex_unlock(pWtp->pmutUsr);
+}
+
+
 /* Destructor */
 BEGINobjDestruct(wti) /* be sure to specify the object type also in END and CODESTART macros! */
     CODESTARTobjDestruct(wti);
@@ -224,9 +382,19 @@ BEGINobjDestruct(wti) /* be sure to specify the object type also in END and CODE
         }
     }
     /* actual destruction */
+    timerwheelCancelSync(&pThis->idleTimer);
+    timerwheelCancelSync(&pThis->sleepTimer);
+    timerwheelCancelSync(&pThis->retryTimer);
     batchFree(&pThis->batch);
     free(pThis->actWrkrInfo);
+    for (int i = 0; i < pThis->nBatchExecMasks; ++i) {
+        free(pThis->batchExecMasks[i]);
+    }
+    free(pThis->batchExecMasks);
+    if (pThis->jsonTokener != NULL) json_tokener_free(pThis->jsonTokener);
     pthread_cond_destroy(&pThis->pcondBusy);
+    pthread_cond_destroy(&pThis->condSleep);
+    pthread_mutex_destroy(&pThis->mutSleep);
     DESTROY_ATOMIC_HELPER_MUT(pThis->mutIsRunning);
     free(pThis->pszDbgHdr);
 ENDobjDestruct(wti)
@@ -237,6 +405,11 @@ ENDobjDestruct(wti)
 BEGINobjConstruct(wti) /* be sure to specify the object type also in END macro! */
     INIT_ATOMIC_HELPER_MUT(pThis->mutIsRunning);
     pthread_cond_init(&pThis->pcondBusy, NULL);
+    pthread_mutex_init(&pThis->mutSleep, NULL);
+    pthread_cond_init(&pThis->condSleep, NULL);
+    timerwheelTimerInit(&pThis->idleTimer, wtiIdleTimerCB, pThis);
+    timerwheelTimerInit(&pThis->sleepTimer, wtiSleepTimerCB, pThis);
+    timerwheelTimerInit(&pThis->retryTimer, wtiRetryTimerCB, pThis);
 ENDobjConstruct(wti)
 
 
@@ -272,6 +445,29 @@ finalize_it:
 }
 
 
+/* re-allocate the batch arrays from the calling worker thread. With a NUMA
+ * memory policy in effect, they are then placed on the worker's node. This
+ * is done once per worker instance; the batch is empty whenever a worker
+ * thread starts.
+ */
+rsRetVal wtiAllocBatchLocal(wti_t *const pThis) {
+    batch_t batch;
+    DEFiRet;
+
+    memset(&batch, 0, sizeof(batch));
+    if (pThis->bBatchLocal || pThis->batch.maxElem == 0) FINALIZE;
+    CHKiRet(batchInit(&batch, pThis->batch.maxElem));
+    batchFree(&pThis->batch);
+    pThis->batch.pElem = batch.pElem;
+    pThis->batch.eltState = batch.eltState;
+    pThis->bBatchLocal = 1;
+
+finalize_it:
+    if (iRet != RS_RET_OK) batchFree(&batch);
+    RETiRet;
+}
+
+
 /* cancellation cleanup handler for queueWorker ()
  * Most importantly, it must bring back the batch into a consistent state.
  * Keep in mind that cancellation is disabled if we run into
@@ -303,16 +499,101 @@ int ATTR_NONNULL() wtiWaitNonEmpty(wti_t *const pThis, const struct timespec tim
     int r;
 
     DBGOPRINT((obj_t *)pThis, "waiting on queue to become non-empty\n");
+    pThis->bCondWaiting = 1;
     if (d_pthread_cond_timedwait(&pThis->pcondBusy, pWtp->pmutUsr, &timeout) != 0) {
         r = 0;
     } else {
         r = 1;
     }
+    pThis->bCondWaiting = 0;
     DBGOPRINT((obj_t *)pThis, "waited on queue to become non-empty, result %d\n", r);
     return r;
 }
 
 
+/* wake up the worker if it waits for work. A worker that has already been
+ * signalled, but not yet run, is not signalled again. So producers cause at
+ * most one wakeup per wait, no matter how many messages they enqueue in the
+ * meantime. pmutUsr must be locked.
+ */
+void ATTR_NONNULL() wtiSignalBusy(wti_t *const pThis) {
+    if (pThis->bCondWaiting) {
+        pThis->bCondWaiting = 0;
+        pthread_cond_signal(&pThis->pcondBusy);
+    }
+}
+
+
+static uint64_t wtiNowUsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* adapt the spin budget after the worker was woken up. If work arrived
+ * within the maximum spin time, spinning would have avoided the wait, so
+ * we spin for the full time again.
+ */
+static void ATTR_NONNULL() wtiSpinAdaptWakeup(wti_t *const pThis, const wtp_t *const pWtp) {
+    if (pWtp->iSpinUsec > 0 && wtiNowUsec() - pThis->tWaitStart < (uint64_t)pWtp->iSpinUsec) {
+        pThis->spinBudget = pWtp->iSpinUsec;
+    }
+}
+
+
+/* Spin for a short time before an idle worker waits on pcondBusy. Waiting
+ * and waking up cost a futex call on each side and a few microseconds of
+ * scheduling latency, which dominates at moderate message rates. The spin
+ * time adapts: it is halved each time spinning was in vain, and spinning
+ * stops altogether once it falls below 1/SPIN_MIN_DIVISOR of the maximum.
+ * So a queue that is really idle does not burn CPU. Spinning is resumed
+ * when a wait turns out to have been shorter than the maximum spin time.
+ * pmutUsr must be locked; it is released while spinning. Returns 1 if
+ * there may be work now.
+ */
+static int ATTR_NONNULL() wtiSpinForWork(wti_t *const pThis, wtp_t *const pWtp) {
+    int bGotWork = 0;
+
+    if (pThis->bSpinHit) {
+        /* we spun before, but there was nothing we could process */
+        pThis->bSpinHit = 0;
+        pThis->spinBudget /= 2;
+        return 0;
+    }
+    if (pThis->spinBudget < pWtp->iSpinUsec / SPIN_MIN_DIVISOR || pThis->spinBudget == 0) {
+        return 0;
+    }
+
+    d_pthread_mutex_unlock(pWtp->pmutUsr);
+    const uint64_t tEnd = wtiNowUsec() + pThis->spinBudget;
+    for (unsigned i = 0;; ++i) {
+        if (pWtp->pfHasWork(pWtp->pUsr)) {
+            bGotWork = 1;
+            break;
+        }
+        if (i < SPIN_PAUSE_ITERATIONS) {
+            cpuRelax();
+        } else {
+            if (wtiNowUsec() >= tEnd) break;
+            sched_yield();
+        }
+    }
+    d_pthread_mutex_lock(pWtp->pmutUsr);
+    if (!bGotWork) {
+        /* producers do not signal us while we spin, so re-check now that we are locked */
+        bGotWork = pWtp->pfHasWork(pWtp->pUsr);
+    }
+
+    if (bGotWork) {
+        pThis->bSpinHit = 1;
+    } else {
+        pThis->spinBudget /= 2;
+    }
+    return bGotWork;
+}
+
+
 /* wait for queue to become non-empty or timeout
  * helper to wtiWorker. Note the the predicate is
  * re-tested by the caller, so it is OK to NOT do it here.
@@ -323,25 +604,159 @@ static void ATTR_NONNULL() doIdleProcessing(wti_t *const pThis, wtp_t *const pWt
 
     DBGPRINTF("%s: worker IDLE, waiting for work.\n", wtiGetDbgHdr(pThis));
 
+    if (pWtp->iSpinUsec > 0) {
+        pThis->tWaitStart = wtiNowUsec();
+    }
+    pThis->bCondWaiting = 1;
     if (pThis->bAlwaysRunning) {
         /* never shut down any started worker */
         d_pthread_cond_wait(&pThis->pcondBusy, pWtp->pmutUsr);
     } else {
-        timeoutComp(&t, pWtp->toWrkShutdown); /* get absolute timeout */
-        if (d_pthread_cond_timedwait(&pThis->pcondBusy, pWtp->pmutUsr, &t) != 0) {
+        /* the timeout is handled by the shared timer wheel, so that idle
+         * workers do not need timed waits of their own
+         */
+        pThis->bIdleTimedOut = 0;
+        pThis->idleDeadline = timerwheelNowMs() + pWtp->toWrkShutdown;
+        pThis->bIdleWaiting = 1;
+        if (timerwheelArm(&pThis->idleTimer, pWtp->toWrkShutdown) == RS_RET_OK) {
+            d_pthread_cond_wait(&pThis->pcondBusy, pWtp->pmutUsr);
+        } else {
+            timeoutComp(&t, pWtp->toWrkShutdown); /* get absolute timeout */
+            if (d_pthread_cond_timedwait(&pThis->pcondBusy, pWtp->pmutUsr, &t) != 0) {
+                pThis->bIdleTimedOut = 1;
+            }
+        }
+        pThis->bIdleWaiting = 0;
+        if (pThis->bIdleTimedOut) {
             DBGPRINTF("%s: inactivity timeout, worker terminating...\n", wtiGetDbgHdr(pThis));
             *pbInactivityTOOccurred = 1; /* indicate we had a timeout */
+        } else {
+            timerwheelCancel(&pThis->idleTimer);
         }
     }
+    pThis->bCondWaiting = 0;
+    wtiSpinAdaptWakeup(pThis, pWtp);
     DBGOPRINT((obj_t *)pThis, "worker awoke from idle processing\n");
 }
 
 
+/* park an idle worker that runs on the shared worker pool. Instead of
+ * waiting, it releases its pool thread but keeps its action worker
+ * instances. wtiUnpark() queues it again when there is new work. Unless it
+ * shall always run, the idle timer terminates it after the worker thread
+ * shutdown timeout, just like a dedicated thread. pmutUsr must be locked.
+ */
+static void ATTR_NONNULL() wtiPark(wti_t *const pThis, wtp_t *const pWtp) {
+    DBGPRINTF("%s: worker IDLE, parking it.\n", wtiGetDbgHdr(pThis));
+    pThis->bPoolParked = 1;
+    if (pWtp->iSpinUsec > 0) {
+        pThis->tWaitStart = wtiNowUsec();
+    }
+    if (!pThis->bAlwaysRunning) {
+        pThis->bIdleTimedOut = 0;
+        pThis->idleDeadline = timerwheelNowMs() + pWtp->toWrkShutdown;
+        pThis->bIdleWaiting = 1;
+        timerwheelArm(&pThis->idleTimer, pWtp->toWrkShutdown);
+    }
+}
+
+
+/* queue a parked worker for execution by the shared pool again. Must be
+ * called with pmutUsr locked. A worker that is not parked may wait for
+ * asynchronous output transactions (wtiWaitAsyncTx()), so we wake it up.
+ */
+void ATTR_NONNULL() wtiUnpark(wti_t *const pThis) {
+    if (pThis->bPoolParked) {
+        pThis->bPoolParked = 0;
+        pThis->bIdleWaiting = 0;
+        timerwheelCancel(&pThis->idleTimer);
+        wrkpoolSubmit(pThis);
+    } else {
+        wtiSignalBusy(pThis);
+    }
+}
+
+
+/* called by an output module (via actionAsyncTxNotify()) when an asynchronous
+ * transaction of this worker completed. May be called from any thread.
+ */
+void ATTR_NONNULL() wtiAsyncTxNotify(wti_t *const pThis) {
+    wtp_t *const pWtp = pThis->pWtp;
+
+    if (pWtp == NULL) {
+        return;
+    }
+    d_pthread_mutex_lock(pWtp->pmutUsr);
+    pThis->bAsyncTxNotified = 1;
+    wtiSignalBusy(pThis);
+    d_pthread_mutex_unlock(pWtp->pmutUsr);
+}
+
+
+/* wait until an asynchronous output transaction completed or there is new
+ * work. Modules tell us about completions via wtiAsyncTxNotify(); the timeout
+ * only guards against a lost notification. pmutUsr must be locked.
+ */
+static void ATTR_NONNULL() wtiWaitAsyncTx(wti_t *const pThis, wtp_t *const pWtp) {
+    struct timespec t;
+
+    if (!pThis->bAsyncTxNotified) {
+        DBGPRINTF("%s: waiting for asynchronous transactions to complete\n", wtiGetDbgHdr(pThis));
+        timeoutComp(&t, ASYNCTX_WAIT_MS);
+        pThis->bCondWaiting = 1;
+        d_pthread_cond_timedwait(&pThis->pcondBusy, pWtp->pmutUsr, &t);
+        pThis->bCondWaiting = 0;
+    }
+    pThis->bAsyncTxNotified = 0;
+}
+
+
+/* let a pooled worker that used up its time slice give its pool thread to
+ * the workers waiting in the run queue, see wrkpool.h. It is queued at the
+ * tail again, so it is not parked and the idle timer is not armed. Returns
+ * 1 if the worker must release its thread. pmutUsr must be locked.
+ */
+static int ATTR_NONNULL() wtiPoolYield(wti_t *const pThis, const uint64_t tSliceStart) {
+    if (wtiNowUsec() - tSliceStart < WRKPOOL_SLICE_USEC || !wrkpoolHaveWaiting()) {
+        return 0;
+    }
+    DBGPRINTF("%s: time slice used up, yielding pool thread.\n", wtiGetDbgHdr(pThis));
+    pThis->tWaitStart = 0; /* we did not wait, so we must not look like a short wait */
+    return wrkpoolSubmit(pThis) == RS_RET_OK;
+}
+
+
+/* park a pooled worker whose action waits for its next retry, instead of
+ * sleeping on its pool thread. The worker keeps its batch; the action has
+ * recorded where to continue it (see actionDoRetry()). The retry timer
+ * queues the worker again, and the queue consumer then continues that
+ * batch instead of dequeuing a new one. Returns 1 if the worker must
+ * release its thread, 0 if it shall continue right away because the
+ * timer could not be armed. pmutUsr must be locked.
+ */
+static int ATTR_NONNULL() wtiRetryPark(wti_t *const pThis) {
+    DBGPRINTF("%s: action retry in %ld ms, parking worker.\n", wtiGetDbgHdr(pThis), pThis->retryParkMs);
+    pThis->tWaitStart = 0; /* the wait is no sign of an idle queue */
+    pThis->retryDeadline = timerwheelNowMs() + pThis->retryParkMs;
+    pThis->bRetryParked = 1;
+    if (timerwheelArm(&pThis->retryTimer, pThis->retryParkMs) != RS_RET_OK) {
+        pThis->bRetryParked = 0;
+        pThis->bRetryResume = 1;
+        return 0;
+    }
+    return 1;
+}
+
+
 /* generic worker thread framework. Note that we prohibit cancellation
  * during almost all times, because it can have very undesired side effects.
  * However, we may need to cancel a thread if the consumer blocks for too
  * long (during shutdown). So what we do is block cancellation, and every
  * consumer must enable it during the periods where it is safe.
+ * If the worker runs on the shared worker pool, it is parked instead of
+ * waiting while idle or while an action waits for a retry, and yields its
+ * thread after a time slice if other workers wait for one; we then return
+ * RS_RET_IDLE and keep the action worker instances.
  */
 PRAGMA_DIAGNOSTIC_PUSH
 PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
@@ -352,6 +767,8 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
     actWrkrInfo_t *__restrict__ wrkrInfo;
     int iCancelStateSave;
     int i, j, k;
+    volatile sbool bParked = 0; /* released the pool thread; volatile: set within the cancel cleanup scope */
+    const uint64_t tSliceStart = pWtp->bPooled ? wtiNowUsec() : 0;
     DEFiRet;
 
     dbgSetThrdName(pThis->pszDbgHdr);
@@ -374,6 +791,14 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
      * when required. -- rgerhards, 2013-11-20
      */
     d_pthread_mutex_lock(pWtp->pmutUsr);
+    if (pWtp->bPooled) {
+        /* resumed by the idle timer? */
+        bInactivityTOOccurred = pThis->bIdleTimedOut;
+        pThis->bIdleTimedOut = 0;
+        if (!bInactivityTOOccurred) {
+            wtiSpinAdaptWakeup(pThis, pWtp);
+        }
+    }
     while (1) { /* loop will be broken below */
         if (pWtp->pfRateLimiter != NULL) { /* call rate-limiter, if defined */
             pWtp->pfRateLimiter(pWtp->pUsr);
@@ -384,6 +809,8 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
         if (terminateRet == RS_RET_TERMINATE_NOW) {
             /* we now need to free the old batch */
             localRet = pWtp->pfObjProcessed(pWtp->pUsr, pThis);
+            pThis->bRetryResume = 0; /* a batch kept for an action retry is gone now */
+            pThis->iRetryElem = 0;
             DBGOPRINT((obj_t *)pThis,
                       "terminating worker because of "
                       "TERMINATE_NOW mode, del iRet %d\n",
@@ -396,7 +823,21 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
 
         if (localRet == RS_RET_ERR_QUEUE_EMERGENCY) {
             break; /* end of loop */
+        } else if (localRet == RS_RET_RETRY_PARKED) {
+            if (wtiRetryPark(pThis)) {
+                bParked = 1;
+                break;
+            }
+            continue;
         } else if (localRet == RS_RET_IDLE) {
+            if (pThis->nAsyncTxInFlight > 0) {
+                /* finish asynchronous output transactions before we go idle */
+                wtiWaitAsyncTx(pThis, pWtp);
+                d_pthread_mutex_unlock(pWtp->pmutUsr);
+                actionAsyncTxPollAll(pThis, 0);
+                d_pthread_mutex_lock(pWtp->pmutUsr);
+                continue;
+            }
             if (terminateRet == RS_RET_TERMINATE_WHEN_IDLE || bInactivityTOOccurred) {
                 DBGOPRINT((obj_t *)pThis,
                           "terminating worker terminateRet=%d, "
@@ -404,14 +845,35 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
                           terminateRet, bInactivityTOOccurred);
                 break; /* end of loop */
             }
+            if (pWtp->iSpinUsec > 0 && wtiSpinForWork(pThis, pWtp)) {
+                continue;
+            }
+            if (pWtp->bPooled) {
+                if (!pThis->bAlwaysRunning && pWtp->toWrkShutdown == 0) {
+                    bInactivityTOOccurred = 1; /* immediate shutdown, no need to park */
+                    continue;
+                }
+                wtiPark(pThis, pWtp);
+                bParked = 1;
+                break;
+            }
             doIdleProcessing(pThis, pWtp, &bInactivityTOOccurred);
             continue; /* request next iteration */
         }
 
         bInactivityTOOccurred = 0; /* reset for next run */
+        pThis->bSpinHit = 0;
+        if (pWtp->bPooled && wtiPoolYield(pThis, tSliceStart)) {
+            bParked = 1;
+            break;
+        }
     }
 
     d_pthread_mutex_unlock(pWtp->pmutUsr);
+    /* Note: if parked, we may already run on another pool thread now */
+    if (bParked) {
+        goto done;
+    }
 
     DBGPRINTF("DDDD: wti %p: worker cleanup action instances\n", pThis);
     for (i = 0; i < runConf->actions.iActionNbr; ++i) {
@@ -419,8 +881,10 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
         dbgprintf("wti %p, action %d, ptr %p\n", pThis, i, wrkrInfo->actWrkrData);
         if (wrkrInfo->actWrkrData != NULL) {
             pAction = wrkrInfo->pAction;
+            actionAsyncTxDrain(pAction, pThis);
             actionRemoveWorker(pAction, wrkrInfo->actWrkrData);
             pAction->pMod->mod.om.freeWrkrInstance(wrkrInfo->actWrkrData);
+            actionAsyncTxFree(pAction, pThis);
             if (pAction->isTransactional) {
                 /* free iparam "cache" - we need to go through to max! */
                 for (j = 0; j < wrkrInfo->p.tx.maxIParams; ++j) {
@@ -436,12 +900,17 @@ PRAGMA_IGNORE_Wempty_body rsRetVal wtiWorker(wti_t *__restrict__ const pThis) {
                 releaseDoActionParams(pAction, pThis, 1);
             }
             wrkrInfo->actWrkrData = NULL; /* re-init for next activation */
+            wrkrInfo->iRetriesParked = 0;
         }
     }
 
+done:
     /* indicate termination */
     pthread_cleanup_pop(0); /* remove cleanup handler */
     pthread_setcancelstate(iCancelStateSave, NULL);
+    if (bParked) {
+        return RS_RET_IDLE;
+    }
     dbgprintf("wti %p: exiting\n", pThis);
 
     RETiRet;
@@ -28,6 +28,7 @@
 #include "obj.h"
 #include "batch.h"
 #include "action.h"
+#include "timerwheel.h"
 
 
 #define ACT_STATE_RDY 0 /* action ready, waiting for new transaction */
@@ -52,6 +53,8 @@ typedef struct actWrkrInfo {
                     immediate failure following */
     int iNbrResRtry; /* number of retries since last suspend */
     sbool bHadAutoCommit; /* did an auto-commit happen during doAction()? */
+    int iRetriesParked; /* retries done when the worker parked in actionDoRetry(), else 0 */
+    actAsyncTx_t *asyncTx; /* asynchronous transactions in flight, NULL if not used */
     struct {
         unsigned actState : 3;
     } flags;
@@ -78,10 +81,45 @@ struct wti_s {
         wtp_t *pWtp; /* my worker thread pool (important if only the work thread instance is passed! */
         batch_t batch; /* pointer to an object array meaningful for current user
                   pointer (e.g. queue pUsr data elemt) */
+        sbool bBatchLocal; /* batch was allocated by the worker itself (see wtiAllocBatchLocal) */
+        /* shared worker pool support (see wrkpool.h) */
+        sbool bPoolParked; /* idle, not queued for a pool thread; protected by pmutUsr */
+        wti_t *pPoolNext; /* run queue link, protected by the pool */
         uchar *pszDbgHdr; /* header string for debug messages */
         actWrkrInfo_t *actWrkrInfo; /* *array* of action wrkr infos for all actions
                           (sized for max nbr of actions in config!) */
         pthread_cond_t pcondBusy; /* condition to wake up the worker, protected by pmutUsr in wtp */
+        unsigned nAsyncTxInFlight; /* async output transactions outstanding over all actions */
+        sbool bAsyncTxNotified; /* an async transaction completed since last poll, protected by pmutUsr */
+        /* idle shutdown, driven by the shared timer wheel (see doIdleProcessing) */
+        timerwheel_timer_t idleTimer;
+        uint64_t idleDeadline; /* monotonic ms, protected by pmutUsr */
+        sbool bIdleWaiting; /* protected by pmutUsr */
+        sbool bIdleTimedOut; /* protected by pmutUsr */
+        /* spin-then-wait for new work (see wtiSpinForWork) */
+        sbool bCondWaiting; /* blocked on pcondBusy and not yet signalled, protected by pmutUsr */
+        sbool bSpinHit; /* last spin saw work, nothing processed since */
+        int spinBudget; /* current adaptive spin time in us */
+        uint64_t tWaitStart; /* monotonic us when the worker began to wait */
+        /* interruptible sleep (see wtiSleep) */
+        timerwheel_timer_t sleepTimer;
+        pthread_mutex_t mutSleep;
+        pthread_cond_t condSleep;
+        sbool bSleepWakeup; /* protected by mutSleep */
+        /* pooled worker parked until an action retry is due (see wtiRetryPark) */
+        timerwheel_timer_t retryTimer;
+        uint64_t retryDeadline; /* monotonic ms, protected by pmutUsr */
+        long retryParkMs; /* wait requested by actionDoRetry() */
+        int iRetryElem; /* batch element to continue with when resumed */
+        sbool bRetryMayPark; /* the current processing step can be continued later */
+        sbool bRetryParked; /* waiting for retryTimer, protected by pmutUsr */
+        sbool bRetryResume; /* continue the batch kept in 'batch', protected by pmutUsr */
+        /* scratch masks for batch script execution, one per nesting level (see ruleset.c) */
+        sbool **batchExecMasks;
+        int nBatchExecMasks; /* number of levels allocated */
+        int batchExecMaskElems; /* number of batch elements each level is sized for */
+        int batchExecDepth; /* number of levels currently in use */
+        struct json_tokener *jsonTokener; /* for parse_json(), created on first use */
         DEF_ATOMIC_HELPER_MUT(mutIsRunning);
         struct {
             uint8_t script_errno; /* errno-type interface for RainerScript functions */
@@ -106,6 +144,12 @@ void ATTR_NONNULL() wtiJoinThrd(wti_t *const pThis);
 rsRetVal wtiSetAlwaysRunning(wti_t *const pThis);
 rsRetVal wtiSetState(wti_t *const pThis, int bNew);
 rsRetVal wtiWakeupThrd(wti_t *const pThis);
+void wtiSleep(wti_t *const pThis, long ms);
+rsRetVal wtiAllocBatchLocal(wti_t *const pThis);
+void wtiUnpark(wti_t *const pThis);
+void wtiEndRetryWait(wti_t *const pThis);
+void wtiSignalBusy(wti_t *const pThis);
+void wtiAsyncTxNotify(wti_t *const pThis);
 int wtiGetState(wti_t *const pThis);
 wti_t *wtiGetDummy(void);
 int ATTR_NONNULL() wtiWaitNonEmpty(wti_t *const pThis, const struct timespec timeout);
@@ -53,6 +53,8 @@
 #include "unicode-helper.h"
 #include "glbl.h"
 #include "errmsg.h"
+#include "cpuaffinity.h"
+#include "wrkpool.h"
 
 /* static data */
 DEFobjStaticHelpers;
@@ -257,6 +259,10 @@ PRAGMA_IGNORE_Wempty_body
     /* awake workers in retry loop */
     for (i = 0; i < pThis->iNumWorkerThreads; ++i) {
         wtpJoinTerminatedWrkr(pThis);
+        if (pThis->bPooled) {
+            wtiUnpark(pThis->pWrkr[i]); /* so that it can terminate */
+            wtiEndRetryWait(pThis->pWrkr[i]);
+        }
         pthread_cond_signal(&pThis->pWrkr[i]->pcondBusy);
         wtiWakeupThrd(pThis->pWrkr[i]);
     }
@@ -324,8 +330,10 @@ static void wtpWrkrExecCleanup(wti_t *pWti) {
     if (dbgTimeoutToStderr) {
         fprintf(stderr, "rsyslog debug: %s: enter WrkrExecCleanup\n", wtiGetDbgHdr(pWti));
     }
-    /* the order of the next two statements is important! */
-    wtiSetState(pWti, WRKTHRD_WAIT_JOIN);
+    /* the order of the next two statements is important! Pool threads are
+     * not joined, so a pooled worker is stopped right away.
+     */
+    wtiSetState(pWti, pThis->bPooled ? WRKTHRD_STOPPED : WRKTHRD_WAIT_JOIN);
     ATOMIC_DEC(&pThis->iCurNumWrkThrd, &pThis->mutCurNumWrkThrd);
 
     /* note: numWorkersNow is only for message generation, so we do not try
@@ -407,6 +415,14 @@ PRAGMA_IGNORE_Wempty_body static void *wtpWorker(
     pthread_cond_broadcast(&pThis->condThrdInitDone);
     d_pthread_mutex_unlock(&pThis->mutWtp);
 
+    if (pThis->pAffinity != NULL) {
+        /* with a NUMA node, the batch is re-allocated under the node's memory policy */
+        if (cpuaffinityApply(pThis->pAffinity) == RS_RET_OK &&
+            cpuaffinityGetNumaNode(pThis->pAffinity) != CPUAFFINITY_NO_NODE) {
+            wtiAllocBatchLocal(pWti);
+        }
+    }
+
     pthread_cleanup_push(wtpWrkrExecCancelCleanup, pWti);
 
     wtiWorker(pWti);
@@ -425,6 +441,53 @@ PRAGMA_IGNORE_Wempty_body static void *wtpWorker(
 }
 PRAGMA_DIAGNOSTIC_POP
 
+
+/* Run a worker on a thread of the shared worker pool (called by the pool).
+ * If the worker parks itself when idle, the pool thread is released and the
+ * worker stays active; it is run again when it is submitted the next time.
+ */
+void ATTR_NONNULL() wtpRunPooledWrkr(wti_t *const pWti) {
+    wtp_t *const pThis = pWti->pWtp;
+    rsRetVal localRet;
+
+    ISOBJ_TYPE_assert(pThis, wtp);
+    pthread_cleanup_push(wtpWrkrExecCancelCleanup, pWti);
+    localRet = wtiWorker(pWti);
+    pthread_cleanup_pop(0);
+    if (localRet == RS_RET_IDLE) {
+        return; /* parked, must not touch pWti any longer */
+    }
+
+    d_pthread_mutex_lock(&pThis->mutWtp);
+    wtpWrkrExecCleanup(pWti);
+    pthread_cond_broadcast(&pThis->condThrdTrm); /* activate anyone waiting on thread shutdown */
+    d_pthread_mutex_unlock(&pThis->mutWtp);
+}
+
+
+/* start a worker on the shared worker pool. Other than a dedicated thread,
+ * it does not need any initialization, so we do not wait for it.
+ * mutWtp must be locked.
+ */
+static rsRetVal ATTR_NONNULL() wtpStartPooledWrkr(wtp_t *const pThis, wti_t *const pWti) {
+    DEFiRet;
+
+    wtiSetState(pWti, WRKTHRD_RUNNING);
+    pWti->bPoolParked = 0;
+    ATOMIC_INC(&pThis->iCurNumWrkThrd, &pThis->mutCurNumWrkThrd); /* we got one more! */
+    if ((iRet = wrkpoolSubmit(pWti)) != RS_RET_OK) {
+        ATOMIC_DEC(&pThis->iCurNumWrkThrd, &pThis->mutCurNumWrkThrd);
+        wtiSetState(pWti, WRKTHRD_STOPPED);
+        FINALIZE;
+    }
+    DBGPRINTF("%s: worker submitted to shared pool, num workers now %d\n", wtpGetDbgHdr(pThis),
+              ATOMIC_FETCH_32BIT(&pThis->iCurNumWrkThrd, &pThis->mutCurNumWrkThrd));
+
+finalize_it:
+    RETiRet;
+}
+
+
 /* start a new worker */
 static rsRetVal ATTR_NONNULL() wtpStartWrkr(wtp_t *const pThis, const int permit_during_shutdown) {
     wti_t *pWti;
@@ -466,6 +529,12 @@ static rsRetVal ATTR_NONNULL() wtpStartWrkr(wtp_t *const pThis, const int permit
     }
 
     pWti = pThis->pWrkr[i];
+    pWti->spinBudget = pThis->iSpinUsec;
+    pWti->bSpinHit = 0;
+    if (pThis->bPooled) {
+        CHKiRet(wtpStartPooledWrkr(pThis, pWti));
+        FINALIZE;
+    }
     wtiSetState(pWti, WRKTHRD_INITIALIZING);
     iState = pthread_create(&(pWti->thrdID), &pThis->attrThrd, wtpWorker, (void *)pWti);
     ATOMIC_INC(&pThis->iCurNumWrkThrd, &pThis->mutCurNumWrkThrd); /* we got one more! */
@@ -537,7 +606,11 @@ rsRetVal ATTR_NONNULL() wtpAdviseMaxWorkers(wtp_t *const pThis, int nMaxWrkr, co
         /* we have needed number of workers, but they may be sleeping */
         for (i = 0, nRunning = 0; i < pThis->iNumWorkerThreads && nRunning < nMaxWrkr; ++i) {
             if (wtiGetState(pThis->pWrkr[i]) != WRKTHRD_STOPPED) {
-                pthread_cond_signal(&pThis->pWrkr[i]->pcondBusy);
+                if (pThis->bPooled) {
+                    wtiUnpark(pThis->pWrkr[i]);
+                } else {
+                    wtiSignalBusy(pThis->pWrkr[i]);
+                }
                 nRunning++;
             }
         }
@@ -560,12 +633,16 @@ DEFpropSetMeth(wtp, toWrkShutdown, long);
 DEFpropSetMeth(wtp, wtpState, wtpState_t);
 DEFpropSetMeth(wtp, iNumWorkerThreads, int);
 DEFpropSetMeth(wtp, pUsr, void *);
+DEFpropSetMeth(wtp, pAffinity, cpuaffinity_t *);
+DEFpropSetMeth(wtp, bPooled, sbool);
+DEFpropSetMeth(wtp, iSpinUsec, int);
 DEFpropSetMethPTR(wtp, pmutUsr, pthread_mutex_t);
 DEFpropSetMethFP(wtp, pfChkStopWrkr, rsRetVal (*pVal)(void *, int));
 DEFpropSetMethFP(wtp, pfRateLimiter, rsRetVal (*pVal)(void *));
 DEFpropSetMethFP(wtp, pfGetDeqBatchSize, rsRetVal (*pVal)(void *, int *));
 DEFpropSetMethFP(wtp, pfDoWork, rsRetVal (*pVal)(void *, void *));
 DEFpropSetMethFP(wtp, pfObjProcessed, rsRetVal (*pVal)(void *, wti_t *));
+DEFpropSetMethFP(wtp, pfHasWork, int (*pVal)(void *));
 
 
 /* set the debug header message
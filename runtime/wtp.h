@@ -62,6 +62,10 @@ struct wtp_s {
         /* user objects */
         void *pUsr; /* pointer to user object (in this case, the queue the wtp belongs to) */
         pthread_attr_t attrThrd; /* attribute for new threads (created just once and cached here) */
+        cpuaffinity_t *pAffinity; /* CPU/NUMA placement of workers, NULL if none (owned by pUsr) */
+        sbool bPooled; /* workers are run by the shared worker pool instead of own threads */
+        int iSpinUsec; /* max time idle workers spin before they wait, 0 = no spinning */
+        int (*pfHasWork)(void *pUsr); /* lock-free hint whether there is work, for spinning */
         pthread_mutex_t *pmutUsr;
         rsRetVal (*pfChkStopWrkr)(void *pUsr, int);
         rsRetVal (*pfGetDeqBatchSize)(void *pUsr, int *); /* obtains max dequeue count from queue config */
@@ -92,6 +96,7 @@ rsRetVal wtpWakeupAllWrkr(wtp_t *pThis);
 rsRetVal wtpCancelAll(wtp_t *pThis, const uchar *const cancelobj);
 rsRetVal wtpSetDbgHdr(wtp_t *pThis, uchar *pszMsg, size_t lenMsg);
 rsRetVal wtpShutdownAll(wtp_t *pThis, wtpState_t tShutdownCmd, struct timespec *ptTimeout);
+void wtpRunPooledWrkr(wti_t *pWti);
 PROTOTYPEObjClassInit(wtp);
 PROTOTYPEObjClassExit(wtp);
 PROTOTYPEpropSetMethFP(wtp, pfChkStopWrkr, rsRetVal (*pVal)(void *, int));
@@ -103,6 +108,10 @@ PROTOTYPEpropSetMeth(wtp, toWrkShutdown, long);
 PROTOTYPEpropSetMeth(wtp, wtpState, wtpState_t);
 PROTOTYPEpropSetMeth(wtp, iMaxWorkerThreads, int);
 PROTOTYPEpropSetMeth(wtp, pUsr, void *);
+PROTOTYPEpropSetMeth(wtp, pAffinity, cpuaffinity_t *);
+PROTOTYPEpropSetMeth(wtp, bPooled, sbool);
+PROTOTYPEpropSetMeth(wtp, iSpinUsec, int);
+PROTOTYPEpropSetMethFP(wtp, pfHasWork, int (*pVal)(void *));
 PROTOTYPEpropSetMeth(wtp, iNumWorkerThreads, int);
 PROTOTYPEpropSetMethPTR(wtp, pmutUsr, pthread_mutex_t);
 
@@ -22,8 +22,11 @@
  */
 
 #include "config.h"
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <unistd.h>
 #include <zlib.h>
 
 #include "rsyslog.h"
@@ -38,6 +41,8 @@ MODULE_TYPE_NOKEEP;
 /* static data */
 DEFobjStaticHelpers;
 
+#define ZLIBW_FILE_BUFSIZE (64 * 1024) /* buffer size for CompressFile() */
+
 
 /* ------------------------------ methods ------------------------------ */
 
@@ -168,6 +173,70 @@ static rsRetVal zlib_Destruct(ATTR_UNUSED strm_t *pThis) {
     return RS_RET_OK;
 }
 
+/* compress the file open as fdIn into a gzip file, whose data is handed to
+ * writeOut(). Used to compress rotated files. The caller's stop flag is
+ * checked after every chunk, so that a shutdown does not need to wait for
+ * a large file; RS_RET_TERMINATE_NOW is returned in that case.
+ */
+static rsRetVal CompressFile(const int fdIn,
+                             rsRetVal (*writeOut)(void *pUsr, uchar *pBuf, size_t lenBuf),
+                             void *const pUsr,
+                             const sbool *const pbStop) {
+    z_stream zstrm;
+    uchar *inBuf = NULL;
+    uchar *outBuf = NULL;
+    int bInitDone = 0;
+    int flush = Z_NO_FLUSH;
+    int zRet;
+    DEFiRet;
+
+    CHKmalloc(inBuf = malloc(ZLIBW_FILE_BUFSIZE));
+    CHKmalloc(outBuf = malloc(ZLIBW_FILE_BUFSIZE));
+    memset(&zstrm, 0, sizeof(zstrm));
+    zRet = deflateInit2(&zstrm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 9, Z_DEFAULT_STRATEGY);
+    if (zRet != Z_OK) {
+        LogError(0, RS_RET_ZLIB_ERR, "error %d returned from zlib/deflateInit2()", zRet);
+        ABORT_FINALIZE(RS_RET_ZLIB_ERR);
+    }
+    bInitDone = 1;
+
+    do {
+        const ssize_t nRead = read(fdIn, inBuf, ZLIBW_FILE_BUFSIZE);
+        if (nRead == -1) {
+            if (errno == EINTR) continue;
+            ABORT_FINALIZE(RS_RET_READ_ERR);
+        }
+        flush = (nRead == 0) ? Z_FINISH : Z_NO_FLUSH;
+        zstrm.next_in = inBuf;
+        zstrm.avail_in = (uInt)nRead;
+        do {
+            zstrm.next_out = outBuf;
+            zstrm.avail_out = ZLIBW_FILE_BUFSIZE;
+            zRet = deflate(&zstrm, flush);
+            if (zRet == Z_STREAM_ERROR) {
+                LogError(0, RS_RET_ZLIB_ERR, "error %d returned from zlib/deflate()", zRet);
+                ABORT_FINALIZE(RS_RET_ZLIB_ERR);
+            }
+            const size_t outavail = ZLIBW_FILE_BUFSIZE - zstrm.avail_out;
+            if (outavail != 0) {
+                CHKiRet(writeOut(pUsr, outBuf, outavail));
+            }
+        } while (zstrm.avail_out == 0);
+        if (*pbStop) {
+            ABORT_FINALIZE(RS_RET_TERMINATE_NOW);
+        }
+    } while (flush != Z_FINISH);
+
+finalize_it:
+    if (bInitDone) {
+        deflateEnd(&zstrm);
+    }
+    free(inBuf);
+    free(outBuf);
+    RETiRet;
+}
+
+
 /* queryInterface function
  * rgerhards, 2008-03-05
  */
@@ -189,6 +258,7 @@ BEGINobjQueryInterface(zlibw)
     pIf->doStrmWrite = doStrmWrite;
     pIf->doCompressFinish = doCompressFinish;
     pIf->Destruct = zlib_Destruct;
+    pIf->CompressFile = CompressFile;
 finalize_it:
 ENDobjQueryInterface(zlibw)
 
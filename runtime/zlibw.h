@@ -37,8 +37,13 @@ BEGINinterface(zlibw) /* name must also be changed in ENDinterface macro! */
                             rsRetVal (*strmPhysWrite)(strm_t *pThis, uchar *pBuf, size_t lenBuf));
     rsRetVal (*doCompressFinish)(strm_t *pThis, rsRetVal (*Destruct)(strm_t *pThis, uchar *pBuf, size_t lenBuf));
     rsRetVal (*Destruct)(strm_t *pThis);
+    /* v3 added 2026-10-18 */
+    rsRetVal (*CompressFile)(int fdIn,
+                             rsRetVal (*writeOut)(void *pUsr, uchar *pBuf, size_t lenBuf),
+                             void *pUsr,
+                             const sbool *pbStop);
 ENDinterface(zlibw)
-#define zlibwCURR_IF_VERSION 2 /* increment whenever you change the interface structure! */
+#define zlibwCURR_IF_VERSION 3 /* increment whenever you change the interface structure! */
 
 
 /* prototypes */
@@ -22,8 +22,14 @@
  */
 
 #include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
 #include <zstd.h>
 
 #include "rsyslog.h"
@@ -40,6 +46,93 @@ MODULE_TYPE_NOKEEP;
 DEFobjStaticHelpers;
 
 
+static int zstd_isSeekable(const strm_t *const pThis) {
+    return pThis->zstd.frameSize > 0 || pThis->zstd.frameInterval > 0;
+}
+
+
+/* append the frame just ended to the frame index. The index is a text
+ * file next to the output file, with one line per frame:
+ *   <offset> <compressed size> <uncompressed size> <first time> <last time>
+ * The times are when data was written to the frame, in seconds since the
+ * epoch. Errors are reported, but do not affect writing the log file.
+ */
+static void zstd_writeFrameIndex(strm_t *const pThis) {
+    char line[128];
+    char *idxName;
+    int len;
+
+    if (pThis->zstd.fdIdx == -1) {
+        if (pThis->pszCurrFName == NULL) return;
+        const size_t lenName = strlen((char *)pThis->pszCurrFName) + sizeof(ZSTDW_INDEX_SUFFIX);
+        if ((idxName = malloc(lenName)) == NULL) return;
+        snprintf(idxName, lenName, "%s%s", (char *)pThis->pszCurrFName, ZSTDW_INDEX_SUFFIX);
+        pThis->zstd.fdIdx = open(idxName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | O_NOCTTY, pThis->tOpenMode);
+        if (pThis->zstd.fdIdx == -1) {
+            LogError(errno, RS_RET_FILE_OPEN_ERROR, "zstd: cannot open frame index '%s', frame not indexed",
+                     idxName);
+        }
+        free(idxName);
+        if (pThis->zstd.fdIdx == -1) return;
+    }
+
+    len = snprintf(line, sizeof(line), "%lld %lld %lld %lld %lld\n",
+                   (long long)(pThis->iCurrOffs - pThis->zstd.frameOut), (long long)pThis->zstd.frameOut,
+                   (long long)pThis->zstd.frameIn, (long long)pThis->zstd.frameFirst,
+                   (long long)pThis->zstd.frameLast);
+    if (write(pThis->zstd.fdIdx, line, len) != len) {
+        LogError(errno, RS_RET_IO_ERROR, "zstd: error writing frame index for '%s'", pThis->pszCurrFName);
+    }
+}
+
+
+/* compress input and write the result. With ZSTD_e_end, this ends the
+ * current frame.
+ */
+static rsRetVal zstd_compress(strm_t *const pThis,
+                              ZSTD_inBuffer *const input,
+                              const ZSTD_EndDirective mode,
+                              rsRetVal (*strmPhysWrite)(strm_t *pThis, uchar *pBuf, size_t lenBuf)) {
+    size_t remaining;
+    DEFiRet;
+
+    do {
+        ZSTD_outBuffer output = {pThis->pZipBuf, pThis->sIOBufSize, 0};
+        remaining = ZSTD_compressStream2(pThis->zstd.cctx, &output, input, mode);
+        if (ZSTD_isError(remaining)) {
+            LogError(0, RS_RET_ZLIB_ERR, "error returned from ZSTD_compressStream2(): %s",
+                     ZSTD_getErrorName(remaining));
+            ABORT_FINALIZE(RS_RET_ZLIB_ERR);
+        }
+        if (output.pos > 0) {
+            CHKiRet(strmPhysWrite(pThis, (uchar *)pThis->pZipBuf, output.pos));
+            pThis->zstd.frameOut += output.pos;
+        }
+    } while (mode == ZSTD_e_continue ? (input->pos != input->size) : (remaining != 0));
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* end the current frame (if it has data) and index it */
+static rsRetVal zstd_endFrame(strm_t *const pThis,
+                              rsRetVal (*strmPhysWrite)(strm_t *pThis, uchar *pBuf, size_t lenBuf)) {
+    DEFiRet;
+
+    if (pThis->zstd.frameIn == 0) FINALIZE;
+    char dummybuf;
+    ZSTD_inBuffer input = {&dummybuf, 0, 0};
+    CHKiRet(zstd_compress(pThis, &input, ZSTD_e_end, strmPhysWrite));
+    zstd_writeFrameIndex(pThis);
+    pThis->zstd.frameIn = 0;
+    pThis->zstd.frameOut = 0;
+
+finalize_it:
+    RETiRet;
+}
+
+
 /* finish buffer, to be called before closing the zstd file. */
 static rsRetVal zstd_doCompressFinish(strm_t *pThis,
                                       rsRetVal (*strmPhysWrite)(strm_t *pThis, uchar *pBuf, size_t lenBuf)) {
@@ -48,6 +141,15 @@ static rsRetVal zstd_doCompressFinish(strm_t *pThis,
     assert(pThis != NULL);
 
     if (!pThis->bzInitDone) goto done;
+    if (zstd_isSeekable(pThis)) {
+        CHKiRet(zstd_endFrame(pThis, strmPhysWrite));
+        /* the next file (after rotation) gets an index of its own */
+        if (pThis->zstd.fdIdx != -1) {
+            close(pThis->zstd.fdIdx);
+            pThis->zstd.fdIdx = -1;
+        }
+        FINALIZE;
+    }
 
     char dummybuf; /* not sure if we can pass in NULL as buffer address in this special case */
     ZSTD_inBuffer input = {&dummybuf, 0, 0};
@@ -71,6 +173,69 @@ done:
 }
 
 
+/* seekable mode: compress the data, ending frames at the first record
+ * (line) end after a frame limit is reached, so that each frame holds
+ * complete records only.
+ */
+static rsRetVal zstd_doSeekableWrite(strm_t *const pThis,
+                                     uchar *const pBuf,
+                                     const size_t lenBuf,
+                                     const int bFlush,
+                                     rsRetVal (*strmPhysWrite)(strm_t *pThis, uchar *pBuf, size_t lenBuf)) {
+    const time_t now = time(NULL);
+    size_t pos = 0;
+    DEFiRet;
+
+    while (pos < lenBuf) {
+        uchar *const p = pBuf + pos;
+        const size_t len = lenBuf - pos;
+        const int64 frameIn = pThis->zstd.frameIn;
+        const int64 frameSize = pThis->zstd.frameSize;
+        const sbool bDue = (frameSize > 0 && frameIn >= frameSize) ||
+                           (frameIn > 0 && pThis->zstd.frameInterval > 0 &&
+                            now - pThis->zstd.frameFirst >= pThis->zstd.frameInterval);
+        size_t take = len;
+        sbool bEnd = 0;
+
+        if (bDue && pThis->zstd.bAtRecordEnd) {
+            CHKiRet(zstd_endFrame(pThis, strmPhysWrite));
+            continue;
+        }
+        /* find the offset at which the frame becomes due, then the record end after it */
+        size_t offsDue = len;
+        if (bDue) {
+            offsDue = 0;
+        } else if (frameSize > 0 && frameIn + (int64)len > frameSize) {
+            offsDue = (size_t)(frameSize - frameIn - 1);
+        }
+        if (offsDue < len) {
+            const uchar *const pLF = memchr(p + offsDue, '\n', len - offsDue);
+            if (pLF != NULL) {
+                take = pLF - p + 1;
+                bEnd = 1;
+            } else if (frameSize > 0 && frameIn + (int64)len >= 2 * frameSize) {
+                bEnd = 1; /* no record end in sight, do not let the frame grow without bound */
+            }
+        }
+
+        if (frameIn == 0) pThis->zstd.frameFirst = now;
+        pThis->zstd.frameLast = now;
+        pThis->zstd.frameIn += take;
+        ZSTD_inBuffer input = {p, take, 0};
+        const ZSTD_EndDirective mode = (bFlush && pos + take == lenBuf) ? ZSTD_e_flush : ZSTD_e_continue;
+        CHKiRet(zstd_compress(pThis, &input, mode, strmPhysWrite));
+        pThis->zstd.bAtRecordEnd = (p[take - 1] == '\n');
+        pos += take;
+        if (bEnd) {
+            CHKiRet(zstd_endFrame(pThis, strmPhysWrite));
+        }
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
 static rsRetVal zstd_doStrmWrite(strm_t *pThis,
                                  uchar *const pBuf,
                                  const size_t lenBuf,
@@ -96,6 +261,11 @@ static rsRetVal zstd_doStrmWrite(strm_t *pThis,
         pThis->bzInitDone = RSTRUE;
     }
 
+    if (zstd_isSeekable(pThis)) {
+        CHKiRet(zstd_doSeekableWrite(pThis, pBuf, lenBuf, bFlush, strmPhysWrite));
+        FINALIZE;
+    }
+
     /* now doing the compression */
     ZSTD_inBuffer input = {pBuf, lenBuf, 0};
 
@@ -129,6 +299,10 @@ static rsRetVal zstd_Destruct(strm_t *const pThis) {
     DEFiRet;
     assert(pThis != NULL);
 
+    if (pThis->zstd.fdIdx != -1) {
+        close(pThis->zstd.fdIdx);
+        pThis->zstd.fdIdx = -1;
+    }
     if (!pThis->bzInitDone) goto done;
 
     const int result = ZSTD_freeCCtx(pThis->zstd.cctx);
@@ -142,6 +316,60 @@ done:
 }
 
 
+/* compress the file open as fdIn into a zstd file, whose data is handed to
+ * writeOut(). Used to compress rotated files. The caller's stop flag is
+ * checked after every chunk, so that a shutdown does not need to wait for
+ * a large file; RS_RET_TERMINATE_NOW is returned in that case.
+ */
+static rsRetVal zstd_CompressFile(const int fdIn,
+                                  rsRetVal (*writeOut)(void *pUsr, uchar *pBuf, size_t lenBuf),
+                                  void *const pUsr,
+                                  const sbool *const pbStop) {
+    ZSTD_CCtx *cctx = NULL;
+    uchar *inBuf = NULL;
+    uchar *outBuf = NULL;
+    size_t remaining;
+    DEFiRet;
+
+    const size_t lenInBuf = ZSTD_CStreamInSize();
+    const size_t lenOutBuf = ZSTD_CStreamOutSize();
+    CHKmalloc(inBuf = malloc(lenInBuf));
+    CHKmalloc(outBuf = malloc(lenOutBuf));
+    CHKmalloc(cctx = ZSTD_createCCtx());
+
+    ZSTD_EndDirective mode = ZSTD_e_continue;
+    do {
+        const ssize_t nRead = read(fdIn, inBuf, lenInBuf);
+        if (nRead == -1) {
+            if (errno == EINTR) continue;
+            ABORT_FINALIZE(RS_RET_READ_ERR);
+        }
+        mode = (nRead == 0) ? ZSTD_e_end : ZSTD_e_continue;
+        ZSTD_inBuffer input = {inBuf, (size_t)nRead, 0};
+        do {
+            ZSTD_outBuffer output = {outBuf, lenOutBuf, 0};
+            remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+            if (ZSTD_isError(remaining)) {
+                LogError(0, RS_RET_ZLIB_ERR, "error from ZSTD_compressStream2(): %s", ZSTD_getErrorName(remaining));
+                ABORT_FINALIZE(RS_RET_ZLIB_ERR);
+            }
+            if (output.pos != 0) {
+                CHKiRet(writeOut(pUsr, outBuf, output.pos));
+            }
+        } while ((mode == ZSTD_e_end) ? (remaining != 0) : (input.pos < input.size));
+        if (*pbStop) {
+            ABORT_FINALIZE(RS_RET_TERMINATE_NOW);
+        }
+    } while (mode != ZSTD_e_end);
+
+finalize_it:
+    ZSTD_freeCCtx(cctx);
+    free(inBuf);
+    free(outBuf);
+    RETiRet;
+}
+
+
 /* queryInterface function
  * rgerhards, 2008-03-05
  */
@@ -153,6 +381,7 @@ BEGINobjQueryInterface(zstdw)
     pIf->doStrmWrite = zstd_doStrmWrite;
     pIf->doCompressFinish = zstd_doCompressFinish;
     pIf->Destruct = zstd_Destruct;
+    pIf->CompressFile = zstd_CompressFile;
 finalize_it:
 ENDobjQueryInterface(zstdw)
 
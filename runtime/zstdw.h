@@ -29,13 +29,21 @@ BEGINinterface(zstdw) /* name must also be changed in ENDinterface macro! */
                             rsRetVal (*strmPhysWrite)(strm_t *pThis, uchar *pBuf, size_t lenBuf));
     rsRetVal (*doCompressFinish)(strm_t *pThis, rsRetVal (*Destruct)(strm_t *pThis, uchar *pBuf, size_t lenBuf));
     rsRetVal (*Destruct)(strm_t *pThis);
+    /* v2 added 2026-10-18 */
+    rsRetVal (*CompressFile)(int fdIn,
+                             rsRetVal (*writeOut)(void *pUsr, uchar *pBuf, size_t lenBuf),
+                             void *pUsr,
+                             const sbool *pbStop);
 ENDinterface(zstdw)
-#define zstdwCURR_IF_VERSION 1 /* increment whenever you change the interface structure! */
+#define zstdwCURR_IF_VERSION 2 /* increment whenever you change the interface structure! */
 
 
 /* prototypes */
 PROTOTYPEObj(zstdw);
 
+/* suffix of the frame index written next to seekable zstd files */
+#define ZSTDW_INDEX_SUFFIX ".zidx"
+
 /* the name of our library binary */
 #define LM_ZSTDW_FILENAME "lmzstdw"
 
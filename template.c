@@ -48,6 +48,7 @@
 #include "msg.h"
 #include "parserif.h"
 #include "unicode-helper.h"
+#include "jsonlazy.h"
 
 /* states for lazily built JSON tree used in list templates with jsonf mode */
 #define TPL_JSON_TREE_NOT_BUILT 0
@@ -2852,6 +2853,23 @@ void tplLastStaticInit(rsconf_t *conf, struct template *tpl) {
     conf->templates.lastStatic = tpl;
 }
 
+/* Collect the message variable references of all templates for lazy JSON
+ * parsing (see jsonlazy.h).
+ */
+void tplCollectJSONRefs(rsconf_t *conf, jsonlazy_keys_t *pKeys) {
+    struct template *pTpl;
+    struct templateEntry *pTpe;
+
+    for (pTpl = conf->templates.root; pTpl != NULL; pTpl = pTpl->pNext) {
+        if (pTpl->bHaveSubtree) jsonlazyAddRef(pKeys, pTpl->subtree.id, pTpl->subtree.name);
+        for (pTpe = pTpl->pEntryRoot; pTpe != NULL; pTpe = pTpe->pNext) {
+            if (pTpe->eEntryType == FIELD) {
+                jsonlazyAddRef(pKeys, pTpe->data.field.msgProp.id, pTpe->data.field.msgProp.name);
+            }
+        }
+    }
+}
+
 /* Print the template structure. This is more or less a
  * debug or test aid, but anyhow I think it's worth it...
  */
@@ -188,6 +188,7 @@ int tplGetEntryCount(struct template *pTpl);
 void tplDeleteAll(rsconf_t *conf);
 void tplDeleteNew(rsconf_t *conf);
 void tplPrintList(rsconf_t *conf);
+void tplCollectJSONRefs(rsconf_t *conf, jsonlazy_keys_t *pKeys);
 void tplLastStaticInit(rsconf_t *conf, struct template *tpl);
 rsRetVal ExtendBuf(actWrkrIParams_t *const iparam, const size_t iMinSize);
 int tplRequiresDateCall(struct template *pTpl);
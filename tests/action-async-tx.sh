@@ -0,0 +1,40 @@
+#!/bin/bash
+# check asynchronous transactions (action.maxInFlight) with the omtestasync
+# test module: all messages must be delivered when batches complete
+# successfully, are reported suspended or fail.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+module(load="../plugins/omtesting/.libs/omtestasync")
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" Ruleset="stats" bracketing="on")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" {
+	action(type="omtestasync" file="'${RSYSLOG_DYNNAME}'.ok.log" template="outfmt" name="ok"
+	       queue.type="linkedList" queue.dequeueBatchSize="64" action.maxInFlight="4")
+	action(type="omtestasync" file="'${RSYSLOG_DYNNAME}'.suspend.log" template="outfmt" name="suspend"
+	       failEvery="3" failWith="suspend"
+	       queue.type="linkedList" queue.dequeueBatchSize="64" action.maxInFlight="4")
+	action(type="omtestasync" file="'${RSYSLOG_DYNNAME}'.error.log" template="outfmt" name="error"
+	       failEvery="3" failWith="error"
+	       queue.type="linkedList" queue.dequeueBatchSize="64" action.maxInFlight="4")
+}
+'
+startup
+injectmsg
+wait_queueempty
+wait_for_stats_flush ${RSYSLOG_DYNNAME}.out.stats.log
+shutdown_when_empty
+wait_shutdown
+for f in ok suspend error; do
+	SEQ_CHECK_FILE=${RSYSLOG_DYNNAME}.$f.log seq_check
+done
+content_check --regex "ok: .*async.submitted=[1-9][0-9]* async.retried=0" ${RSYSLOG_DYNNAME}.out.stats.log
+content_check --regex "suspend: .*async.submitted=[1-9][0-9]* async.retried=[1-9]" ${RSYSLOG_DYNNAME}.out.stats.log
+content_check --regex "error: .*async.submitted=[1-9][0-9]* async.retried=[1-9]" ${RSYSLOG_DYNNAME}.out.stats.log
+exit_test
@@ -0,0 +1,29 @@
+#!/bin/bash
+# check that adaptive commit sizing (action.batch.*) delivers all
+# messages and reports its counters via impstats
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+generate_conf
+add_conf '
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" Ruleset="stats" bracketing="on")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:"
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt" name="adaptive"
+	       queue.type="linkedList" queue.dequeueBatchSize="128" queue.minDequeueBatchSize.timeout="100"
+	       action.batch.targetLatency="20" action.batch.minSize="4" action.batch.maxSize="2048")
+'
+startup
+injectmsg
+wait_queueempty
+wait_for_stats_flush ${RSYSLOG_DYNNAME}.out.stats.log
+shutdown_when_empty
+wait_shutdown
+seq_check
+content_check --regex "adaptive: .*batch.size=[0-9]+ batch.latency=[0-9]+ batch.commits=[1-9]" \
+	${RSYSLOG_DYNNAME}.out.stats.log
+exit_test
@@ -0,0 +1,39 @@
+#!/bin/bash
+# check that mmap read mode survives a truncation ("copytruncate") while a
+# window of the file is mapped and being read by a reader thread: the lost
+# pages raise SIGBUS, which must be recovered from, and the new content of
+# the file must be read afterwards
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify-only
+export NUMMESSAGES=200000
+generate_conf
+add_conf '
+global(workDirectory="./'"$RSYSLOG_DYNNAME"'.spool")
+main_queue(queue.size="200")
+module(load="../plugins/omtesting/.libs/omtesting")
+module(load="../plugins/imfile/.libs/imfile" mode="inotify" readerThreads="2")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input" Tag="file:" mmap="on" reopenOnTruncate="on")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then {
+	:omtesting:sleep 0 1000
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+mkdir $RSYSLOG_DYNNAME.spool
+# the file spans several windows; the slow action and the small queue keep
+# the reader blocked in the middle of the first one
+./inputfilegen -m $NUMMESSAGES > $RSYSLOG_DYNNAME.input
+startup
+wait_file_lines $RSYSLOG_OUT_LOG 500
+
+truncate -s 0 $RSYSLOG_DYNNAME.input
+$TESTTOOL_DIR/msleep 1000
+./inputfilegen -m 10 -i 9000000 >> $RSYSLOG_DYNNAME.input
+wait_content '09000009'
+
+shutdown_immediate
+wait_shutdown
+content_check_with_count '09000000' 1
+exit_test
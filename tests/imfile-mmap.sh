@@ -0,0 +1,33 @@
+#!/bin/bash
+# check mmap read mode: a file that spans several mapping windows, data
+# appended later and a truncation (which must be detected as with read())
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify
+export NUMMESSAGES=200000
+generate_conf
+add_conf '
+global(workDirectory="./'"$RSYSLOG_DYNNAME"'.spool")
+module(load="../plugins/imfile/.libs/imfile")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input" Tag="file:" mmap="on" reopenOnTruncate="on")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+mkdir $RSYSLOG_DYNNAME.spool
+./inputfilegen -m $NUMMESSAGES > $RSYSLOG_DYNNAME.input
+startup
+wait_file_lines $RSYSLOG_OUT_LOG $NUMMESSAGES
+
+./inputfilegen -m 1000 -i $NUMMESSAGES >> $RSYSLOG_DYNNAME.input
+wait_file_lines $RSYSLOG_OUT_LOG $((NUMMESSAGES + 1000))
+
+# the new content is shorter than what was read, so this is a truncation
+./inputfilegen -m 10 -i $((NUMMESSAGES + 1000)) > $RSYSLOG_DYNNAME.input
+wait_file_lines $RSYSLOG_OUT_LOG $((NUMMESSAGES + 1010))
+
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES + 1009))
+exit_test
@@ -0,0 +1,46 @@
+#!/bin/bash
+# check that with reader threads, a large file and many small ones are read
+# completely and the messages of each file are submitted in order
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify-only
+export BIGLINES=20000
+export NUMSMALL=20
+export SMALLLINES=100
+export NUMMESSAGES=$((BIGLINES + NUMSMALL * SMALLLINES))
+
+mkdir "$RSYSLOG_DYNNAME.work" "$RSYSLOG_DYNNAME.input"
+generate_conf
+add_conf '
+global(workDirectory="./'"$RSYSLOG_DYNNAME"'.work")
+
+module(load="../plugins/imfile/.libs/imfile" mode="inotify" readerThreads="4")
+
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input/*.log" Tag="file:" maxLinesAtOnce="100")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+./inputfilegen -m $BIGLINES > $RSYSLOG_DYNNAME.input/big.log &
+for i in $(seq 0 $((NUMSMALL - 1))); do
+	./inputfilegen -m $SMALLLINES -i $((BIGLINES + i * SMALLLINES)) > $RSYSLOG_DYNNAME.input/small.$i.log
+done
+wait
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+
+# messages of each file must be in the order they were written
+awk -v big=$BIGLINES -v small=$SMALLLINES '
+	{ f = ($1 < big) ? -1 : int(($1 - big) / small) }
+	(f in last) && $1 != last[f] + 1 { print "out of order: " last[f] " followed by " $1; err = 1 }
+	{ last[f] = $1 }
+	END { exit err }' $RSYSLOG_OUT_LOG
+if [ $? -ne 0 ]; then
+	echo "FAIL: messages of a file were not submitted in order"
+	error_exit 1
+fi
+exit_test
@@ -0,0 +1,43 @@
+#!/bin/bash
+# Benchmark for the imfile line reader (strmReadLine/strmReadMultiLine).
+# Reads a large file with long lines in the different read variants and
+# reports the throughput of each. Also checks that all lines are read.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export TB_TEST_MAX_RUNTIME=1800 # works on large files
+export NUMMESSAGES=${IMFILE_PERF_LINES:-1000000}
+./inputfilegen -m $NUMMESSAGES -d 1000 > $RSYSLOG_DYNNAME.data
+ls -lh $RSYSLOG_DYNNAME.data
+
+# $1 - name, $2 - input parameters, $3 - expected number of output lines
+variant=0
+run_variant() {
+	variant=$((variant + 1))
+	# a new file for each variant, so that no state file applies
+	cp $RSYSLOG_DYNNAME.data $RSYSLOG_DYNNAME.input.$variant
+	generate_conf
+	add_conf '
+module(load="../plugins/imfile/.libs/imfile")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME.input.$variant'" Tag="file:" '"$2"')
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+	rm -f $RSYSLOG_OUT_LOG
+	local start=$(date +%s%N)
+	startup
+	wait_file_lines --delay 1000 "$RSYSLOG_OUT_LOG" $3 1500
+	local end=$(date +%s%N)
+	shutdown_when_empty
+	wait_shutdown
+	local ms=$(( (end - start) / 1000000 ))
+	[ $ms -eq 0 ] && ms=1
+	printf 'imfile readline benchmark: %-28s %6d ms %8d lines/s\n' "$1" $ms $(( NUMMESSAGES * 1000 / ms ))
+}
+
+run_variant "readMode=0" 'readMode="0"' $NUMMESSAGES
+run_variant "readMode=0 trimLineOverBytes" 'readMode="0" trimLineOverBytes="200"' $NUMMESSAGES
+run_variant "readMode=2 escapeLF" 'readMode="2" escapeLF="on"' $((NUMMESSAGES - 1)) # last line stays pending
+run_variant "endmsg.regex" 'endmsg.regex="X$"' $NUMMESSAGES
+seq_check
+exit_test
@@ -0,0 +1,68 @@
+#!/bin/bash
+# check that imfile keeps the file states in a state store if one is
+# configured: the state file of a run without the store is moved into it,
+# and restarts continue where the previous run stopped
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify
+write_conf() {
+	generate_conf
+	add_conf '
+global(workDirectory="./'"$RSYSLOG_DYNNAME"'.spool")
+
+module(load="../plugins/imfile/.libs/imfile" '"$1"')
+
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input" Tag="file:")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+}
+
+# first run without state store, leaves a state file
+write_conf ''
+./inputfilegen -m 100 > $RSYSLOG_DYNNAME.input
+startup
+wait_file_lines $RSYSLOG_OUT_LOG 100
+shutdown_when_empty
+wait_shutdown
+if ! ls $RSYSLOG_DYNNAME.spool/imfile-state:* > /dev/null 2>&1; then
+	echo "FAIL: no state file written by the run without state store"
+	ls -l $RSYSLOG_DYNNAME.spool
+	error_exit 1
+fi
+
+# with the state store, the state file must be moved into it
+write_conf 'stateStore="state.db" stateStore.commitInterval="100"'
+./inputfilegen -m 100 -i 100 >> $RSYSLOG_DYNNAME.input
+startup
+wait_file_lines $RSYSLOG_OUT_LOG 200
+shutdown_when_empty
+wait_shutdown
+if ls $RSYSLOG_DYNNAME.spool/imfile-state:* > /dev/null 2>&1; then
+	echo "FAIL: state file still exists with state store"
+	ls -l $RSYSLOG_DYNNAME.spool
+	error_exit 1
+fi
+if ! grep -q "imfile-state:" $RSYSLOG_DYNNAME.spool/state.db; then
+	echo "FAIL: state store does not contain the file state"
+	cat -v $RSYSLOG_DYNNAME.spool/state.db
+	error_exit 1
+fi
+
+# and the next run must continue from the state in the store. A malformed
+# record in front of it must be skipped, not cut off the rest of the store.
+sed -i '1a +5 3 bogus' $RSYSLOG_DYNNAME.spool/state.db
+./inputfilegen -m 100 -i 200 >> $RSYSLOG_DYNNAME.input
+startup
+wait_file_lines $RSYSLOG_OUT_LOG 300
+shutdown_when_empty
+wait_shutdown
+seq_check 0 299
+if grep -q "bogus" $RSYSLOG_DYNNAME.spool/state.db; then
+	echo "FAIL: malformed record not removed from state store"
+	cat -v $RSYSLOG_DYNNAME.spool/state.db
+	error_exit 1
+fi
+exit_test
@@ -0,0 +1,46 @@
+#!/bin/bash
+# check that a wildcard matching many files picks up all of them, both those
+# existing at startup and those created later, and that files are still
+# picked up after many others have been deleted (watch descriptors and
+# active objects are removed from and re-added to imfile's tables)
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify-only
+export NUMFILES=200
+export IMFILECHECKTIMEOUT="60"
+
+mkdir "$RSYSLOG_DYNNAME.work" "$RSYSLOG_DYNNAME.input"
+generate_conf
+add_conf '
+global(workDirectory="./'"$RSYSLOG_DYNNAME"'.work")
+
+module(load="../plugins/imfile/.libs/imfile" mode="inotify")
+
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input/*.log" Tag="file:")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+for i in $(seq 1 $NUMFILES); do
+	./inputfilegen -m 1 -i $i > $RSYSLOG_DYNNAME.input/before.$i.log
+done
+
+startup
+wait_file_lines $RSYSLOG_OUT_LOG $NUMFILES $IMFILECHECKTIMEOUT
+
+for i in $(seq 1 $NUMFILES); do
+	./inputfilegen -m 1 -i $((NUMFILES + i)) > $RSYSLOG_DYNNAME.input/after.$i.log
+done
+wait_file_lines $RSYSLOG_OUT_LOG $((2 * NUMFILES)) $IMFILECHECKTIMEOUT
+
+rm -f $RSYSLOG_DYNNAME.input/*.log
+for i in $(seq 1 $NUMFILES); do
+	./inputfilegen -m 1 -i $((2 * NUMFILES + i)) > $RSYSLOG_DYNNAME.input/again.$i.log
+done
+wait_file_lines $RSYSLOG_OUT_LOG $((3 * NUMFILES)) $IMFILECHECKTIMEOUT
+
+shutdown_when_empty
+wait_shutdown
+seq_check 1 $((3 * NUMFILES))
+exit_test
@@ -0,0 +1,23 @@
+#!/bin/bash
+# check that imtcp receives all messages when each worker has its own epoll
+# set and SO_REUSEPORT listener; the low maxReads also exercises the re-arm
+# done on starvation protection in that mode
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+generate_conf
+add_conf '
+module(load="../plugins/imtcp/.libs/imtcp" workerthreads="4" workerthreads.reuseport="on")
+input(type="imtcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port" starvationProtection.maxReads="2")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(type="omfile" template="outfmt"
+			         file="'$RSYSLOG_OUT_LOG'")
+'
+startup
+tcpflood -c20 -m $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
@@ -0,0 +1,55 @@
+#!/bin/bash
+# check that imudp receives all messages with UDP GRO enabled and
+# reports the GRO listener counters via impstats. The messages are sent
+# with UDP_SEGMENT, so that the kernel passes them to imudp as coalesced
+# buffers, which imudp must split into the original datagrams.
+# Note that with UDP we can always have message loss, so we keep the
+# message count low.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+./udpgso_sender -c || skip_test
+generate_conf
+add_conf '
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" Ruleset="stats" bracketing="on")
+module(load="../plugins/imudp/.libs/imudp" gro="on")
+input(type="imudp" address="127.0.0.1" port="'$TCPFLOOD_PORT'")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+template(name="rawfmt" type="string" string="%rawmsg%\n")
+:msg, contains, "msgnum:" {
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+	action(type="omfile" file="'$RSYSLOG2_OUT_LOG'" template="rawfmt")
+}
+'
+startup
+./udpgso_sender -t 127.0.0.1 -p $TCPFLOOD_PORT -m $NUMMESSAGES -s 20 || error_exit 1
+wait_queueempty
+wait_for_stats_flush ${RSYSLOG_DYNNAME}.out.stats.log
+shutdown_when_empty
+wait_shutdown
+seq_check
+
+# every datagram must arrive exactly as it was sent
+for i in $(seq 0 $((NUMMESSAGES - 1))); do
+	printf '<167>Mar  1 01:00:00 172.20.245.8 tag msgnum:%8.8d:\n' $i
+done > $RSYSLOG_DYNNAME.expected
+if ! cmp <(sort $RSYSLOG_DYNNAME.expected) <(sort $RSYSLOG2_OUT_LOG); then
+	echo "FAIL: received messages differ from the sent ones"
+	diff <(sort $RSYSLOG_DYNNAME.expected) <(sort $RSYSLOG2_OUT_LOG) | head -20
+	error_exit 1
+fi
+
+# the datagrams must have been received in coalesced buffers
+stats=$(grep -o 'gro.buffers=[0-9]* gro.segments=[0-9]*' ${RSYSLOG_DYNNAME}.out.stats.log | tail -n1)
+buffers=$(echo "$stats" | sed -n 's/gro.buffers=\([0-9]*\) .*/\1/p')
+segments=$(echo "$stats" | sed -n 's/.*gro.segments=\([0-9]*\)/\1/p')
+if [ -z "$buffers" ] || [ "$buffers" -lt 1 ] || [ "$segments" -le "$buffers" ]; then
+	echo "FAIL: expected gro.segments > gro.buffers, stats: '$stats'"
+	error_exit 1
+fi
+exit_test
@@ -0,0 +1,25 @@
+#!/bin/bash
+# check that imudp receives all messages if each worker has its own
+# SO_REUSEPORT socket per listener. With CPU steering, the datagrams of
+# our single sender are spread over the workers.
+# Note that with UDP we can always have message loss, so we keep the
+# message count low.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export TCPFLOOD_EXTRA_OPTS="-b1 -W1"
+export NUMMESSAGES=1000
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+generate_conf
+add_conf '
+module(load="../plugins/imudp/.libs/imudp" threads="4" reusePort="on" reusePort.steering="cpu")
+input(type="imudp" address="127.0.0.1" port="'$TCPFLOOD_PORT'")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+startup
+tcpflood -Tudp -t 127.0.0.1 -m $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
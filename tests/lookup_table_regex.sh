@@ -0,0 +1,54 @@
+#!/bin/bash
+# test for lookup tables of type "regex": the first matching entry (in table
+# order) must win, also for large tables that use the literal prefilter, and
+# after a HUP-triggered reload.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+# $1: file name, $2: regex of entry 197, $3: regex of entry 198
+gen_table() {
+	{
+		printf '{ "version": 1, "nomatch": "none", "type": "regex", "table": [\n'
+		for i in $(seq 0 196); do
+			printf '  {"regex": "no-such-token-%d", "tag": "never"},\n' $i
+		done
+		printf '  {"regex": "%s", "tag": "first"},\n' "$2"
+		printf '  {"regex": "%s", "tag": "second"},\n' "$3"
+		printf '  {"regex": "(xyz|zyx)", "tag": "never"}\n'
+		printf ']}\n'
+	} > $1
+}
+generate_conf
+add_conf '
+lookup_table(name="rx" file="'$RSYSLOG_DYNNAME'.rx.lkp_tbl" reloadOnHUP="on")
+
+template(name="outfmt" type="string" string="- %msg% %$.lkp%\n")
+
+set $.lkp = lookup("rx", $msg);
+
+action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+gen_table $RSYSLOG_DYNNAME.rx.lkp_tbl 'msgnum:0000000[0-4]:' 'msgnum:000000[0-9]+'
+startup
+injectmsg 0 10
+wait_queueempty
+content_check "msgnum:00000000: first"
+content_check "msgnum:00000004: first"
+content_check "msgnum:00000005: second"
+content_check "msgnum:00000009: second"
+gen_table $RSYSLOG_DYNNAME.rx.lkp_tbl 'msgnum:000000[0-9]+' 'msgnum:0000000[0-4]:'
+issue_HUP
+await_lookup_table_reload
+injectmsg 10 2
+injectmsg 0 1
+shutdown_when_empty
+wait_shutdown
+content_check "msgnum:00000010: first"
+content_check "msgnum:00000011: first"
+if [ $(grep -c "msgnum:00000000: first" $RSYSLOG_OUT_LOG) -ne 2 ]; then
+	echo "FAIL: entry order not honored after reload"
+	cat $RSYSLOG_OUT_LOG
+	error_exit 1
+fi
+assert_content_missing "never"
+assert_content_missing "none"
+exit_test
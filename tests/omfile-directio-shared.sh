@@ -0,0 +1,32 @@
+#!/bin/bash
+# check that a file written with direct I/O does not overwrite data another
+# process appended to it: omfile must notice the size change and switch to
+# regular appending writes. If the file system does not support O_DIRECT,
+# the regular write path is used from the start, so the test passes on all
+# platforms.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+				 directIO="on" ioBufferSize="10k")
+'
+startup
+injectmsg 0 10000
+wait_file_lines $RSYSLOG_OUT_LOG 10000
+echo "written by another process" >> $RSYSLOG_OUT_LOG
+injectmsg 10000 10000
+wait_file_lines $RSYSLOG_OUT_LOG $((NUMMESSAGES + 1))
+shutdown_when_empty
+wait_shutdown
+if ! grep -qx "written by another process" $RSYSLOG_OUT_LOG; then
+	echo "FAIL: line appended by another process was overwritten"
+	error_exit 1
+fi
+grep -vx "written by another process" $RSYSLOG_OUT_LOG > $RSYSLOG_DYNNAME.seq.log
+export SEQ_CHECK_FILE=$RSYSLOG_DYNNAME.seq.log
+seq_check
+exit_test
@@ -0,0 +1,37 @@
+#!/bin/bash
+# check that omfile and disk queue files written with direct I/O are
+# complete, also when a file is reopened and appended to. If the file system
+# does not support O_DIRECT, the regular write path is used, so the test
+# passes on all platforms.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+generate_conf
+add_conf '
+global(workDirectory="'$RSYSLOG_DYNNAME'.spool")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" {
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       directIO="on" ioBufferSize="10k" rotation.sizeLimit="10m")
+	action(type="omfile" file="'$RSYSLOG2_OUT_LOG'" template="outfmt"
+	       queue.type="disk" queue.fileName="actq" queue.maxFileSize="64k"
+	       queue.directIO="on")
+}
+'
+startup
+injectmsg 0 10000
+wait_file_lines $RSYSLOG_OUT_LOG 10000
+shutdown_when_empty
+wait_shutdown
+# after a restart, the files must be appended to
+startup
+injectmsg 10000 10000
+wait_file_lines $RSYSLOG_OUT_LOG $NUMMESSAGES
+wait_file_lines $RSYSLOG2_OUT_LOG $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check
+export SEQ_CHECK_FILE=$RSYSLOG2_OUT_LOG
+seq_check
+exit_test
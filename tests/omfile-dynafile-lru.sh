@@ -0,0 +1,42 @@
+#!/bin/bash
+# check that the dynafile cache evicts the least recently used file and
+# reports hits, misses and evictions via impstats
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" Ruleset="stats" bracketing="on")
+
+template(name="outfmt" type="string" string="%msg:F,58:3%\n")
+template(name="dynfile" type="string" string="'$RSYSLOG_DYNNAME'.out.%msg:F,58:2%.log")
+:msg, contains, "file:"
+	action(type="omfile" dynaFile="dynfile" template="outfmt" dynaFileCacheSize="3")
+'
+startup
+# cache of 3 files, most recently used first: 2 1 0
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:0:0"
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:1:1"
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:2:2"
+# hit, now 0 2 1
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:0:3"
+# miss, evicts 1 - now 3 0 2
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:3:4"
+# hits, now 2 0 3
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:0:5"
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:2:6"
+# miss, evicts 3 - now 1 2 0
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:1:7"
+# current file
+injectmsg_literal "<129>Mar 10 01:00:00 172.20.245.8 tag file:1:8"
+wait_queueempty
+wait_for_stats_flush ${RSYSLOG_DYNNAME}.out.stats.log
+shutdown_when_empty
+wait_shutdown
+cat $RSYSLOG_DYNNAME.out.[0-3].log > $RSYSLOG_OUT_LOG
+seq_check 0 8
+content_check --regex "dynafile cache dynfile: .*requests=9 level0=1 hits=3 missed=5 evicted=2 maxused=3" \
+	${RSYSLOG_DYNNAME}.out.stats.log
+exit_test
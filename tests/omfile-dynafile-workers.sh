@@ -0,0 +1,29 @@
+#!/bin/bash
+# write dynafiles from several action workers concurrently, with a
+# dynafile cache smaller than the number of files
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+combine_files() {
+	cat $RSYSLOG_DYNNAME.out.[0-7].log > $RSYSLOG_OUT_LOG
+}
+export NUMMESSAGES=20000
+export QUEUE_EMPTY_CHECK_FUNC=wait_seq_check
+export PRE_SEQ_CHECK_FUNC=combine_files
+export SEQ_CHECK_FILE=$RSYSLOG_OUT_LOG
+generate_conf
+add_conf '
+module(load="../plugins/imtcp/.libs/imtcp")
+input(type="imtcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+template(name="outfmt" type="string" string="%msg:F,58:3%\n")
+template(name="dynfile" type="string" string="'$RSYSLOG_DYNNAME'.out.%msg:F,58:2%.log")
+local0.* action(type="omfile" template="outfmt" dynafile="dynfile" dynaFileCacheSize="4"
+		queue.type="linkedList" queue.workerThreads="4" queue.workerThreadMinimumMessages="100"
+		queue.dequeueBatchSize="16")
+'
+startup
+tcpflood -m$NUMMESSAGES -f8
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
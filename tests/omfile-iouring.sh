@@ -0,0 +1,36 @@
+#!/bin/bash
+# check that async omfile writes, synced writes and synced disk queue files
+# are complete and in order when they go through the shared io_uring. If the
+# ring can not be set up, the regular write path is used, so the test passes
+# on all platforms.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=5000 # synced disk queue writes are slow
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+generate_conf
+add_conf '
+global(ioUring.entries="64" workDirectory="'$RSYSLOG_DYNNAME'.spool")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+template(name="dynfile" type="string" string="'$RSYSLOG_DYNNAME'.dyn.%$.n%.log")
+:msg, contains, "msgnum:" {
+	set $.n = cnum(field($msg, 58, 2)) % 8;
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       asyncWriting="on" flushInterval="1" ioBufferSize="4k")
+	action(type="omfile" dynaFile="dynfile" template="outfmt"
+	       asyncWriting="on" flushInterval="1" ioBufferSize="4k")
+	action(type="omfile" file="'$RSYSLOG2_OUT_LOG'" template="outfmt" sync="on"
+	       queue.type="disk" queue.fileName="actq" queue.syncQueueFiles="on")
+}
+'
+startup
+injectmsg
+wait_file_lines $RSYSLOG2_OUT_LOG $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check
+export SEQ_CHECK_FILE=$RSYSLOG2_OUT_LOG
+seq_check
+cat $RSYSLOG_DYNNAME.dyn.*.log | sort -n > $RSYSLOG_DYNNAME.dyn.all
+export SEQ_CHECK_FILE=$RSYSLOG_DYNNAME.dyn.all
+seq_check
+exit_test
@@ -0,0 +1,42 @@
+#!/bin/bash
+# check native time based rotation: data of each interval goes to its own
+# segment, which is named after the end of its interval, and no message
+# is lost
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=2000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then {
+	action(type="omfile" file="'$RSYSLOG_DYNNAME.log'" template="outfmt"
+		rotation.interval="2")
+}
+'
+startup
+injectmsg 0 1000
+wait_queueempty
+# make sure the next messages fall into a later interval
+sleep 3
+injectmsg 1000 1000
+shutdown_when_empty
+wait_shutdown
+ls -l $RSYSLOG_DYNNAME.log*
+segments=$(ls $RSYSLOG_DYNNAME.log.* 2> /dev/null)
+if [ "$segments" == "" ]; then
+	echo "FAIL: file was not rotated"
+	error_exit 1
+fi
+# intervals of 2 seconds are aligned to midnight, so they end on even seconds
+for seg in $segments; do
+	stamp=${seg#$RSYSLOG_DYNNAME.log.}
+	secs=${stamp:13:2}
+	if [ $(( 10#$secs % 2 )) -ne 0 ]; then
+		echo "FAIL: segment $seg is not named after the end of its interval"
+		error_exit 1
+	fi
+done
+cat $segments $RSYSLOG_DYNNAME.log > $RSYSLOG_OUT_LOG
+seq_check
+exit_test
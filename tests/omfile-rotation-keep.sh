@@ -0,0 +1,42 @@
+#!/bin/bash
+# check that native rotation removes the oldest segments beyond
+# rotation.keep, and that a plain rotation.sizeLimit without any native
+# rotation parameter still does not rotate
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then {
+	action(type="omfile" file="'$RSYSLOG_DYNNAME.log'" template="outfmt"
+		rotation.sizeLimit="10k" rotation.keep="2")
+	action(type="omfile" file="'$RSYSLOG_DYNNAME.plain.log'" template="outfmt"
+		rotation.sizeLimit="10k")
+}
+'
+startup
+injectmsg
+wait_queueempty
+# give the rotation thread time to remove the old segments
+for i in $(seq 1 100); do
+	[ $(ls $RSYSLOG_DYNNAME.log.* 2> /dev/null | wc -l) -le 2 ] && break
+	rst_msleep 100
+done
+shutdown_when_empty
+wait_shutdown
+ls -l $RSYSLOG_DYNNAME.*log*
+if [ $(ls $RSYSLOG_DYNNAME.log.* 2> /dev/null | wc -l) -ne 2 ]; then
+	echo "FAIL: expected exactly 2 segments to be kept"
+	error_exit 1
+fi
+if ls $RSYSLOG_DYNNAME.plain.log.* 2> /dev/null; then
+	echo "FAIL: rotation.sizeLimit without native rotation parameters rotated the file"
+	error_exit 1
+fi
+# the kept segments and the current file hold the newest messages, without gaps
+cat $RSYSLOG_DYNNAME.log.* $RSYSLOG_DYNNAME.log > $RSYSLOG_OUT_LOG
+first=$(sort -n $RSYSLOG_OUT_LOG | head -1)
+seq_check $(( 10#$first )) $(( NUMMESSAGES - 1 ))
+exit_test
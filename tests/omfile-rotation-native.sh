@@ -0,0 +1,37 @@
+#!/bin/bash
+# check native size based rotation: rotated files are compressed in the
+# background and no message is lost
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=50000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then {
+	action(type="omfile" file="'$RSYSLOG_DYNNAME.log'" template="outfmt"
+		rotation.sizeLimit="50k" rotation.compress="gzip")
+}
+'
+startup
+injectmsg
+wait_queueempty
+# give the rotation thread time to compress the last rotated file
+for i in $(seq 1 100); do
+	ls $RSYSLOG_DYNNAME.log.*[0-9] > /dev/null 2>&1 || break
+	rst_msleep 100
+done
+shutdown_when_empty
+wait_shutdown
+ls -l $RSYSLOG_DYNNAME.log*
+if ls $RSYSLOG_DYNNAME.log.*[0-9] 2> /dev/null; then
+	echo "FAIL: rotated files were not compressed"
+	error_exit 1
+fi
+if [ $(ls $RSYSLOG_DYNNAME.log.*.gz | wc -l) -lt 2 ]; then
+	echo "FAIL: file was not rotated"
+	error_exit 1
+fi
+{ gunzip -c $RSYSLOG_DYNNAME.log.*.gz; cat $RSYSLOG_DYNNAME.log; } > $RSYSLOG_OUT_LOG
+seq_check
+exit_test
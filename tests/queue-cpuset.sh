@@ -0,0 +1,26 @@
+#!/bin/bash
+# check that workers of a queue pinned via queue.cpuset process all
+# messages, and that an invalid cpuset is reported but not fatal
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" {
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       queue.type="linkedList" queue.workerThreads="2" queue.cpuset="0")
+	action(type="omfile" file="'$RSYSLOG2_OUT_LOG'" template="outfmt"
+	       queue.type="linkedList" queue.cpuset="3-1")
+}
+action(type="omfile" file="'$RSYSLOG_DYNNAME'.errors.log")
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check
+export SEQ_CHECK_FILE=$RSYSLOG2_OUT_LOG
+seq_check
+content_check "invalid cpuset '3-1'" $RSYSLOG_DYNNAME.errors.log
+exit_test
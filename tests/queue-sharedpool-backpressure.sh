@@ -0,0 +1,26 @@
+#!/bin/bash
+# check that a full action queue slows down its producers instead of losing
+# messages when the shared worker pool has a single thread. The main and
+# ruleset queue workers that wait for space in the action queue must not
+# hold the pool thread that the action worker needs to drain it.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=500
+generate_conf
+add_conf '
+global(workerPool.threads="1")
+module(load="../plugins/omtesting/.libs/omtestasync")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+ruleset(name="rs" queue.type="linkedList") {
+	action(type="omtestasync" file="'$RSYSLOG_OUT_LOG'" template="outfmt" delay="5"
+	       queue.type="linkedList" queue.size="10" queue.dequeueBatchSize="2"
+	       action.maxInFlight="1")
+}
+:msg, contains, "msgnum:" call rs
+'
+startup
+injectmsg 0 $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
@@ -0,0 +1,74 @@
+#!/bin/bash
+# check that the shared worker pool is fair: with more busy queues than
+# pool threads, a queue that keeps finding work must yield its pool thread
+# after its time slice, so that every queue keeps making progress.
+# Each ruleset queue needs about 1ms per message, so none of them runs dry
+# while the messages are processed. Ruleset queues must opt in to the pool;
+# they write directly, so they never wait for a full action queue.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=2000
+generate_conf
+add_conf '
+global(workerPool.threads="2")
+module(load="../plugins/omtesting/.libs/omtesting")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+ruleset(name="rs1" queue.type="linkedList" queue.dequeueBatchSize="4"
+	queue.sharedWorkerPool="on") {
+	:omtesting:sleep 0 1000
+	action(type="omfile" file="'$RSYSLOG_DYNNAME'.rs1.log" template="outfmt")
+}
+ruleset(name="rs2" queue.type="linkedList" queue.dequeueBatchSize="4"
+	queue.sharedWorkerPool="on") {
+	:omtesting:sleep 0 1000
+	action(type="omfile" file="'$RSYSLOG_DYNNAME'.rs2.log" template="outfmt")
+}
+ruleset(name="rs3" queue.type="linkedList" queue.dequeueBatchSize="4"
+	queue.sharedWorkerPool="on") {
+	:omtesting:sleep 0 1000
+	action(type="omfile" file="'$RSYSLOG_DYNNAME'.rs3.log" template="outfmt")
+}
+:msg, contains, "msgnum:" {
+	call rs1
+	call rs2
+	call rs3
+}
+'
+startup
+injectmsg 0 $NUMMESSAGES
+
+count_lines() {
+	if [ -f "$1" ]; then
+		wc -l < "$1"
+	else
+		echo 0
+	fi
+}
+
+# wait until the first queue has done a quarter of its work; without
+# fairness, at least one of the others has not got a pool thread by then
+for i in $(seq 1 300); do
+	done_max=0
+	for rs in rs1 rs2 rs3; do
+		n=$(count_lines $RSYSLOG_DYNNAME.$rs.log)
+		[ $n -gt $done_max ] && done_max=$n
+	done
+	[ $done_max -ge $((NUMMESSAGES / 4)) ] && break
+	./msleep 100
+done
+for rs in rs1 rs2 rs3; do
+	n=$(count_lines $RSYSLOG_DYNNAME.$rs.log)
+	echo "$rs processed $n messages when the first queue reached $done_max"
+	if [ $n -eq 0 ]; then
+		echo "FAIL: queue of ruleset $rs made no progress, it starved"
+		error_exit 1
+	fi
+done
+
+shutdown_when_empty
+wait_shutdown
+for rs in rs1 rs2 rs3; do
+	export SEQ_CHECK_FILE=$RSYSLOG_DYNNAME.$rs.log
+	seq_check
+done
+exit_test
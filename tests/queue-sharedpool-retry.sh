@@ -0,0 +1,28 @@
+#!/bin/bash
+# check that an action which is suspended and retried forever does not keep
+# the only thread of the shared worker pool busy. Its worker must give the
+# thread back while it waits for the next retry, so that the queue of the
+# second action still gets drained.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=500
+generate_conf
+add_conf '
+global(workerPool.threads="1")
+module(load="../plugins/omtesting/.libs/omtesting")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+$ActionQueueType LinkedList
+$ActionResumeRetryCount -1
+$ActionResumeInterval 1
+:msg, contains, "msgnum:" :omtesting:always_suspend
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt" queue.type="linkedList")
+'
+startup
+injectmsg 0 $NUMMESSAGES
+# the suspended action queue never drains, so we cannot shut down when empty
+wait_file_lines "$RSYSLOG_OUT_LOG" $NUMMESSAGES
+shutdown_immediate
+wait_shutdown
+seq_check
+exit_test
@@ -0,0 +1,32 @@
+#!/bin/bash
+# check that queues whose workers run on the shared worker pool process all
+# messages, including when there are more queue workers than pool threads
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+generate_conf
+add_conf '
+global(workerPool.threads="2")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" {
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       queue.type="linkedList" queue.workerThreads="4"
+	       queue.timeoutWorkerThreadShutdown="100")
+	action(type="omfile" file="'$RSYSLOG2_OUT_LOG'" template="outfmt"
+	       queue.type="fixedArray")
+	action(type="omfile" file="'$RSYSLOG_DYNNAME'.dedicated.log" template="outfmt"
+	       queue.type="linkedList" queue.sharedWorkerPool="off")
+}
+'
+startup
+injectmsg 0 10000
+./msleep 500 # let the pooled workers park and time out
+injectmsg 10000 10000
+shutdown_when_empty
+wait_shutdown
+seq_check
+export SEQ_CHECK_FILE=$RSYSLOG2_OUT_LOG
+seq_check
+export SEQ_CHECK_FILE=$RSYSLOG_DYNNAME.dedicated.log
+seq_check
+exit_test
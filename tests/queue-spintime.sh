@@ -0,0 +1,29 @@
+#!/bin/bash
+# check that queues with spinning idle workers (queue.spinTime) process
+# all messages, both in bursts and when messages trickle in
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" {
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       queue.type="linkedList" queue.spinTime="200")
+	action(type="omfile" file="'$RSYSLOG2_OUT_LOG'" template="outfmt"
+	       queue.type="fixedArray" queue.workerThreads="2" queue.spinTime="50")
+}
+'
+startup
+injectmsg 0 5000
+for i in $(seq 5000 5099); do
+	injectmsg $i 1
+	./msleep 5
+done
+injectmsg 5100 4900
+shutdown_when_empty
+wait_shutdown
+seq_check
+export SEQ_CHECK_FILE=$RSYSLOG2_OUT_LOG
+seq_check
+exit_test
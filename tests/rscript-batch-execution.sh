@@ -0,0 +1,45 @@
+#!/bin/bash
+# Test for global(ruleset.batchExecution="on"): statements are executed
+# batch-at-a-time. Checks if/else, stop, PRI filters and (sync) ruleset
+# calls deliver the same result as with per-message execution.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+global(ruleset.batchExecution="on")
+main_queue(queue.dequeueBatchSize="512")
+
+template(name="outfmt" type="string" string="%$.nbr%\n")
+
+ruleset(name="classify") {
+	if cnum($.nbr) % 2 == 0 then {
+		set $.kind = "even";
+	} else {
+		set $.kind = "odd";
+	}
+}
+
+mail.* {
+	action(type="omfile" file="'$RSYSLOG_DYNNAME'.mail.log" template="outfmt")
+}
+
+local4.debug {
+	if $msg contains "msgnum:" then {
+		set $.nbr = field($msg, 58, 2);
+		if cnum($.nbr) < 100 then
+			stop
+		call classify
+		if $.kind == "" then
+			stop
+		action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+	}
+}
+'
+startup
+injectmsg 0 $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check 100 $((NUMMESSAGES - 1))
+check_file_not_exists $RSYSLOG_DYNNAME.mail.log
+exit_test
@@ -0,0 +1,42 @@
+#!/bin/bash
+# Test for global(script.profiling="on"): statements and function calls
+# must be reported via impstats and written to the dump file on HUP.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+global(script.profiling="on"
+       script.profiling.dumpFile="'$RSYSLOG_DYNNAME'.profile")
+module(load="../plugins/impstats/.libs/impstats"
+	log.file="'$RSYSLOG_DYNNAME'.stats" interval="1" ruleset="stats")
+
+ruleset(name="stats") {
+	stop # nothing to do here
+}
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if re_match($msg, "msgnum:[0-9]+") then {
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg 0 $NUMMESSAGES
+wait_queueempty
+./msleep 1500
+issue_HUP
+./msleep 1000
+shutdown_when_empty
+wait_shutdown
+seq_check
+content_check 'origin=rainerscript' $RSYSLOG_DYNNAME.stats
+content_check ':if.executions=1000' $RSYSLOG_DYNNAME.stats
+# labels must carry the config file the statement was defined in
+content_check --regex "${TESTCONF_NM}\.conf:[0-9][0-9]*:if\.executions=1000" $RSYSLOG_DYNNAME.stats
+content_check --regex "${TESTCONF_NM}\.conf:[0-9][0-9]*:re_match()\.executions=1000" $RSYSLOG_DYNNAME.stats
+content_check ':re_match().executions=1000' $RSYSLOG_DYNNAME.stats
+content_check '# ticks executions ticks/execution location' $RSYSLOG_DYNNAME.profile
+content_check ' 1000 ' $RSYSLOG_DYNNAME.profile
+content_check ':action(' $RSYSLOG_DYNNAME.profile
+exit_test
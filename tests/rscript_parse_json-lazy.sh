@@ -0,0 +1,28 @@
+#!/bin/bash
+# check parse_json() in lazy mode: only referenced members are needed,
+# skipped members must still be well-formed.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+module(load="../plugins/imtcp/.libs/imtcp")
+input(type="imtcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+template(name="outfmt" type="string" string="%$.ret% %$.ret2% %$!parsed!c1% %$!parsed!c3!x% %$!parsed!n%\n")
+
+local4.* {
+	set $.ret = parse_json("{ \"c1\":\"data\", \"c2\":{\"a\":[1,\"}]\"]}, \"c3\":{\"x\":\"y\"}, \"n\":42 }",
+			       "\$!parsed", "lazy");
+	set $.ret2 = parse_json("{ \"c1\":\"data\", \"c2\":[1,2 }", "\$!invalid", "lazy");
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+
+startup
+tcpflood -m1
+shutdown_when_empty
+wait_shutdown
+
+export EXPECTED='0 1 data y 42'
+cmp_exact $RSYSLOG_OUT_LOG
+
+exit_test
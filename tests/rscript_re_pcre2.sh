@@ -0,0 +1,23 @@
+#!/bin/bash
+# Test re_match() and re_extract() with global(regex.engine="pcre2").
+# "\d" is used on purpose: it is only understood by PCRE2, so the test
+# fails if the POSIX engine is used.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+generate_conf
+add_conf '
+global(regex.engine="pcre2")
+template(name="outfmt" type="string" string="%$.nbr%\n")
+
+if re_match($msg, "msgnum:\\d{8}:") then {
+	set $.nbr = re_extract($msg, "msgnum:0*(\\d+):", 0, 1, "none");
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg 0 $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
@@ -0,0 +1,14 @@
+#!/bin/bash
+# check the runtime timer wheel: expiry, cancel, cascade and the
+# wakeup of the timer thread
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+
+./timerwheel_test > $RSYSLOG_DYNNAME.output 2>&1
+if [ $? -ne 0 ]; then
+	cat $RSYSLOG_DYNNAME.output
+	echo "timer wheel checks failed"
+	error_exit 1
+fi
+
+exit_test
@@ -0,0 +1,173 @@
+/* checks the runtime timer wheel: expiry, cancel, cascade and wakeup
+ * computation. The wheel source is included directly, so that its internal
+ * state can be inspected and no full runtime needs to be initialized.
+ *
+ * Part of the testbench for rsyslog.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog project, released under ASL 2.0
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include "../runtime/timerwheel.c"
+
+/* minimal stand-ins for what the wheel uses from the runtime */
+int Debug = 0;
+pthread_attr_t default_thread_attr;
+
+void r_dbgprintf(const char __attribute__((unused)) * srcname, const char __attribute__((unused)) * fmt, ...) {}
+
+void LogError(const int iErrno, const int iErrCode, const char *fmt, ...) {
+    va_list ap;
+    fprintf(stderr, "LogError (errno %d, code %d): ", iErrno, iErrCode);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "\n");
+}
+
+rsRetVal timeoutComp(struct timespec *pt, long iTimeout) {
+    clock_gettime(CLOCK_REALTIME, pt);
+    pt->tv_sec += iTimeout / 1000;
+    pt->tv_nsec += (iTimeout % 1000) * 1000000;
+    if (pt->tv_nsec >= 1000000000) {
+        pt->tv_nsec -= 1000000000;
+        ++pt->tv_sec;
+    }
+    return RS_RET_OK;
+}
+
+
+/* permitted lateness of a callback; generous for loaded CI machines */
+#define SLACK_MS 300
+
+struct tstTimer {
+    timerwheel_timer_t timer;
+    const char *name;
+    long ms;
+    uint64_t armedAt;
+    uint64_t firedAt;
+    int nFired;
+    int nRearm;
+};
+
+static pthread_mutex_t mutFired = PTHREAD_MUTEX_INITIALIZER;
+static int seqFired = 0;
+static int nErrors = 0;
+
+static void tstCB(void *pUsr) {
+    struct tstTimer *const t = (struct tstTimer *)pUsr;
+
+    pthread_mutex_lock(&mutFired);
+    t->firedAt = timerwheelNowMs();
+    t->nFired = ++seqFired;
+    pthread_mutex_unlock(&mutFired);
+    if (t->nRearm > 0) {
+        --t->nRearm;
+        t->armedAt = timerwheelNowMs();
+        timerwheelArm(&t->timer, t->ms);
+    }
+}
+
+static void tstArm(struct tstTimer *const t, const char *const name, const long ms) {
+    memset(t, 0, sizeof(*t));
+    t->name = name;
+    t->ms = ms;
+    timerwheelTimerInit(&t->timer, tstCB, t);
+    t->armedAt = timerwheelNowMs();
+    if (timerwheelArm(&t->timer, ms) != RS_RET_OK) {
+        fprintf(stderr, "FAIL: %s: could not arm timer\n", name);
+        ++nErrors;
+    }
+}
+
+static void tstCheckFired(const struct tstTimer *const t) {
+    long late;
+
+    pthread_mutex_lock(&mutFired);
+    if (t->nFired == 0) {
+        fprintf(stderr, "FAIL: %s: did not fire\n", t->name);
+        ++nErrors;
+    } else {
+        late = (long)(t->firedAt - t->armedAt) - t->ms;
+        if (late < 0 || late > SLACK_MS) {
+            fprintf(stderr, "FAIL: %s: fired %ld ms off its %ld ms expiry\n", t->name, late, t->ms);
+            ++nErrors;
+        }
+    }
+    pthread_mutex_unlock(&mutFired);
+}
+
+int main(void) {
+    struct tstTimer tShort, tCascade, tLater, tCancel, tRearm;
+    uint64_t nextWake;
+
+    pthread_attr_init(&default_thread_attr);
+    if (timerwheelClassInit() != RS_RET_OK) {
+        fprintf(stderr, "FAIL: timerwheelClassInit\n");
+        return 1;
+    }
+
+    /* a lone timer on level 1 must determine the wakeup on its own, the
+     * thread must not wake up at every level 0 wrap.
+     */
+    tstArm(&tCascade, "cascade", 1500);
+    usleep(50000);
+    pthread_mutex_lock(&tw.mut);
+    nextWake = tw.nextWake;
+    pthread_mutex_unlock(&tw.mut);
+    if (nextWake != tCascade.timer.expires) {
+        fprintf(stderr, "FAIL: timer thread wakes at tick %llu, level 1 timer expires at %llu\n",
+                (unsigned long long)nextWake, (unsigned long long)tCascade.timer.expires);
+        ++nErrors;
+    }
+
+    /* a level 0 timer armed later, but due after the cascaded one */
+    usleep(900000);
+    tstArm(&tLater, "later", 600);
+    tstArm(&tShort, "short", 100);
+    tstArm(&tCancel, "cancel", 300);
+    tstArm(&tRearm, "rearm", 200);
+    tRearm.nRearm = 2;
+    usleep(50000);
+    if (timerwheelCancel(&tCancel.timer) != 1) {
+        fprintf(stderr, "FAIL: cancel: timer was not pending\n");
+        ++nErrors;
+    }
+    if (timerwheelCancel(&tCancel.timer) != 0) {
+        fprintf(stderr, "FAIL: cancel: timer still pending after cancel\n");
+        ++nErrors;
+    }
+
+    usleep(1500000);
+    tstCheckFired(&tShort);
+    tstCheckFired(&tCascade);
+    tstCheckFired(&tLater);
+    tstCheckFired(&tRearm);
+    if (tRearm.nRearm != 0) {
+        fprintf(stderr, "FAIL: rearm: %d re-arms left\n", tRearm.nRearm);
+        ++nErrors;
+    }
+    if (tCancel.nFired != 0) {
+        fprintf(stderr, "FAIL: cancel: cancelled timer fired\n");
+        ++nErrors;
+    }
+    if (tCascade.nFired > tLater.nFired) {
+        fprintf(stderr, "FAIL: cascade: level 1 timer fired after a later level 0 timer\n");
+        ++nErrors;
+    }
+    pthread_mutex_lock(&tw.mut);
+    if (tw.nPending != 0) {
+        fprintf(stderr, "FAIL: %d timers still pending\n", tw.nPending);
+        ++nErrors;
+    }
+    pthread_mutex_unlock(&tw.mut);
+
+    timerwheelClassExit();
+    if (nErrors == 0) printf("timer wheel checks OK\n");
+    return nErrors == 0 ? 0 : 1;
+}
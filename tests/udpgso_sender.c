@@ -0,0 +1,150 @@
+/* sends numbered test messages via UDP with generic segmentation offload
+ * (UDP_SEGMENT), so that several equally sized datagrams are passed to the
+ * kernel in a single send. A receiver with UDP_GRO enabled on the loopback
+ * interface gets them as one coalesced buffer.
+ *
+ * Command line options:
+ * -t target address (default 127.0.0.1)
+ * -p target port (required unless -c is given)
+ * -m number of messages (default 1000)
+ * -s number of messages (segments) per send (default 20)
+ * -c only check if UDP_SEGMENT is supported
+ *
+ * Each message is "<167>Mar  1 01:00:00 172.20.245.8 tag msgnum:NNNNNNNN:",
+ * with messages numbered from 0. Exits with 77 if UDP_SEGMENT is not
+ * supported, so that the test can be skipped.
+ *
+ * Part of the testbench for rsyslog.
+ *
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * This file is part of the rsyslog project, released under ASL 2.0
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#if defined(__linux__)
+    #include <netinet/udp.h>
+#endif
+
+#define MSG_FMT "<167>Mar  1 01:00:00 172.20.245.8 tag msgnum:%8.8d:"
+#define MSG_LEN 54 /* length of a formatted message, all are equally sized */
+#define MAX_SEGS 64
+
+#ifdef UDP_SEGMENT
+static int sendBurst(const int sock, const struct sockaddr_in *const addr, const int first, const int nSegs) {
+    char buf[MAX_SEGS * MSG_LEN + 1];
+    char ctl[CMSG_SPACE(sizeof(uint16_t))];
+    struct iovec iov;
+    struct msghdr mh;
+    struct cmsghdr *cmsg;
+    const uint16_t segSize = MSG_LEN;
+    int i;
+
+    for (i = 0; i < nSegs; ++i) {
+        snprintf(buf + i * MSG_LEN, MSG_LEN + 1, MSG_FMT, first + i);
+    }
+    iov.iov_base = buf;
+    iov.iov_len = (size_t)nSegs * MSG_LEN;
+    memset(&mh, 0, sizeof(mh));
+    memset(ctl, 0, sizeof(ctl));
+    mh.msg_name = (void *)addr;
+    mh.msg_namelen = sizeof(*addr);
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = ctl;
+    mh.msg_controllen = sizeof(ctl);
+    cmsg = CMSG_FIRSTHDR(&mh);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(segSize));
+    memcpy(CMSG_DATA(cmsg), &segSize, sizeof(segSize));
+
+    if (sendmsg(sock, &mh, 0) != (ssize_t)iov.iov_len) {
+        perror("udpgso_sender: sendmsg");
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+#ifdef UDP_SEGMENT
+    const char *target = "127.0.0.1";
+    int port = 0;
+    int nMsgs = 1000;
+    int nSegs = 20;
+    int bCheckOnly = 0;
+    int segSize = MSG_LEN;
+    struct sockaddr_in addr;
+    int sock;
+    int opt;
+    int i;
+
+    while ((opt = getopt(argc, argv, "t:p:m:s:c")) != -1) {
+        switch (opt) {
+            case 't':
+                target = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'm':
+                nMsgs = atoi(optarg);
+                break;
+            case 's':
+                nSegs = atoi(optarg);
+                break;
+            case 'c':
+                bCheckOnly = 1;
+                break;
+            default:
+                fprintf(stderr, "usage: udpgso_sender [-c] [-t target] -p port [-m messages] [-s segments]\n");
+                exit(1);
+        }
+    }
+    if (nSegs < 2 || nSegs > MAX_SEGS || (!bCheckOnly && port == 0)) {
+        fprintf(stderr, "udpgso_sender: invalid parameters\n");
+        exit(1);
+    }
+
+    if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) == -1) {
+        perror("udpgso_sender: socket");
+        exit(1);
+    }
+    if (setsockopt(sock, SOL_UDP, UDP_SEGMENT, &segSize, sizeof(segSize)) != 0) {
+        fprintf(stderr, "udpgso_sender: UDP_SEGMENT not supported: %s\n", strerror(errno));
+        exit(77);
+    }
+    if (bCheckOnly) exit(0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, target, &addr.sin_addr) != 1) {
+        fprintf(stderr, "udpgso_sender: invalid target address '%s'\n", target);
+        exit(1);
+    }
+
+    for (i = 0; i < nMsgs; i += nSegs) {
+        if (sendBurst(sock, &addr, i, (nMsgs - i < nSegs) ? nMsgs - i : nSegs) != 0) exit(1);
+        usleep(1000); /* UDP is lossy, give the receiver a chance to keep up */
+    }
+    close(sock);
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    fprintf(stderr, "udpgso_sender: UDP_SEGMENT not supported on this platform\n");
+    return 77;
+#endif
+}
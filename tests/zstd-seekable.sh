@@ -0,0 +1,48 @@
+#!/bin/bash
+# check that seekable zstd output (compression.zstd.frameSize) is a valid
+# zstd file split into multiple indexed frames, and that the frames can be
+# extracted via the index.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+generate_conf
+add_conf '
+module(load="builtin:omfile" compression.driver="zstd")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" {
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'.zst" template="outfmt"
+	       zipLevel="3" compression.zstd.frameSize="16k")
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+}
+'
+startup
+injectmsg
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+export SEQ_CHECK_FILE=$RSYSLOG_OUT_LOG.zst
+seq_check
+nframes=$(wc -l < $RSYSLOG_OUT_LOG.zst.zidx)
+if [ "$nframes" -lt 2 ]; then
+	echo "FAIL: expected multiple frames in index, got $nframes:"
+	cat $RSYSLOG_OUT_LOG.zst.zidx
+	error_exit 1
+fi
+# index entries must cover the file without gaps
+awk -v size=$(wc -c < $RSYSLOG_OUT_LOG.zst) '
+	$1 != next_offs { print "FAIL: frame at " $1 " expected at " next_offs; exit 1 }
+	{ next_offs = $1 + $2 }
+	END { if (next_offs != size) { print "FAIL: index ends at " next_offs ", file size " size; exit 1 } }
+	' $RSYSLOG_OUT_LOG.zst.zidx || error_exit 1
+if [ -x ../tools/rszstdextract ]; then
+	../tools/rszstdextract --from 0 $RSYSLOG_OUT_LOG.zst > $RSYSLOG_DYNNAME.extracted
+	export SEQ_CHECK_FILE=$RSYSLOG_DYNNAME.extracted
+	seq_check
+	../tools/rszstdextract --from "2099-01-01" $RSYSLOG_OUT_LOG.zst > $RSYSLOG_DYNNAME.extracted
+	if [ -s $RSYSLOG_DYNNAME.extracted ]; then
+		echo "FAIL: frames extracted for a time range without data"
+		error_exit 1
+	fi
+fi
+exit_test
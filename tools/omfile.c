@@ -70,6 +70,8 @@
 #include "cryprov.h"
 #include "parserif.h"
 #include "janitor.h"
+#include "dyncache.h"
+#include "filerotate.h"
 #include "rsconf.h"
 
 MODULE_TYPE_OUTPUT;
@@ -84,56 +86,25 @@ static rsRetVal resetConfigVariables(uchar __attribute__((unused)) * pp, void __
 DEF_OMOD_STATIC_DATA;
 DEFobjCurrIf(strm) DEFobjCurrIf(statsobj)
 
-/**
- * @brief Global counter/clock for file access timestamping.
- *
- * This counter is used as a "Lamport logical clock" for the LRU mechanism
- * of the dynamic file cache. It provides a monotonically increasing sequence
- * number to track the access order of files, rather than actual time.
- * It is highly unlikely to wrap within the lifetime of a process.
- */
-#ifdef HAVE_ATOMIC_BUILTINS64
-    static uint64 clockFileAccess = 0;
-#else
-    static unsigned clockFileAccess = 0;
-#endif
-
-/**
- * @brief Mutex for protecting clockFileAccess in non-atomic builtins environments.
- */
-#ifndef HAVE_ATOMIC_BUILTINS
-static pthread_mutex_t mutClock;
-#endif
-
-/**
- * @brief Retrieves and increments the global file access clock.
- *
- * This function provides a monotonically increasing counter used for the LRU
- * mechanism in the dynamic file cache. It is thread-safe.
- *
- * @return The incremented value of the file access clock.
- */
-static uint64 getClockFileAccess(void) {
-#ifdef HAVE_ATOMIC_BUILTINS64
-    return ATOMIC_INC_AND_FETCH_uint64(&clockFileAccess, &mutClock);
-#else
-    return ATOMIC_INC_AND_FETCH_unsigned(&clockFileAccess, &mutClock);
-#endif
-}
-
-
 /**
  * @brief Structure for a dynamic file name cache entry.
  *
  * This structure holds information about a dynamically opened file,
- * including its name, the associated stream, signature provider data,
- * and access timestamp for LRU management.
+ * including the associated stream and signature provider data. Its name
+ * and LRU position are kept by the dyncache.
+ *
+ * Workers hold a reference (cacheEntry.nRefs, changed with mutDynCache
+ * locked) to the entry they currently write to, and lock its mutex while
+ * writing. So different files are written concurrently, and referenced
+ * entries stay in the cache. If a referenced entry's file needs to be
+ * closed (HUP, close timeout), only pStrm is closed; it is reopened on
+ * the next write.
  */
 struct s_dynaFileCacheEntry {
-    uchar *pName; /**< name currently open, if dynamic name */
-    strm_t *pStrm; /**< our output stream */
+    dyncache_entry_t cacheEntry; /**< name and LRU linkage, must be first */
+    pthread_mutex_t mut; /**< serializes writes to this file */
+    strm_t *pStrm; /**< our output stream, NULL if closed */
     void *sigprovFileData; /**< opaque data ptr for provider use */
-    uint64 clkTickAccessed; /**< for LRU - based on clockFileAccess */
     short nInactive; /**< number of minutes not writen - for close timeout */
 };
 typedef struct s_dynaFileCacheEntry dynaFileCacheEntry;
@@ -152,7 +123,9 @@ typedef struct s_dynaFileCacheEntry dynaFileCacheEntry;
  * file output action.
  */
 typedef struct _instanceData {
-    pthread_mutex_t mutWrite; /**< guard against multiple instances writing to single file */
+    pthread_mutex_t mutWrite; /**< guard against multiple instances writing to single file (static
+                                   file, or dynafiles with signature provider) */
+    pthread_mutex_t mutDynCache; /**< guards the dynafile cache */
     uchar *fname; /**< file or template name (display only) */
     uchar *tplName; /**< name of assigned template */
     strm_t *pStrm; /**< our output stream */
@@ -163,6 +136,7 @@ typedef struct _instanceData {
     int fDirCreateMode; /**< creation mode for mkdir() */
     int bCreateDirs; /**< auto-create directories? */
     int bSyncFile; /**< should the file by sync()'ed? 1- yes, 0- no */
+    int bDirectIO; /**< write with O_DIRECT, bypassing the page cache? */
     uint8_t iNumTpls; /**< number of tpls we use */
     uid_t fileUID; /**< IDs for creation */
     uid_t dirUID;
@@ -180,18 +154,17 @@ typedef struct _instanceData {
     void *cryprovData; /**< opaque data ptr for provider use */
     cryprov_if_t cryprov; /**< ptr to crypto provider interface */
     sbool useCryprov; /**< quicker than checkig ptr (1 vs 8 bytes!) */
-    int iCurrElt; /**< currently active cache element (-1 = none) */
-    int iCurrCacheSize; /**< currently cache size (1-based) */
     int iDynaFileCacheSize; /**< size of file handle cache */
-    /**
-     * The cache is implemented as an array. An empty element is indicated
-     * by a NULL pointer. Memory is allocated as needed. The following
-     * pointer points to the overall structure.
-     */
-    dynaFileCacheEntry **dynCache;
+    dyncache_t *dynCache; /**< open files, indexed by name, in LRU order */
     off_t iSizeLimit; /**< file size limit, 0 = no limit */
     uchar *pszSizeLimitCmd; /**< command to carry out when size limit is reached */
+    int iRotateInterval; /**< rotate natively every this many seconds, 0 = no time based rotation */
+    fileRotateCompress_t rotateCompress; /**< compression of rotated files */
+    int iRotateKeep; /**< rotated files to keep, 0 = all */
+    sbool bRotateNative; /**< rotation.interval, .compress or .keep given: rotate natively */
     int iZipLevel; /**< zip mode to use for this selector */
+    int64 zstdFrameSize; /**< seekable zstd: uncompressed bytes per frame, 0 = no limit */
+    int zstdFrameInterval; /**< seekable zstd: seconds per frame, 0 = no limit */
     int iIOBufSize; /**< size of associated io buffer */
     int iFlushInterval; /**< how fast flush buffer on inactivity? */
     short iCloseTimeout; /**< after how many *minutes* shall the file be closed if inactive? */
@@ -202,6 +175,7 @@ typedef struct _instanceData {
     statsobj_t *stats; /**< dynafile, primarily cache stats */
     STATSCOUNTER_DEF(ctrRequests, mutCtrRequests);
     STATSCOUNTER_DEF(ctrLevel0, mutCtrLevel0);
+    STATSCOUNTER_DEF(ctrHit, mutCtrHit);
     STATSCOUNTER_DEF(ctrEvict, mutCtrEvict);
     STATSCOUNTER_DEF(ctrMiss, mutCtrMiss);
     STATSCOUNTER_DEF(ctrMax, mutCtrMax);
@@ -213,10 +187,11 @@ typedef struct _instanceData {
  * @brief Worker instance data for the omfile module.
  *
  * This structure holds a pointer to the main instance data for use
- * by worker threads.
+ * by worker threads, and the dynafile the worker wrote to last.
  */
 typedef struct wrkrInstanceData {
     instanceData *pData;
+    dynaFileCacheEntry *pCurrElt; /**< dynafile written last, referenced (NULL = none) */
 } wrkrInstanceData_t;
 
 /**
@@ -295,6 +270,8 @@ static struct cnfparamdescr actpdescr[] = {{"dynafilecachesize", eCmdHdlrInt, 0}
                                            {"flushinterval", eCmdHdlrInt, 0}, /* legacy: omfileflushinterval */
                                            {"asyncwriting", eCmdHdlrBinary, 0}, /* legacy: omfileasyncwriting */
                                            {"veryrobustzip", eCmdHdlrBinary, 0},
+                                           {"compression.zstd.framesize", eCmdHdlrSize, 0},
+                                           {"compression.zstd.frameinterval", eCmdHdlrNonNegInt, 0},
                                            {"flushontxend", eCmdHdlrBinary, 0}, /* legacy: omfileflushontxend */
                                            {"iobuffersize", eCmdHdlrSize, 0}, /* legacy: omfileiobuffersize */
                                            {"dirowner", eCmdHdlrUID, 0}, /* legacy: dirowner */
@@ -310,6 +287,7 @@ static struct cnfparamdescr actpdescr[] = {{"dynafilecachesize", eCmdHdlrInt, 0}
                                            {"failonchownfailure", eCmdHdlrBinary, 0}, /* legacy: failonchownfailure */
                                            {"createdirs", eCmdHdlrBinary, 0}, /* legacy: createdirs */
                                            {"sync", eCmdHdlrBinary, 0}, /* legacy: actionfileenablesync */
+                                           {"directio", eCmdHdlrBinary, 0},
                                            {"file", eCmdHdlrString, 0}, /* either "file" or ... */
                                            {"dynafile", eCmdHdlrString, 0}, /* "dynafile" MUST be present */
                                            {"sig.provider", eCmdHdlrGetWord, 0},
@@ -317,6 +295,9 @@ static struct cnfparamdescr actpdescr[] = {{"dynafilecachesize", eCmdHdlrInt, 0}
                                            {"closetimeout", eCmdHdlrPositiveInt, 0},
                                            {"rotation.sizelimit", eCmdHdlrSize, 0},
                                            {"rotation.sizelimitcommand", eCmdHdlrString, 0},
+                                           {"rotation.interval", eCmdHdlrNonNegInt, 0},
+                                           {"rotation.compress", eCmdHdlrGetWord, 0},
+                                           {"rotation.keep", eCmdHdlrNonNegInt, 0},
                                            {"template", eCmdHdlrGetWord, 0},
                                            {"addlf", eCmdHdlrBinary, 0}};
 static struct cnfparamblk actpblk = {CNFPARAMBLK_VERSION, sizeof(actpdescr) / sizeof(struct cnfparamdescr), actpdescr};
@@ -498,89 +479,84 @@ finalize_it:
 
 
 /**
- * @brief Deletes an entry from the dynamic file name cache.
+ * @brief Closes the file of a dynamic file cache entry.
  *
- * This function closes the associated file stream, frees memory for the
- * file name, and optionally frees the cache entry structure itself.
+ * The entry itself stays valid. If it is still in use, the file is
+ * reopened on the next write to it.
  *
- * @param pData Pointer to the instance data containing the dynamic file cache.
- * @param iEntry The index of the entry to be deleted in the cache array.
- * @param bFreeEntry If 1, the cache entry structure itself is free()ed;
- * if 0, only its contents are freed (e.g., if it's being
- * reused for a new entry).
- * @return RS_RET_OK on success.
+ * @param pData Pointer to the instance data owning the cache.
+ * @param pEntry The cache entry, locked or not in use.
  */
-static rsRetVal dynaFileDelCacheEntry(instanceData *__restrict__ const pData, const int iEntry, const int bFreeEntry) {
-    dynaFileCacheEntry **pCache = pData->dynCache;
-    DEFiRet;
-    assert(pCache != NULL);
-
-    if (pCache[iEntry] == NULL) FINALIZE;
-
-    DBGPRINTF("Removing entry %d for file '%s' from dynaCache.\n", iEntry,
-              pCache[iEntry]->pName == NULL ? UCHAR_CONSTANT("[OPEN FAILED]") : pCache[iEntry]->pName);
-
-    if (pCache[iEntry]->pName != NULL) {
-        free(pCache[iEntry]->pName);
-        pCache[iEntry]->pName = NULL;
-    }
-
-    if (pCache[iEntry]->pStrm != NULL) {
-        if (iEntry == pData->iCurrElt) {
-            pData->iCurrElt = -1;
-            pData->pStrm = NULL;
-        }
-        strm.Destruct(&pCache[iEntry]->pStrm);
-        if (pData->useSigprov) {
-            pData->sigprov.OnFileClose(pCache[iEntry]->sigprovFileData);
-            pCache[iEntry]->sigprovFileData = NULL;
-        }
+static void dynaFileCloseEntry(instanceData *__restrict__ const pData, dynaFileCacheEntry *__restrict__ const pEntry) {
+    if (pEntry->pStrm == NULL) return;
+    strm.Destruct(&pEntry->pStrm);
+    if (pData->useSigprov) {
+        pData->sigprov.OnFileClose(pEntry->sigprovFileData);
+        pEntry->sigprovFileData = NULL;
     }
+}
 
-    if (bFreeEntry) {
-        free(pCache[iEntry]);
-        pCache[iEntry] = NULL;
-    }
 
-finalize_it:
-    RETiRet;
+/**
+ * @brief Destructor for entries dropped from the dynamic file name cache.
+ *
+ * Called by the dyncache when an entry is evicted, timed out or the whole
+ * cache is cleared. It closes the associated file stream and frees the
+ * cache entry structure. Entries are only dropped while not in use.
+ *
+ * @param pCacheEntry The cache entry to be destructed.
+ * @param pUsr Pointer to the instance data owning the cache.
+ */
+static void dynaFileDestructCacheEntry(dyncache_entry_t *const pCacheEntry, void *const pUsr) {
+    instanceData *const pData = (instanceData *)pUsr;
+    dynaFileCacheEntry *const pEntry = (dynaFileCacheEntry *)pCacheEntry;
+
+    DBGPRINTF("Removing entry for file '%s' from dynaCache.\n", pCacheEntry->pName);
+    dynaFileCloseEntry(pData, pEntry);
+    pthread_mutex_destroy(&pEntry->mut);
+    free(pEntry);
 }
 
 
 /**
- * @brief Frees all dynamic file name cache entries and closes relevant files.
+ * @brief Closes all files of the dynamic file cache.
  *
- * This function is typically called during module shutdown or HUP processing
- * to release all resources held by the dynamic file cache.
+ * Entries not in use are dropped from the cache. Entries in use by a worker
+ * stay, but their files are closed. This is called for HUP processing, with
+ * mutDynCache locked.
  *
  * @param pData Pointer to the instance data containing the dynamic file cache.
  */
-static void dynaFileFreeCacheEntries(instanceData *__restrict__ const pData) {
-    register int i;
-    assert(pData != NULL);
-
-    for (i = 0; i < pData->iCurrCacheSize; ++i) {
-        dynaFileDelCacheEntry(pData, i, 1);
+static void dynaFileCloseAll(instanceData *__restrict__ const pData) {
+    dyncache_entry_t *pCacheEntry;
+    dyncache_entry_t *pNext;
+
+    for (pCacheEntry = pData->dynCache->pHead; pCacheEntry != NULL; pCacheEntry = pNext) {
+        dynaFileCacheEntry *const pEntry = (dynaFileCacheEntry *)pCacheEntry;
+        pNext = pCacheEntry->pNext;
+        if (pCacheEntry->nRefs == 0) {
+            dyncacheRemove(pData->dynCache, pCacheEntry);
+        } else {
+            pthread_mutex_lock(&pEntry->mut);
+            dynaFileCloseEntry(pData, pEntry);
+            pthread_mutex_unlock(&pEntry->mut);
+        }
     }
-    /* invalidate current element */
-    pData->iCurrElt = -1;
-    pData->pStrm = NULL;
 }
 
 
 /**
  * @brief Frees the dynamic file name cache structure.
  *
- * This function first frees all entries within the cache and then
- * deallocates the cache array itself.
+ * This closes all files and deallocates the cache. It is called when the
+ * action is destructed, so no worker holds an entry any longer.
  *
  * @param pData Pointer to the instance data containing the dynamic file cache.
  */
 static void dynaFileFreeCache(instanceData *__restrict__ const pData) {
     assert(pData != NULL);
 
-    dynaFileFreeCacheEntries(pData);
-    if (pData->dynCache != NULL) free(pData->dynCache);
+    dyncacheDestruct(&pData->dynCache);
 }
 
 
@@ -612,11 +588,14 @@ static rsRetVal closeFile(instanceData *__restrict__ const pData) {
  *
  * @param pData Pointer to the instance data containing the signature provider.
  * @param fn The name of the file to be processed.
+ * @param ppSigprovFileData Receives the provider's data for this file.
  * @return RS_RET_OK on success.
  */
-static rsRetVal sigprovPrepare(instanceData *__restrict__ const pData, uchar *__restrict__ const fn) {
+static rsRetVal sigprovPrepare(instanceData *__restrict__ const pData,
+                               uchar *__restrict__ const fn,
+                               void **const ppSigprovFileData) {
     DEFiRet;
-    pData->sigprov.OnFileOpen(pData->sigprovData, fn, &pData->sigprovFileData);
+    pData->sigprov.OnFileOpen(pData->sigprovData, fn, ppSigprovFileData);
     RETiRet;
 }
 
@@ -631,15 +610,21 @@ static rsRetVal sigprovPrepare(instanceData *__restrict__ const pData, uchar *__
  *
  * @param pData Pointer to the instance data for the file output action.
  * @param newFileName The name of the file to prepare access for.
+ * @param ppStrm Receives the stream, NULL on failure.
+ * @param ppSigprovFileData Receives the signature provider data for the file.
  * @return RS_RET_OK on success, or an error code if file creation,
  * directory creation, or stream construction fails.
  */
-static rsRetVal prepareFile(instanceData *__restrict__ const pData, const uchar *__restrict__ const newFileName) {
+static rsRetVal prepareFile(instanceData *__restrict__ const pData,
+                            const uchar *__restrict__ const newFileName,
+                            strm_t **const ppStrm,
+                            void **const ppSigprovFileData) {
     int fd;
     char errStr[1024]; /* buffer for strerr() */
+    strm_t *pStrm = NULL;
     DEFiRet;
 
-    pData->pStrm = NULL;
+    *ppStrm = NULL;
     if (access((char *)newFileName, F_OK) != 0) {
         /* file does not exist, create it (and eventually parent directories */
         if (pData->bCreateDirs) {
@@ -696,37 +681,46 @@ static rsRetVal prepareFile(instanceData *__restrict__ const pData, const uchar
     ustrncpy(szBaseName, (uchar *)basename((char *)szNameBuf), MAXFNAME);
     szBaseName[MAXFNAME] = '\0';
 
-    CHKiRet(strm.Construct(&pData->pStrm));
-    CHKiRet(strm.SetFName(pData->pStrm, szBaseName, ustrlen(szBaseName)));
-    CHKiRet(strm.SetDir(pData->pStrm, szDirName, ustrlen(szDirName)));
-    CHKiRet(strm.SetiZipLevel(pData->pStrm, pData->iZipLevel));
-    CHKiRet(strm.SetbVeryReliableZip(pData->pStrm, pData->bVeryRobustZip));
-    CHKiRet(strm.SetsIOBufSize(pData->pStrm, (size_t)pData->iIOBufSize));
-    CHKiRet(strm.SettOperationsMode(pData->pStrm, STREAMMODE_WRITE_APPEND));
-    CHKiRet(strm.SettOpenMode(pData->pStrm, cs.fCreateMode));
-    CHKiRet(strm.SetcompressionDriver(pData->pStrm, runModConf->compressionDriver));
-    CHKiRet(strm.SetCompressionWorkers(pData->pStrm, runModConf->compressionDriver_workers));
-    CHKiRet(strm.SetbSync(pData->pStrm, pData->bSyncFile));
-    CHKiRet(strm.SetsType(pData->pStrm, STREAMTYPE_FILE_SINGLE));
-    CHKiRet(strm.SetiSizeLimit(pData->pStrm, pData->iSizeLimit));
+    CHKiRet(strm.Construct(&pStrm));
+    CHKiRet(strm.SetFName(pStrm, szBaseName, ustrlen(szBaseName)));
+    CHKiRet(strm.SetDir(pStrm, szDirName, ustrlen(szDirName)));
+    CHKiRet(strm.SetiZipLevel(pStrm, pData->iZipLevel));
+    CHKiRet(strm.SetbVeryReliableZip(pStrm, pData->bVeryRobustZip));
+    CHKiRet(strm.SetsIOBufSize(pStrm, (size_t)pData->iIOBufSize));
+    CHKiRet(strm.SettOperationsMode(pStrm, STREAMMODE_WRITE_APPEND));
+    CHKiRet(strm.SettOpenMode(pStrm, cs.fCreateMode));
+    CHKiRet(strm.SetcompressionDriver(pStrm, runModConf->compressionDriver));
+    CHKiRet(strm.SetCompressionWorkers(pStrm, runModConf->compressionDriver_workers));
+    CHKiRet(strm.SetZstdFrameLimits(pStrm, pData->zstdFrameSize, pData->zstdFrameInterval));
+    CHKiRet(strm.SetbSync(pStrm, pData->bSyncFile));
+    CHKiRet(strm.SetbDirectIO(pStrm, pData->bDirectIO));
+    CHKiRet(strm.SetsType(pStrm, STREAMTYPE_FILE_SINGLE));
+    CHKiRet(strm.SetiSizeLimit(pStrm, pData->iSizeLimit));
+    /* native rotation renames the file, which the async writer, signature
+     * and crypto providers do not support
+     */
+    if (pData->bRotateNative && !pData->bUseAsyncWriter && !pData->useSigprov && !pData->useCryprov) {
+        CHKiRet(strm.SetRotation(pStrm, pData->iRotateInterval, pData->rotateCompress, pData->iRotateKeep));
+    }
     if (pData->useCryprov) {
-        CHKiRet(strm.Setcryprov(pData->pStrm, &pData->cryprov));
-        CHKiRet(strm.SetcryprovData(pData->pStrm, pData->cryprovData));
+        CHKiRet(strm.Setcryprov(pStrm, &pData->cryprov));
+        CHKiRet(strm.SetcryprovData(pStrm, pData->cryprovData));
     }
     /* set the flush interval only if we actually use it - otherwise it will activate
      * async processing, which is a real performance waste if we do not do buffered
      * writes! -- rgerhards, 2009-07-06
      */
-    if (pData->bUseAsyncWriter) CHKiRet(strm.SetiFlushInterval(pData->pStrm, pData->iFlushInterval));
-    if (pData->pszSizeLimitCmd != NULL) CHKiRet(strm.SetpszSizeLimitCmd(pData->pStrm, ustrdup(pData->pszSizeLimitCmd)));
-    CHKiRet(strm.ConstructFinalize(pData->pStrm));
+    if (pData->bUseAsyncWriter) CHKiRet(strm.SetiFlushInterval(pStrm, pData->iFlushInterval));
+    if (pData->pszSizeLimitCmd != NULL) CHKiRet(strm.SetpszSizeLimitCmd(pStrm, ustrdup(pData->pszSizeLimitCmd)));
+    CHKiRet(strm.ConstructFinalize(pStrm));
 
-    if (pData->useSigprov) sigprovPrepare(pData, szNameBuf);
+    if (pData->useSigprov) sigprovPrepare(pData, szNameBuf, ppSigprovFileData);
+    *ppStrm = pStrm;
 
 finalize_it:
     if (iRet != RS_RET_OK) {
-        if (pData->pStrm != NULL) {
-            closeFile(pData);
+        if (pStrm != NULL) {
+            strm.Destruct(&pStrm);
         }
     }
     RETiRet;
@@ -734,136 +728,142 @@ finalize_it:
 
 
 /**
- * @brief Handles dynamic file names, ensuring the correct file is open for writing.
+ * @brief Opens a dynamic file.
+ *
+ * @param pData Pointer to the instance data for the file output action.
+ * @param fileName The dynamic file name to open.
+ * @param pEntry The cache entry receiving the stream.
+ * @return RS_RET_OK on success, or the error of prepareFile(), which is
+ * also reported.
+ */
+static rsRetVal ATTR_NONNULL() dynaFileOpen(instanceData *__restrict__ const pData,
+                                            const uchar *__restrict__ const fileName,
+                                            dynaFileCacheEntry *__restrict__ const pEntry) {
+    DEFiRet;
+
+    iRet = prepareFile(pData, fileName, &pEntry->pStrm, &pEntry->sigprovFileData);
+    if (iRet != RS_RET_OK) {
+        /* We do no longer care about internal messages. The errmsg rate limiter
+         * will take care of too-frequent error messages.
+         */
+        parser_errmsg(
+            "Could not open dynamic file '%s' [state %d] - discarding "
+            "message",
+            fileName, iRet);
+    }
+    RETiRet;
+}
+
+
+/**
+ * @brief Gets a reference to the dynamic file cache entry for a file name.
  *
- * This function checks if the requested dynamic file name is already present
- * in the cache. If so, it reuses the existing file handle. If not, it attempts
- * to open the new file, potentially evicting an older entry from the LRU cache
- * if the cache is full.
+ * If the file is not cached yet, it is opened and added to the cache,
+ * potentially evicting the least recently used entry that no worker holds.
+ * The reference must be dropped via dynaFilePut().
  *
  * @param pData Pointer to the instance data for the file output action.
- * @param newFileName The new dynamic file name to prepare.
+ * @param newFileName The dynamic file name to prepare.
+ * @param ppEntry Receives the cache entry.
  * @return RS_RET_OK on success, or an error code if the file cannot be opened
  * or memory allocation fails.
  */
-static rsRetVal ATTR_NONNULL()
-    prepareDynFile(instanceData *__restrict__ const pData, const uchar *__restrict__ const newFileName) {
-    uint64 ctOldest; /* "timestamp" of oldest element */
-    int iOldest;
-    int i;
-    int iFirstFree;
-    rsRetVal localRet;
-    dynaFileCacheEntry **pCache;
+static rsRetVal ATTR_NONNULL() dynaFileGet(instanceData *__restrict__ const pData,
+                                           const uchar *__restrict__ const newFileName,
+                                           dynaFileCacheEntry **const ppEntry) {
+    dynaFileCacheEntry *pEntry;
     DEFiRet;
 
-    assert(pData != NULL);
-    assert(newFileName != NULL);
+    pthread_mutex_lock(&pData->mutDynCache);
+    pEntry = (dynaFileCacheEntry *)dyncacheFind(pData->dynCache, newFileName);
+    if (pEntry != NULL) {
+        /* we found our element! */
+        STATSCOUNTER_INC(pData->ctrHit, pData->mutCtrHit);
+    } else {
+        STATSCOUNTER_INC(pData->ctrMiss, pData->mutCtrMiss);
 
-    pCache = pData->dynCache;
+        /* make room before opening, so that we never have more files open than the cache size */
+        if (dyncacheEvict(pData->dynCache)) {
+            STATSCOUNTER_INC(pData->ctrEvict, pData->mutCtrEvict);
+        }
 
-    /* first check, if we still have the current file */
-    if ((pData->iCurrElt != -1) && !ustrcmp(newFileName, pCache[pData->iCurrElt]->pName)) {
-        /* great, we are all set */
-        pCache[pData->iCurrElt]->clkTickAccessed = getClockFileAccess();
-        STATSCOUNTER_INC(pData->ctrLevel0, pData->mutCtrLevel0);
-        /* LRU needs only a strictly monotonically increasing counter, so such a one could do */
-        FINALIZE;
+        /* the entry is only added to the cache after the open was successful */
+        CHKmalloc(pEntry = (dynaFileCacheEntry *)calloc(1, sizeof(dynaFileCacheEntry)));
+        pthread_mutex_init(&pEntry->mut, NULL);
+        if ((iRet = dynaFileOpen(pData, newFileName, pEntry)) == RS_RET_OK) {
+            iRet = dyncacheInsert(pData->dynCache, &pEntry->cacheEntry, newFileName);
+        }
+        if (iRet != RS_RET_OK) {
+            dynaFileCloseEntry(pData, pEntry);
+            pthread_mutex_destroy(&pEntry->mut);
+            free(pEntry);
+            FINALIZE;
+        }
+        STATSCOUNTER_SETMAX_NOMUT(pData->ctrMax, (unsigned)pData->dynCache->nEntries);
+        DBGPRINTF("Added new entry for file cache, file '%s'.\n", newFileName);
     }
+    ++pEntry->cacheEntry.nRefs;
+    *ppEntry = pEntry;
 
-    /* ok, no luck - current file cannot be re-used */
-
-    /* if we need to flush (at least) on TXEnd, we need to flush now - because
-     * we do not know if we will otherwise come back to this file to flush it
-     * at end of TX. see https://github.com/rsyslog/rsyslog/issues/2502
-     */
-    if (((runModConf->pConf->globals.glblDevOptions & DEV_OPTION_8_1905_HANG_TEST) == 0) && pData->bFlushOnTXEnd &&
-        pData->pStrm != NULL) {
-        CHKiRet(strm.Flush(pData->pStrm));
-    }
+finalize_it:
+    pthread_mutex_unlock(&pData->mutDynCache);
+    RETiRet;
+}
 
-    /* Now let's search the table if we find a matching spot.
-     * While doing so, we also prepare for creation of a new one.
-     */
-    pData->iCurrElt = -1; /* invalid current element pointer */
-    iFirstFree = -1; /* not yet found */
-    iOldest = 0; /* we assume the first element to be the oldest - that will change as we loop */
-    ctOldest = getClockFileAccess(); /* there must always be an older one */
-    for (i = 0; i < pData->iCurrCacheSize; ++i) {
-        if (pCache[i] == NULL || pCache[i]->pName == NULL) {
-            if (iFirstFree == -1) iFirstFree = i;
-        } else { /* got an element, let's see if it matches */
-            if (!ustrcmp(newFileName, pCache[i]->pName)) {
-                /* we found our element! */
-                pData->pStrm = pCache[i]->pStrm;
-                if (pData->useSigprov) pData->sigprovFileData = pCache[i]->sigprovFileData;
-                pData->iCurrElt = i;
-                pCache[i]->clkTickAccessed = getClockFileAccess(); /* update "timestamp" for LRU */
-                FINALIZE;
-            }
-            /* did not find it - so lets keep track of the counters for LRU */
-            if (pCache[i]->clkTickAccessed < ctOldest) {
-                ctOldest = pCache[i]->clkTickAccessed;
-                iOldest = i;
-            }
-        }
-    }
 
-    /* we have not found an entry */
-    STATSCOUNTER_INC(pData->ctrMiss, pData->mutCtrMiss);
+/**
+ * @brief Drops a reference obtained via dynaFileGet().
+ *
+ * @param pData Pointer to the instance data owning the cache.
+ * @param pEntry The cache entry, which must not be locked by the caller.
+ */
+static void ATTR_NONNULL() dynaFilePut(instanceData *__restrict__ const pData,
+                                       dynaFileCacheEntry *__restrict__ const pEntry) {
+    pthread_mutex_lock(&pData->mutDynCache);
+    --pEntry->cacheEntry.nRefs;
+    pthread_mutex_unlock(&pData->mutDynCache);
+}
 
-    /* similarly, we need to set the current pStrm to NULL, because otherwise, if prepareFile() fails,
-     * we may end up using an old stream. This bug depends on how exactly prepareFile fails,
-     * but it could be triggered in the common case of a failed open() system call.
-     * rgerhards, 2010-03-22
-     */
-    pData->pStrm = NULL, pData->sigprovFileData = NULL;
 
-    if (iFirstFree == -1 && (pData->iCurrCacheSize < pData->iDynaFileCacheSize)) {
-        /* there is space left, so set it to that index */
-        iFirstFree = pData->iCurrCacheSize++;
-        STATSCOUNTER_SETMAX_NOMUT(pData->ctrMax, (unsigned)pData->iCurrCacheSize);
-    }
+/**
+ * @brief Locks a referenced dynamic file cache entry for writing.
+ *
+ * If the file was closed in the meantime (HUP, close timeout), it is
+ * reopened. On failure, the entry is not locked.
+ *
+ * @param pData Pointer to the instance data owning the cache.
+ * @param pEntry The referenced cache entry.
+ * @return RS_RET_OK on success, or the error of reopening the file.
+ */
+static rsRetVal ATTR_NONNULL() dynaFileLock(instanceData *__restrict__ const pData,
+                                            dynaFileCacheEntry *__restrict__ const pEntry) {
+    DEFiRet;
 
-    /* Note that the following code sequence does not work with the cache entry itself,
-     * but rather with pData->pStrm, the (sole) stream pointer in the non-dynafile case.
-     * The cache array is only updated after the open was successful. -- rgerhards, 2010-03-21
-     */
-    if (iFirstFree == -1) {
-        dynaFileDelCacheEntry(pData, iOldest, 0);
-        STATSCOUNTER_INC(pData->ctrEvict, pData->mutCtrEvict);
-        iFirstFree = iOldest; /* this one *is* now free ;) */
-    } else {
-        /* we need to allocate memory for the cache structure */
-        CHKmalloc(pCache[iFirstFree] = (dynaFileCacheEntry *)calloc(1, sizeof(dynaFileCacheEntry)));
+    pthread_mutex_lock(&pEntry->mut);
+    if (pEntry->pStrm == NULL) {
+        iRet = dynaFileOpen(pData, pEntry->cacheEntry.pName, pEntry);
+        if (iRet != RS_RET_OK) {
+            pthread_mutex_unlock(&pEntry->mut);
+        }
     }
+    RETiRet;
+}
 
-    /* Ok, we finally can open the file */
-    localRet = prepareFile(pData, newFileName); /* ignore exact error, we check fd below */
 
-    /* check if we had an error */
-    if (localRet != RS_RET_OK) {
-        /* We do no longer care about internal messages. The errmsg rate limiter
-         * will take care of too-frequent error messages.
-         */
-        parser_errmsg(
-            "Could not open dynamic file '%s' [state %d] - discarding "
-            "message",
-            newFileName, localRet);
-        ABORT_FINALIZE(localRet);
-    }
+/**
+ * @brief Unlocks a dynamic file cache entry locked via dynaFileLock().
+ *
+ * @param pEntry The locked cache entry.
+ * @param bFlush Shall the file be flushed before it is unlocked?
+ * @return RS_RET_OK on success, or the error of the flush.
+ */
+static rsRetVal ATTR_NONNULL() dynaFileUnlock(dynaFileCacheEntry *__restrict__ const pEntry, const int bFlush) {
+    DEFiRet;
 
-    if ((pCache[iFirstFree]->pName = ustrdup(newFileName)) == NULL) {
-        closeFile(pData); /* need to free failed entry! */
-        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    if (bFlush && pEntry->pStrm != NULL) {
+        iRet = strm.Flush(pEntry->pStrm);
     }
-    pCache[iFirstFree]->pStrm = pData->pStrm;
-    if (pData->useSigprov) pCache[iFirstFree]->sigprovFileData = pData->sigprovFileData;
-    pCache[iFirstFree]->clkTickAccessed = getClockFileAccess();
-    pData->iCurrElt = iFirstFree;
-    DBGPRINTF("Added new entry %d for file cache, file '%s'.\n", iFirstFree, newFileName);
-
-finalize_it:
-    if (iRet == RS_RET_OK) pCache[pData->iCurrElt]->nInactive = 0;
+    pthread_mutex_unlock(&pEntry->mut);
     RETiRet;
 }
 
@@ -872,15 +872,21 @@ finalize_it:
  * @brief Performs the actual buffered write operation to the file stream.
  *
  * This function writes the provided buffer to the stream associated with
- * the instance data. It also calls the signature provider's `OnRecordWrite`
+ * the file. It also calls the signature provider's `OnRecordWrite`
  * method if a signature provider is in use.
  *
- * @param pData Pointer to the instance data containing the stream and provider info.
+ * @param pData Pointer to the instance data containing the provider info.
+ * @param pStrm The stream to write to, may be NULL if the file is not open.
+ * @param sigprovFileData The signature provider's data for the file.
  * @param pszBuf Pointer to the buffer containing the data to write.
  * @param lenBuf The length of the data in the buffer.
  * @return RS_RET_OK on success, or an error code from the stream write operation.
  */
-static rsRetVal doWrite(instanceData *__restrict__ const pData, uchar *__restrict__ const pszBuf, const int lenBuf) {
+static rsRetVal doWrite(instanceData *__restrict__ const pData,
+                        strm_t *__restrict__ const pStrm,
+                        void *const sigprovFileData,
+                        uchar *__restrict__ const pszBuf,
+                        const int lenBuf) {
     DEFiRet;
     assert(pData != NULL);
     assert(pszBuf != NULL);
@@ -893,14 +899,14 @@ static rsRetVal doWrite(instanceData *__restrict__ const pData, uchar *__restric
     rs_size_t sigWriteLen = (rs_size_t)lenBuf;
     int freeSigBuf = 0;
 
-    DBGPRINTF("omfile: write to stream, pData->pStrm %p, lenBuf %d, needsLF %d, strt data %.128s\n", pData->pStrm,
-              lenBuf, needsLF, pszBuf);
-    if (pData->pStrm != NULL) {
+    DBGPRINTF("omfile: write to stream, pStrm %p, lenBuf %d, needsLF %d, strt data %.128s\n", pStrm, lenBuf,
+              needsLF, pszBuf);
+    if (pStrm != NULL) {
         if (lenBuf > 0) {
-            CHKiRet(strm.Write(pData->pStrm, pszBuf, lenBuf));
+            CHKiRet(strm.Write(pStrm, pszBuf, lenBuf));
         }
         if (needsLF) {
-            CHKiRet(strm.WriteChar(pData->pStrm, '\n'));
+            CHKiRet(strm.WriteChar(pStrm, '\n'));
         }
     }
 
@@ -923,7 +929,7 @@ static rsRetVal doWrite(instanceData *__restrict__ const pData, uchar *__restric
             sigWriteBuf = sigBuf;
             sigWriteLen = (rs_size_t)sigLen;
         }
-        CHKiRet(pData->sigprov.OnRecordWrite(pData->sigprovFileData, sigWriteBuf, sigWriteLen));
+        CHKiRet(pData->sigprov.OnRecordWrite(sigprovFileData, sigWriteBuf, sigWriteLen));
     }
 
 finalize_it:
@@ -935,11 +941,10 @@ finalize_it:
 
 
 /**
- * @brief Writes a message to the configured file.
+ * @brief Writes a message to the configured static file.
  *
- * This function determines whether the output is to a static file or a
- * dynamic file. If dynamic, it calls `prepareDynFile` to ensure the correct
- * file is open. It then calls `doWrite` to perform the actual write operation.
+ * This function opens the file if needed, then calls `doWrite` to perform
+ * the actual write operation. Must be called with mutWrite locked.
  *
  * @param pData Pointer to the instance data for the file output action.
  * @param pParam Pointer to the action worker instance parameters.
@@ -953,23 +958,15 @@ static rsRetVal writeFile(instanceData *__restrict__ const pData,
     DEFiRet;
 
     STATSCOUNTER_INC(pData->ctrRequests, pData->mutCtrRequests);
-    /* first check if we have a dynamic file name and, if so,
-     * check if it still is ok or a new file needs to be created
-     */
-    if (pData->bDynamicName) {
-        DBGPRINTF("omfile: file to log to: %s\n", actParam(pParam, pData->iNumTpls, iMsg, 1).param);
-        CHKiRet(prepareDynFile(pData, actParam(pParam, pData->iNumTpls, iMsg, 1).param));
-    } else { /* "regular", non-dynafile */
+    if (pData->pStrm == NULL) {
+        CHKiRet(prepareFile(pData, pData->fname, &pData->pStrm, &pData->sigprovFileData));
         if (pData->pStrm == NULL) {
-            CHKiRet(prepareFile(pData, pData->fname));
-            if (pData->pStrm == NULL) {
-                parser_errmsg("Could not open output file '%s'", pData->fname);
-            }
+            parser_errmsg("Could not open output file '%s'", pData->fname);
         }
-        pData->nInactive = 0;
     }
+    pData->nInactive = 0;
 
-    iRet = doWrite(pData, actParam(pParam, pData->iNumTpls, iMsg, 0).param,
+    iRet = doWrite(pData, pData->pStrm, pData->sigprovFileData, actParam(pParam, pData->iNumTpls, iMsg, 0).param,
                    actParam(pParam, pData->iNumTpls, iMsg, 0).lenStr);
 
 finalize_it:
@@ -977,6 +974,78 @@ finalize_it:
 }
 
 
+/**
+ * @brief Writes a batch of messages to their dynamic files.
+ *
+ * Only the cache lookups are serialized across the action's workers. The
+ * writes lock the file written to, so workers writing to different files
+ * do not block each other, while writes to one file stay in order. The
+ * file written last is kept referenced by the worker, so a following
+ * batch for the same file needs no cache lookup ("level0").
+ *
+ * If the file cannot be opened, the message is discarded.
+ *
+ * @param pWrkrData Pointer to the worker instance data.
+ * @param pParams Pointer to the action worker instance parameters.
+ * @param nParams The number of messages in the batch.
+ * @return RS_RET_OK on success, or an error code if flushing fails.
+ */
+static rsRetVal writeDynaFiles(wrkrInstanceData_t *__restrict__ const pWrkrData,
+                               const actWrkrIParams_t *__restrict__ const pParams,
+                               const unsigned nParams) {
+    instanceData *__restrict__ const pData = pWrkrData->pData;
+    dynaFileCacheEntry *pEntry = pWrkrData->pCurrElt;
+    int bLocked = 0;
+    unsigned i;
+    DEFiRet;
+
+    /* if we need to flush (at least) on TXEnd, we need to flush when switching files - because
+     * we do not know if we will otherwise come back to this file to flush it
+     * at end of TX. see https://github.com/rsyslog/rsyslog/issues/2502
+     */
+    const int bFlushOnSwitch =
+        pData->bFlushOnTXEnd && (runModConf->pConf->globals.glblDevOptions & DEV_OPTION_8_1905_HANG_TEST) == 0;
+
+    for (i = 0; i < nParams; ++i) {
+        const uchar *const fileName = actParam(pParams, pData->iNumTpls, i, 1).param;
+        STATSCOUNTER_INC(pData->ctrRequests, pData->mutCtrRequests);
+        DBGPRINTF("omfile: file to log to: %s\n", fileName);
+        if (pEntry != NULL && !ustrcmp(fileName, pEntry->cacheEntry.pName)) {
+            /* great, we are all set */
+            STATSCOUNTER_INC(pData->ctrLevel0, pData->mutCtrLevel0);
+        } else {
+            if (pEntry != NULL) {
+                if (bLocked) {
+                    dynaFileUnlock(pEntry, bFlushOnSwitch);
+                    bLocked = 0;
+                }
+                dynaFilePut(pData, pEntry);
+                pEntry = NULL;
+            }
+            if (dynaFileGet(pData, fileName, &pEntry) != RS_RET_OK) {
+                continue;
+            }
+        }
+        if (!bLocked) {
+            if (dynaFileLock(pData, pEntry) != RS_RET_OK) {
+                continue;
+            }
+            bLocked = 1;
+        }
+        pEntry->nInactive = 0;
+        doWrite(pData, pEntry->pStrm, pEntry->sigprovFileData, actParam(pParams, pData->iNumTpls, i, 0).param,
+                actParam(pParams, pData->iNumTpls, i, 0).lenStr);
+    }
+
+    /* see commitTransaction for the flush */
+    if (bLocked) {
+        iRet = dynaFileUnlock(pEntry, pData->bFlushOnTXEnd);
+    }
+    pWrkrData->pCurrElt = pEntry;
+    RETiRet;
+}
+
+
 BEGINbeginCnfLoad
     CODESTARTbeginCnfLoad;
     loadModConf = pModConf;
@@ -1080,20 +1149,35 @@ ENDsetModCnf
  * @param pData Pointer to the instance data containing the dynamic file cache.
  */
 static void janitorChkDynaFiles(instanceData *__restrict__ const pData) {
-    int i;
-    dynaFileCacheEntry **pCache = pData->dynCache;
-
-    for (i = 0; i < pData->iCurrCacheSize; ++i) {
-        if (pCache[i] == NULL) continue;
-        DBGPRINTF("omfile janitor: checking dynafile %d:%s, inactive since %d\n", i,
-                  pCache[i]->pName == NULL ? UCHAR_CONSTANT("[OPEN FAILED]") : pCache[i]->pName,
-                  (int)pCache[i]->nInactive);
-        if (pCache[i]->nInactive >= pData->iCloseTimeout) {
-            STATSCOUNTER_INC(pData->ctrCloseTimeouts, pData->mutCtrCloseTimeouts);
-            dynaFileDelCacheEntry(pData, i, 1);
-            if (pData->iCurrElt == i) pData->iCurrElt = -1; /* no longer available! */
+    dyncache_entry_t *pCacheEntry;
+    dyncache_entry_t *pNext;
+
+    for (pCacheEntry = pData->dynCache->pHead; pCacheEntry != NULL; pCacheEntry = pNext) {
+        dynaFileCacheEntry *const pEntry = (dynaFileCacheEntry *)pCacheEntry;
+        pNext = pCacheEntry->pNext;
+        DBGPRINTF("omfile janitor: checking dynafile %s, inactive since %d, in use %d\n", pCacheEntry->pName,
+                  (int)pEntry->nInactive, pCacheEntry->nRefs);
+        if (pCacheEntry->nRefs == 0) {
+            if (pEntry->pStrm == NULL) {
+                dyncacheRemove(pData->dynCache, pCacheEntry); /* closed while in use */
+            } else if (pEntry->nInactive >= pData->iCloseTimeout) {
+                STATSCOUNTER_INC(pData->ctrCloseTimeouts, pData->mutCtrCloseTimeouts);
+                dyncacheRemove(pData->dynCache, pCacheEntry);
+            } else {
+                pEntry->nInactive += runModConf->pConf->globals.janitorInterval;
+            }
         } else {
-            pCache[i]->nInactive += runModConf->pConf->globals.janitorInterval;
+            /* held by a worker, maybe an idle one: the entry stays, but the file is closed */
+            pthread_mutex_lock(&pEntry->mut);
+            if (pEntry->pStrm != NULL) {
+                if (pEntry->nInactive >= pData->iCloseTimeout) {
+                    STATSCOUNTER_INC(pData->ctrCloseTimeouts, pData->mutCtrCloseTimeouts);
+                    dynaFileCloseEntry(pData, pEntry);
+                } else {
+                    pEntry->nInactive += runModConf->pConf->globals.janitorInterval;
+                }
+            }
+            pthread_mutex_unlock(&pEntry->mut);
         }
     }
 }
@@ -1111,7 +1195,9 @@ static void janitorCB(void *pUsr) {
     instanceData *__restrict__ const pData = (instanceData *)pUsr;
     pthread_mutex_lock(&pData->mutWrite);
     if (pData->bDynamicName) {
+        pthread_mutex_lock(&pData->mutDynCache);
         janitorChkDynaFiles(pData);
+        pthread_mutex_unlock(&pData->mutDynCache);
     } else {
         if (pData->pStrm != NULL) {
             DBGPRINTF("omfile janitor: checking file %s, inactive since %d\n", pData->fname, pData->nInactive);
@@ -1155,6 +1241,7 @@ BEGINcreateInstance
     pData->pStrm = NULL;
     pData->bAddLF = 1;
     pthread_mutex_init(&pData->mutWrite, NULL);
+    pthread_mutex_init(&pData->mutDynCache, NULL);
 ENDcreateInstance
 
 
@@ -1185,12 +1272,16 @@ BEGINfreeInstance
         free(pData->cryprovName);
         free(pData->cryprovNameFull);
     }
+    pthread_mutex_destroy(&pData->mutDynCache);
     pthread_mutex_destroy(&pData->mutWrite);
 ENDfreeInstance
 
 
 BEGINfreeWrkrInstance
     CODESTARTfreeWrkrInstance;
+    if (pWrkrData->pCurrElt != NULL) {
+        dynaFilePut(pWrkrData->pData, pWrkrData->pCurrElt);
+    }
 ENDfreeWrkrInstance
 
 
@@ -1213,12 +1304,6 @@ BEGINcommitTransaction
         goto terminate;
     }
 
-    pthread_mutex_lock(&pData->mutWrite);
-
-    for (i = 0; i < nParams; ++i) {
-        writeFile(pData, pParams, i);
-    }
-    /* Note: pStrm may be NULL if there was an error opening the stream */
     /* if bFlushOnTXEnd is set, we need to flush on transaction end - in
      * any case. It is not relevant if this is using background writes
      * (which then become pretty slow) or not. And, similarly, no flush
@@ -1227,12 +1312,26 @@ BEGINcommitTransaction
      * for a discussion of why we actually need this.
      * rgerhards, 2017-01-13
      */
-    if (pData->bFlushOnTXEnd && pData->pStrm != NULL) {
-        CHKiRet(strm.Flush(pData->pStrm));
+    if (pData->bDynamicName && !pData->useSigprov) {
+        /* locks per file, so workers write to different files concurrently */
+        iRet = writeDynaFiles(pWrkrData, pParams, nParams);
+    } else if (pData->bDynamicName) {
+        /* signature providers are not known to be thread-safe */
+        pthread_mutex_lock(&pData->mutWrite);
+        iRet = writeDynaFiles(pWrkrData, pParams, nParams);
+        pthread_mutex_unlock(&pData->mutWrite);
+    } else {
+        pthread_mutex_lock(&pData->mutWrite);
+        for (i = 0; i < nParams; ++i) {
+            writeFile(pData, pParams, i);
+        }
+        /* Note: pStrm may be NULL if there was an error opening the stream */
+        if (pData->bFlushOnTXEnd && pData->pStrm != NULL) {
+            iRet = strm.Flush(pData->pStrm);
+        }
+        pthread_mutex_unlock(&pData->mutWrite);
     }
 
-finalize_it:
-    pthread_mutex_unlock(&pData->mutWrite);
     if (iRet == RS_RET_FILE_OPEN_ERROR || iRet == RS_RET_FILE_NOT_FOUND) {
         iRet = (pData->bDynamicName && runModConf->bDynafileDoNotSuspend) ? RS_RET_OK : RS_RET_SUSPENDED;
     }
@@ -1262,8 +1361,11 @@ static void setInstParamDefaults(instanceData *__restrict__ const pData) {
     pData->fDirCreateMode = loadModConf->fDirCreateMode;
     pData->bCreateDirs = 1;
     pData->bSyncFile = 0;
+    pData->bDirectIO = 0;
     pData->iZipLevel = 0;
     pData->bVeryRobustZip = 0;
+    pData->zstdFrameSize = 0;
+    pData->zstdFrameInterval = 0;
     pData->bFlushOnTXEnd = FLUSHONTX_DFLT;
     pData->iIOBufSize = IOBUF_DFLT_SIZE;
     pData->iFlushInterval = FLUSH_INTRVL_DFLT;
@@ -1277,6 +1379,10 @@ static void setInstParamDefaults(instanceData *__restrict__ const pData) {
     pData->iSizeLimit = 0;
     pData->isDevNull = 0;
     pData->pszSizeLimitCmd = NULL;
+    pData->iRotateInterval = 0;
+    pData->rotateCompress = FILEROTATE_COMPRESS_NONE;
+    pData->iRotateKeep = 0;
+    pData->bRotateNative = 0;
 }
 
 /**
@@ -1309,6 +1415,9 @@ static rsRetVal setupInstStatsCtrs(instanceData *__restrict__ const pData) {
     STATSCOUNTER_INIT(pData->ctrLevel0, pData->mutCtrLevel0);
     CHKiRet(statsobj.AddCounter(pData->stats, UCHAR_CONSTANT("level0"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
                                 &(pData->ctrLevel0)));
+    STATSCOUNTER_INIT(pData->ctrHit, pData->mutCtrHit);
+    CHKiRet(statsobj.AddCounter(pData->stats, UCHAR_CONSTANT("hits"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &(pData->ctrHit)));
     STATSCOUNTER_INIT(pData->ctrMiss, pData->mutCtrMiss);
     CHKiRet(statsobj.AddCounter(pData->stats, UCHAR_CONSTANT("missed"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
                                 &(pData->ctrMiss)));
@@ -1464,6 +1573,10 @@ BEGINnewActInst
             pData->iFlushInterval = pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "veryrobustzip")) {
             pData->bVeryRobustZip = pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "compression.zstd.framesize")) {
+            pData->zstdFrameSize = pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "compression.zstd.frameinterval")) {
+            pData->zstdFrameInterval = (int)pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "asyncwriting")) {
             pData->bUseAsyncWriter = pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "flushontxend")) {
@@ -1494,6 +1607,8 @@ BEGINnewActInst
             pData->bFailOnChown = (int)pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "sync")) {
             pData->bSyncFile = (int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "directio")) {
+            pData->bDirectIO = (int)pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "createdirs")) {
             pData->bCreateDirs = (int)pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "addlf")) {
@@ -1521,6 +1636,24 @@ BEGINnewActInst
             pData->iSizeLimit = (int)pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "rotation.sizelimitcommand")) {
             pData->pszSizeLimitCmd = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL);
+        } else if (!strcmp(actpblk.descr[i].name, "rotation.interval")) {
+            pData->iRotateInterval = (int)pvals[i].val.d.n;
+            pData->bRotateNative = 1;
+        } else if (!strcmp(actpblk.descr[i].name, "rotation.compress")) {
+            if (!es_strcasebufcmp(pvals[i].val.d.estr, (const uchar *)"none", sizeof("none") - 1)) {
+                pData->rotateCompress = FILEROTATE_COMPRESS_NONE;
+            } else if (!es_strcasebufcmp(pvals[i].val.d.estr, (const uchar *)"gzip", sizeof("gzip") - 1)) {
+                pData->rotateCompress = FILEROTATE_COMPRESS_GZIP;
+            } else if (!es_strcasebufcmp(pvals[i].val.d.estr, (const uchar *)"zstd", sizeof("zstd") - 1)) {
+                pData->rotateCompress = FILEROTATE_COMPRESS_ZSTD;
+            } else {
+                parser_errmsg("omfile: invalid value for rotation.compress, must be \"none\", \"gzip\" or \"zstd\"");
+                ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+            }
+            pData->bRotateNative = 1;
+        } else if (!strcmp(actpblk.descr[i].name, "rotation.keep")) {
+            pData->iRotateKeep = (int)pvals[i].val.d.n;
+            pData->bRotateNative = 1;
         } else {
             dbgprintf(
                 "omfile: program error, non-handled "
@@ -1554,6 +1687,41 @@ BEGINnewActInst
         pData->isDevNull = 1;
     }
 
+    if ((pData->zstdFrameSize != 0 || pData->zstdFrameInterval != 0) &&
+        (loadModConf->compressionDriver != STRM_COMPRESS_ZSTD || pData->iZipLevel == 0)) {
+        parser_errmsg(
+            "omfile: compression.zstd.frameSize and compression.zstd.frameInterval "
+            "require compression.driver=\"zstd\" and a zipLevel - ignored");
+        pData->zstdFrameSize = 0;
+        pData->zstdFrameInterval = 0;
+    }
+
+    if (pData->bRotateNative) {
+        if (pData->bUseAsyncWriter || pData->sigprovName != NULL || pData->cryprovName != NULL) {
+            parser_errmsg(
+                "omfile: rotation.interval, rotation.compress and rotation.keep can not be "
+                "used together with asyncWriting, sig.provider or cry.provider");
+            ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        }
+        if (pData->iRotateInterval == 0 && (pData->iSizeLimit == 0 || pData->pszSizeLimitCmd != NULL)) {
+            parser_errmsg(
+                "omfile: rotation.compress and rotation.keep only apply to native rotation, which "
+                "requires rotation.interval or rotation.sizeLimit without rotation.sizeLimitCommand "
+                "- ignored");
+        }
+    }
+    if (pData->rotateCompress != FILEROTATE_COMPRESS_NONE) {
+        if (pData->iZipLevel != 0) {
+            parser_errmsg("omfile: rotation.compress can not be used with zipLevel, the file is already compressed");
+            ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        }
+        if (fileRotateUseCompressor(pData->rotateCompress) != RS_RET_OK) {
+            parser_errmsg("omfile: the module for rotation.compress=\"%s\" could not be loaded",
+                          (pData->rotateCompress == FILEROTATE_COMPRESS_GZIP) ? "gzip" : "zstd");
+            ABORT_FINALIZE(RS_RET_CONF_PARAM_INVLD);
+        }
+    }
+
     if (pData->sigprovName != NULL) {
         initSigprov(pData, lst);
     }
@@ -1574,9 +1742,7 @@ BEGINnewActInst
         pData->iNumTpls = 2;
         // TODO: create unified code for this (legacy+v6 system)
         /* we now allocate the cache table */
-        CHKmalloc(pData->dynCache =
-                      (dynaFileCacheEntry **)calloc(pData->iDynaFileCacheSize, sizeof(dynaFileCacheEntry *)));
-        pData->iCurrElt = -1; /* no current element */
+        CHKiRet(dyncacheConstruct(&pData->dynCache, pData->iDynaFileCacheSize, dynaFileDestructCacheEntry, pData));
     }
     // TODO: add	pData->iSizeLimit = 0; /* default value, use outchannels to configure! */
     setupInstStatsCtrs(pData);
@@ -1641,14 +1807,12 @@ BEGINparseSelectorAct
             CHKiRet(cflineParseFileName(p, fname, *ppOMSR, 0, OMSR_NO_RQD_TPL_OPTS, getDfltTpl()));
             pData->fname = ustrdup(fname);
             pData->bDynamicName = 1;
-            pData->iCurrElt = -1; /* no current element */
             /* "filename" is actually a template name, we need this as string 1. So let's add it
              * to the pOMSR. -- rgerhards, 2007-07-27
              */
             CHKiRet(OMSRsetEntry(*ppOMSR, 1, ustrdup(pData->fname), OMSR_NO_RQD_TPL_OPTS));
             /* we now allocate the cache table */
-            CHKmalloc(pData->dynCache =
-                          (dynaFileCacheEntry **)calloc(cs.iDynaFileCacheSize, sizeof(dynaFileCacheEntry *)));
+            CHKiRet(dyncacheConstruct(&pData->dynCache, cs.iDynaFileCacheSize, dynaFileDestructCacheEntry, pData));
             break;
 
         case '/':
@@ -1720,7 +1884,9 @@ BEGINdoHUP
     CODESTARTdoHUP;
     pthread_mutex_lock(&pData->mutWrite);
     if (pData->bDynamicName) {
-        dynaFileFreeCacheEntries(pData);
+        pthread_mutex_lock(&pData->mutDynCache);
+        dynaFileCloseAll(pData);
+        pthread_mutex_unlock(&pData->mutDynCache);
     } else {
         if (pData->pStrm != NULL) {
             closeFile(pData);
@@ -1734,7 +1900,6 @@ BEGINmodExit
     CODESTARTmodExit;
     objRelease(strm, CORE_COMPONENT);
     objRelease(statsobj, CORE_COMPONENT);
-    DESTROY_ATOMIC_HELPER_MUT(mutClock);
 ENDmodExit
 
 
@@ -1756,8 +1921,6 @@ BEGINmodInit(File)
     CHKiRet(objUse(strm, CORE_COMPONENT));
     CHKiRet(objUse(statsobj, CORE_COMPONENT));
 
-    INIT_ATOMIC_HELPER_MUT(mutClock);
-
     INITChkCoreFeature(bCoreSupportsBatching, CORE_FEATURE_BATCHING);
     DBGPRINTF("omfile: %susing transactional output interface.\n", bCoreSupportsBatching ? "" : "not ");
     CHKiRet(omsdRegCFSLineHdlr((uchar *)"dynafilecachesize", 0, eCmdHdlrInt, setDynaFileCacheSize, NULL,
@@ -1139,7 +1139,7 @@ static rsRetVal doTryResume(targetData_t *pTarget) {
             CHKiRet(changeToNs(pData));
             bNeedReturnNs = 1;
             pTarget->pSockArray = net.create_udp_socket((uchar *)address, NULL, bBindRequired, 0, pData->UDPSendBuf,
-                                                        pData->ipfreebind, pData->device);
+                                                        pData->ipfreebind, pData->device, 0);
             CHKiRet(returnToOriginalNs(pData));
             bNeedReturnNs = 0;
         }
@@ -69,6 +69,8 @@
 #include "dirty.h"
 #include "janitor.h"
 #include "parserif.h"
+#include "scriptprof.h"
+#include "stream.h"
 
 /* some global vars we need to differentiate between environments,
  * for TZ-related things see
@@ -1263,6 +1265,19 @@ static void hdlr_enable(int sig, void (*hdlr)()) {
     sigaction(sig, &sigAct, NULL);
 }
 
+/* the stream class recovers from SIGBUS on lost pages of mapped files. The
+ * handler returns via siglongjmp(), which does not restore the signal mask,
+ * so SIGBUS must not be blocked while it runs (SA_NODEFER).
+ */
+static void hdlr_enable_sigbus(void) {
+    struct sigaction sigAct;
+    memset(&sigAct, 0, sizeof(sigAct));
+    sigemptyset(&sigAct.sa_mask);
+    sigAct.sa_sigaction = strmSigbusHandler;
+    sigAct.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigaction(SIGBUS, &sigAct, NULL);
+}
+
 static void hdlr_sighup(void) {
     pthread_mutex_lock(&mutHadHUP);
     bHadHUP = 1;
@@ -1742,6 +1757,7 @@ static void initAll(int argc, char **argv) {
     hdlr_enable(SIGTERM, rsyslogdDoDie);
     hdlr_enable(SIGCHLD, hdlr_sigchld);
     hdlr_enable(SIGHUP, hdlr_sighup);
+    hdlr_enable_sigbus();
 
     if (rsconfNeedDropPriv(loadConf)) {
         /* need to write pid file early as we may loose permissions */
@@ -1763,6 +1779,8 @@ static void initAll(int argc, char **argv) {
         CHKiRet(writePidFile());
     }
 
+    CHKiRet(janitorStart(runConf->globals.janitorInterval));
+
     /* END OF INTIALIZATION */
     DBGPRINTF("rsyslogd: initialization completed, transitioning to regular run mode\n");
 
@@ -1900,6 +1918,8 @@ static void doHUP(void) {
     lookupDoHUP();
     DBGPRINTF("doHUP: doing errmsgs\n");
     errmsgDoHUP();
+    DBGPRINTF("doHUP: doing script profiler\n");
+    scriptprofDoHUP();
 }
 
 /* rsyslogdDoDie() is a signal handler. If called, it sets the bFinished variable
@@ -2093,6 +2113,7 @@ static void mainloop(void) {
             need_free_mutex = 0;
             pthread_mutex_unlock(&mutHadHUP);
             doHUP();
+            janitorRun();
             pthread_mutex_lock(&mutHadHUP);
             bHadHUP = 0;
             pthread_mutex_unlock(&mutHadHUP);
@@ -2108,13 +2129,12 @@ static void mainloop(void) {
         wait_timeout(&origmask);
         pthread_sigmask(SIG_UNBLOCK, &sigblockset, NULL);
 
-        janitorRun();
-
         assert(datetime.GetTime != NULL); /* This is only to keep clang static analyzer happy */
         datetime.GetTime(&tTime);
         checkGoneAwaySenders(tTime);
 
     } while (!bFinished); /* end do ... while() */
+    janitorStop();
 }
 
 /* Finalize and destruct all actions.
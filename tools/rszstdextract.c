@@ -0,0 +1,333 @@
+/* This is a tool for extracting time ranges from seekable zstd log files,
+ * as written by omfile with compression.zstd.frameSize or
+ * compression.zstd.frameInterval set.
+ *
+ * Copyright 2026 Adiscon GmbH
+ *
+ * This file is part of rsyslog.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifdef HAVE_CONFIG_H
+    #include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <zstd.h>
+
+/* must match ZSTDW_INDEX_SUFFIX in runtime/zstdw.h */
+#define INDEX_SUFFIX ".zidx"
+
+/* one entry of the frame index */
+typedef struct {
+    long long offs; /* offset of the frame in the log file */
+    long long csize; /* compressed size */
+    long long usize; /* uncompressed size */
+    long long first; /* time of first write to the frame */
+    long long last; /* time of last write to the frame */
+} frameIdx_t;
+
+static int verbose = 0;
+static int listOnly = 0;
+static long long timeFrom = LLONG_MIN;
+static long long timeTo = LLONG_MAX;
+static char *idxFile = NULL;
+
+
+/* parse a time given on the command line. Accepted are seconds since the
+ * epoch and local times in the form "YYYY-MM-DD[ HH:MM[:SS]]" (a 'T' may
+ * be used instead of the space). Returns 0 on success.
+ */
+static int parseTime(const char *const str, long long *const pTime) {
+    static const char *const fmts[] = {"%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M",
+                                       "%Y-%m-%d %H:%M", "%Y-%m-%d", NULL};
+    struct tm tm;
+    char *end;
+    const char *p;
+
+    errno = 0;
+    const long long val = strtoll(str, &end, 10);
+    if (errno == 0 && end != str && *end == '\0') {
+        *pTime = val;
+        return 0;
+    }
+
+    for (int i = 0; fmts[i] != NULL; ++i) {
+        memset(&tm, 0, sizeof(tm));
+        p = strptime(str, fmts[i], &tm);
+        if (p != NULL && *p == '\0') {
+            tm.tm_isdst = -1;
+            *pTime = (long long)mktime(&tm);
+            return 0;
+        }
+    }
+    fprintf(stderr, "invalid time '%s', expected seconds since the epoch or YYYY-MM-DD[ HH:MM[:SS]]\n", str);
+    return 1;
+}
+
+
+static const char *fmtTime(const long long t, char *const buf, const size_t lenBuf) {
+    const time_t tt = (time_t)t;
+    struct tm tm;
+
+    if (localtime_r(&tt, &tm) == NULL || strftime(buf, lenBuf, "%Y-%m-%dT%H:%M:%S", &tm) == 0) {
+        snprintf(buf, lenBuf, "%lld", t);
+    }
+    return buf;
+}
+
+
+/* read the frame index. Returns 0 on success, with *ppIdx allocated. */
+static int readIndex(const char *const name, frameIdx_t **const ppIdx, int *const pNumFrames) {
+    FILE *fp;
+    char line[256];
+    frameIdx_t *idx = NULL;
+    frameIdx_t *newIdx;
+    int numFrames = 0;
+    int maxFrames = 0;
+    int lineno = 0;
+    int r = 1;
+
+    if ((fp = fopen(name, "r")) == NULL) {
+        perror(name);
+        goto done;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        ++lineno;
+        if (numFrames == maxFrames) {
+            maxFrames = (maxFrames == 0) ? 64 : 2 * maxFrames;
+            if ((newIdx = realloc(idx, maxFrames * sizeof(frameIdx_t))) == NULL) {
+                perror("realloc");
+                goto done;
+            }
+            idx = newIdx;
+        }
+        frameIdx_t *const pFrame = &idx[numFrames];
+        if (sscanf(line, "%lld %lld %lld %lld %lld", &pFrame->offs, &pFrame->csize, &pFrame->usize,
+                   &pFrame->first, &pFrame->last) != 5 ||
+            pFrame->offs < 0 || pFrame->csize <= 0) {
+            fprintf(stderr, "%s:%d: invalid index entry, ignored\n", name, lineno);
+            continue;
+        }
+        ++numFrames;
+    }
+    r = 0;
+
+done:
+    if (fp != NULL) fclose(fp);
+    if (r == 0) {
+        *ppIdx = idx;
+        *pNumFrames = numFrames;
+    } else {
+        free(idx);
+    }
+    return r;
+}
+
+
+/* decompress one frame to stdout */
+static int extractFrame(const int fd,
+                        const frameIdx_t *const pFrame,
+                        ZSTD_DCtx *const dctx,
+                        char *const inBuf,
+                        const size_t lenInBuf,
+                        char *const outBuf,
+                        const size_t lenOutBuf) {
+    long long offs = pFrame->offs;
+    long long toRead = pFrame->csize;
+    size_t ret = 0;
+
+    ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+    while (toRead > 0) {
+        const size_t lenRead = (toRead < (long long)lenInBuf) ? (size_t)toRead : lenInBuf;
+        const ssize_t nRead = pread(fd, inBuf, lenRead, (off_t)offs);
+        if (nRead <= 0) {
+            fprintf(stderr, "error reading frame at offset %lld: %s\n", pFrame->offs,
+                    (nRead == 0) ? "file truncated" : strerror(errno));
+            return 1;
+        }
+        offs += nRead;
+        toRead -= nRead;
+
+        ZSTD_inBuffer input = {inBuf, (size_t)nRead, 0};
+        while (input.pos < input.size) {
+            ZSTD_outBuffer output = {outBuf, lenOutBuf, 0};
+            ret = ZSTD_decompressStream(dctx, &output, &input);
+            if (ZSTD_isError(ret)) {
+                fprintf(stderr, "error decompressing frame at offset %lld: %s\n", pFrame->offs,
+                        ZSTD_getErrorName(ret));
+                return 1;
+            }
+            if (fwrite(outBuf, 1, output.pos, stdout) != output.pos) {
+                perror("stdout");
+                return 1;
+            }
+        }
+    }
+    if (ret != 0) {
+        fprintf(stderr, "frame at offset %lld is incomplete\n", pFrame->offs);
+        return 1;
+    }
+    return 0;
+}
+
+
+static int processFile(const char *const name) {
+    frameIdx_t *idx = NULL;
+    int numFrames = 0;
+    ZSTD_DCtx *dctx = NULL;
+    char *inBuf = NULL;
+    char *outBuf = NULL;
+    char *idxName = NULL;
+    char tFirst[32], tLast[32];
+    int fd = -1;
+    int nSelected = 0;
+    int r = 1;
+
+    if (idxFile == NULL) {
+        const size_t lenName = strlen(name) + sizeof(INDEX_SUFFIX);
+        if ((idxName = malloc(lenName)) == NULL) {
+            perror("malloc");
+            goto done;
+        }
+        snprintf(idxName, lenName, "%s%s", name, INDEX_SUFFIX);
+    }
+    if (readIndex((idxFile == NULL) ? idxName : idxFile, &idx, &numFrames) != 0) goto done;
+
+    if (listOnly) {
+        for (int i = 0; i < numFrames; ++i) {
+            printf("%lld %lld %lld %s %s\n", idx[i].offs, idx[i].csize, idx[i].usize,
+                   fmtTime(idx[i].first, tFirst, sizeof(tFirst)), fmtTime(idx[i].last, tLast, sizeof(tLast)));
+        }
+        r = 0;
+        goto done;
+    }
+
+    if ((fd = open(name, O_RDONLY | O_CLOEXEC)) == -1) {
+        perror(name);
+        goto done;
+    }
+    const size_t lenInBuf = ZSTD_DStreamInSize();
+    const size_t lenOutBuf = ZSTD_DStreamOutSize();
+    if ((dctx = ZSTD_createDCtx()) == NULL || (inBuf = malloc(lenInBuf)) == NULL ||
+        (outBuf = malloc(lenOutBuf)) == NULL) {
+        fprintf(stderr, "out of memory\n");
+        goto done;
+    }
+
+    for (int i = 0; i < numFrames; ++i) {
+        if (idx[i].last < timeFrom || idx[i].first > timeTo) continue;
+        if (verbose) {
+            fprintf(stderr, "frame at offset %lld: %s - %s, %lld bytes\n", idx[i].offs,
+                    fmtTime(idx[i].first, tFirst, sizeof(tFirst)), fmtTime(idx[i].last, tLast, sizeof(tLast)),
+                    idx[i].usize);
+        }
+        if (extractFrame(fd, &idx[i], dctx, inBuf, lenInBuf, outBuf, lenOutBuf) != 0) goto done;
+        ++nSelected;
+    }
+    if (verbose) {
+        fprintf(stderr, "%s: %d of %d frames extracted\n", name, nSelected, numFrames);
+    }
+    r = 0;
+
+done:
+    if (fd != -1) close(fd);
+    ZSTD_freeDCtx(dctx);
+    free(inBuf);
+    free(outBuf);
+    free(idxName);
+    free(idx);
+    return r;
+}
+
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: rszstdextract [OPTIONS] FILE ...\n"
+            "  -f, --from <time>   extract frames with data written at or after <time>\n"
+            "  -t, --to <time>     extract frames with data written at or before <time>\n"
+            "  -i, --index <file>  use <file> as frame index instead of FILE" INDEX_SUFFIX
+            "\n"
+            "  -l, --list          list the frames instead of extracting them\n"
+            "  -v, --verbose       report the extracted frames on stderr\n"
+            "<time> is either seconds since the epoch or a local time like \"2026-10-18 12:00:00\"\n");
+}
+
+
+static struct option long_options[] = {{"from", required_argument, NULL, 'f'},
+                                       {"to", required_argument, NULL, 't'},
+                                       {"index", required_argument, NULL, 'i'},
+                                       {"list", no_argument, NULL, 'l'},
+                                       {"verbose", no_argument, NULL, 'v'},
+                                       {"help", no_argument, NULL, 'h'},
+                                       {NULL, 0, NULL, 0}};
+
+static const char *short_options = "f:t:i:lvh";
+
+int main(int argc, char *argv[]) {
+    int opt;
+    int r = 0;
+
+    while ((opt = getopt_long(argc, argv, short_options, long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'f':
+                if (parseTime(optarg, &timeFrom) != 0) exit(1);
+                break;
+            case 't':
+                if (parseTime(optarg, &timeTo) != 0) exit(1);
+                break;
+            case 'i':
+                idxFile = optarg;
+                break;
+            case 'l':
+                listOnly = 1;
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            case 'h':
+                usage();
+                exit(0);
+            default:
+                usage();
+                exit(1);
+        }
+    }
+
+    if (optind == argc) {
+        usage();
+        exit(1);
+    }
+    if (idxFile != NULL && argc - optind > 1) {
+        fprintf(stderr, "--index can only be used with a single file\n");
+        exit(1);
+    }
+
+    for (int i = optind; i < argc; ++i) {
+        if (processFile(argv[i]) != 0) {
+            fprintf(stderr, "error processing file %s\n", argv[i]);
+            r = 1;
+        }
+    }
+    return r;
+}